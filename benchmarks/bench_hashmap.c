@@ -0,0 +1,87 @@
+// benchmarks/bench_hashmap.c
+// Compares the red-black `Map` against the open-addressing `HashMap` on
+// insert / successful lookup / failed lookup over random int keys.
+//
+// Usage: bench_hashmap [n]   (default n = 1000000)
+#include "CLIP/Map.h"
+#include "CLIP/HashMap.h"
+#include <stdint.h>
+#include <time.h>
+
+static int cmp_int(const int *a, const int *b)
+{
+  return (*a > *b) - (*a < *b);
+}
+
+CLIP_DEFINE_MAP_TYPE(int, int, cmp_int)
+CLIP_DEFINE_HASHMAP_TYPE(int, int, clip_hash_int, clip_eq_int)
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x243f6a8885a308d3ULL;
+static int next_key(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (int)(rng_state & 0x7fffffff);
+}
+
+static void report(const char *name, const char *op, int n, double seconds)
+{
+  printf("%-8s %-12s %10.1f ns/op\n", name, op, seconds * 1e9 / n);
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  int *keys = malloc((size_t)n * sizeof(int));
+  int *misses = malloc((size_t)n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    keys[i] = next_key() | 1; // odd keys are present
+  for (int i = 0; i < n; i++)
+    misses[i] = next_key() & ~1; // even keys are absent
+  long checksum = 0;
+
+  Map(int, int) map = Map_init(int, int);
+  double t0 = now_sec();
+  for (int i = 0; i < n; i++)
+    Map_insert(int, int, &map, keys[i], i);
+  double t1 = now_sec();
+  for (int i = 0; i < n; i++)
+    checksum += *Map_get(int, int, &map, keys[i]);
+  double t2 = now_sec();
+  for (int i = 0; i < n; i++)
+    checksum += Map_contains(int, int, &map, misses[i]);
+  double t3 = now_sec();
+  report("Map", "insert", n, t1 - t0);
+  report("Map", "get (hit)", n, t2 - t1);
+  report("Map", "get (miss)", n, t3 - t2);
+  Map_free(int, int, &map);
+
+  HashMap(int, int) hmap = HashMap_init(int, int);
+  t0 = now_sec();
+  for (int i = 0; i < n; i++)
+    HashMap_insert(int, int, &hmap, keys[i], i);
+  t1 = now_sec();
+  for (int i = 0; i < n; i++)
+    checksum += *HashMap_get(int, int, &hmap, keys[i]);
+  t2 = now_sec();
+  for (int i = 0; i < n; i++)
+    checksum += HashMap_contains(int, int, &hmap, misses[i]);
+  t3 = now_sec();
+  report("HashMap", "insert", n, t1 - t0);
+  report("HashMap", "get (hit)", n, t2 - t1);
+  report("HashMap", "get (miss)", n, t3 - t2);
+  HashMap_free(int, int, &hmap);
+
+  printf("(checksum %ld)\n", checksum);
+  free(keys);
+  free(misses);
+  return 0;
+}
@@ -0,0 +1,454 @@
+// benchmarks/bench_json.c
+// Parses generated documents and releases them, comparing the default
+// allocator (Json_parse + Json_free), an arena (Json_parse_arena +
+// Json_arena_free) and in situ strings on top of the arena (Json_parse_insitu,
+// no string copies), followed by serializing the document back (Json_stringify
+// into a reused in-memory buffer, compact) and looking up every member of each record
+// (Json_object_get). A SAX pass (Json_sax_parse, no tree) is timed as well,
+// and the same events from the incremental parser fed 64 KiB chunks. The
+// structural engine (Json_set_engine) repeats the arena and SAX passes
+// ("s-arena", "s-sax") and builds its tape (Json_tape_parse). A wide record
+// then has three of its members read, by a full parse and by Json_parse_select,
+// and out of the parsed record by Json_object_get and by compiled paths. A
+// large array of doubles is parsed into nodes and packed (Json_parse_packed).
+// Finally the records are written one per line and parsed with
+// Json_parse_lines on a growing number of threads.
+//
+// Three documents are used: compact records, an indented log of long
+// messages, which is dominated by whitespace skipping and string scanning, and
+// numeric telemetry (64-bit ids, timestamps and full-precision readings).
+// `bench_json_scalar` is the same program built with CLIP_JSON_NO_SIMD, so
+// running both shows what the SIMD scanners bring.
+//
+// Usage: bench_json [n] [rounds]   (default n = 100000, rounds = 5)
+#include "CLIP/Parsers/json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static char *make_records(int n, size_t *len)
+{
+  size_t cap = (size_t)n * 128 + 16;
+  char *doc = malloc(cap);
+  size_t pos = 0;
+  pos += snprintf(doc + pos, cap - pos, "[");
+  for (int i = 0; i < n; i++)
+    pos += snprintf(doc + pos, cap - pos,
+                    "%s{\"id\": %d, \"name\": \"user%d\", \"score\": %d.%02d, \"active\": %s, \"tags\": [\"a\", \"b\"]}",
+                    i ? ", " : "", i, i, i % 1000, i % 100, i % 2 ? "true" : "false");
+  pos += snprintf(doc + pos, cap - pos, "]");
+  *len = pos;
+  return doc;
+}
+
+static char *make_log(int n, size_t *len)
+{
+  static const char words[] = "request served from cache after upstream timeout; retrying with backoff ";
+  size_t cap = (size_t)n * 400 + 16;
+  char *doc = malloc(cap);
+  size_t pos = 0;
+  pos += snprintf(doc + pos, cap - pos, "[\n");
+  for (int i = 0; i < n; i++)
+  {
+    pos += snprintf(doc + pos, cap - pos, "%s    {\n        \"level\": \"info\",\n        \"message\": \"",
+                    i ? ",\n" : "");
+    for (int w = 0; w < 3; w++)
+      pos += snprintf(doc + pos, cap - pos, "%s", words);
+    pos += snprintf(doc + pos, cap - pos, "\\\"id\\\" %d\"\n    }", i);
+  }
+  pos += snprintf(doc + pos, cap - pos, "\n]");
+  *len = pos;
+  return doc;
+}
+
+static char *make_telemetry(int n, size_t *len)
+{
+  size_t cap = (size_t)n * 160 + 16;
+  char *doc = malloc(cap);
+  size_t pos = 0;
+  unsigned long long id = 0x9E3779B97F4A7C15ULL;
+  pos += snprintf(doc + pos, cap - pos, "[");
+  for (int i = 0; i < n; i++)
+  {
+    id = id * 6364136223846793005ULL + 1442695040888963407ULL;
+    pos += snprintf(doc + pos, cap - pos, "%s[%llu, %d, %.17g, %.6f, %.3e]", i ? ", " : "", id,
+                    1700000000 + i, (double)(id >> 11) / (1ULL << 53), (double)(i % 10000) / 7.0,
+                    (double)i * 1.5e-9);
+  }
+  pos += snprintf(doc + pos, cap - pos, "]");
+  *len = pos;
+  return doc;
+}
+
+static void report(const char *name, size_t bytes, int rounds, double parse, double release)
+{
+  double mb = (double)bytes * rounds / (1024.0 * 1024.0);
+  printf("  %-8s parse %8.1f MB/s   free %8.3f ms   parse+free %8.1f MB/s\n",
+         name, mb / parse, release * 1e3 / rounds, mb / (parse + release));
+}
+
+static char *make_lines(int n, size_t *len)
+{
+  size_t cap = (size_t)n * 128 + 16;
+  char *doc = malloc(cap);
+  size_t pos = 0;
+  for (int i = 0; i < n; i++)
+    pos += snprintf(doc + pos, cap - pos,
+                    "{\"id\": %d, \"name\": \"user%d\", \"score\": %d.%02d, \"active\": %s, \"tags\": [\"a\", \"b\"]}\n",
+                    i, i, i % 1000, i % 100, i % 2 ? "true" : "false");
+  *len = pos;
+  return doc;
+}
+
+static void count_line(void *ud, size_t offset, JsonValue *v)
+{
+  (void)ud;
+  (void)offset;
+  (void)v;
+}
+
+static void run_lines(const char *doc, size_t len, int rounds)
+{
+  printf("json lines: %.1f MB\n", len / (1024.0 * 1024.0));
+  for (int threads = 1; threads <= 8; threads *= 2)
+  {
+    double ordered = 0, unordered = 0;
+    for (int r = 0; r < rounds; r++)
+    {
+      double t0 = now_sec();
+      Json_parse_lines(doc, len, threads, true, count_line, NULL);
+      double t1 = now_sec();
+      Json_parse_lines(doc, len, threads, false, count_line, NULL);
+      unordered += now_sec() - t1;
+      ordered += t1 - t0;
+    }
+    double mb = (double)len * rounds / (1024.0 * 1024.0);
+    printf("  %d thread(s)  ordered %8.1f MB/s   unordered %8.1f MB/s\n", threads, mb / ordered, mb / unordered);
+  }
+}
+
+// One wide event record: 200 members of mixed types, a few of them nested
+static char *make_wide(size_t *len)
+{
+  size_t cap = 64 * 1024;
+  char *doc = malloc(cap);
+  size_t pos = 0;
+  pos += snprintf(doc + pos, cap - pos, "{");
+  for (int i = 0; i < 200; i++)
+  {
+    if (i % 10 == 3)
+      pos += snprintf(doc + pos, cap - pos, "\"attr%d\": {\"kind\": \"span\", \"ids\": [%d, %d, %d], \"ok\": true}, ",
+                      i, i, i * 7, i * 13);
+    else if (i % 3 == 0)
+      pos += snprintf(doc + pos, cap - pos, "\"attr%d\": \"value of attribute %d\", ", i, i);
+    else
+      pos += snprintf(doc + pos, cap - pos, "\"attr%d\": %d.%03d, ", i, i * 31, i % 1000);
+  }
+  pos += snprintf(doc + pos, cap - pos, "\"user\": {\"id\": 42, \"name\": \"ann\"}, \"status\": 200}");
+  *len = pos;
+  return doc;
+}
+
+// Reads three fields of the wide record: a full parse and lookups against Json_parse_select
+static void run_select(int n, int rounds)
+{
+  size_t len;
+  char *doc = make_wide(&len);
+  static const char *const paths[] = {"attr13.kind", "user.name", "status"};
+  long checksum = 0;
+  double full = 0, select = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    for (int i = 0; i < n / 10; i++)
+    {
+      JsonValue *v = Json_parse(doc);
+      checksum += Json_object_get(Json_object_get(v, "attr13"), "kind") != NULL;
+      checksum += Json_object_get(Json_object_get(v, "user"), "name") != NULL;
+      checksum += Json_object_get(v, "status") != NULL;
+      Json_free(v);
+    }
+    double t1 = now_sec();
+    for (int i = 0; i < n / 10; i++)
+    {
+      JsonValue *out[3];
+      checksum += (long)Json_parse_select(doc, paths, 3, out);
+      for (int k = 0; k < 3; k++)
+        Json_free(out[k]);
+    }
+    select += now_sec() - t1;
+    full += t1 - t0;
+  }
+  double mb = (double)len * (n / 10) * rounds / (1024.0 * 1024.0);
+  printf("wide record: %.1f KB, 3 of 200 members\n", len / 1024.0);
+  printf("  parse+get %8.1f MB/s   select %8.1f MB/s\n", mb / full, mb / select);
+
+  // The same three fields out of the parsed record: chained lookups against compiled paths
+  JsonValue *v = Json_parse(doc);
+  JsonPath *compiled[3];
+  for (int k = 0; k < 3; k++)
+    compiled[k] = Json_path_compile(paths[k]);
+  double get = 0, eval = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    for (int i = 0; i < n; i++)
+    {
+      checksum += Json_object_get(Json_object_get(v, "attr13"), "kind") != NULL;
+      checksum += Json_object_get(Json_object_get(v, "user"), "name") != NULL;
+      checksum += Json_object_get(v, "status") != NULL;
+    }
+    double t1 = now_sec();
+    for (int i = 0; i < n; i++)
+      for (int k = 0; k < 3; k++)
+        checksum += Json_path_eval(compiled[k], v) != NULL;
+    eval += now_sec() - t1;
+    get += t1 - t0;
+  }
+  printf("  object_get %7.1f ns per path   path_eval %7.1f ns per path   (checksum %ld)\n",
+         get * 1e9 / (3.0 * n * rounds), eval * 1e9 / (3.0 * n * rounds), checksum);
+  for (int k = 0; k < 3; k++)
+    Json_path_free(compiled[k]);
+  Json_free(v);
+  free(doc);
+}
+
+// One array of n * 10 doubles, parsed into nodes and packed, then summed
+static void run_packed(int n, int rounds)
+{
+  size_t count = (size_t)n * 10, cap = count * 24 + 16, len = 0;
+  char *doc = malloc(cap);
+  len += snprintf(doc + len, cap - len, "[");
+  for (size_t i = 0; i < count; i++)
+    len += snprintf(doc + len, cap - len, "%s%.6f", i ? ", " : "", (double)(i % 100000) / 7.0);
+  snprintf(doc + len, cap - len, "]");
+  printf("number array: %.1f MB, %zu doubles\n", len / (1024.0 * 1024.0), count);
+
+  double parse[2] = {0}, sum[2] = {0}, release[2] = {0}, total = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    for (int packed = 0; packed < 2; packed++)
+    {
+      double t0 = now_sec();
+      JsonValue *v = packed ? Json_parse_packed(doc, NULL) : Json_parse(doc);
+      double t1 = now_sec();
+      if (packed)
+        for (size_t i = 0; i < v->numbers.size; i++)
+          total += v->numbers.doubles[i];
+      else
+        for (clip_size_t i = 0; i < v->list.size; i++)
+          total += v->list.data[i]->number;
+      double t2 = now_sec();
+      Json_free(v);
+      release[packed] += now_sec() - t2;
+      sum[packed] += t2 - t1;
+      parse[packed] += t1 - t0;
+    }
+  }
+  double mb = (double)len * rounds / (1024.0 * 1024.0);
+  for (int packed = 0; packed < 2; packed++)
+    printf("  %-8s parse %8.1f MB/s   sum %8.3f ms   free %8.3f ms   %zu bytes per number\n",
+           packed ? "packed" : "nodes", mb / parse[packed], sum[packed] * 1e3 / rounds,
+           release[packed] * 1e3 / rounds, packed ? sizeof(double) : sizeof(JsonValue) + sizeof(JsonValue_ptr));
+  printf("  (sum %g)\n", total);
+  free(doc);
+}
+
+static bool count_value(void *ud)
+{
+  (*(long *)ud)++;
+  return true;
+}
+
+static long run(const char *title, const char *doc, size_t len, int rounds)
+{
+  printf("%s: %.1f MB\n", title, len / (1024.0 * 1024.0));
+  long checksum = 0;
+
+  double parse = 0, release = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    JsonValue *v = Json_parse(doc);
+    double t1 = now_sec();
+    checksum += v->list.size;
+    Json_free(v);
+    release += now_sec() - t1;
+    parse += t1 - t0;
+  }
+  report("malloc", len, rounds, parse, release);
+
+  CLIP_Arena arena;
+  clip_arena_init(&arena, 1 << 20);
+  parse = release = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    JsonValue *v = Json_parse_arena(doc, &arena);
+    double t1 = now_sec();
+    checksum += v->list.size;
+    Json_arena_free(&arena);
+    release += now_sec() - t1;
+    parse += t1 - t0;
+  }
+  report("arena", len, rounds, parse, release);
+
+  char *scratch = malloc(len + 1);
+  parse = release = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    memcpy(scratch, doc, len + 1); // in situ parsing overwrites its input
+    double t0 = now_sec();
+    JsonValue *v = Json_parse_insitu(scratch, &arena.allocator);
+    double t1 = now_sec();
+    checksum += v->list.size;
+    Json_arena_free(&arena);
+    release += now_sec() - t1;
+    parse += t1 - t0;
+  }
+  report("insitu", len, rounds, parse, release);
+  free(scratch);
+
+  JsonValue *v = Json_parse_arena(doc, &arena);
+  CLIP_StrBuf out;
+  clip_strbuf_init(&out);
+  double write = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    out.len = 0;
+    double t0 = now_sec();
+    Json_stringify(v, &out, JSON_STRINGIFY_COMPACT);
+    write += now_sec() - t0;
+  }
+  printf("  stringify      %8.1f MB/s   (%.1f MB of output)\n",
+         (double)out.len * rounds / (1024.0 * 1024.0) / write, out.len / (1024.0 * 1024.0));
+  checksum += (long)out.len;
+  clip_strbuf_free(&out);
+
+  // Looks up every member of every record by its key
+  long gets = 0;
+  double get = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    for (clip_size_t i = 0; i < v->list.size; i++)
+    {
+      JsonValue *rec = v->list.data[i];
+      if (rec->type != JSON_OBJECT)
+        continue;
+      for (clip_size_t k = 0; k < rec->object.members.size; k++)
+        checksum += Json_object_get(rec, rec->object.members.data[k].key) != NULL;
+      gets += rec->object.members.size;
+    }
+    get += now_sec() - t0;
+  }
+  if (gets)
+    printf("  object_get     %8.1f ns per lookup\n", get * 1e9 / gets);
+  Json_arena_free(&arena);
+  clip_arena_destroy(&arena);
+
+  JsonSaxHandler counter = {0};
+  counter.on_start_object = count_value;
+  counter.on_start_array = count_value;
+  parse = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    Json_sax_parse(doc, len, &counter, &checksum);
+    parse += now_sec() - t0;
+  }
+  report("sax", len, rounds, parse, 0);
+
+  parse = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    JsonParser *p = Json_parser_new_sax(&counter, &checksum);
+    for (size_t i = 0; i < len; i += 1 << 16)
+      Json_parser_feed(p, doc + i, len - i < (1 << 16) ? len - i : (1 << 16));
+    Json_parser_finish(p, NULL);
+    parse += now_sec() - t0;
+  }
+  report("chunked", len, rounds, parse, 0);
+
+  // The structural engine: the same DOM (on an arena) and SAX passes, and its tape
+  Json_set_engine(JSON_ENGINE_STRUCTURAL);
+  clip_arena_init(&arena, 1 << 20);
+  parse = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    JsonValue *doc_value = Json_parse_arena(doc, &arena);
+    parse += now_sec() - t0;
+    checksum += doc_value->list.size;
+    Json_arena_free(&arena);
+  }
+  clip_arena_destroy(&arena);
+  report("s-arena", len, rounds, parse, 0);
+
+  parse = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    Json_sax_parse(doc, len, &counter, &checksum);
+    parse += now_sec() - t0;
+  }
+  report("s-sax", len, rounds, parse, 0);
+  Json_set_engine(JSON_ENGINE_RECURSIVE);
+
+  JsonTape tape = {0};
+  parse = 0;
+  for (int r = 0; r < rounds; r++)
+  {
+    double t0 = now_sec();
+    Json_tape_parse(doc, len, &tape);
+    parse += now_sec() - t0;
+    checksum += (long)tape.size;
+  }
+  Json_tape_free(&tape);
+  report("tape", len, rounds, parse, 0);
+  return checksum;
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 5;
+#ifdef CLIP_JSON_NO_SIMD
+  printf("scanners: scalar\n");
+#else
+  printf("scanners: simd (when available)\n");
+#endif
+  long checksum = 0;
+  size_t len;
+
+  char *doc = make_records(n, &len);
+  checksum += run("records", doc, len, rounds);
+  free(doc);
+
+  doc = make_log(n, &len);
+  checksum += run("long strings", doc, len, rounds);
+  free(doc);
+
+  doc = make_telemetry(n, &len);
+  checksum += run("telemetry", doc, len, rounds);
+  free(doc);
+
+  run_select(n, rounds);
+  run_packed(n, rounds);
+
+  doc = make_lines(n * 4, &len);
+  run_lines(doc, len, rounds);
+  free(doc);
+
+  printf("checksum %ld\n", checksum);
+  return 0;
+}
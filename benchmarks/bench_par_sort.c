@@ -0,0 +1,69 @@
+// benchmarks/bench_par_sort.c
+// Scaling of `List_par_sort` from 1 thread up to the number of online CPUs
+// (doubling the thread count each step) against the serial `List_sort`.
+//
+// Usage: bench_par_sort [n] [max_threads]   (default n = 10000000, max_threads = CPUs)
+#include "CLIP/ParSort.h"
+#include <stdint.h>
+#include <time.h>
+
+static int cmp_int(const int *a, const int *b)
+{
+  return (*a > *b) - (*a < *b);
+}
+
+CLIP_DEFINE_LIST_TYPE(int)
+CLIP_DEFINE_LIST_PAR_SORT(int)
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t rng_state = 0x243f6a8885a308d3ULL;
+static int next_key(void)
+{
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (int)(rng_state & 0x7fffffff);
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : 10000000;
+  int max_threads = argc > 2 ? atoi(argv[2]) : clip_par_sort_default_threads();
+  int *keys = malloc((size_t)n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    keys[i] = next_key();
+
+  List(int) xs = List_init(int, n);
+  xs.size = n;
+
+  memcpy(xs.data, keys, (size_t)n * sizeof(int));
+  double t0 = now_sec();
+  List_sort(int, &xs, cmp_int);
+  double serial = now_sec() - t0;
+  printf("%-22s %10.2f ms\n", "List_sort", serial * 1e3);
+
+  for (int threads = 1;; threads *= 2)
+  {
+    if (threads > max_threads)
+      threads = max_threads;
+    memcpy(xs.data, keys, (size_t)n * sizeof(int));
+    t0 = now_sec();
+    List_par_sort(int, &xs, cmp_int, threads);
+    double seconds = now_sec() - t0;
+    char name[32];
+    snprintf(name, sizeof(name), "List_par_sort (%d)", threads);
+    printf("%-22s %10.2f ms   %5.2fx\n", name, seconds * 1e3, serial / seconds);
+    if (threads == max_threads)
+      break;
+  }
+
+  List_free(int, &xs);
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,250 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Pluggable allocator interface shared by every CLIP container.
+ *
+ * A `CLIP_Allocator` is a table of `alloc` / `realloc` / `free` callbacks plus
+ * an opaque context. Every container stores a pointer to the allocator it was
+ * created with (`NULL` meaning the default one) and routes all of its memory
+ * traffic through `clip_alloc`, `clip_realloc` and `clip_free`. The callbacks
+ * receive the size of the block being resized or released, so allocators that
+ * do not keep per-block headers (arenas, size-class pools) can be plugged in.
+ *
+ * The default allocator is libc, and can itself be replaced at compile time by
+ * defining `CLIP_MALLOC`, `CLIP_REALLOC` and `CLIP_FREE` before including any
+ * CLIP header.
+ *
+ * `CLIP_Arena` is a bump allocator with this interface: allocations are a
+ * pointer increment, individual frees are (almost always) no-ops and the whole
+ * arena is released or recycled at once, which suits request-scoped data.
+ *
+ * Example:
+ * CLIP_Arena arena;
+ * clip_arena_init(&arena, 0);
+ * List(int) xs = List_init_with_allocator(int, 16, &arena.allocator);
+ * List_append(int, &xs, 42);
+ * clip_arena_reset(&arena); // drops `xs` and everything else in the arena
+ * clip_arena_destroy(&arena);
+ */
+#ifndef CLIP_ALLOCATOR_H
+#define CLIP_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compile-time hooks for the default allocator. */
+#ifndef CLIP_MALLOC
+#define CLIP_MALLOC(size) malloc(size)
+#endif
+
+#ifndef CLIP_REALLOC
+#define CLIP_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+
+#ifndef CLIP_FREE
+#define CLIP_FREE(ptr) free(ptr)
+#endif
+
+typedef struct CLIP_Allocator
+{
+  void *(*alloc)(void *ctx, size_t size);
+  void *(*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+  void (*free)(void *ctx, void *ptr, size_t size);
+  void *ctx; /* Passed back to every callback */
+} CLIP_Allocator;
+
+/**
+ * @brief Allocate `size` bytes from `allocator` (the default allocator if NULL).
+ */
+static inline void *clip_alloc(const CLIP_Allocator *allocator, size_t size)
+{
+  if (!allocator)
+    return CLIP_MALLOC(size);
+  return allocator->alloc(allocator->ctx, size);
+}
+
+/**
+ * @brief Resize a block obtained from `allocator` from `old_size` to `new_size` bytes.
+ */
+static inline void *clip_realloc(const CLIP_Allocator *allocator, void *ptr, size_t old_size, size_t new_size)
+{
+  if (!allocator)
+    return CLIP_REALLOC(ptr, new_size);
+  return allocator->realloc(allocator->ctx, ptr, old_size, new_size);
+}
+
+/**
+ * @brief Release a block of `size` bytes obtained from `allocator`. NULL pointers are ignored.
+ */
+static inline void clip_free(const CLIP_Allocator *allocator, void *ptr, size_t size)
+{
+  if (!ptr)
+    return;
+  if (!allocator)
+  {
+    CLIP_FREE(ptr);
+    return;
+  }
+  allocator->free(allocator->ctx, ptr, size);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Bump arena                                                              */
+/* ---------------------------------------------------------------------- */
+
+/* Default size of an arena block. */
+#define CLIP_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+/* Alignment of every arena allocation. */
+#define CLIP_ARENA_ALIGNMENT _Alignof(max_align_t)
+
+#define CLIP_ARENA_ALIGN_UP(n) (((n) + CLIP_ARENA_ALIGNMENT - 1) / CLIP_ARENA_ALIGNMENT * CLIP_ARENA_ALIGNMENT)
+
+typedef struct CLIP_ArenaBlock
+{
+  struct CLIP_ArenaBlock *next;
+  size_t capacity; /* Usable bytes after the (aligned) header */
+} CLIP_ArenaBlock;
+
+typedef struct CLIP_Arena
+{
+  CLIP_ArenaBlock *blocks;  /* All blocks, oldest first */
+  CLIP_ArenaBlock *current; /* Block allocations are currently bumped from */
+  size_t used;              /* Bytes already handed out from `current` */
+  size_t block_size;        /* Usable size of a regular block */
+  void *last;               /* Most recent allocation, can be grown or popped in place */
+  CLIP_Allocator allocator; /* Interface handed to the containers (ctx is the arena) */
+} CLIP_Arena;
+
+#define CLIP_ARENA_HEADER_SIZE CLIP_ARENA_ALIGN_UP(sizeof(CLIP_ArenaBlock))
+
+static inline void *clip_arena_alloc(CLIP_Arena *arena, size_t size);
+static inline void *clip_arena_allocator_alloc(void *ctx, size_t size);
+static inline void *clip_arena_allocator_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size);
+static inline void clip_arena_allocator_free(void *ctx, void *ptr, size_t size);
+
+/**
+ * @brief Initialize an empty arena. No memory is allocated until the first request.
+ *
+ * The arena must not be moved once containers hold `&arena->allocator`.
+ *
+ * @param arena The arena
+ * @param block_size Usable size of each block (0 for `CLIP_ARENA_DEFAULT_BLOCK_SIZE`)
+ */
+static inline void clip_arena_init(CLIP_Arena *arena, size_t block_size)
+{
+  arena->blocks = NULL;
+  arena->current = NULL;
+  arena->used = 0;
+  arena->block_size = CLIP_ARENA_ALIGN_UP(block_size ? block_size : CLIP_ARENA_DEFAULT_BLOCK_SIZE);
+  arena->last = NULL;
+  arena->allocator.alloc = clip_arena_allocator_alloc;
+  arena->allocator.realloc = clip_arena_allocator_realloc;
+  arena->allocator.free = clip_arena_allocator_free;
+  arena->allocator.ctx = arena;
+}
+
+/**
+ * @brief Hand out `size` bytes. Requests larger than a block get a block of their own.
+ */
+static inline void *clip_arena_alloc(CLIP_Arena *arena, size_t size)
+{
+  size = CLIP_ARENA_ALIGN_UP(size ? size : 1);
+  if (!arena->current || arena->current->capacity - arena->used < size)
+  {
+    /* Blocks kept by a reset are reused in order, as long as they are big enough */
+    CLIP_ArenaBlock *next = arena->current ? arena->current->next : arena->blocks;
+    if (!next || next->capacity < size)
+    {
+      size_t capacity = size > arena->block_size ? size : arena->block_size;
+      CLIP_ArenaBlock *block = (CLIP_ArenaBlock *)CLIP_MALLOC(CLIP_ARENA_HEADER_SIZE + capacity);
+      if (!block)
+      {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+      }
+      block->capacity = capacity;
+      block->next = next;
+      if (arena->current)
+        arena->current->next = block;
+      else
+        arena->blocks = block;
+      next = block;
+    }
+    arena->current = next;
+    arena->used = 0;
+  }
+  void *ptr = (char *)arena->current + CLIP_ARENA_HEADER_SIZE + arena->used;
+  arena->used += size;
+  arena->last = ptr;
+  return ptr;
+}
+
+/**
+ * @brief Make the whole arena available again, keeping its blocks for reuse.
+ * Everything allocated from it so far becomes invalid.
+ */
+static inline void clip_arena_reset(CLIP_Arena *arena)
+{
+  arena->current = NULL;
+  arena->used = 0;
+  arena->last = NULL;
+}
+
+/**
+ * @brief Release every block of the arena. The arena can be reused afterwards.
+ */
+static inline void clip_arena_destroy(CLIP_Arena *arena)
+{
+  CLIP_ArenaBlock *block = arena->blocks;
+  while (block)
+  {
+    CLIP_ArenaBlock *next = block->next;
+    CLIP_FREE(block);
+    block = next;
+  }
+  clip_arena_init(arena, arena->block_size);
+}
+
+static inline void *clip_arena_allocator_alloc(void *ctx, size_t size)
+{
+  return clip_arena_alloc((CLIP_Arena *)ctx, size);
+}
+
+/* The most recent allocation grows in place while its block has room; anything else is copied. */
+static inline void *clip_arena_allocator_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+  CLIP_Arena *arena = (CLIP_Arena *)ctx;
+  if (!ptr)
+    return clip_arena_alloc(arena, new_size);
+  if (new_size <= old_size)
+    return ptr;
+  if (ptr == arena->last)
+  {
+    size_t start = (size_t)((char *)ptr - ((char *)arena->current + CLIP_ARENA_HEADER_SIZE));
+    size_t size = CLIP_ARENA_ALIGN_UP(new_size);
+    if (arena->current->capacity - start >= size)
+    {
+      arena->used = start + size;
+      return ptr;
+    }
+  }
+  void *copy = clip_arena_alloc(arena, new_size);
+  memcpy(copy, ptr, old_size);
+  return copy;
+}
+
+/* Only the most recent allocation is given back; other blocks wait for the reset. */
+static inline void clip_arena_allocator_free(void *ctx, void *ptr, size_t size)
+{
+  (void)size;
+  CLIP_Arena *arena = (CLIP_Arena *)ctx;
+  if (ptr == arena->last)
+  {
+    arena->used = (size_t)((char *)ptr - ((char *)arena->current + CLIP_ARENA_HEADER_SIZE));
+    arena->last = NULL;
+  }
+}
+
+#endif /* CLIP_ALLOCATOR_H */
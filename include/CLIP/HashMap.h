@@ -0,0 +1,557 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief In this file we define a series of macros that generates a **type-safe** hash map
+ * (flat, open-addressing table in the SwissTable style) for any given key-value pair types in C.
+ *
+ * Unlike `Map.h`, the entries live in one contiguous slot array and a lookup is
+ * resolved by comparing 16 one-byte control tags at a time (SSE2 when available,
+ * a portable scalar loop otherwise), so the average `get`/`insert` is O(1) and
+ * touches one or two cache lines. Iteration order is unspecified.
+ *
+ * Example:
+ * // Define a hash and an equality function for keys
+ * uint64_t string_hash(const char* const* key) {
+ *     return clip_hash_bytes(*key, strlen(*key));
+ * }
+ * bool string_eq(const char* const* a, const char* const* b) {
+ *     return strcmp(*a, *b) == 0;
+ * }
+ *
+ * typedef const char *string;
+ * CLIP_DEFINE_HASHMAP_TYPE(string, int, string_hash, string_eq)
+ *
+ * HashMap(string, int) map = HashMap_init(string, int);
+ * HashMap_insert(string, int, &map, "hello", 42);
+ * HashMap_free(string, int, &map);
+ *
+ * The following methods are generated automatically (same surface as `Map.h`):
+ * - init
+ * - init_with_allocator
+ * - insert
+ * - get
+ * - contains
+ * - remove
+ * - clear
+ * - size
+ * - reserve
+ * - to_str_custom (takes user-supplied key and value conversion functions)
+ * - to_str (requires registration via CLIP_REGISTER_HASHMAP_PRINT)
+ * - write_custom / write (stream into a `CLIP_StrBuf`, same text as to_str)
+ * - free
+ * - for_each (lets you apply a function over the map entries)
+ */
+#ifndef CLIP_HASHMAP_H
+#define CLIP_HASHMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/StrBuf.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Number of control bytes probed at once. */
+#define CLIP_HASHMAP_GROUP_WIDTH 16
+
+/* Control byte states. A full slot stores the low 7 bits of its hash (0..127). */
+#define CLIP_HASHMAP_CTRL_EMPTY ((int8_t)-128)
+#define CLIP_HASHMAP_CTRL_DELETED ((int8_t)-2)
+
+/* --- Hash helpers --- */
+
+/**
+ * @brief Finalizer that spreads the entropy of a 64-bit value over all its bits.
+ */
+static inline uint64_t clip_hash_u64(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+/**
+ * @brief Hash an arbitrary byte range (8 bytes per step).
+ */
+static inline uint64_t clip_hash_bytes(const void *data, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  uint64_t h = 0x9e3779b97f4a7c15ULL ^ (len * 0x100000001b3ULL);
+  while (len >= 8)
+  {
+    uint64_t chunk;
+    memcpy(&chunk, p, 8);
+    h = (h ^ chunk) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+    p += 8;
+    len -= 8;
+  }
+  uint64_t tail = 0;
+  for (size_t i = 0; i < len; i++)
+    tail |= (uint64_t)p[i] << (8 * i);
+  h = (h ^ tail) * 0x9e3779b97f4a7c15ULL;
+  return clip_hash_u64(h);
+}
+
+/**
+ * @brief Ready-made hash/equality functions for common key types.
+ */
+static inline uint64_t clip_hash_int(const int *key) { return clip_hash_u64((uint64_t)(int64_t)*key); }
+static inline bool clip_eq_int(const int *a, const int *b) { return *a == *b; }
+static inline uint64_t clip_hash_cstr(const char *const *key) { return clip_hash_bytes(*key, strlen(*key)); }
+static inline bool clip_eq_cstr(const char *const *a, const char *const *b) { return strcmp(*a, *b) == 0; }
+
+/* --- Control-group probing --- */
+
+/**
+ * @brief Returns a bitmask with bit `i` set when `group[i] == tag`.
+ */
+static inline uint32_t clip_hashmap_group_match(const int8_t *group, int8_t tag)
+{
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < CLIP_HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] == tag) << i;
+  return mask;
+#endif
+}
+
+/**
+ * @brief Returns a bitmask of the slots in the group that are empty or deleted.
+ */
+static inline uint32_t clip_hashmap_group_match_free(const int8_t *group)
+{
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+#else
+  uint32_t mask = 0;
+  for (int i = 0; i < CLIP_HASHMAP_GROUP_WIDTH; i++)
+    mask |= (uint32_t)(group[i] < -1) << i;
+  return mask;
+#endif
+}
+
+/**
+ * @brief Maximum number of live + deleted slots for a given capacity (7/8 load factor).
+ */
+static inline clip_size_t clip_hashmap_max_load(clip_size_t capacity)
+{
+  return capacity - capacity / 8;
+}
+
+/**
+ * @brief Next (doubled) capacity for a table of `slot_size` slots, or -1 if it cannot be represented.
+ */
+static inline clip_size_t clip_hashmap_grow_capacity(clip_size_t capacity, size_t slot_size)
+{
+  clip_size_t max = clip_max_capacity(slot_size);
+  if (max > CLIP_SIZE_MAX - CLIP_HASHMAP_GROUP_WIDTH)
+    max = CLIP_SIZE_MAX - CLIP_HASHMAP_GROUP_WIDTH;
+  return capacity <= max / 2 ? capacity * 2 : -1;
+}
+
+/**
+ * @brief Writes a control byte, keeping the cloned tail (used by unaligned group loads) in sync.
+ */
+static inline void clip_hashmap_set_ctrl(int8_t *ctrl, clip_size_t capacity, clip_size_t index, int8_t value)
+{
+  ctrl[index] = value;
+  ctrl[((index - (CLIP_HASHMAP_GROUP_WIDTH - 1)) & (capacity - 1)) + (CLIP_HASHMAP_GROUP_WIDTH - 1)] = value;
+}
+
+/**
+ * @brief Define a type-safe, flat open-addressing hash map for given key-value types.
+ *
+ * This macro generates:
+ * - A typedef `HashMap_<KeyType>_<ValueType>` structure containing the control bytes,
+ *   the slot array, the capacity and the size.
+ * - A set of **static inline functions** specialized for `<KeyType, ValueType>`:
+ *
+ * Requirements:
+ * - User provides a hash function for keys:
+ *      uint64_t hash(const KeyType* key)
+ * - User provides an equality function for keys:
+ *      bool eq(const KeyType* a, const KeyType* b)
+ *
+ * @param KeyType The key type (e.g., `int`, `string`, `struct Foo`).
+ * @param ValueType The value type (e.g., `int`, `string`, `struct Bar`).
+ * @param HashFunc The hash function for the key type.
+ * @param EqFunc The equality function for the key type.
+ * @param KEY_FREE_FN Free function for the key type
+ * @param VALUE_FREE_FN Free function for the value type
+ * @param BUF_SIZE Optional: Buffer size allocated per element for string conversion. Default is 256.
+ */
+#define CLIP_DEFINE_HASHMAP_TYPE(...) \
+  CLIP_DEFINE_HASHMAP_TYPE_IMPL(__VA_ARGS__, NULL, NULL, 256)
+
+#define CLIP_DEFINE_HASHMAP_TYPE_WITH_FREE(KeyType, ValueType, HashFunc, EqFunc, KEY_FREE_FN, VALUE_FREE_FN) \
+  CLIP_DEFINE_HASHMAP_TYPE_IMPL(KeyType, ValueType, HashFunc, EqFunc, KEY_FREE_FN, VALUE_FREE_FN, 256)
+
+#define CLIP_DEFINE_HASHMAP_TYPE_FULL(KeyType, ValueType, HashFunc, EqFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE) \
+  CLIP_DEFINE_HASHMAP_TYPE_IMPL(KeyType, ValueType, HashFunc, EqFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE)
+
+/**
+ * @brief Implementation of `CLIP_DEFINE_HASHMAP_TYPE`.
+ *
+ * @param KeyType The key type
+ * @param ValueType The value type
+ * @param HashFunc The hash function for keys
+ * @param EqFunc The equality function for keys
+ * @param KEY_FREE_FN Destructor for keys (or NULL)
+ * @param VALUE_FREE_FN Destructor for values (or NULL)
+ * @param BUF_SIZE The buffer size
+ */
+#define CLIP_DEFINE_HASHMAP_TYPE_IMPL(KeyType, ValueType, HashFunc, EqFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE, ...)  \
+  typedef struct                                                                                                        \
+  {                                                                                                                     \
+    KeyType key;                                                                                                        \
+    ValueType value;                                                                                                    \
+  } HashMapSlot_##KeyType##_##ValueType;                                                                                \
+                                                                                                                        \
+  typedef struct                                                                                                        \
+  {                                                                                                                     \
+    int8_t *ctrl; /* capacity + GROUP_WIDTH control bytes */                                                            \
+    HashMapSlot_##KeyType##_##ValueType *slots;                                                                         \
+    clip_size_t capacity;    /* 0 or a power of two >= GROUP_WIDTH */                                                   \
+    clip_size_t size;        /* Number of live entries */                                                               \
+    clip_size_t growth_left; /* Inserts into empty slots left before a rehash */                                        \
+    const CLIP_Allocator *allocator; /* NULL for the default allocator */                                               \
+  } HashMap_##KeyType##_##ValueType;                                                                                    \
+                                                                                                                        \
+  static inline HashMap_##KeyType##_##ValueType init_hashmap_##KeyType##_##ValueType()                                  \
+  {                                                                                                                     \
+    HashMap_##KeyType##_##ValueType map = {0};                                                                          \
+    return map;                                                                                                         \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline HashMap_##KeyType##_##ValueType init_hashmap_with_allocator_##KeyType##_##ValueType(                    \
+      const CLIP_Allocator *allocator)                                                                                  \
+  {                                                                                                                     \
+    HashMap_##KeyType##_##ValueType map = {0};                                                                          \
+    map.allocator = allocator;                                                                                          \
+    return map;                                                                                                         \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline clip_size_t hashmap_find_##KeyType##_##ValueType(const HashMap_##KeyType##_##ValueType *map,            \
+                                                           const KeyType *key, uint64_t hash)                           \
+  {                                                                                                                     \
+    if (map->capacity == 0)                                                                                             \
+      return -1;                                                                                                        \
+    size_t mask = (size_t)map->capacity - 1;                                                                            \
+    size_t pos = (size_t)(hash >> 7) & mask;                                                                            \
+    size_t stride = 0;                                                                                                  \
+    int8_t tag = (int8_t)(hash & 0x7f);                                                                                 \
+    for (;;)                                                                                                            \
+    {                                                                                                                   \
+      const int8_t *group = map->ctrl + pos;                                                                            \
+      uint32_t match = clip_hashmap_group_match(group, tag);                                                            \
+      while (match)                                                                                                     \
+      {                                                                                                                 \
+        size_t index = (pos + (size_t)__builtin_ctz(match)) & mask;                                                     \
+        if (EqFunc(&map->slots[index].key, key))                                                                        \
+          return (clip_size_t)index;                                                                                    \
+        match &= match - 1;                                                                                             \
+      }                                                                                                                 \
+      if (clip_hashmap_group_match(group, CLIP_HASHMAP_CTRL_EMPTY))                                                     \
+        return -1;                                                                                                      \
+      stride += CLIP_HASHMAP_GROUP_WIDTH;                                                                               \
+      pos = (pos + stride) & mask;                                                                                      \
+    }                                                                                                                   \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline clip_size_t hashmap_find_free_##KeyType##_##ValueType(const HashMap_##KeyType##_##ValueType *map,       \
+                                                                uint64_t hash)                                          \
+  {                                                                                                                     \
+    size_t mask = (size_t)map->capacity - 1;                                                                            \
+    size_t pos = (size_t)(hash >> 7) & mask;                                                                            \
+    size_t stride = 0;                                                                                                  \
+    for (;;)                                                                                                            \
+    {                                                                                                                   \
+      uint32_t match = clip_hashmap_group_match_free(map->ctrl + pos);                                                  \
+      if (match)                                                                                                        \
+        return (clip_size_t)((pos + (size_t)__builtin_ctz(match)) & mask);                                              \
+      stride += CLIP_HASHMAP_GROUP_WIDTH;                                                                               \
+      pos = (pos + stride) & mask;                                                                                      \
+    }                                                                                                                   \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline void hashmap_rehash_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map,                       \
+                                                              clip_size_t new_capacity)                                 \
+  {                                                                                                                     \
+    int8_t *new_ctrl = (int8_t *)clip_alloc(map->allocator, (size_t)new_capacity + CLIP_HASHMAP_GROUP_WIDTH);           \
+    HashMapSlot_##KeyType##_##ValueType *new_slots = (HashMapSlot_##KeyType##_##ValueType *)clip_alloc(                 \
+        map->allocator, (size_t)new_capacity * sizeof(HashMapSlot_##KeyType##_##ValueType));                            \
+    if (!new_ctrl || !new_slots)                                                                                        \
+    {                                                                                                                   \
+      fprintf(stderr, "Memory allocation failed!\n");                                                                   \
+      exit(EXIT_FAILURE);                                                                                               \
+    }                                                                                                                   \
+    memset(new_ctrl, (unsigned char)CLIP_HASHMAP_CTRL_EMPTY, (size_t)new_capacity + CLIP_HASHMAP_GROUP_WIDTH);          \
+                                                                                                                        \
+    HashMap_##KeyType##_##ValueType old = *map;                                                                         \
+    map->ctrl = new_ctrl;                                                                                               \
+    map->slots = new_slots;                                                                                             \
+    map->capacity = new_capacity;                                                                                       \
+    map->growth_left = clip_hashmap_max_load(new_capacity) - map->size;                                                 \
+                                                                                                                        \
+    for (clip_size_t i = 0; i < old.capacity; i++)                                                                      \
+    {                                                                                                                   \
+      if (old.ctrl[i] < 0)                                                                                              \
+        continue;                                                                                                       \
+      uint64_t hash = HashFunc(&old.slots[i].key);                                                                      \
+      clip_size_t index = hashmap_find_free_##KeyType##_##ValueType(map, hash);                                         \
+      clip_hashmap_set_ctrl(map->ctrl, new_capacity, index, (int8_t)(hash & 0x7f));                                     \
+      map->slots[index] = old.slots[i];                                                                                 \
+    }                                                                                                                   \
+    clip_free(map->allocator, old.ctrl, (size_t)old.capacity + CLIP_HASHMAP_GROUP_WIDTH);                               \
+    clip_free(map->allocator, old.slots, (size_t)old.capacity * sizeof(HashMapSlot_##KeyType##_##ValueType));           \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_reserve_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map, clip_size_t count)   \
+  {                                                                                                                     \
+    clip_size_t capacity = map->capacity ? map->capacity : CLIP_HASHMAP_GROUP_WIDTH;                                    \
+    while (clip_hashmap_max_load(capacity) < count)                                                                     \
+    {                                                                                                                   \
+      capacity = clip_hashmap_grow_capacity(capacity, sizeof(HashMapSlot_##KeyType##_##ValueType));                     \
+      if (capacity < 0)                                                                                                 \
+        return false;                                                                                                   \
+    }                                                                                                                   \
+    if (capacity > map->capacity)                                                                                       \
+      hashmap_rehash_##KeyType##_##ValueType(map, capacity);                                                            \
+    return true;                                                                                                        \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_insert_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map,                       \
+                                                              KeyType key, ValueType value)                             \
+  {                                                                                                                     \
+    uint64_t hash = HashFunc(&key);                                                                                     \
+    clip_size_t index = hashmap_find_##KeyType##_##ValueType(map, &key, hash);                                          \
+    if (index >= 0)                                                                                                     \
+    {                                                                                                                   \
+      map->slots[index].value = value; /* update existing value */                                                      \
+      return false;                    /* indicate no new entry was added */                                            \
+    }                                                                                                                   \
+    if (map->growth_left == 0)                                                                                          \
+    {                                                                                                                   \
+      /* Mostly tombstones: rebuild in place. Otherwise grow. */                                                        \
+      if (map->capacity && map->size <= clip_hashmap_max_load(map->capacity) / 2)                                       \
+        hashmap_rehash_##KeyType##_##ValueType(map, map->capacity);                                                     \
+      else                                                                                                              \
+      {                                                                                                                 \
+        clip_size_t capacity = map->capacity ? clip_hashmap_grow_capacity(                                              \
+                                                   map->capacity, sizeof(HashMapSlot_##KeyType##_##ValueType))          \
+                                             : CLIP_HASHMAP_GROUP_WIDTH;                                                \
+        if (capacity < 0)                                                                                               \
+        {                                                                                                               \
+          fprintf(stderr, "HashMap capacity overflow!\n");                                                              \
+          exit(EXIT_FAILURE);                                                                                           \
+        }                                                                                                               \
+        hashmap_rehash_##KeyType##_##ValueType(map, capacity);                                                          \
+      }                                                                                                                 \
+    }                                                                                                                   \
+    index = hashmap_find_free_##KeyType##_##ValueType(map, hash);                                                       \
+    if (map->ctrl[index] == CLIP_HASHMAP_CTRL_EMPTY)                                                                    \
+      map->growth_left--;                                                                                               \
+    clip_hashmap_set_ctrl(map->ctrl, map->capacity, index, (int8_t)(hash & 0x7f));                                      \
+    map->slots[index].key = key;                                                                                        \
+    map->slots[index].value = value;                                                                                    \
+    map->size++;                                                                                                        \
+    return true;                                                                                                        \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_contains_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map, KeyType key)        \
+  {                                                                                                                     \
+    return hashmap_find_##KeyType##_##ValueType(map, &key, HashFunc(&key)) >= 0;                                        \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline ValueType *hashmap_get_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map, KeyType key)       \
+  {                                                                                                                     \
+    clip_size_t index = hashmap_find_##KeyType##_##ValueType(map, &key, HashFunc(&key));                                \
+    return index >= 0 ? &map->slots[index].value : NULL;                                                                \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_remove_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map, KeyType key)          \
+  {                                                                                                                     \
+    clip_size_t index = hashmap_find_##KeyType##_##ValueType(map, &key, HashFunc(&key));                                \
+    if (index < 0)                                                                                                      \
+      return false;                                                                                                     \
+    /* If no probe sequence can have walked past this slot while the group was full, */                                 \
+    /* it can go straight back to EMPTY instead of becoming a tombstone. */                                             \
+    clip_size_t before = (index - CLIP_HASHMAP_GROUP_WIDTH) & (map->capacity - 1);                                      \
+    uint32_t empty_after = clip_hashmap_group_match(map->ctrl + index, CLIP_HASHMAP_CTRL_EMPTY);                        \
+    uint32_t empty_before = clip_hashmap_group_match(map->ctrl + before, CLIP_HASHMAP_CTRL_EMPTY);                      \
+    bool was_never_full = empty_before && empty_after &&                                                                \
+                          (__builtin_ctz(empty_after) + (__builtin_clz(empty_before) - 16)) < CLIP_HASHMAP_GROUP_WIDTH; \
+    clip_hashmap_set_ctrl(map->ctrl, map->capacity, index,                                                              \
+                          was_never_full ? CLIP_HASHMAP_CTRL_EMPTY : CLIP_HASHMAP_CTRL_DELETED);                        \
+    if (was_never_full)                                                                                                 \
+      map->growth_left++;                                                                                               \
+    map->size--;                                                                                                        \
+    return true;                                                                                                        \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline clip_size_t hashmap_size_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map)                  \
+  {                                                                                                                     \
+    return map->size;                                                                                                   \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_empty_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map)                        \
+  {                                                                                                                     \
+    return map->size == 0;                                                                                              \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline void hashmap_clear_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map)                        \
+  {                                                                                                                     \
+    void (*KeyDtor)(KeyType *) = KEY_FREE_FN;                                                                           \
+    void (*ValDtor)(ValueType *) = VALUE_FREE_FN;                                                                       \
+    if (KeyDtor || ValDtor)                                                                                             \
+    {                                                                                                                   \
+      for (clip_size_t i = 0; i < map->capacity; i++)                                                                   \
+      {                                                                                                                 \
+        if (map->ctrl[i] < 0)                                                                                           \
+          continue;                                                                                                     \
+        if (KeyDtor)                                                                                                    \
+          KeyDtor(&map->slots[i].key);                                                                                  \
+        if (ValDtor)                                                                                                    \
+          ValDtor(&map->slots[i].value);                                                                                \
+      }                                                                                                                 \
+    }                                                                                                                   \
+    if (map->capacity)                                                                                                  \
+    {                                                                                                                   \
+      memset(map->ctrl, (unsigned char)CLIP_HASHMAP_CTRL_EMPTY, (size_t)map->capacity + CLIP_HASHMAP_GROUP_WIDTH);      \
+      map->growth_left = clip_hashmap_max_load(map->capacity);                                                          \
+    }                                                                                                                   \
+    map->size = 0;                                                                                                      \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline void free_hashmap_##KeyType##_##ValueType(HashMap_##KeyType##_##ValueType *map)                         \
+  {                                                                                                                     \
+    hashmap_clear_##KeyType##_##ValueType(map);                                                                         \
+    clip_free(map->allocator, map->ctrl, (size_t)map->capacity + CLIP_HASHMAP_GROUP_WIDTH);                             \
+    clip_free(map->allocator, map->slots, (size_t)map->capacity * sizeof(HashMapSlot_##KeyType##_##ValueType));         \
+    map->ctrl = NULL;                                                                                                   \
+    map->slots = NULL;                                                                                                  \
+    map->capacity = 0;                                                                                                  \
+    map->growth_left = 0;                                                                                               \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline bool hashmap_write_##KeyType##_##ValueType##_custom(HashMap_##KeyType##_##ValueType *map,               \
+                                                                    CLIP_StrBuf *out,                                   \
+                                                                    void (*key_to_str)(KeyType, char *, size_t),        \
+                                                                    void (*val_to_str)(ValueType, char *, size_t))      \
+  {                                                                                                                     \
+    if (!map || !clip_strbuf_putc(out, '{'))                                                                            \
+      return false;                                                                                                     \
+    bool is_first = true;                                                                                               \
+    for (clip_size_t i = 0; i < map->capacity; i++)                                                                     \
+    {                                                                                                                   \
+      if (map->ctrl[i] < 0)                                                                                             \
+        continue;                                                                                                       \
+      if (!clip_strbuf_puts(out, is_first ? "{" : ", {"))                                                               \
+        return false;                                                                                                   \
+      char *key = clip_strbuf_reserve(out, BUF_SIZE);                                                                   \
+      if (!key)                                                                                                         \
+        return false;                                                                                                   \
+      key[0] = '\0';                                                                                                    \
+      key_to_str(map->slots[i].key, key, BUF_SIZE);                                                                     \
+      clip_strbuf_commit_str(out, BUF_SIZE);                                                                            \
+      if (!clip_strbuf_append(out, " : ", 3))                                                                           \
+        return false;                                                                                                   \
+      char *val = clip_strbuf_reserve(out, BUF_SIZE);                                                                   \
+      if (!val)                                                                                                         \
+        return false;                                                                                                   \
+      val[0] = '\0';                                                                                                    \
+      val_to_str(map->slots[i].value, val, BUF_SIZE);                                                                   \
+      clip_strbuf_commit_str(out, BUF_SIZE);                                                                            \
+      if (!clip_strbuf_putc(out, '}'))                                                                                  \
+        return false;                                                                                                   \
+      is_first = false;                                                                                                 \
+    }                                                                                                                   \
+    return clip_strbuf_putc(out, '}');                                                                                  \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline char *hashmap_to_str_##KeyType##_##ValueType##_custom(HashMap_##KeyType##_##ValueType *map,             \
+                                                                      void (*key_to_str)(KeyType, char *, size_t),      \
+                                                                      void (*val_to_str)(ValueType, char *, size_t))    \
+  {                                                                                                                     \
+    if (!map)                                                                                                           \
+      return NULL;                                                                                                      \
+    CLIP_StrBuf out;                                                                                                    \
+    clip_strbuf_init(&out);                                                                                             \
+    hashmap_write_##KeyType##_##ValueType##_custom(map, &out, key_to_str, val_to_str);                                  \
+    return clip_strbuf_detach(&out);                                                                                    \
+  }                                                                                                                     \
+                                                                                                                        \
+  static inline void hashmap_foreach_##KeyType##_##ValueType(                                                           \
+      HashMap_##KeyType##_##ValueType *map,                                                                             \
+      void (*fn)(KeyType * key, ValueType * val, void *userdata),                                                       \
+      void *userdata)                                                                                                   \
+  {                                                                                                                     \
+    for (clip_size_t i = 0; i < map->capacity; i++)                                                                     \
+    {                                                                                                                   \
+      if (map->ctrl[i] >= 0)                                                                                            \
+        fn(&map->slots[i].key, &map->slots[i].value, userdata);                                                         \
+    }                                                                                                                   \
+  }
+
+#define CLIP_REGISTER_HASHMAP_PRINT(KeyType, ValueType, key_fn, val_fn)                                                   \
+  static inline bool hashmap_write_##KeyType##_##ValueType##_main(HashMap_##KeyType##_##ValueType *map, CLIP_StrBuf *out) \
+  {                                                                                                                       \
+    return hashmap_write_##KeyType##_##ValueType##_custom(map, out, key_fn, val_fn);                                      \
+  }                                                                                                                       \
+                                                                                                                          \
+  static inline char *hashmap_to_str_##KeyType##_##ValueType##_main(HashMap_##KeyType##_##ValueType *map)                 \
+  {                                                                                                                       \
+    return hashmap_to_str_##KeyType##_##ValueType##_custom(map, key_fn, val_fn);                                          \
+  }
+
+#define HashMap(KeyType, ValueType) HashMap_##KeyType##_##ValueType
+#define HashMap_init(KeyType, ValueType) init_hashmap_##KeyType##_##ValueType()
+#define HashMap_init_with_allocator(KeyType, ValueType, allocator) init_hashmap_with_allocator_##KeyType##_##ValueType(allocator)
+#define HashMap_insert(KeyType, ValueType, map, key, val) hashmap_insert_##KeyType##_##ValueType(map, key, val)
+#define HashMap_get(KeyType, ValueType, map, key) hashmap_get_##KeyType##_##ValueType(map, key)
+#define HashMap_contains(KeyType, ValueType, map, key) hashmap_contains_##KeyType##_##ValueType(map, key)
+#define HashMap_to_str(KeyType, ValueType, map) hashmap_to_str_##KeyType##_##ValueType##_main(map)
+#define HashMap_to_str_custom(KeyType, ValueType, map, keyfn, valfn) hashmap_to_str_##KeyType##_##ValueType##_custom(map, keyfn, valfn)
+#define HashMap_write(KeyType, ValueType, map, out) hashmap_write_##KeyType##_##ValueType##_main(map, out)
+#define HashMap_write_custom(KeyType, ValueType, map, out, keyfn, valfn) hashmap_write_##KeyType##_##ValueType##_custom(map, out, keyfn, valfn)
+#define HashMap_remove(KeyType, ValueType, map, key) hashmap_remove_##KeyType##_##ValueType(map, key)
+#define HashMap_size(KeyType, ValueType, map) hashmap_size_##KeyType##_##ValueType(map)
+#define HashMap_empty(KeyType, ValueType, map) hashmap_empty_##KeyType##_##ValueType(map)
+#define HashMap_clear(KeyType, ValueType, map) hashmap_clear_##KeyType##_##ValueType(map)
+#define HashMap_reserve(KeyType, ValueType, map, n) hashmap_reserve_##KeyType##_##ValueType(map, n)
+#define HashMap_free(KeyType, ValueType, map) free_hashmap_##KeyType##_##ValueType(map)
+#define HashMap_foreach(KeyType, ValueType, map, fn, userdata) hashmap_foreach_##KeyType##_##ValueType(map, fn, userdata)
+
+#define HashMap_fprint(KeyType, ValueType, map, file) \
+  do                                                  \
+  {                                                   \
+    CLIP_StrBuf _out;                                 \
+    clip_strbuf_init_file(&_out, file);               \
+    HashMap_write(KeyType, ValueType, map, &_out);    \
+    clip_strbuf_free(&_out);                          \
+  } while (0)
+
+#define HashMap_print(KeyType, ValueType, map) HashMap_fprint(KeyType, ValueType, map, stdout)
+
+#define HashMap_println(KeyType, ValueType, map) \
+  do                                             \
+  {                                              \
+    HashMap_print(KeyType, ValueType, map);      \
+    printf("\n");                                \
+  } while (0)
+
+#endif /* CLIP_HASHMAP_H */
@@ -13,6 +13,7 @@
  *
  * The following methods are generated automatically:
  * - init
+ * - init_with_allocator
  * - init_from_array
  * - ensure_capacity
  * - append
@@ -27,10 +28,14 @@
  * - clear
  * - reserve
  * - shrink_to_fit
+ * - write (streams into a `CLIP_StrBuf`, requires registration via CLIP_REGISTER_LIST_PRINT)
+ * - write_custom (takes a user-supplied function)
  * - to_str (requires registration via CLIP_REGISTER_LIST_PRINT)
  * - to_str_custom (takes a user-supplied function)
  * - reverse
- * - sort
+ * - sort (pdqsort specialized per type, see `Sort.h`)
+ * - stable_sort (timsort)
+ * - radix_sort
  * - merge
  * - free
  */
@@ -42,6 +47,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/Sort.h>
+#include <CLIP/StrBuf.h>
+
 /**
  * @brief Define a type-safe dynamic list for the given element type.
  *
@@ -139,14 +149,22 @@
   typedef struct                                                                  \
   {                                                                               \
     Type *data;                                                                   \
-    int size;                                                                     \
-    int capacity;                                                                 \
+    clip_size_t size;                                                             \
+    clip_size_t capacity;                                                         \
+    const CLIP_Allocator *allocator; /* NULL for the default allocator */         \
   } List_##Type;                                                                  \
                                                                                   \
-  static inline List_##Type init_list_##Type(int capacity)                        \
+  static inline List_##Type init_list_with_allocator_##Type(                      \
+      clip_size_t capacity, const CLIP_Allocator *allocator)                      \
   {                                                                               \
     List_##Type list;                                                             \
-    list.data = malloc(capacity * sizeof(Type));                                  \
+    size_t bytes;                                                                 \
+    if (capacity < 0 || !clip_size_mul((size_t)capacity, sizeof(Type), &bytes))   \
+    {                                                                             \
+      fprintf(stderr, "Invalid list capacity!\n");                                \
+      exit(EXIT_FAILURE);                                                         \
+    }                                                                             \
+    list.data = clip_alloc(allocator, bytes);                                     \
     if (!list.data)                                                               \
     {                                                                             \
       fprintf(stderr, "Memory allocation failed!\n");                             \
@@ -154,34 +172,52 @@
     }                                                                             \
     list.size = 0;                                                                \
     list.capacity = capacity;                                                     \
+    list.allocator = allocator;                                                   \
     return list;                                                                  \
   }                                                                               \
                                                                                   \
+  static inline List_##Type init_list_##Type(clip_size_t capacity)                \
+  {                                                                               \
+    return init_list_with_allocator_##Type(capacity, NULL);                       \
+  }                                                                               \
+                                                                                  \
   static inline List_##Type init_list_from_array_##Type(const Type *arr,          \
-                                                        int n)                    \
+                                                        clip_size_t n)            \
   {                                                                               \
     List_##Type list;                                                             \
-    list.data = malloc(n * sizeof(Type));                                         \
+    size_t bytes;                                                                 \
+    if (n < 0 || !clip_size_mul((size_t)n, sizeof(Type), &bytes))                 \
+    {                                                                             \
+      fprintf(stderr, "Invalid list capacity!\n");                                \
+      exit(EXIT_FAILURE);                                                         \
+    }                                                                             \
+    list.data = clip_alloc(NULL, bytes);                                          \
     if (!list.data && n > 0)                                                      \
     {                                                                             \
       fprintf(stderr, "Memory allocation failed!\n");                             \
       exit(EXIT_FAILURE);                                                         \
     }                                                                             \
-    memcpy(list.data, arr, n * sizeof(Type));                                     \
+    memcpy(list.data, arr, bytes);                                                \
     list.size = n;                                                                \
     list.capacity = n;                                                            \
+    list.allocator = NULL;                                                        \
     return list;                                                                  \
   }                                                                               \
                                                                                   \
   static inline bool list_ensure_capacity_##Type(List_##Type *list,               \
-                                                 int needed)                      \
+                                                 clip_size_t needed)              \
   {                                                                               \
+    if (needed > CLIP_SIZE_MAX - list->size)                                      \
+      return false;                                                               \
     if (list->size + needed > list->capacity)                                     \
     {                                                                             \
-      int new_capacity = list->capacity ? list->capacity * 2 : 1;                 \
-      while (new_capacity < list->size + needed)                                  \
-        new_capacity *= 2;                                                        \
-      Type *new_data = realloc(list->data, new_capacity * sizeof(Type));          \
+      clip_size_t new_capacity = clip_grow_capacity(                              \
+          list->capacity, list->size + needed, sizeof(Type));                     \
+      if (new_capacity < 0)                                                       \
+        return false;                                                             \
+      Type *new_data = clip_realloc(list->allocator, list->data,                  \
+                                    (size_t)list->capacity * sizeof(Type),        \
+                                    (size_t)new_capacity * sizeof(Type));         \
       if (!new_data)                                                              \
         return false;                                                             \
       list->data = new_data;                                                      \
@@ -208,7 +244,7 @@
     return true;                                                                  \
   }                                                                               \
                                                                                   \
-  static inline bool list_replace_##Type(List_##Type *list, int index,            \
+  static inline bool list_replace_##Type(List_##Type *list, clip_size_t index,    \
                                          Type value)                              \
   {                                                                               \
     if (index < 0 || index >= list->size)                                         \
@@ -217,7 +253,8 @@
     return true;                                                                  \
   }                                                                               \
                                                                                   \
-  static inline bool list_insert_##Type(List_##Type *list, int index, Type value) \
+  static inline bool list_insert_##Type(List_##Type *list, clip_size_t index,     \
+                                        Type value)                               \
   {                                                                               \
     if (index < 0 || index > list->size)                                          \
       return false;                                                               \
@@ -231,7 +268,7 @@
   }                                                                               \
                                                                                   \
   static inline Type                                                              \
-  list_get_##Type(List_##Type *list, int index)                                   \
+  list_get_##Type(List_##Type *list, clip_size_t index)                           \
   {                                                                               \
     if (index < 0 || index >= list->size)                                         \
     {                                                                             \
@@ -241,7 +278,7 @@
     return list->data[index];                                                     \
   }                                                                               \
                                                                                   \
-  static inline Type *list_get_ptr_##Type(List_##Type *list, int index)           \
+  static inline Type *list_get_ptr_##Type(List_##Type *list, clip_size_t index)   \
   {                                                                               \
     if (index < 0 || index >= list->size)                                         \
     {                                                                             \
@@ -251,17 +288,17 @@
     return &list->data[index];                                                    \
   }                                                                               \
                                                                                   \
-  static inline Type list_at_##Type(List_##Type *list, int index)                 \
+  static inline Type list_at_##Type(List_##Type *list, clip_size_t index)         \
   {                                                                               \
     return list->data[index];                                                     \
   }                                                                               \
                                                                                   \
-  static inline Type *list_at_ptr_##Type(List_##Type *list, int index)            \
+  static inline Type *list_at_ptr_##Type(List_##Type *list, clip_size_t index)    \
   {                                                                               \
     return &list->data[index];                                                    \
   }                                                                               \
                                                                                   \
-  static inline bool list_remove_at_##Type(List_##Type *list, int index)          \
+  static inline bool list_remove_at_##Type(List_##Type *list, clip_size_t index)  \
   {                                                                               \
     if (index < 0 || index >= list->size)                                         \
       return false;                                                               \
@@ -273,11 +310,16 @@
                                                                                   \
   static inline void list_clear_##Type(List_##Type *list) { list->size = 0; }     \
                                                                                   \
-  static inline bool list_reserve_##Type(List_##Type *list, int capacity)         \
+  static inline bool list_reserve_##Type(List_##Type *list,                       \
+                                         clip_size_t capacity)                    \
   {                                                                               \
     if (capacity <= list->capacity)                                               \
       return true;                                                                \
-    Type *new_data = realloc(list->data, capacity * sizeof(Type));                \
+    if (capacity > clip_max_capacity(sizeof(Type)))                               \
+      return false;                                                               \
+    Type *new_data = clip_realloc(list->allocator, list->data,                    \
+                                  (size_t)list->capacity * sizeof(Type),          \
+                                  (size_t)capacity * sizeof(Type));               \
     if (!new_data)                                                                \
       return false;                                                               \
     list->data = new_data;                                                        \
@@ -289,7 +331,9 @@
   {                                                                               \
     if (list->size == list->capacity)                                             \
       return true;                                                                \
-    Type *new_data = realloc(list->data, list->size * sizeof(Type));              \
+    Type *new_data = clip_realloc(list->allocator, list->data,                    \
+                                  (size_t)list->capacity * sizeof(Type),          \
+                                  (size_t)list->size * sizeof(Type));             \
     if (!new_data && list->size > 0)                                              \
       return false;                                                               \
     list->data = new_data;                                                        \
@@ -297,33 +341,42 @@
     return true;                                                                  \
   }                                                                               \
                                                                                   \
+  static inline bool list_write_##Type##_custom(                                  \
+      List_##Type *list, CLIP_StrBuf *out,                                        \
+      void (*elem_to_str)(Type, char *, size_t))                                  \
+  {                                                                               \
+    if (!list || !clip_strbuf_putc(out, '['))                                     \
+      return false;                                                               \
+    for (clip_size_t i = 0; i < list->size; i++)                                  \
+    {                                                                             \
+      if (i > 0 && !clip_strbuf_append(out, ", ", 2))                             \
+        return false;                                                             \
+      char *elem = clip_strbuf_reserve(out, BUF_SIZE);                            \
+      if (!elem)                                                                  \
+        return false;                                                             \
+      elem[0] = '\0';                                                             \
+      elem_to_str(list->data[i], elem, BUF_SIZE);                                 \
+      clip_strbuf_commit_str(out, BUF_SIZE);                                      \
+    }                                                                             \
+    return clip_strbuf_putc(out, ']');                                            \
+  }                                                                               \
+                                                                                  \
   static inline char *list_to_str_##Type##_custom(                                \
       List_##Type *list, void (*elem_to_str)(Type, char *, size_t))               \
   {                                                                               \
     if (!list)                                                                    \
       return NULL;                                                                \
-    size_t bufsize = list->size * BUF_SIZE + 2;                                   \
-    char *buffer = malloc(bufsize);                                               \
-    if (!buffer)                                                                  \
-      return NULL;                                                                \
-    strcpy(buffer, "[");                                                          \
-    char elem[BUF_SIZE];                                                          \
-    for (int i = 0; i < list->size; i++)                                          \
-    {                                                                             \
-      elem_to_str(list->data[i], elem, sizeof(elem));                             \
-      strcat(buffer, elem);                                                       \
-      if (i < list->size - 1)                                                     \
-        strcat(buffer, ", ");                                                     \
-    }                                                                             \
-    strcat(buffer, "]");                                                          \
-    return buffer;                                                                \
+    CLIP_StrBuf out;                                                              \
+    clip_strbuf_init(&out);                                                       \
+    list_write_##Type##_custom(list, &out, elem_to_str);                          \
+    return clip_strbuf_detach(&out);                                              \
   }                                                                               \
                                                                                   \
   static inline void list_reverse_##Type(List_##Type *list)                       \
   {                                                                               \
     if (list->size < 2)                                                           \
       return;                                                                     \
-    for (int i = 0; i < list->size / 2; i++)                                      \
+    for (clip_size_t i = 0; i < list->size / 2; i++)                              \
     {                                                                             \
       Type temp = list->data[i];                                                  \
       list->data[i] = list->data[list->size - 1 - i];                             \
@@ -331,6 +384,8 @@
     }                                                                             \
   }                                                                               \
                                                                                   \
+  CLIP_DEFINE_SORT(list_##Type, Type, comparator)                                 \
+                                                                                  \
   static inline bool                                                              \
   list_sort_##Type(                                                               \
       List_##Type *list, int (*comparator)(const Type *a, const Type *b))         \
@@ -339,12 +394,37 @@
     {                                                                             \
       return false;                                                               \
     }                                                                             \
-    if (list->size < 2)                                                           \
+    clip_sort_list_##Type(list->data, (size_t)list->size, comparator);            \
+    return true;                                                                  \
+  }                                                                               \
+                                                                                  \
+  CLIP_DEFINE_STABLE_SORT(list_##Type, Type, comparator)                          \
+                                                                                  \
+  static inline bool                                                              \
+  list_stable_sort_##Type(                                                        \
+      List_##Type *list, int (*comparator)(const Type *a, const Type *b))         \
+  {                                                                               \
+    if (!list || !list->data || !comparator)                                      \
     {                                                                             \
-      return true;                                                                \
+      return false;                                                               \
+    }                                                                             \
+    clip_stable_sort_with_allocator_list_##Type(list->data, (size_t)list->size,   \
+                                                comparator, list->allocator);     \
+    return true;                                                                  \
+  }                                                                               \
+                                                                                  \
+  CLIP_DEFINE_RADIX_SORT(list_##Type, Type)                                       \
+                                                                                  \
+  static inline bool                                                              \
+  list_radix_sort_##Type(List_##Type *list, uint64_t (*key)(const Type *),        \
+                         CLIP_RadixScratch *scratch)                              \
+  {                                                                               \
+    if (!list || !list->data || !key)                                             \
+    {                                                                             \
+      return false;                                                               \
     }                                                                             \
-    qsort(list->data, list->size, sizeof(Type),                                   \
-          (int (*)(const void *, const void *))comparator);                       \
+    clip_radix_sort_with_allocator_list_##Type(list->data, (size_t)list->size,    \
+                                               key, scratch, list->allocator);    \
     return true;                                                                  \
   }                                                                               \
   static inline bool list_merge_##Type(List_##Type *dest,                         \
@@ -362,13 +442,14 @@
     void (*Dtor_fn)(Type *) = FREE_FN;                                            \
     if (Dtor_fn)                                                                  \
     {                                                                             \
-      for (int i = 0; i < list->size; i++)                                        \
+      for (clip_size_t i = 0; i < list->size; i++)                                \
       {                                                                           \
                                                                                   \
         (Dtor_fn)(&list->data[i]);                                                \
       }                                                                           \
     }                                                                             \
-    free(list->data);                                                             \
+    clip_free(list->allocator, list->data,                                        \
+              (size_t)list->capacity * sizeof(Type));                             \
     list->data = NULL;                                                            \
     list->size = 0;                                                               \
     list->capacity = 0;                                                           \
@@ -377,8 +458,8 @@
 /**
  * @brief Registers the default print function for a specific list type.
  *
- * This macro **defines** the `list_to_str_<Type>_main` function, which is used
- * by convenience macros like `List_to_str` and `List_print`.
+ * This macro **defines** the `list_write_<Type>_main` and `list_to_str_<Type>_main` functions,
+ * which are used by convenience macros like `List_write`, `List_to_str` and `List_print`.
  *
  * @param Type The element type for which to register the print function.
  * @param print_fn The function with signature: `void func(Type, char*, size_t)`.
@@ -401,15 +482,68 @@
  * List_print(int, &xs);  // Uses registered function!
  * ```
  */
-#define CLIP_REGISTER_LIST_PRINT(Type, print_fn)                             \
-  static inline char *list_to_str_##Type##_main(List_##Type *list)           \
-  {                                                                          \
-    if (!print_fn)                                                           \
-    {                                                                        \
-      fprintf(stderr, "No print function registered for type " #Type "!\n"); \
-      return NULL;                                                           \
-    }                                                                        \
-    return list_to_str_##Type##_custom(list, print_fn);                      \
+#define CLIP_REGISTER_LIST_PRINT(Type, print_fn)                                   \
+  static inline bool list_write_##Type##_main(List_##Type *list, CLIP_StrBuf *out) \
+  {                                                                                \
+    if (!print_fn)                                                                 \
+    {                                                                              \
+      fprintf(stderr, "No print function registered for type " #Type "!\n");       \
+      return false;                                                                \
+    }                                                                              \
+    return list_write_##Type##_custom(list, out, print_fn);                        \
+  }                                                                                \
+                                                                                   \
+  static inline char *list_to_str_##Type##_main(List_##Type *list)                 \
+  {                                                                                \
+    if (!print_fn)                                                                 \
+    {                                                                              \
+      fprintf(stderr, "No print function registered for type " #Type "!\n");       \
+      return NULL;                                                                 \
+    }                                                                              \
+    return list_to_str_##Type##_custom(list, print_fn);                            \
+  }
+
+/**
+ * @brief Defines a sort for a list type with the comparison fixed at compile time.
+ *
+ * This macro **defines** `list_sort_<Name>_<Type>` and `list_stable_sort_<Name>_<Type>`,
+ * used through `List_sort_by` and `List_stable_sort_by`.
+ * Unlike `List_sort`, whose comparator is a runtime function pointer, `CMP` is
+ * expanded directly inside the sorting loops, so it can be inlined (or be a
+ * function-like macro such as `CLIP_SORT_ASC`).
+ *
+ * @param Type The element type of the list.
+ * @param Name A name for this ordering (several orderings can coexist for one type).
+ * @param CMP Comparison called as `CMP(const Type *a, const Type *b)` returning <0, 0 or >0.
+ *
+ * Example:
+ * ```c
+ * CLIP_DEFINE_LIST_TYPE(int);
+ * CLIP_DEFINE_LIST_SORT(int, asc, CLIP_SORT_ASC);
+ *
+ * List_sort_by(int, asc, &xs);
+ * ```
+ */
+#define CLIP_DEFINE_LIST_SORT(Type, Name, CMP)                                   \
+  CLIP_DEFINE_SORT(list_##Name##_##Type, Type, CMP)                              \
+  CLIP_DEFINE_STABLE_SORT(list_##Name##_##Type, Type, CMP)                       \
+                                                                                 \
+  static inline bool list_sort_##Name##_##Type(List_##Type *list)                \
+  {                                                                              \
+    if (!list || !list->data)                                                    \
+      return false;                                                              \
+    clip_sort_list_##Name##_##Type(list->data, (size_t)list->size, NULL);        \
+    return true;                                                                 \
+  }                                                                              \
+                                                                                 \
+  static inline bool list_stable_sort_##Name##_##Type(List_##Type *list)         \
+  {                                                                              \
+    if (!list || !list->data)                                                    \
+      return false;                                                              \
+    clip_stable_sort_with_allocator_list_##Name##_##Type(list->data,             \
+                                                         (size_t)list->size,     \
+                                                         NULL, list->allocator); \
+    return true;                                                                 \
   }
 
 /**
@@ -429,6 +563,12 @@
  */
 #define List_init(Type, cap) init_list_##Type(cap)
 
+/**
+ * @def List_init_with_allocator(Type, cap, allocator)
+ * @brief Initialize a list whose storage comes from `allocator` (a `const CLIP_Allocator *`, NULL for the default).
+ */
+#define List_init_with_allocator(Type, cap, allocator) init_list_with_allocator_##Type(cap, allocator)
+
 /**
  * @def List_init_from_array(Type, arr, n)
  * @brief Initialize a list with elements copied from an existing C array.
@@ -471,7 +611,7 @@
  * ```
  */
 #define List_init_from_static_array(Type, arr) \
-  init_list_from_array_##Type((arr), (int)(sizeof(arr) / sizeof((arr)[0])))
+  init_list_from_array_##Type((arr), (clip_size_t)(sizeof(arr) / sizeof((arr)[0])))
 
 /**
  * @def List_append(Type, list, val)
@@ -653,6 +793,51 @@
  */
 #define List_to_str_custom(Type, list, fn) list_to_str_##Type##_custom(list, fn)
 
+/**
+ * @def List_write(Type, list, out)
+ * @brief Stream the list contents into the `CLIP_StrBuf` `out` using the registered
+ * print function. Produces the same text as `List_to_str` in linear time, without
+ * building the whole string first.
+ *
+ * @return false if the writer failed.
+ * @note You must call `CLIP_REGISTER_LIST_PRINT(Type, fn)` for this type first.
+ */
+#define List_write(Type, list, out) list_write_##Type##_main(list, out)
+
+/**
+ * @def List_write_custom(Type, list, out, fn)
+ * @brief Stream the list contents into `out` using a user-supplied
+ *        element-to-string function.
+ */
+#define List_write_custom(Type, list, out, fn) list_write_##Type##_custom(list, out, fn)
+
+/**
+ * @def List_fprint(Type, list, file)
+ * @brief Stream the list to a `FILE *` through a fixed-size buffer using the
+ * registered print function. (Does not print a trailing newline)
+ */
+#define List_fprint(Type, list, file)   \
+  do                                    \
+  {                                     \
+    CLIP_StrBuf _out;                   \
+    clip_strbuf_init_file(&_out, file); \
+    List_write(Type, list, &_out);      \
+    clip_strbuf_free(&_out);            \
+  } while (0)
+
+/**
+ * @def List_fprint_custom(Type, list, file, fn)
+ * @brief Stream the list to a `FILE *` using the given element-to-string function.
+ */
+#define List_fprint_custom(Type, list, file, fn) \
+  do                                             \
+  {                                              \
+    CLIP_StrBuf _out;                            \
+    clip_strbuf_init_file(&_out, file);          \
+    List_write_custom(Type, list, &_out, fn);    \
+    clip_strbuf_free(&_out);                     \
+  } while (0)
+
 /**
  * @def List_reverse(Type, list)
  * @brief Reverses the given list
@@ -662,10 +847,67 @@
 /**
  * @def List_sort(Type, list, cmp)
  * @brief Sorts the list in-place using the provided comparator function.
+ *
+ * Uses a pattern-defeating quicksort specialized for `Type` (not stable).
  * @return Returns `true` on success, `false` if the list or comparator is NULL.
  */
 #define List_sort(Type, list, cmp) list_sort_##Type(list, cmp)
 
+/**
+ * @def List_sort_by(Type, Name, list)
+ * @brief Sorts the list in-place with the ordering defined by `CLIP_DEFINE_LIST_SORT(Type, Name, CMP)`.
+ * @return Returns `true` on success, `false` if the list is NULL.
+ */
+#define List_sort_by(Type, Name, list) list_sort_##Name##_##Type(list)
+
+/**
+ * @def List_stable_sort(Type, list, cmp)
+ * @brief Sorts the list in-place keeping equal elements in their original order (timsort).
+ *
+ * Natural runs in the input are detected and merged with galloping merges, so
+ * nearly sorted lists or lists built by `List_merge` of sorted lists sort in close
+ * to linear time. Stability allows multi-key sorts: sort by the secondary key
+ * first, then stable sort by the primary key.
+ * @return Returns `true` on success, `false` if the list or comparator is NULL.
+ */
+#define List_stable_sort(Type, list, cmp) list_stable_sort_##Type(list, cmp)
+
+/**
+ * @def List_stable_sort_by(Type, Name, list)
+ * @brief Stable counterpart of `List_sort_by` for an ordering defined by `CLIP_DEFINE_LIST_SORT`.
+ */
+#define List_stable_sort_by(Type, Name, list) list_stable_sort_##Name##_##Type(list)
+
+/**
+ * @def List_radix_sort(Type, list, key)
+ * @brief Sorts the list in-place with a stable LSD radix sort in O(n) time.
+ *
+ * `key` maps every element to a `uint64_t` whose unsigned order is the desired order.
+ * Use `clip_radix_key_int`, `clip_radix_key_double`, ... for lists of numbers, or
+ * write an extractor for structs with the `clip_radix_key_from_*` transforms:
+ * ```c
+ * uint64_t by_price(const Item *it) { return clip_radix_key_from_f64(it->price); }
+ *
+ * List_radix_sort(int, &xs, clip_radix_key_int);
+ * List_radix_sort(Item, &items, by_price);
+ * ```
+ * @return Returns `true` on success, `false` if the list or key extractor is NULL.
+ */
+#define List_radix_sort(Type, list, key) list_radix_sort_##Type(list, key, NULL)
+
+/**
+ * @def List_radix_sort_scratch(Type, list, key, scratch)
+ * @brief Same as `List_radix_sort` but reuses the `CLIP_RadixScratch` buffer across calls.
+ *
+ * Example:
+ * ```c
+ * CLIP_RadixScratch scratch = CLIP_RADIX_SCRATCH_INIT;
+ * List_radix_sort_scratch(int, &batch, clip_radix_key_int, &scratch); // once per batch
+ * clip_radix_scratch_free(&scratch);
+ * ```
+ */
+#define List_radix_sort_scratch(Type, list, key, scratch) list_radix_sort_##Type(list, key, scratch)
+
 /**
  * @def List_merge(Type, dest, src)
  * @brief Append all elements from one list into another.
@@ -707,16 +949,7 @@
  * List_print(int, &my_list);
  * ```
  */
-#define List_print(Type, list)                \
-  do                                          \
-  {                                           \
-    char *_tmp_str = List_to_str(Type, list); \
-    if (_tmp_str)                             \
-    {                                         \
-      printf("%s", _tmp_str);                 \
-      free(_tmp_str);                         \
-    }                                         \
-  } while (0)
+#define List_print(Type, list) List_fprint(Type, list, stdout)
 
 /**
  * @def List_print_custom(Type, list, fn)
@@ -728,16 +961,7 @@
  * List_print_custom(Student, &classroom, Student_to_str);
  * ```
  */
-#define List_print_custom(Type, list, fn)                \
-  do                                                     \
-  {                                                      \
-    char *_tmp_str = List_to_str_custom(Type, list, fn); \
-    if (_tmp_str)                                        \
-    {                                                    \
-      printf("%s", _tmp_str);                            \
-      free(_tmp_str);                                    \
-    }                                                    \
-  } while (0)
+#define List_print_custom(Type, list, fn) List_fprint_custom(Type, list, stdout, fn)
 
 /**
  * @def List_println(Type, list)
@@ -786,10 +1010,10 @@
  *
  * @note The iterator stores the size at the start of the loop to avoid problems.
  */
-#define List_foreach(Type, var, list)                \
-  for (int _i_##var = 0, _size_##var = (list)->size; \
-       _i_##var < _size_##var;                       \
-       _i_##var++)                                   \
+#define List_foreach(Type, var, list)                        \
+  for (clip_size_t _i_##var = 0, _size_##var = (list)->size; \
+       _i_##var < _size_##var;                               \
+       _i_##var++)                                           \
     for (Type *var = &(list)->data[_i_##var]; var != NULL; var = NULL)
 
 #endif /* CLIP_LIST_H */
@@ -17,6 +17,7 @@
  *
  * The following methods are generated automatically:
  * - init
+ * - init_with_allocator
  * - insert
  * - get
  * - contains_key
@@ -25,6 +26,7 @@
  * - size
  * - to_str_custom (takes user-supplied key and value conversion functions)
  * - to_str (requires registration via CLIP_REGISTER_MAP_PRINT)
+ * - write_custom / write (stream into a `CLIP_StrBuf`, same text as to_str)
  * - free
  * - for_each (lets you apply a function over the map values iterator like)
  */
@@ -36,6 +38,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/StrBuf.h>
+#include <CLIP/Pool.h>
+
 /**
  * @brief Define a type-safe, tree-based ordered map for given key-value types.
  *
@@ -56,13 +63,23 @@
  * @param BUF_SIZE Optional: Buffer size allocated per element for string conversion. Default is 256.
  */
 #define CLIP_DEFINE_MAP_TYPE(...) \
-  CLIP_DEFINE_MAP_TYPE_IMPL(__VA_ARGS__, NULL, NULL, 256)
+  CLIP_DEFINE_MAP_TYPE_IMPL(__VA_ARGS__, NULL, NULL, 256, 0)
 
 #define CLIP_DEFINE_MAP_TYPE_WITH_FREE(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN) \
-  CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, 256)
+  CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, 256, 0)
 
 #define CLIP_DEFINE_MAP_TYPE_FULL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE) \
-  CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE)
+  CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE, 0)
+
+/**
+ * @brief Defines the Map type with its nodes allocated from a per-map node pool (see `Pool.h`).
+ *
+ * Nodes are carved out of chunked slabs and recycled through a free list, so
+ * `Map_clear` followed by refilling the map does not allocate, and `Map_free`
+ * releases a handful of chunks instead of one block per node.
+ */
+#define CLIP_DEFINE_MAP_TYPE_POOLED(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN) \
+  CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, 256, CLIP_POOL_DEFAULT_CHUNK_NODES)
 
 /**
  * @brief Specialized implementation of `CLIP_DEFINE_MAP_TYPE` but allows the
@@ -72,8 +89,9 @@
  * @param ValueType The value type
  * @param CompareFunc The comparator function for keys
  * @param BUF_SIZE The buffer size
+ * @param POOL_CHUNK Maximum number of nodes per pool chunk, or 0 to allocate every node with `malloc`
  */
-#define CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE, ...)                                                                          \
+#define CLIP_DEFINE_MAP_TYPE_IMPL(KeyType, ValueType, CompareFunc, KEY_FREE_FN, VALUE_FREE_FN, BUF_SIZE, POOL_CHUNK, ...)                                                      \
                                                                                                                                                                                \
   typedef enum                                                                                                                                                                 \
   {                                                                                                                                                                            \
@@ -92,7 +110,9 @@
   typedef struct                                                                                                                                                               \
   {                                                                                                                                                                            \
     MapNode_##KeyType##_##ValueType *root;                                                                                                                                     \
-    int size;                                                                                                                                                                  \
+    clip_size_t size;                                                                                                                                                          \
+    CLIP_NodePool *pool; /* Node pool (pooled maps only, created on first insert) */                                                                                           \
+    const CLIP_Allocator *allocator; /* Source of the nodes (and pool), NULL for the default allocator */                                                                      \
   } Map_##KeyType##_##ValueType;                                                                                                                                               \
                                                                                                                                                                                \
   static inline Map_##KeyType##_##ValueType init_map_##KeyType##_##ValueType()                                                                                                 \
@@ -101,13 +121,30 @@
     return map;                                                                                                                                                                \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
-  static inline MapNode_##KeyType##_##ValueType *map_node_new_##KeyType##_##ValueType(KeyType key, ValueType value)                                                            \
+  static inline Map_##KeyType##_##ValueType init_map_with_allocator_##KeyType##_##ValueType(const CLIP_Allocator *allocator)                                                   \
   {                                                                                                                                                                            \
-    MapNode_##KeyType##_##ValueType *node = (MapNode_##KeyType##_##ValueType *)malloc(sizeof(MapNode_##KeyType##_##ValueType));                                                \
-    if (!node)                                                                                                                                                                 \
+    Map_##KeyType##_##ValueType map = {0};                                                                                                                                     \
+    map.allocator = allocator;                                                                                                                                                 \
+    return map;                                                                                                                                                                \
+  }                                                                                                                                                                            \
+                                                                                                                                                                               \
+  static inline MapNode_##KeyType##_##ValueType *map_node_new_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map, KeyType key, ValueType value)                          \
+  {                                                                                                                                                                            \
+    MapNode_##KeyType##_##ValueType *node;                                                                                                                                     \
+    if (POOL_CHUNK)                                                                                                                                                            \
     {                                                                                                                                                                          \
-      fprintf(stderr, "Memory allocation failed!\n");                                                                                                                          \
-      exit(EXIT_FAILURE);                                                                                                                                                      \
+      if (!map->pool)                                                                                                                                                          \
+        map->pool = clip_pool_new(sizeof(MapNode_##KeyType##_##ValueType), POOL_CHUNK, map->allocator);                                                                        \
+      node = (MapNode_##KeyType##_##ValueType *)clip_pool_alloc(map->pool);                                                                                                    \
+    }                                                                                                                                                                          \
+    else                                                                                                                                                                       \
+    {                                                                                                                                                                          \
+      node = (MapNode_##KeyType##_##ValueType *)clip_alloc(map->allocator, sizeof(MapNode_##KeyType##_##ValueType));                                                           \
+      if (!node)                                                                                                                                                               \
+      {                                                                                                                                                                        \
+        fprintf(stderr, "Memory allocation failed!\n");                                                                                                                        \
+        exit(EXIT_FAILURE);                                                                                                                                                    \
+      }                                                                                                                                                                        \
     }                                                                                                                                                                          \
     node->key = key;                                                                                                                                                           \
     node->value = value;                                                                                                                                                       \
@@ -116,6 +153,14 @@
     return node;                                                                                                                                                               \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
+  static inline void map_node_release_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map, MapNode_##KeyType##_##ValueType *node)                                         \
+  {                                                                                                                                                                            \
+    if (POOL_CHUNK)                                                                                                                                                            \
+      clip_pool_release(map->pool, node);                                                                                                                                      \
+    else                                                                                                                                                                       \
+      clip_free(map->allocator, node, sizeof(MapNode_##KeyType##_##ValueType));                                                                                                \
+  }                                                                                                                                                                            \
+                                                                                                                                                                               \
   static inline void map_rotate_left_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map, MapNode_##KeyType##_##ValueType *x)                                             \
   {                                                                                                                                                                            \
     MapNode_##KeyType##_##ValueType *y = x->right;                                                                                                                             \
@@ -319,7 +364,7 @@
       y = x;                                                                                                                                                                   \
       x = (cmp < 0) ? x->left : x->right;                                                                                                                                      \
     }                                                                                                                                                                          \
-    MapNode_##KeyType##_##ValueType *z = map_node_new_##KeyType##_##ValueType(key, value);                                                                                     \
+    MapNode_##KeyType##_##ValueType *z = map_node_new_##KeyType##_##ValueType(map, key, value);                                                                                \
     z->parent = y;                                                                                                                                                             \
     if (!y)                                                                                                                                                                    \
       map->root = z;                                                                                                                                                           \
@@ -422,7 +467,7 @@
       y->color = z->color;                                                                                                                                                     \
     }                                                                                                                                                                          \
                                                                                                                                                                                \
-    free(z);                                                                                                                                                                   \
+    map_node_release_##KeyType##_##ValueType(map, z);                                                                                                                          \
     map->size--;                                                                                                                                                               \
                                                                                                                                                                                \
     if (y_original_color == MAP_BLACK_##KeyType##_##ValueType)                                                                                                                 \
@@ -431,7 +476,7 @@
     return true;                                                                                                                                                               \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
-  static inline int map_size_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map)                                                                                         \
+  static inline clip_size_t map_size_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map)                                                                                 \
   {                                                                                                                                                                            \
     return map->size;                                                                                                                                                          \
   }                                                                                                                                                                            \
@@ -441,12 +486,12 @@
     return map->size == 0;                                                                                                                                                     \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
-  static inline void map_clear_node_##KeyType##_##ValueType(MapNode_##KeyType##_##ValueType *node)                                                                             \
+  static inline void map_clear_node_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map, MapNode_##KeyType##_##ValueType *node)                                           \
   {                                                                                                                                                                            \
     if (!node)                                                                                                                                                                 \
       return;                                                                                                                                                                  \
-    map_clear_node_##KeyType##_##ValueType(node->left);                                                                                                                        \
-    map_clear_node_##KeyType##_##ValueType(node->right);                                                                                                                       \
+    map_clear_node_##KeyType##_##ValueType(map, node->left);                                                                                                                   \
+    map_clear_node_##KeyType##_##ValueType(map, node->right);                                                                                                                  \
     void (*KeyDtor)(KeyType *) = KEY_FREE_FN;                                                                                                                                      \
     void (*ValDtor)(ValueType *) = VALUE_FREE_FN;                                                                                                                                  \
                                                                                                                                                                                \
@@ -454,12 +499,19 @@
       KeyDtor(&node->key);                                                                                                                                                     \
     if (ValDtor)                                                                                                                                                               \
       ValDtor(&node->value);                                                                                                                                                   \
-    free(node);                                                                                                                                                                \
+    if (!POOL_CHUNK)                                                                                                                                                           \
+      clip_free(map->allocator, node, sizeof(MapNode_##KeyType##_##ValueType));                                                                                                \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
   static inline void map_clear_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map)                                                                                       \
   {                                                                                                                                                                            \
-    map_clear_node_##KeyType##_##ValueType(map->root);                                                                                                                         \
+    void (*KeyDtor)(KeyType *) = KEY_FREE_FN;                                                                                                                                  \
+    void (*ValDtor)(ValueType *) = VALUE_FREE_FN;                                                                                                                              \
+    /* Pooled nodes without destructors are dropped wholesale by the pool reset */                                                                                             \
+    if (!POOL_CHUNK || KeyDtor || ValDtor)                                                                                                                                     \
+      map_clear_node_##KeyType##_##ValueType(map, map->root);                                                                                                                  \
+    if (map->pool)                                                                                                                                                             \
+      clip_pool_reset(map->pool);                                                                                                                                              \
     map->root = NULL;                                                                                                                                                          \
     map->size = 0;                                                                                                                                                             \
   }                                                                                                                                                                            \
@@ -467,33 +519,55 @@
   static inline void free_map_##KeyType##_##ValueType(Map_##KeyType##_##ValueType *map)                                                                                        \
   {                                                                                                                                                                            \
     map_clear_##KeyType##_##ValueType(map);                                                                                                                                    \
+    if (map->pool)                                                                                                                                                             \
+    {                                                                                                                                                                          \
+      clip_pool_destroy(map->pool);                                                                                                                                            \
+      clip_free(map->allocator, map->pool, sizeof(CLIP_NodePool));                                                                                                             \
+      map->pool = NULL;                                                                                                                                                        \
+    }                                                                                                                                                                          \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
-  static inline void map_to_str_node_##KeyType##_##ValueType(                                                                                                                  \
-      MapNode_##KeyType##_##ValueType *node, char *buf, size_t size,                                                                                                           \
+  static inline bool map_write_node_##KeyType##_##ValueType(                                                                                                                   \
+      MapNode_##KeyType##_##ValueType *node, CLIP_StrBuf *out,                                                                                                                 \
       void (*key_to_str)(KeyType, char *, size_t),                                                                                                                             \
       void (*val_to_str)(ValueType, char *, size_t), bool *is_first)                                                                                                           \
   {                                                                                                                                                                            \
     if (!node)                                                                                                                                                                 \
-      return;                                                                                                                                                                  \
-    map_to_str_node_##KeyType##_##ValueType(node->left, buf, size, key_to_str, val_to_str, is_first);                                                                          \
-    if (!*is_first)                                                                                                                                                            \
-    {                                                                                                                                                                          \
-      size_t len = strlen(buf);                                                                                                                                                \
-      if (len + 2 < size)                                                                                                                                                      \
-        strcat(buf, ", ");                                                                                                                                                     \
-    }                                                                                                                                                                          \
-    size_t len = strlen(buf);                                                                                                                                                  \
-    if (len < size)                                                                                                                                                            \
-    {                                                                                                                                                                          \
-      strcat(buf, "{");                                                                                                                                                        \
-      key_to_str(node->key, buf + strlen(buf), size - strlen(buf));                                                                                                            \
-      strcat(buf, " : ");                                                                                                                                                      \
-      val_to_str(node->value, buf + strlen(buf), size - strlen(buf));                                                                                                          \
-      strcat(buf, "}");                                                                                                                                                        \
-    }                                                                                                                                                                          \
+      return true;                                                                                                                                                             \
+    if (!map_write_node_##KeyType##_##ValueType(node->left, out, key_to_str, val_to_str, is_first))                                                                            \
+      return false;                                                                                                                                                            \
+    if (!clip_strbuf_puts(out, *is_first ? "{" : ", {"))                                                                                                                       \
+      return false;                                                                                                                                                            \
+    char *key = clip_strbuf_reserve(out, BUF_SIZE);                                                                                                                            \
+    if (!key)                                                                                                                                                                  \
+      return false;                                                                                                                                                            \
+    key[0] = '\0';                                                                                                                                                             \
+    key_to_str(node->key, key, BUF_SIZE);                                                                                                                                      \
+    clip_strbuf_commit_str(out, BUF_SIZE);                                                                                                                                     \
+    if (!clip_strbuf_append(out, " : ", 3))                                                                                                                                    \
+      return false;                                                                                                                                                            \
+    char *val = clip_strbuf_reserve(out, BUF_SIZE);                                                                                                                            \
+    if (!val)                                                                                                                                                                  \
+      return false;                                                                                                                                                            \
+    val[0] = '\0';                                                                                                                                                             \
+    val_to_str(node->value, val, BUF_SIZE);                                                                                                                                    \
+    clip_strbuf_commit_str(out, BUF_SIZE);                                                                                                                                     \
+    if (!clip_strbuf_putc(out, '}'))                                                                                                                                           \
+      return false;                                                                                                                                                            \
     *is_first = false;                                                                                                                                                         \
-    map_to_str_node_##KeyType##_##ValueType(node->right, buf, size, key_to_str, val_to_str, is_first);                                                                         \
+    return map_write_node_##KeyType##_##ValueType(node->right, out, key_to_str, val_to_str, is_first);                                                                         \
+  }                                                                                                                                                                            \
+                                                                                                                                                                               \
+  static inline bool map_write_##KeyType##_##ValueType##_custom(Map_##KeyType##_##ValueType *map, CLIP_StrBuf *out,                                                            \
+                                                                void (*key_to_str)(KeyType, char *, size_t),                                                                   \
+                                                                void (*val_to_str)(ValueType, char *, size_t))                                                                 \
+  {                                                                                                                                                                            \
+    if (!map || !clip_strbuf_putc(out, '{'))                                                                                                                                   \
+      return false;                                                                                                                                                            \
+    bool is_first = true;                                                                                                                                                      \
+    if (!map_write_node_##KeyType##_##ValueType(map->root, out, key_to_str, val_to_str, &is_first))                                                                            \
+      return false;                                                                                                                                                            \
+    return clip_strbuf_putc(out, '}');                                                                                                                                         \
   }                                                                                                                                                                            \
                                                                                                                                                                                \
   static inline char *map_to_str_##KeyType##_##ValueType##_custom(Map_##KeyType##_##ValueType *map,                                                                            \
@@ -502,15 +576,10 @@
   {                                                                                                                                                                            \
     if (!map)                                                                                                                                                                  \
       return NULL;                                                                                                                                                             \
-    size_t bufsize = map->size * BUF_SIZE + 32;                                                                                                                                \
-    char *buffer = malloc(bufsize);                                                                                                                                            \
-    if (!buffer)                                                                                                                                                               \
-      return NULL;                                                                                                                                                             \
-    strcpy(buffer, "{");                                                                                                                                                       \
-    bool is_first = true;                                                                                                                                                      \
-    map_to_str_node_##KeyType##_##ValueType(map->root, buffer, bufsize, key_to_str, val_to_str, &is_first);                                                                    \
-    strcat(buffer, "}");                                                                                                                                                       \
-    return buffer;                                                                                                                                                             \
+    CLIP_StrBuf out;                                                                                                                                                           \
+    clip_strbuf_init(&out);                                                                                                                                                    \
+    map_write_##KeyType##_##ValueType##_custom(map, &out, key_to_str, val_to_str);                                                                                             \
+    return clip_strbuf_detach(&out);                                                                                                                                           \
   }                                                                                                                                                                            \
   /* Iterator Functions */                                                                                                                                                     \
   static inline void map_foreach_node_##KeyType##_##ValueType(                                                                                                                 \
@@ -533,19 +602,27 @@
     map_foreach_node_##KeyType##_##ValueType(map->root, fn, userdata);                                                                                                         \
   }
 
-#define CLIP_REGISTER_MAP_PRINT(KeyType, ValueType, key_fn, val_fn)                               \
-  static inline char *map_to_str_##KeyType##_##ValueType##_main(Map_##KeyType##_##ValueType *map) \
-  {                                                                                               \
-    return map_to_str_##KeyType##_##ValueType##_custom(map, key_fn, val_fn);                      \
+#define CLIP_REGISTER_MAP_PRINT(KeyType, ValueType, key_fn, val_fn)                                                 \
+  static inline bool map_write_##KeyType##_##ValueType##_main(Map_##KeyType##_##ValueType *map, CLIP_StrBuf *out) \
+  {                                                                                                               \
+    return map_write_##KeyType##_##ValueType##_custom(map, out, key_fn, val_fn);                                  \
+  }                                                                                                               \
+                                                                                                                  \
+  static inline char *map_to_str_##KeyType##_##ValueType##_main(Map_##KeyType##_##ValueType *map)                 \
+  {                                                                                                               \
+    return map_to_str_##KeyType##_##ValueType##_custom(map, key_fn, val_fn);                                      \
   }
 
 #define Map(KeyType, ValueType) Map_##KeyType##_##ValueType
 #define Map_init(KeyType, ValueType) init_map_##KeyType##_##ValueType()
+#define Map_init_with_allocator(KeyType, ValueType, allocator) init_map_with_allocator_##KeyType##_##ValueType(allocator)
 #define Map_insert(KeyType, ValueType, map, key, val) map_insert_##KeyType##_##ValueType(map, key, val)
 #define Map_get(KeyType, ValueType, map, key) map_get_##KeyType##_##ValueType(map, key)
 #define Map_contains(KeyType, ValueType, map, key) map_contains_##KeyType##_##ValueType(map, key)
 #define Map_to_str(KeyType, ValueType, map) map_to_str_##KeyType##_##ValueType##_main(map)
 #define Map_to_str_custom(KeyType, ValueType, map, keyfn, valfn) map_to_str_##KeyType##_##ValueType##_custom(map, keyfn, valfn)
+#define Map_write(KeyType, ValueType, map, out) map_write_##KeyType##_##ValueType##_main(map, out)
+#define Map_write_custom(KeyType, ValueType, map, out, keyfn, valfn) map_write_##KeyType##_##ValueType##_custom(map, out, keyfn, valfn)
 #define Map_remove(KeyType, ValueType, map, key) map_remove_##KeyType##_##ValueType(map, key)
 #define Map_size(KeyType, ValueType, map) map_size_##KeyType##_##ValueType(map)
 #define Map_empty(KeyType, ValueType, map) map_empty_##KeyType##_##ValueType(map)
@@ -553,22 +630,22 @@
 #define Map_free(KeyType, ValueType, map) free_map_##KeyType##_##ValueType(map)
 #define Map_foreach(KeyType, ValueType, map, fn, userdata) map_foreach_##KeyType##_##ValueType(map, fn, userdata)
 
-#define Map_print(KeyType, map)          \
-  do                                     \
-  {                                      \
-    char *_s = Map_to_str(KeyType, map); \
-    if (_s)                              \
-    {                                    \
-      printf("%s", _s);                  \
-      free(_s);                          \
-    }                                    \
+#define Map_fprint(KeyType, ValueType, map, file) \
+  do                                              \
+  {                                               \
+    CLIP_StrBuf _out;                             \
+    clip_strbuf_init_file(&_out, file);           \
+    Map_write(KeyType, ValueType, map, &_out);    \
+    clip_strbuf_free(&_out);                      \
   } while (0)
 
-#define Map_println(KeyType, map) \
-  do                              \
-  {                               \
-    Map_print(KeyType, map);      \
-    printf("\n");                 \
+#define Map_print(KeyType, ValueType, map) Map_fprint(KeyType, ValueType, map, stdout)
+
+#define Map_println(KeyType, ValueType, map) \
+  do                                         \
+  {                                          \
+    Map_print(KeyType, ValueType, map);      \
+    printf("\n");                            \
   } while (0)
 
 #endif /* CLIP_MAP_H */
\ No newline at end of file
@@ -0,0 +1,242 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Multi-threaded sort for `List` types (requires pthreads).
+ *
+ * The list is split into one chunk per thread, every chunk is sorted
+ * concurrently with the serial pdqsort kernel of `List.h`, and the sorted runs
+ * are then merged pairwise into a scratch buffer. Each merge round is itself
+ * parallel: the output of the round is cut into equal slices and every thread
+ * finds its slice boundaries inside the input runs with a merge-path binary
+ * search, so all threads do the same amount of work whatever the data.
+ *
+ * Lists below `CLIP_PAR_SORT_THRESHOLD` elements (or a thread count below 2)
+ * take the serial path, since spawning threads would cost more than it saves.
+ *
+ * Example:
+ * CLIP_DEFINE_LIST_TYPE(int)
+ * CLIP_DEFINE_LIST_PAR_SORT(int)
+ *
+ * List_par_sort(int, &xs, compare_ints, 8); // 0 threads = one per online CPU
+ */
+#ifndef CLIP_PAR_SORT_H
+#define CLIP_PAR_SORT_H
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <CLIP/List.h>
+
+/* Lists shorter than this are sorted on the calling thread only. */
+#ifndef CLIP_PAR_SORT_THRESHOLD
+#define CLIP_PAR_SORT_THRESHOLD 65536
+#endif
+
+/* Upper bound for the number of threads used by a single sort. */
+#define CLIP_PAR_SORT_MAX_THREADS 64
+
+/**
+ * @brief Number of online CPUs (at least 1), used when the caller asks for 0 threads.
+ */
+static inline int clip_par_sort_default_threads(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? (int)cpus : 1;
+}
+
+/**
+ * @brief Runs `fn(&tasks[i])` for `i` in `[0, count)`, each on its own thread.
+ * The calling thread takes task 0; tasks whose thread cannot be created also run inline.
+ */
+static inline void clip_par_sort_run(void *(*fn)(void *), void *tasks, size_t task_size, int count)
+{
+  pthread_t threads[CLIP_PAR_SORT_MAX_THREADS];
+  bool started[CLIP_PAR_SORT_MAX_THREADS];
+  for (int i = 1; i < count; i++)
+  {
+    void *task = (char *)tasks + (size_t)i * task_size;
+    started[i] = pthread_create(&threads[i], NULL, fn, task) == 0;
+    if (!started[i])
+      fn(task);
+  }
+  fn(tasks);
+  for (int i = 1; i < count; i++)
+    if (started[i])
+      pthread_join(threads[i], NULL);
+}
+
+/**
+ * @brief Generates `list_par_sort_<Type>`, the parallel counterpart of `list_sort_<Type>`.
+ *
+ * Must be used after `CLIP_DEFINE_LIST_TYPE(Type)` (it reuses the list's serial sort kernel).
+ *
+ * @param Type The element type of the list
+ */
+#define CLIP_DEFINE_LIST_PAR_SORT(Type)                                                                 \
+                                                                                                        \
+  typedef struct                                                                                        \
+  {                                                                                                     \
+    Type *data;    /* The list storage */                                                               \
+    Type *src;     /* Runs being merged in the current round */                                         \
+    Type *dst;     /* Output of the current round */                                                    \
+    size_t n;                                                                                           \
+    size_t bounds[CLIP_PAR_SORT_MAX_THREADS + 1]; /* Run i is [bounds[i], bounds[i + 1]) */             \
+    int runs;                                                                                           \
+    int nthreads;                                                                                       \
+    int (*comparator)(const Type *, const Type *);                                                      \
+  } ListParSortJob_##Type;                                                                              \
+                                                                                                        \
+  typedef struct                                                                                        \
+  {                                                                                                     \
+    ListParSortJob_##Type *job;                                                                         \
+    int index;                                                                                          \
+  } ListParSortTask_##Type;                                                                             \
+                                                                                                        \
+  /* Sorts run `index` in `src` (copying it there from the list storage first if needed) */             \
+  static inline void *list_par_sort_chunk_##Type(void *arg)                                             \
+  {                                                                                                     \
+    ListParSortTask_##Type *task = (ListParSortTask_##Type *)arg;                                       \
+    ListParSortJob_##Type *job = task->job;                                                             \
+    size_t lo = job->bounds[task->index];                                                               \
+    size_t hi = job->bounds[task->index + 1];                                                           \
+    if (job->src != job->data)                                                                          \
+      memcpy(job->src + lo, job->data + lo, (hi - lo) * sizeof(Type));                                  \
+    clip_sort_list_##Type(job->src + lo, hi - lo, job->comparator);                                     \
+    return NULL;                                                                                        \
+  }                                                                                                     \
+                                                                                                        \
+  /* Number of elements of `a` among the first `diag` elements of merge(a, b) */                        \
+  static inline size_t list_par_sort_split_##Type(const Type *a, size_t la, const Type *b, size_t lb,   \
+                                                  size_t diag,                                          \
+                                                  int (*comparator)(const Type *, const Type *))        \
+  {                                                                                                     \
+    size_t lo = diag > lb ? diag - lb : 0;                                                              \
+    size_t hi = diag < la ? diag : la;                                                                  \
+    while (lo < hi)                                                                                     \
+    {                                                                                                   \
+      size_t mid = lo + (hi - lo) / 2;                                                                  \
+      if (comparator(&a[mid], &b[diag - 1 - mid]) <= 0)                                                 \
+        lo = mid + 1;                                                                                   \
+      else                                                                                              \
+        hi = mid;                                                                                       \
+    }                                                                                                   \
+    return lo;                                                                                          \
+  }                                                                                                     \
+                                                                                                        \
+  /* Produces the slice `index` (1 / nthreads of the output) of the current merge round */              \
+  static inline void *list_par_sort_merge_##Type(void *arg)                                             \
+  {                                                                                                     \
+    ListParSortTask_##Type *task = (ListParSortTask_##Type *)arg;                                       \
+    ListParSortJob_##Type *job = task->job;                                                             \
+    int (*comparator)(const Type *, const Type *) = job->comparator;                                    \
+    size_t out_lo = job->n * (size_t)task->index / (size_t)job->nthreads;                               \
+    size_t out_hi = job->n * (size_t)(task->index + 1) / (size_t)job->nthreads;                         \
+                                                                                                        \
+    for (int r = 0; r < job->runs; r += 2)                                                              \
+    {                                                                                                   \
+      size_t a_lo = job->bounds[r];                                                                     \
+      size_t a_hi = job->bounds[r + 1];                                                                 \
+      size_t b_hi = r + 2 <= job->runs ? job->bounds[r + 2] : a_hi; /* The last run may be unpaired */  \
+      if (b_hi <= out_lo || a_lo >= out_hi)                                                             \
+        continue;                                                                                       \
+                                                                                                        \
+      const Type *a = job->src + a_lo;                                                                  \
+      const Type *b = job->src + a_hi;                                                                  \
+      size_t la = a_hi - a_lo;                                                                          \
+      size_t lb = b_hi - a_hi;                                                                          \
+      size_t d0 = (out_lo > a_lo ? out_lo : a_lo) - a_lo;                                               \
+      size_t d1 = (out_hi < b_hi ? out_hi : b_hi) - a_lo;                                               \
+      size_t i = list_par_sort_split_##Type(a, la, b, lb, d0, comparator);                              \
+      size_t j = d0 - i;                                                                                \
+      size_t i_end = list_par_sort_split_##Type(a, la, b, lb, d1, comparator);                          \
+      size_t j_end = d1 - i_end;                                                                        \
+                                                                                                        \
+      Type *out = job->dst + a_lo + d0;                                                                 \
+      while (i < i_end && j < j_end)                                                                    \
+        *out++ = comparator(&b[j], &a[i]) < 0 ? b[j++] : a[i++];                                        \
+      memcpy(out, a + i, (i_end - i) * sizeof(Type));                                                   \
+      out += i_end - i;                                                                                 \
+      memcpy(out, b + j, (j_end - j) * sizeof(Type));                                                   \
+    }                                                                                                   \
+    return NULL;                                                                                        \
+  }                                                                                                     \
+                                                                                                        \
+  /**                                                                                                   \
+   * @brief Sorts the list in-place using up to `nthreads` threads (not stable).                        \
+   * @param nthreads Number of threads, 0 or less to use one per online CPU                             \
+   */                                                                                                   \
+  static inline bool list_par_sort_##Type(List_##Type *list,                                            \
+                                          int (*comparator)(const Type *, const Type *), int nthreads)  \
+  {                                                                                                     \
+    if (!list || !list->data || !comparator)                                                            \
+    {                                                                                                   \
+      return false;                                                                                     \
+    }                                                                                                   \
+    size_t n = (size_t)list->size;                                                                      \
+    if (nthreads <= 0)                                                                                  \
+      nthreads = clip_par_sort_default_threads();                                                       \
+    if (nthreads > CLIP_PAR_SORT_MAX_THREADS)                                                           \
+      nthreads = CLIP_PAR_SORT_MAX_THREADS;                                                             \
+    if (nthreads < 2 || n < CLIP_PAR_SORT_THRESHOLD)                                                    \
+    {                                                                                                   \
+      clip_sort_list_##Type(list->data, n, comparator);                                                 \
+      return true;                                                                                      \
+    }                                                                                                   \
+                                                                                                        \
+    Type *scratch = (Type *)clip_alloc(list->allocator, n * sizeof(Type));                              \
+    if (!scratch)                                                                                       \
+    {                                                                                                   \
+      fprintf(stderr, "Memory allocation failed!\n");                                                   \
+      exit(EXIT_FAILURE);                                                                               \
+    }                                                                                                   \
+                                                                                                        \
+    ListParSortJob_##Type job;                                                                          \
+    ListParSortTask_##Type tasks[CLIP_PAR_SORT_MAX_THREADS];                                            \
+    job.data = list->data;                                                                              \
+    job.n = n;                                                                                          \
+    job.runs = nthreads;                                                                                \
+    job.nthreads = nthreads;                                                                            \
+    job.comparator = comparator;                                                                        \
+    for (int i = 0; i <= nthreads; i++)                                                                 \
+      job.bounds[i] = n * (size_t)i / (size_t)nthreads;                                                 \
+    for (int i = 0; i < nthreads; i++)                                                                  \
+    {                                                                                                   \
+      tasks[i].job = &job;                                                                              \
+      tasks[i].index = i;                                                                               \
+    }                                                                                                   \
+                                                                                                        \
+    /* Every merge round swaps buffers: start in the one that makes the last round end in the list */   \
+    int rounds = 0;                                                                                     \
+    for (int r = 1; r < nthreads; r *= 2)                                                               \
+      rounds++;                                                                                         \
+    job.src = rounds % 2 ? scratch : list->data;                                                        \
+    job.dst = rounds % 2 ? list->data : scratch;                                                        \
+                                                                                                        \
+    clip_par_sort_run(list_par_sort_chunk_##Type, tasks, sizeof(tasks[0]), nthreads);                   \
+    while (job.runs > 1)                                                                                \
+    {                                                                                                   \
+      clip_par_sort_run(list_par_sort_merge_##Type, tasks, sizeof(tasks[0]), nthreads);                 \
+      Type *swap = job.src;                                                                             \
+      job.src = job.dst;                                                                                \
+      job.dst = swap;                                                                                   \
+      int merged = (job.runs + 1) / 2;                                                                  \
+      for (int i = 1; i < merged; i++)                                                                  \
+        job.bounds[i] = job.bounds[2 * i];                                                              \
+      job.bounds[merged] = n;                                                                           \
+      job.runs = merged;                                                                                \
+    }                                                                                                   \
+                                                                                                        \
+    clip_free(list->allocator, scratch, n * sizeof(Type));                                              \
+    return true;                                                                                        \
+  }
+
+/**
+ * @def List_par_sort(Type, list, cmp, nthreads)
+ * @brief Sorts the list in-place with `nthreads` threads (0 = one per online CPU).
+ *
+ * Requires `CLIP_DEFINE_LIST_PAR_SORT(Type)`. Lists smaller than
+ * `CLIP_PAR_SORT_THRESHOLD` are sorted serially, like `List_sort`.
+ * @return Returns `true` on success, `false` if the list or comparator is NULL.
+ */
+#define List_par_sort(Type, list, cmp, nthreads) list_par_sort_##Type(list, cmp, nthreads)
+
+#endif /* CLIP_PAR_SORT_H */
@@ -1,9 +1,11 @@
 // include/CLIP/Parsers/Json.h
 #ifndef CLIP_PARSERS_JSON_H
 #define CLIP_PARSERS_JSON_H
-#include <CLIP/Map.h>
+#include <CLIP/Allocator.h>
 #include <CLIP/List.h>
+#include <CLIP/StrBuf.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 
 typedef const char *string;
@@ -16,11 +18,31 @@ typedef enum {
     JSON_NUMBER,
     JSON_STRING,
     JSON_OBJECT,
-    JSON_LIST
+    JSON_LIST,
+    JSON_NUMBER_ARRAY // Numbers or booleans of one kind in a single buffer, see `Json_parse_packed`
 } JsonType;
 
+// How a JSON_NUMBER was written, and so which member holds its exact value
+typedef enum {
+    JSON_NUMBER_DOUBLE, // Has a fraction or exponent, or does not fit in 64 bits
+    JSON_NUMBER_INT,    // Integer in [INT64_MIN, INT64_MAX], exact in `integer`
+    JSON_NUMBER_UINT    // Integer in (INT64_MAX, UINT64_MAX], exact in `uinteger`
+} JsonNumberKind;
+
+// A number as read from the input: `number` is always set, the exact integer only for INT and UINT
+typedef struct JsonNumber {
+    double number;
+    JsonNumberKind number_kind;
+    union {
+        int64_t integer;
+        uint64_t uinteger;
+    };
+} JsonNumber;
+
 
 void Json_free(JsonValue_ptr v);
+void Json_free_with_allocator(JsonValue_ptr v, const CLIP_Allocator *allocator);
+void Json_arena_free(CLIP_Arena *arena);
 
 static void Json_free_wrapper(JsonValue_ptr *v_ptr) {
     if (v_ptr && *v_ptr) {
@@ -28,40 +50,298 @@ static void Json_free_wrapper(JsonValue_ptr *v_ptr) {
     }
 }
 
-static void free_string(string *k)
+// Objects and arrays are parsed and freed with an explicit stack on the heap, not by recursion,
+// so deep documents are safe on small thread stacks. A document nested deeper than
+// CLIP_JSON_MAX_DEPTH is rejected: the parse functions return NULL.
+JsonValue_ptr Json_parse(const string input);
+JsonValue_ptr Json_parse_with_allocator(const string input, const CLIP_Allocator *allocator);
+JsonValue_ptr Json_parse_arena(const string input, CLIP_Arena *arena);
+JsonValue_ptr Json_parse_insitu(char *input, const CLIP_Allocator *allocator);
+// Like `Json_parse_with_allocator`, except that an array whose elements are all integers in
+// int64 range, all other numbers, or all booleans becomes a JSON_NUMBER_ARRAY holding them in
+// one buffer instead of a JSON_LIST of nodes. Empty and mixed arrays stay lists.
+JsonValue_ptr Json_parse_packed(const string input, const CLIP_Allocator *allocator);
+
+// How `Json_parse`, `Json_parse_with_allocator`, `Json_parse_arena` and `Json_sax_parse` read
+// their input. Both engines accept the same documents and build the same values.
+typedef enum {
+    JSON_ENGINE_RECURSIVE, // Descends the input byte by byte (the default)
+    JSON_ENGINE_STRUCTURAL // Indexes the tokens with SIMD first, then walks the index
+} JsonEngine;
+
+// Process-wide; set it before parsing starts. With the structural engine, text it rejects
+// is handed to the recursive parser, so `Json_parse` still reads what it can of invalid input.
+// In situ and incremental parsing always use their own parsers.
+void Json_set_engine(JsonEngine engine);
+JsonEngine Json_get_engine(void);
+
+// Value of `key` in a JSON_OBJECT, or NULL if it is absent (or `obj` is not an object)
+JsonValue_ptr Json_object_get(const JsonValue *obj, const char *key);
+
+// Exact integer value of a JSON_NUMBER; false if it is not a whole number in range
+bool Json_get_int64(const JsonValue *v, int64_t *out);
+bool Json_get_uint64(const JsonValue *v, uint64_t *out);
+
+// Element count of a JSON_LIST or JSON_NUMBER_ARRAY, 0 for anything else
+size_t Json_array_size(const JsonValue *v);
+// Element `i` of a JSON_LIST or JSON_NUMBER_ARRAY; false if it is out of range or of another type
+bool Json_array_number(const JsonValue *v, size_t i, JsonNumber *out);
+bool Json_array_bool(const JsonValue *v, size_t i, bool *out);
+
+// ---- Selective parsing ----
+
+// Parses only the values at `paths`: `out[i]` receives the value at `paths[i]` (release it with
+// `Json_free`), or NULL when the document has nothing there or the path is malformed. A path
+// chains keys with '.' and array positions with "[n]", as in "user.tags[0]"; "" is the whole
+// document, and keys holding '.' or '[' cannot be named. Every other value is skipped by counting
+// quotes and brackets, with nothing decoded, allocated or copied. A repeated key resolves to its
+// last occurrence, as with `Json_object_get` and `Json_path_eval`, so the objects a path goes
+// through are read to their end; the rest of an array is skipped once every path is found.
+// Returns how many paths were found.
+size_t Json_parse_select(const string input, const string *paths, size_t n, JsonValue_ptr *out);
+
+// ---- Compiled paths ----
+
+// A path in the syntax of `Json_parse_select`, read once and resolved against any number of
+// documents. Keys are hashed up front, and each remembers where it was found in the last
+// document, so records of the same shape resolve quickly. That memory makes evaluation modify
+// the path: share one between threads only with a lock, or compile one per thread.
+typedef struct JsonPath JsonPath;
+
+// NULL if `path` is malformed; release it with `Json_path_free`
+JsonPath *Json_path_compile(const char *path);
+void Json_path_free(JsonPath *path);
+// The value at `path` in `root` (resolving keys like `Json_object_get`), or NULL if there is none.
+// The elements of a JSON_NUMBER_ARRAY are not values of their own: read them with `Json_array_number`.
+JsonValue_ptr Json_path_eval(JsonPath *path, const JsonValue *root);
+
+// ---- Serialization ----
+
+// Flags for `Json_stringify`
+#define JSON_STRINGIFY_COMPACT 0 // No whitespace at all
+#define JSON_STRINGIFY_PRETTY 1  // One member per line, indented by two spaces, ": " after keys
+
+// Writes `v` as JSON text to `out` (in memory or streaming, see StrBuf.h). Doubles are written
+// with digits that always read back as the same double, shortest in almost all cases, and keep
+// a ".0" when whole; NaN and infinities are written as null. Returns false if the buffer failed.
+bool Json_stringify(const JsonValue *v, CLIP_StrBuf *out, int flags);
+// The same into a new string, to be released with `free`
+char *Json_to_str(const JsonValue *v, int flags);
+
+// ---- Streaming (SAX) parsing ----
+
+// Deepest nesting of objects and arrays the parsers accept
+#ifndef CLIP_JSON_MAX_DEPTH
+#define CLIP_JSON_MAX_DEPTH 1024
+#endif
+
+// Events reported by `Json_sax_parse`, each given the caller's `ud`. Any callback may be NULL;
+// returning false stops the parse. Strings and keys are decoded, not NUL-terminated, and only
+// valid during the call (they point into the input when they contain no escapes).
+typedef struct JsonSaxHandler {
+    bool (*on_null)(void *ud);
+    bool (*on_bool)(void *ud, bool value);
+    bool (*on_number)(void *ud, const JsonNumber *number);
+    bool (*on_string)(void *ud, const char *str, size_t len);
+    bool (*on_key)(void *ud, const char *key, size_t len);
+    bool (*on_start_object)(void *ud);
+    bool (*on_end_object)(void *ud);
+    bool (*on_start_array)(void *ud);
+    bool (*on_end_array)(void *ud);
+} JsonSaxHandler;
+
+typedef enum {
+    JSON_SAX_OK,
+    JSON_SAX_STOPPED,      // A callback returned false
+    JSON_SAX_SYNTAX_ERROR, // Malformed, truncated, or followed by something other than whitespace
+    JSON_SAX_TOO_DEEP      // Nested deeper than CLIP_JSON_MAX_DEPTH
+} JsonSaxStatus;
+
+// Parses the `len` bytes at `input` (no terminator needed) without building a tree. Memory use
+// does not depend on the document size: only strings with escapes are copied, into one reused buffer.
+JsonSaxStatus Json_sax_parse(const char *input, size_t len, const JsonSaxHandler *handler, void *ud);
+
+// ---- Tape ----
+
+// A document flattened into 64-bit words by the structural engine: the top byte of each word is
+// a JsonTapeType, the other 56 bits its payload. A container's start word points past its end,
+// so subtrees are skipped in one step; object members are a key string followed by the value.
+typedef enum {
+    JSON_TAPE_NULL = 'n',
+    JSON_TAPE_TRUE = 't',
+    JSON_TAPE_FALSE = 'f',
+    JSON_TAPE_INT = 'l',          // The next word holds the int64_t
+    JSON_TAPE_UINT = 'u',         // The next word holds the uint64_t (above INT64_MAX)
+    JSON_TAPE_DOUBLE = 'd',       // The next word holds the bits of the double
+    JSON_TAPE_STRING = '"',       // Payload: offset of the string in `strings`
+    JSON_TAPE_START_OBJECT = '{', // Payload: index of the word after the matching end
+    JSON_TAPE_END_OBJECT = '}',   // Payload: index of the matching start
+    JSON_TAPE_START_ARRAY = '[',
+    JSON_TAPE_END_ARRAY = ']'
+} JsonTapeType;
+
+#define JSON_TAPE_PAYLOAD_MASK ((UINT64_C(1) << 56) - 1)
+
+typedef struct JsonTape {
+    uint64_t *words; // The document starts at word 0
+    size_t size, capacity;
+    char *strings; // Decoded strings and keys
+    size_t strings_len, strings_cap;
+} JsonTape;
+
+// Parses the `len` bytes at `input` into `tape`, which must be zeroed the first time; passing it
+// again reuses its buffers. On error the tape is left empty. Release it with `Json_tape_free`.
+JsonSaxStatus Json_tape_parse(const char *input, size_t len, JsonTape *tape);
+void Json_tape_free(JsonTape *tape);
+
+static inline JsonTapeType Json_tape_type(const JsonTape *tape, size_t i)
 {
-    free((char *)*k);
+    return (JsonTapeType)(tape->words[i] >> 56);
 }
 
-JsonValue_ptr Json_parse(const string input);
-static JsonValue_ptr parse_value(string *s);
-static JsonValue_ptr parse_object(string *s);
-static JsonValue_ptr parse_list(string *s);
-static JsonValue_ptr parse_string(string *s);
-static JsonValue_ptr parse_number(string *s);
-static JsonValue_ptr parse_literal(string *s, string literal, JsonType type, int bool_val);
+// Index of the word after the value starting at word `i`
+size_t Json_tape_next(const JsonTape *tape, size_t i);
+// The string at word `i`: NUL-terminated, with its length (which counts any "\u0000") in `len`
+const char *Json_tape_string(const JsonTape *tape, size_t i, size_t *len);
+// The number at word `i`, as the parsers report it
+void Json_tape_number(const JsonTape *tape, size_t i, JsonNumber *out);
+
+// ---- Incremental parsing ----
+
+// Parses a document fed in chunks of any size, e.g. straight from fixed-size read buffers.
+// Chunks may split the input anywhere, including inside strings and numbers; only a token cut
+// by a boundary is copied. Chunks need not outlive the call that feeds them.
+//
+// JsonParser *p = Json_parser_new(NULL);
+// while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+//     if (Json_parser_feed(p, buf, n) != JSON_SAX_OK)
+//         break;
+// JsonValue *doc = Json_parser_finish(p, &status);
+typedef struct JsonParser JsonParser;
+
+// Builds a document from nodes of `allocator` (NULL for the default), returned by `Json_parser_finish`
+JsonParser *Json_parser_new(const CLIP_Allocator *allocator);
+// Reports events to `handler` as they become available instead of building a document
+JsonParser *Json_parser_new_sax(const JsonSaxHandler *handler, void *ud);
+// Returns the first error met so far (every later call returns it too), or JSON_SAX_OK
+JsonSaxStatus Json_parser_feed(JsonParser *p, const char *chunk, size_t len);
+// Ends the input and releases the parser. Returns the document (NULL on error or with a handler);
+// `status`, if not NULL, receives the final status.
+JsonValue_ptr Json_parser_finish(JsonParser *p, JsonSaxStatus *status);
+
+// ---- JSON Lines (NDJSON) ----
+
+// Bytes of input a thread takes at a time, extended to the end of the line it falls in
+#ifndef CLIP_JSON_LINES_BATCH
+#define CLIP_JSON_LINES_BATCH (256 * 1024)
+#endif
+
+// Receives each record with the byte offset of its line; `value` is NULL if the line is not valid
+// JSON. The value lives in a per-thread arena and is only valid during the call.
+typedef void (*JsonLineCallback)(void *ud, size_t offset, JsonValue_ptr value);
+
+// Parses every non-blank line of `buf` on up to `nthreads` threads (0 or less: one per online CPU).
+// `ordered` delivers the records one at a time in input order; otherwise `callback` runs on the
+// worker threads as records complete, concurrently, and must be thread-safe.
+// Returns the number of lines that were not valid JSON. Requires pthreads.
+size_t Json_parse_lines(const char *buf, size_t len, int nthreads, bool ordered, JsonLineCallback callback, void *ud);
 
 
 CLIP_DEFINE_LIST_TYPE_WITH_FREE(JsonValue_ptr, Json_free_wrapper);
 
-static inline int clip_json_cmp_str(const string *a, const string *b)
-{
-    return strcmp(*a, *b);
-};
+typedef struct JsonMember JsonMember;
 
-//CLIP_DEFINE_MAP_TYPE();
-CLIP_DEFINE_MAP_TYPE_WITH_FREE(string, JsonValue_ptr, clip_json_cmp_str, free_string, Json_free_wrapper)
+// Objects with at least this many members also get a hash index
+#ifndef CLIP_JSON_OBJECT_INDEX_MIN
+#define CLIP_JSON_OBJECT_INDEX_MIN 16
+#endif
 
+// Members are stored flat, in input order, each holding its value. A repeated key keeps every
+// occurrence and the last one wins on lookup. Small objects are searched linearly; larger ones
+// through `index`.
+typedef struct JsonObject {
+    struct {
+        JsonMember *data;
+        clip_size_t size;
+        clip_size_t capacity;
+        const CLIP_Allocator *allocator; // NULL for the default allocator
+    } members;
+    // NULL, or index[0] = slot count (a power of two) followed by the open addressing slots,
+    // each holding a member position + 1 (0 = empty)
+    uint32_t *index;
+} JsonObject;
+
+// What the elements of a JSON_NUMBER_ARRAY are
+typedef enum {
+    JSON_PACKED_INT,    // Integers in int64 range, in `ints`
+    JSON_PACKED_DOUBLE, // Numbers written with a fraction or exponent, in `doubles`
+    JSON_PACKED_BOOL    // In `bools`
+} JsonPackedKind;
+
+typedef struct JsonNumberArray {
+    JsonPackedKind kind;
+    size_t size;
+    size_t capacity;
+    union {
+        int64_t *ints;
+        double *doubles;
+        bool *bools;
+    };
+} JsonNumberArray;
+
+// Only the root of a document is allocated on its own: every other value is stored in its
+// container (an array element in `slots`, a member in its JsonMember), so scalars cost no
+// allocation, and strings and containers one for their contents. null, true and false at the
+// root are shared, read-only values.
 struct JsonValue {
     JsonType type;
+    bool insitu;   // Strings (and object keys) point into the input given to `Json_parse_insitu`
+    bool embedded; // Stored in its container or shared: freeing it releases only its contents
     union {
-        string str; // JSON_STRING
-        double number;
+        struct {
+            string str;     // JSON_STRING, NUL-terminated
+            size_t str_len; // Decoded length, which also covers embedded "\u0000"
+        };
+        struct {
+            double number;              // JSON_NUMBER, always set (rounded for integers beyond 2^53)
+            JsonNumberKind number_kind; // Whether the exact value below is meaningful
+            union {
+                int64_t integer;        // JSON_NUMBER_INT
+                uint64_t uinteger;      // JSON_NUMBER_UINT
+            };
+        };
         bool boolean;
-        Map(string, JsonValue_ptr) object;
-        List(JsonValue_ptr) list;
+        JsonObject object;
+        struct {
+            List(JsonValue_ptr) list; // JSON_LIST: list.data[i] points at slots[i]
+            JsonValue_ptr slots;      // The elements themselves, list.capacity of them
+        };
+        JsonNumberArray numbers; // JSON_NUMBER_ARRAY
     };
 };
 
+struct JsonMember {
+    string key;          // NUL-terminated
+    size_t key_len;      // Decoded length, which also covers embedded "\u0000"
+    JsonValue_ptr value; // Points at `slot`
+    JsonValue slot;
+};
+
+// Builds a JsonValue tree from SAX events: pass `&Json_dom_handler` as the handler and the
+// builder as `ud`. This is how a DOM is assembled from any event source.
+typedef struct JsonDomBuilder {
+    const CLIP_Allocator *allocator; // Source of the document, NULL for the default allocator
+    List(JsonValue_ptr) open; // Containers still being filled, innermost last
+    char *key;                // Object key waiting for its value
+    size_t key_len;
+    JsonValue_ptr root;
+} JsonDomBuilder;
+
+extern const JsonSaxHandler Json_dom_handler;
+
+void Json_dom_builder_init(JsonDomBuilder *b, const CLIP_Allocator *allocator);
+// Hands over the finished document, or frees it and returns NULL if it is incomplete
+JsonValue_ptr Json_dom_builder_finish(JsonDomBuilder *b);
+
 
 #endif // CLIP_PARSERS_JSON_H
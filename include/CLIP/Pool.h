@@ -0,0 +1,181 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Fixed-size node pool (slab allocator) used by the tree-based containers.
+ *
+ * Nodes are carved out of chunks ("slabs") that grow geometrically up to a
+ * maximum chunk size. Released nodes go onto an intrusive free list and are
+ * handed out again before any new memory is touched. `clip_pool_reset` makes
+ * every chunk available again without returning memory to the system, so a
+ * clear-then-refill cycle does no allocation at all, and `clip_pool_destroy`
+ * costs one `free` per chunk instead of one per node.
+ *
+ * Example:
+ * CLIP_NodePool pool;
+ * clip_pool_init(&pool, sizeof(struct MyNode), CLIP_POOL_DEFAULT_CHUNK_NODES);
+ * struct MyNode *n = clip_pool_alloc(&pool);
+ * clip_pool_release(&pool, n);
+ * clip_pool_destroy(&pool);
+ *
+ * `Map.h` and `Set.h` use it through `CLIP_DEFINE_MAP_TYPE_POOLED` and
+ * `CLIP_DEFINE_SET_TYPE_POOLED`.
+ */
+#ifndef CLIP_POOL_H
+#define CLIP_POOL_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <CLIP/Allocator.h>
+
+/* Default upper bound for the number of nodes in a single chunk. */
+#define CLIP_POOL_DEFAULT_CHUNK_NODES 1024
+
+/* Number of nodes in the first chunk of a pool. */
+#define CLIP_POOL_FIRST_CHUNK_NODES 16
+
+typedef struct CLIP_PoolChunk
+{
+  struct CLIP_PoolChunk *next;
+  size_t capacity; /* Number of nodes stored in this chunk */
+} CLIP_PoolChunk;
+
+typedef struct
+{
+  size_t node_size;                /* Size of one node (rounded up to hold the free-list link) */
+  size_t max_chunk_nodes;          /* Upper bound for the chunk growth */
+  size_t next_chunk_nodes;         /* Size of the next chunk to allocate */
+  void *free_list;                 /* Intrusive list of released nodes */
+  CLIP_PoolChunk *chunks;          /* All chunks, oldest first */
+  CLIP_PoolChunk *current;         /* Chunk nodes are currently bumped from */
+  size_t used;                     /* Nodes already handed out from `current` */
+  const CLIP_Allocator *allocator; /* Chunk allocator, NULL for the default one */
+} CLIP_NodePool;
+
+/* Chunk header size, rounded up so the node storage is maximally aligned. */
+#define CLIP_POOL_HEADER_SIZE \
+  ((sizeof(CLIP_PoolChunk) + _Alignof(max_align_t) - 1) / _Alignof(max_align_t) * _Alignof(max_align_t))
+
+/**
+ * @brief Initialize an empty pool. No memory is allocated until the first node is requested.
+ *
+ * @param pool The pool
+ * @param node_size Size of the nodes handed out by the pool
+ * @param max_chunk_nodes Maximum number of nodes per chunk (chunks start small and double up to it)
+ * @param allocator Where the chunks come from (NULL for the default allocator)
+ */
+static inline void clip_pool_init_with_allocator(CLIP_NodePool *pool, size_t node_size, size_t max_chunk_nodes,
+                                                 const CLIP_Allocator *allocator)
+{
+  if (node_size < sizeof(void *))
+    node_size = sizeof(void *);
+  pool->node_size = (node_size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+  pool->max_chunk_nodes = max_chunk_nodes ? max_chunk_nodes : CLIP_POOL_DEFAULT_CHUNK_NODES;
+  pool->next_chunk_nodes = CLIP_POOL_FIRST_CHUNK_NODES < pool->max_chunk_nodes ? CLIP_POOL_FIRST_CHUNK_NODES
+                                                                                : pool->max_chunk_nodes;
+  pool->free_list = NULL;
+  pool->chunks = NULL;
+  pool->current = NULL;
+  pool->used = 0;
+  pool->allocator = allocator;
+}
+
+/**
+ * @brief Initialize an empty pool backed by the default allocator (see `clip_pool_init_with_allocator`).
+ */
+static inline void clip_pool_init(CLIP_NodePool *pool, size_t node_size, size_t max_chunk_nodes)
+{
+  clip_pool_init_with_allocator(pool, node_size, max_chunk_nodes, NULL);
+}
+
+/**
+ * @brief Hand out one node. Reuses released nodes first, then already allocated chunks.
+ */
+static inline void *clip_pool_alloc(CLIP_NodePool *pool)
+{
+  if (pool->free_list)
+  {
+    void *node = pool->free_list;
+    pool->free_list = *(void **)node;
+    return node;
+  }
+  if (!pool->current || pool->used == pool->current->capacity)
+  {
+    CLIP_PoolChunk *next = pool->current ? pool->current->next : pool->chunks;
+    if (!next)
+    {
+      size_t nodes = pool->next_chunk_nodes;
+      next = (CLIP_PoolChunk *)clip_alloc(pool->allocator, CLIP_POOL_HEADER_SIZE + nodes * pool->node_size);
+      if (!next)
+      {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+      }
+      next->next = NULL;
+      next->capacity = nodes;
+      if (pool->current)
+        pool->current->next = next;
+      else
+        pool->chunks = next;
+      if (pool->next_chunk_nodes * 2 <= pool->max_chunk_nodes)
+        pool->next_chunk_nodes *= 2;
+      else
+        pool->next_chunk_nodes = pool->max_chunk_nodes;
+    }
+    pool->current = next;
+    pool->used = 0;
+  }
+  return (char *)pool->current + CLIP_POOL_HEADER_SIZE + pool->used++ * pool->node_size;
+}
+
+/**
+ * @brief Give a node back to the pool (pushes it onto the free list).
+ */
+static inline void clip_pool_release(CLIP_NodePool *pool, void *node)
+{
+  *(void **)node = pool->free_list;
+  pool->free_list = node;
+}
+
+/**
+ * @brief Mark every node of the pool as free while keeping all chunks for reuse.
+ */
+static inline void clip_pool_reset(CLIP_NodePool *pool)
+{
+  pool->free_list = NULL;
+  pool->current = pool->chunks;
+  pool->used = 0;
+}
+
+/**
+ * @brief Release every chunk of the pool. The pool can be reused afterwards.
+ */
+static inline void clip_pool_destroy(CLIP_NodePool *pool)
+{
+  CLIP_PoolChunk *chunk = pool->chunks;
+  while (chunk)
+  {
+    CLIP_PoolChunk *next = chunk->next;
+    clip_free(pool->allocator, chunk, CLIP_POOL_HEADER_SIZE + chunk->capacity * pool->node_size);
+    chunk = next;
+  }
+  clip_pool_init_with_allocator(pool, pool->node_size, pool->max_chunk_nodes, pool->allocator);
+}
+
+/**
+ * @brief Allocate a new, empty pool object from `allocator` (used lazily by the pooled containers).
+ * The pool object and its chunks come from the same allocator.
+ */
+static inline CLIP_NodePool *clip_pool_new(size_t node_size, size_t max_chunk_nodes, const CLIP_Allocator *allocator)
+{
+  CLIP_NodePool *pool = (CLIP_NodePool *)clip_alloc(allocator, sizeof(CLIP_NodePool));
+  if (!pool)
+  {
+    fprintf(stderr, "Memory allocation failed!\n");
+    exit(EXIT_FAILURE);
+  }
+  clip_pool_init_with_allocator(pool, node_size, max_chunk_nodes, allocator);
+  return pool;
+}
+
+#endif /* CLIP_POOL_H */
@@ -26,6 +26,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/StrBuf.h>
+
 #define CLIP_DEFINE_QUEUE_TYPE(...) \
   CLIP_DEFINE_QUEUE_TYPE_IMPL(__VA_ARGS__, NULL, 256)
 
@@ -54,6 +58,7 @@
  * - A typedef `Queue_<Type>` structure.
  * - A set of **static inline functions** specialized for `<Type>`:
  * - `init_queue_<Type>`
+ * - `init_queue_with_allocator_<Type>`
  * - `free_queue_<Type>`
  * - `queue_is_empty_<Type>`
  * - `queue_is_full_<Type>`
@@ -73,17 +78,26 @@
   typedef struct                                                               \
   {                                                                            \
     Type *data;                                                                \
-    int head;     /* Index of the front element */                             \
-    int tail;     /* Index where the next element will be inserted */          \
-    int count;    /* Number of elements in the queue */                        \
-    int capacity; /* Total storage capacity */                                 \
+    clip_size_t head;     /* Index of the front element */                     \
+    clip_size_t tail;     /* Index where the next element will be inserted */  \
+    clip_size_t count;    /* Number of elements in the queue */                \
+    clip_size_t capacity; /* Total storage capacity */                         \
+    const CLIP_Allocator *allocator; /* NULL for the default allocator */      \
   } Queue_##Type;                                                              \
                                                                                \
-  static inline Queue_##Type init_queue_##Type(int capacity)                   \
+  static inline Queue_##Type init_queue_with_allocator_##Type(                 \
+      clip_size_t capacity, const CLIP_Allocator *allocator)                   \
   {                                                                            \
     Queue_##Type q;                                                            \
     /* Allocate one extra slot to easily distinguish full from empty */        \
-    q.data = malloc((capacity + 1) * sizeof(Type));                            \
+    size_t bytes;                                                              \
+    if (capacity < 0 || capacity == CLIP_SIZE_MAX ||                           \
+        !clip_size_mul((size_t)capacity + 1, sizeof(Type), &bytes))            \
+    {                                                                          \
+      fprintf(stderr, "Invalid queue capacity!\n");                            \
+      exit(EXIT_FAILURE);                                                      \
+    }                                                                          \
+    q.data = clip_alloc(allocator, bytes);                                     \
     if (!q.data)                                                               \
     {                                                                          \
       fprintf(stderr, "Queue memory allocation failed!\n");                    \
@@ -93,21 +107,28 @@
     q.head = 0;                                                                \
     q.tail = 0;                                                                \
     q.count = 0;                                                               \
+    q.allocator = allocator;                                                   \
     return q;                                                                  \
   }                                                                            \
                                                                                \
+  static inline Queue_##Type init_queue_##Type(clip_size_t capacity)           \
+  {                                                                            \
+    return init_queue_with_allocator_##Type(capacity, NULL);                   \
+  }                                                                            \
+                                                                               \
   static inline void free_queue_##Type(Queue_##Type *q)                        \
   {                                                                            \
     void (*free_fn)(Type *) = FREE_FN;                                         \
     if (free_fn)                                                               \
     {                                                                          \
-      for (int i = 0; i < q->count; i++)                                       \
+      for (clip_size_t i = 0; i < q->count; i++)                               \
       {                                                                        \
                                                                                \
         (free_fn)(&q->data[i]);                                                \
       }                                                                        \
     }                                                                          \
-    free(q->data);                                                             \
+    clip_free(q->allocator, q->data,                                           \
+              ((size_t)q->capacity + 1) * sizeof(Type));                       \
     q->data = NULL;                                                            \
     q->capacity = 0;                                                           \
     q->head = 0;                                                               \
@@ -125,7 +146,7 @@
     return q->count == q->capacity;                                            \
   }                                                                            \
                                                                                \
-  static inline int queue_size_##Type(const Queue_##Type *q)                   \
+  static inline clip_size_t queue_size_##Type(const Queue_##Type *q)           \
   {                                                                            \
     return q->count;                                                           \
   }                                                                            \
@@ -186,52 +207,64 @@
     q->count = 0;                                                              \
   }                                                                            \
                                                                                \
+  static inline bool queue_write_##Type##_custom(                              \
+      const Queue_##Type *q, CLIP_StrBuf *out,                                 \
+      void (*elem_to_str)(Type, char *, size_t))                               \
+  {                                                                            \
+    if (!q || !clip_strbuf_putc(out, '['))                                     \
+      return false;                                                            \
+    for (clip_size_t i = 0; i < q->count; i++)                                 \
+    {                                                                          \
+      if (i > 0 && !clip_strbuf_append(out, ", ", 2))                          \
+        return false;                                                          \
+      clip_size_t current_index = (q->head + i) % (q->capacity + 1);           \
+      char *elem = clip_strbuf_reserve(out, BUF_SIZE);                         \
+      if (!elem)                                                               \
+        return false;                                                          \
+      elem[0] = '\0';                                                          \
+      elem_to_str(q->data[current_index], elem, BUF_SIZE);                     \
+      clip_strbuf_commit_str(out, BUF_SIZE);                                   \
+    }                                                                          \
+    return clip_strbuf_putc(out, ']');                                         \
+  }                                                                            \
+                                                                               \
   static inline char *queue_to_str_##Type##_custom(                            \
       const Queue_##Type *q, void (*elem_to_str)(Type, char *, size_t))        \
   {                                                                            \
     if (!q)                                                                    \
       return NULL;                                                             \
-    if (q->count == 0)                                                         \
-    {                                                                          \
-      char *buffer = malloc(3);                                                \
-      if (!buffer)                                                             \
-        return NULL;                                                           \
-      strcpy(buffer, "[]");                                                    \
-      return buffer;                                                           \
-    }                                                                          \
-    size_t bufsize = q->count * BUF_SIZE + 3;                                  \
-    char *buffer = malloc(bufsize);                                            \
-    if (!buffer)                                                               \
-      return NULL;                                                             \
-    strcpy(buffer, "[");                                                       \
-    char elem[BUF_SIZE];                                                       \
-    for (int i = 0; i < q->count; i++)                                         \
-    {                                                                          \
-      int current_index = (q->head + i) % (q->capacity + 1);                   \
-      elem_to_str(q->data[current_index], elem, sizeof(elem));                 \
-      strcat(buffer, elem);                                                    \
-      if (i < q->count - 1)                                                    \
-        strcat(buffer, ", ");                                                  \
-    }                                                                          \
-    strcat(buffer, "]");                                                       \
-    return buffer;                                                             \
+    CLIP_StrBuf out;                                                           \
+    clip_strbuf_init(&out);                                                    \
+    queue_write_##Type##_custom(q, &out, elem_to_str);                         \
+    return clip_strbuf_detach(&out);                                           \
   }
 
-#define CLIP_REGISTER_QUEUE_PRINT(Type, print_fn)                                  \
-  static inline char *queue_to_str_##Type##_main(const Queue_##Type *q)            \
-  {                                                                                \
-    if (!print_fn)                                                                 \
-    {                                                                              \
-      fprintf(stderr, "No print function registered for queue type " #Type "!\n"); \
-      return NULL;                                                                 \
-    }                                                                              \
-    return queue_to_str_##Type##_custom(q, print_fn);                              \
+#define CLIP_REGISTER_QUEUE_PRINT(Type, print_fn)                                       \
+  static inline bool queue_write_##Type##_main(const Queue_##Type *q, CLIP_StrBuf *out) \
+  {                                                                                     \
+    if (!print_fn)                                                                      \
+    {                                                                                   \
+      fprintf(stderr, "No print function registered for queue type " #Type "!\n");      \
+      return false;                                                                     \
+    }                                                                                   \
+    return queue_write_##Type##_custom(q, out, print_fn);                               \
+  }                                                                                     \
+                                                                                        \
+  static inline char *queue_to_str_##Type##_main(const Queue_##Type *q)                 \
+  {                                                                                     \
+    if (!print_fn)                                                                      \
+    {                                                                                   \
+      fprintf(stderr, "No print function registered for queue type " #Type "!\n");      \
+      return NULL;                                                                      \
+    }                                                                                   \
+    return queue_to_str_##Type##_custom(q, print_fn);                                   \
   }
 
 /* --- Convenience Macros --- */
 
 #define Queue(Type) Queue_##Type
 #define Queue_init(Type, cap) init_queue_##Type(cap)
+#define Queue_init_with_allocator(Type, cap, allocator) init_queue_with_allocator_##Type(cap, allocator)
 #define Queue_free(Type, q) free_queue_##Type(q)
 #define Queue_is_empty(Type, q) queue_is_empty_##Type(q)
 #define Queue_is_full(Type, q) queue_is_full_##Type(q)
@@ -243,29 +276,31 @@
 #define Queue_clear(Type, q) queue_clear_##Type(q)
 #define Queue_to_str(Type, q) queue_to_str_##Type##_main(q)
 #define Queue_to_str_custom(Type, q, fn) queue_to_str_##Type##_custom(q, fn)
+#define Queue_write(Type, q, out) queue_write_##Type##_main(q, out)
+#define Queue_write_custom(Type, q, out, fn) queue_write_##Type##_custom(q, out, fn)
 
-#define Queue_print(Type, q)                \
-  do                                        \
-  {                                         \
-    char *_tmp_str = Queue_to_str(Type, q); \
-    if (_tmp_str)                           \
-    {                                       \
-      printf("%s", _tmp_str);               \
-      free(_tmp_str);                       \
-    }                                       \
+#define Queue_fprint(Type, q, file)     \
+  do                                    \
+  {                                     \
+    CLIP_StrBuf _out;                   \
+    clip_strbuf_init_file(&_out, file); \
+    Queue_write(Type, q, &_out);        \
+    clip_strbuf_free(&_out);            \
   } while (0)
 
-#define Queue_print_custom(Type, q, fn)                \
-  do                                                   \
-  {                                                    \
-    char *_tmp_str = Queue_to_str_custom(Type, q, fn); \
-    if (_tmp_str)                                      \
-    {                                                  \
-      printf("%s", _tmp_str);                          \
-      free(_tmp_str);                                  \
-    }                                                  \
+#define Queue_fprint_custom(Type, q, file, fn) \
+  do                                           \
+  {                                            \
+    CLIP_StrBuf _out;                          \
+    clip_strbuf_init_file(&_out, file);        \
+    Queue_write_custom(Type, q, &_out, fn);    \
+    clip_strbuf_free(&_out);                   \
   } while (0)
 
+#define Queue_print(Type, q) Queue_fprint(Type, q, stdout)
+
+#define Queue_print_custom(Type, q, fn) Queue_fprint_custom(Type, q, stdout, fn)
+
 #define Queue_println(Type, q) \
   do                           \
   {                            \
@@ -17,12 +17,15 @@
  *
  * The following methods are generated automatically:
  * - init
+ * - init_with_allocator
  * - insert
  * - contains
  * - remove
  * - clear
  * - size
  * - to_str_custom (takes a user-supplied function)
+ * - write (streams into a `CLIP_StrBuf`, requires registration via CLIP_REGISTER_SET_PRINT)
+ * - write_custom (takes a user-supplied function)
  * - to_str (requires registration via CLIP_REGISTER_SET_PRINT)
  * - free
  */
@@ -34,6 +37,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/StrBuf.h>
+#include <CLIP/Pool.h>
+
 /**
  * @brief Define a type-safe, tree-based ordered set for a given type.
  *
@@ -51,25 +59,35 @@
  * @param BUF_SIZE Optional: Buffer size allocated per element for string conversion. Default is 256.
  */
 #define CLIP_DEFINE_SET_TYPE(...) \
-  CLIP_DEFINE_SET_TYPE_IMPL(__VA_ARGS__, NULL, 256)
+  CLIP_DEFINE_SET_TYPE_IMPL(__VA_ARGS__, NULL, 256, 0)
 
 /**
  * @brief Defines the Set type with a given buffer size
  */
 #define CLIP_DEFINE_SET_TYPE_BUF(Type, CompareFunc, BUF_SIZE) \
-  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, NULL, BUF)
+  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, NULL, BUF_SIZE, 0)
 
 /**
  * @brief Defines the Set type with a given free function for the type
  */
 #define CLIP_DEFINE_SET_TYPE_WITH_FREE(Type, CompareFunc, FREE_FN) \
-  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, 256)
+  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, 256, 0)
 
 /**
  * @brief Defines the Set type with a given free function and a custom buffer size for the print
  */
 #define CLIP_DEFINE_SET_TYPE_FULL(Type, CompareFunc, FREE_FN, BUF_SIZE) \
-  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, BUF_SIZE)
+  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, BUF_SIZE, 0)
+
+/**
+ * @brief Defines the Set type with its nodes allocated from a per-set node pool (see `Pool.h`).
+ *
+ * Nodes are carved out of chunked slabs and recycled through a free list, so
+ * `Set_clear` followed by refilling the set does not allocate, and `Set_free`
+ * releases a handful of chunks instead of one block per node.
+ */
+#define CLIP_DEFINE_SET_TYPE_POOLED(Type, CompareFunc, FREE_FN) \
+  CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, 256, CLIP_POOL_DEFAULT_CHUNK_NODES)
 
 /**
  * @brief Specialized implementation of `CLIP_DEFINE_SET_TYPE` but allows the
@@ -79,8 +97,9 @@
  * @param CompareFunc The comparator function
  * @param FREE_FN Destructor/Free function for the type : Useful for automatic liberating memory
  * @param BUF_SIZE The buffer size
+ * @param POOL_CHUNK Maximum number of nodes per pool chunk, or 0 to allocate every node with `malloc`
  */
-#define CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, BUF_SIZE, ...)                           \
+#define CLIP_DEFINE_SET_TYPE_IMPL(Type, CompareFunc, FREE_FN, BUF_SIZE, POOL_CHUNK, ...)               \
                                                                                                        \
   typedef enum                                                                                         \
   {                                                                                                    \
@@ -98,7 +117,9 @@
   typedef struct                                                                                       \
   {                                                                                                    \
     SetNode_##Type *root;                                                                              \
-    int size;                                                                                          \
+    clip_size_t size;                                                                                  \
+    CLIP_NodePool *pool; /* Node pool (pooled sets only, created on first insert) */                   \
+    const CLIP_Allocator *allocator; /* Source of the nodes (and pool), NULL for the default */        \
   } Set_##Type;                                                                                        \
                                                                                                        \
   static inline Set_##Type init_set_##Type()                                                           \
@@ -107,13 +128,30 @@
     return set;                                                                                        \
   }                                                                                                    \
                                                                                                        \
-  static inline SetNode_##Type *set_node_new_##Type(Type value)                                        \
+  static inline Set_##Type init_set_with_allocator_##Type(const CLIP_Allocator *allocator)             \
   {                                                                                                    \
-    SetNode_##Type *node = (SetNode_##Type *)malloc(sizeof(SetNode_##Type));                           \
-    if (!node)                                                                                         \
+    Set_##Type set = {0};                                                                              \
+    set.allocator = allocator;                                                                         \
+    return set;                                                                                        \
+  }                                                                                                    \
+                                                                                                       \
+  static inline SetNode_##Type *set_node_new_##Type(Set_##Type *set, Type value)                       \
+  {                                                                                                    \
+    SetNode_##Type *node;                                                                              \
+    if (POOL_CHUNK)                                                                                    \
     {                                                                                                  \
-      fprintf(stderr, "Memory allocation failed!\n");                                                  \
-      exit(EXIT_FAILURE);                                                                              \
+      if (!set->pool)                                                                                  \
+        set->pool = clip_pool_new(sizeof(SetNode_##Type), POOL_CHUNK, set->allocator);                 \
+      node = (SetNode_##Type *)clip_pool_alloc(set->pool);                                             \
+    }                                                                                                  \
+    else                                                                                               \
+    {                                                                                                  \
+      node = (SetNode_##Type *)clip_alloc(set->allocator, sizeof(SetNode_##Type));                     \
+      if (!node)                                                                                       \
+      {                                                                                                \
+        fprintf(stderr, "Memory allocation failed!\n");                                                \
+        exit(EXIT_FAILURE);                                                                            \
+      }                                                                                                \
     }                                                                                                  \
     node->value = value;                                                                               \
     node->left = node->right = node->parent = NULL;                                                    \
@@ -121,6 +159,14 @@
     return node;                                                                                       \
   }                                                                                                    \
                                                                                                        \
+  static inline void set_node_release_##Type(Set_##Type *set, SetNode_##Type *node)                    \
+  {                                                                                                    \
+    if (POOL_CHUNK)                                                                                    \
+      clip_pool_release(set->pool, node);                                                              \
+    else                                                                                               \
+      clip_free(set->allocator, node, sizeof(SetNode_##Type));                                         \
+  }                                                                                                    \
+                                                                                                       \
   static inline void rotate_left_##Type(Set_##Type *set, SetNode_##Type *x)                            \
   {                                                                                                    \
     SetNode_##Type *y = x->right;                                                                      \
@@ -318,7 +364,7 @@
       y = x;                                                                                           \
       x = (cmp < 0) ? x->left : x->right;                                                              \
     }                                                                                                  \
-    SetNode_##Type *z = set_node_new_##Type(value);                                                    \
+    SetNode_##Type *z = set_node_new_##Type(set, value);                                               \
     z->parent = y;                                                                                     \
     if (!y)                                                                                            \
       set->root = z;                                                                                   \
@@ -415,7 +461,7 @@
       y->color = z->color;                                                                             \
     }                                                                                                  \
                                                                                                        \
-    free(z);                                                                                           \
+    set_node_release_##Type(set, z);                                                                   \
     set->size--;                                                                                       \
                                                                                                        \
     if (y_original_color == SET_BLACK_##Type)                                                          \
@@ -424,7 +470,7 @@
     return true;                                                                                       \
   }                                                                                                    \
                                                                                                        \
-  static inline int                                                                                    \
+  static inline clip_size_t                                                                            \
   set_size_##Type(Set_##Type *set)                                                                     \
   {                                                                                                    \
     return set->size;                                                                                  \
@@ -435,23 +481,29 @@
     return set->size == 0;                                                                             \
   }                                                                                                    \
                                                                                                        \
-  static inline void set_clear_node_##Type(SetNode_##Type *node)                                       \
+  static inline void set_clear_node_##Type(Set_##Type *set, SetNode_##Type *node)                      \
   {                                                                                                    \
     if (!node)                                                                                         \
       return;                                                                                          \
-    set_clear_node_##Type(node->left);                                                                 \
-    set_clear_node_##Type(node->right);                                                                \
+    set_clear_node_##Type(set, node->left);                                                            \
+    set_clear_node_##Type(set, node->right);                                                           \
     void (*Dtor_fn)(Type *) = FREE_FN;                                                                 \
     if (Dtor_fn)                                                                                       \
     {                                                                                                  \
       (Dtor_fn)(&node->value);                                                                         \
     }                                                                                                  \
-    free(node);                                                                                        \
+    if (!POOL_CHUNK)                                                                                   \
+      clip_free(set->allocator, node, sizeof(SetNode_##Type));                                         \
   }                                                                                                    \
                                                                                                        \
   static inline void set_clear_##Type(Set_##Type *set)                                                 \
   {                                                                                                    \
-    set_clear_node_##Type(set->root);                                                                  \
+    void (*Dtor_fn)(Type *) = FREE_FN;                                                                 \
+    /* Pooled nodes without a destructor are dropped wholesale by the pool reset */                    \
+    if (!POOL_CHUNK || Dtor_fn)                                                                        \
+      set_clear_node_##Type(set, set->root);                                                           \
+    if (set->pool)                                                                                     \
+      clip_pool_reset(set->pool);                                                                      \
     set->root = NULL;                                                                                  \
     set->size = 0;                                                                                     \
   }                                                                                                    \
@@ -477,14 +529,14 @@
    * Elements that already exist in dest will not be duplicated.                                       \
    * @return The number of elements successfully added from src to dest.                               \
    */                                                                                                  \
-  static inline int set_join_##Type(Set_##Type *dest, Set_##Type *src)                                 \
+  static inline clip_size_t set_join_##Type(Set_##Type *dest, Set_##Type *src)                         \
   {                                                                                                    \
     if (!src || !dest || set_empty_##Type(src))                                                        \
       return 0;                                                                                        \
                                                                                                        \
-    int initial_size = set_size_##Type(dest);                                                          \
+    clip_size_t initial_size = set_size_##Type(dest);                                                  \
     set_join_recursive_##Type(dest, src->root);                                                        \
-    int final_size = set_size_##Type(dest);                                                            \
+    clip_size_t final_size = set_size_##Type(dest);                                                    \
     set_clear_##Type(src);                                                                             \
     return final_size - initial_size;                                                                  \
   }                                                                                                    \
@@ -492,27 +544,43 @@
   static inline void free_set_##Type(Set_##Type *set)                                                  \
   {                                                                                                    \
     set_clear_##Type(set);                                                                             \
+    if (set->pool)                                                                                     \
+    {                                                                                                  \
+      clip_pool_destroy(set->pool);                                                                    \
+      clip_free(set->allocator, set->pool, sizeof(CLIP_NodePool));                                     \
+      set->pool = NULL;                                                                                \
+    }                                                                                                  \
   }                                                                                                    \
                                                                                                        \
-  static inline void set_to_str_node_##Type(SetNode_##Type *node, char *buf,                           \
-                                            size_t size,                                               \
-                                            void (*elem_to_str)(Type, char *, size_t),                 \
-                                            bool *is_first)                                            \
+  static inline bool set_write_node_##Type(SetNode_##Type *node, CLIP_StrBuf *out,                     \
+                                           void (*elem_to_str)(Type, char *, size_t),                  \
+                                           bool *is_first)                                             \
   {                                                                                                    \
     if (!node)                                                                                         \
-      return;                                                                                          \
-    set_to_str_node_##Type(node->left, buf, size, elem_to_str, is_first);                              \
-    if (!*is_first)                                                                                    \
-    {                                                                                                  \
-      size_t current_len = strlen(buf);                                                                \
-      if (current_len + 2 < size)                                                                      \
-        strcat(buf, ", ");                                                                             \
-    }                                                                                                  \
-    size_t current_len = strlen(buf);                                                                  \
-    if (current_len < size)                                                                            \
-      elem_to_str(node->value, buf + current_len, size - current_len);                                 \
+      return true;                                                                                     \
+    if (!set_write_node_##Type(node->left, out, elem_to_str, is_first))                                \
+      return false;                                                                                    \
+    if (!*is_first && !clip_strbuf_append(out, ", ", 2))                                               \
+      return false;                                                                                    \
+    char *elem = clip_strbuf_reserve(out, BUF_SIZE);                                                   \
+    if (!elem)                                                                                         \
+      return false;                                                                                    \
+    elem[0] = '\0';                                                                                    \
+    elem_to_str(node->value, elem, BUF_SIZE);                                                          \
+    clip_strbuf_commit_str(out, BUF_SIZE);                                                             \
     *is_first = false;                                                                                 \
-    set_to_str_node_##Type(node->right, buf, size, elem_to_str, is_first);                             \
+    return set_write_node_##Type(node->right, out, elem_to_str, is_first);                             \
+  }                                                                                                    \
+                                                                                                       \
+  static inline bool set_write_##Type##_custom(Set_##Type *set, CLIP_StrBuf *out,                      \
+                                               void (*elem_to_str)(Type, char *, size_t))              \
+  {                                                                                                    \
+    if (!set || !clip_strbuf_putc(out, '{'))                                                           \
+      return false;                                                                                    \
+    bool is_first = true;                                                                              \
+    if (!set_write_node_##Type(set->root, out, elem_to_str, &is_first))                                \
+      return false;                                                                                    \
+    return clip_strbuf_putc(out, '}');                                                                 \
   }                                                                                                    \
                                                                                                        \
   static inline char *set_to_str_##Type##_custom(Set_##Type *set,                                      \
@@ -520,24 +588,17 @@
   {                                                                                                    \
     if (!set)                                                                                          \
       return NULL;                                                                                     \
-    size_t bufsize = set->size * BUF_SIZE + 16;                                                        \
-    char *buffer = malloc(bufsize);                                                                    \
-    if (!buffer)                                                                                       \
-      return NULL;                                                                                     \
-    strcpy(buffer, "{");                                                                               \
-    bool is_first = true;                                                                              \
-    set_to_str_node_##Type(set->root, buffer, bufsize, elem_to_str, &is_first);                        \
-    size_t current_len = strlen(buffer);                                                               \
-    if (current_len + 1 < bufsize)                                                                     \
-      strcat(buffer, "}");                                                                             \
-    return buffer;                                                                                     \
+    CLIP_StrBuf out;                                                                                   \
+    clip_strbuf_init(&out);                                                                            \
+    set_write_##Type##_custom(set, &out, elem_to_str);                                                 \
+    return clip_strbuf_detach(&out);                                                                   \
   }
 
 /**
  * @brief Registers the default print function for a specific set type.
  *
- * This macro **defines** the `set_to_str_<Type>_main` function, which is used
- * by convenience macros like `Set_to_str` and `Set_print`.
+ * This macro **defines** the `set_write_<Type>_main` and `set_to_str_<Type>_main` functions,
+ * which are used by convenience macros like `Set_write`, `Set_to_str` and `Set_print`.
  *
  * @param Type The element type for which to register the print function.
  * @param print_fn The function with signature: `void func(Type, char*, size_t)`.
@@ -560,15 +621,25 @@
  * Set_print(int, &xs);  // Uses registered function!
  * ```
  */
-#define CLIP_REGISTER_SET_PRINT(Type, print_fn)                              \
-  static inline char *set_to_str_##Type##_main(Set_##Type *set)              \
-  {                                                                          \
-    if (!print_fn)                                                           \
-    {                                                                        \
-      fprintf(stderr, "No print function registered for type " #Type "!\n"); \
-      return NULL;                                                           \
-    }                                                                        \
-    return set_to_str_##Type##_custom(set, print_fn);                        \
+#define CLIP_REGISTER_SET_PRINT(Type, print_fn)                                 \
+  static inline bool set_write_##Type##_main(Set_##Type *set, CLIP_StrBuf *out) \
+  {                                                                             \
+    if (!print_fn)                                                              \
+    {                                                                           \
+      fprintf(stderr, "No print function registered for type " #Type "!\n");    \
+      return false;                                                             \
+    }                                                                           \
+    return set_write_##Type##_custom(set, out, print_fn);                       \
+  }                                                                             \
+                                                                                \
+  static inline char *set_to_str_##Type##_main(Set_##Type *set)                 \
+  {                                                                             \
+    if (!print_fn)                                                              \
+    {                                                                           \
+      fprintf(stderr, "No print function registered for type " #Type "!\n");    \
+      return NULL;                                                              \
+    }                                                                           \
+    return set_to_str_##Type##_custom(set, print_fn);                           \
   }
 
 /**
@@ -588,6 +659,12 @@
  */
 #define Set_init(Type) init_set_##Type()
 
+/**
+ * @def Set_init_with_allocator(Type, allocator)
+ * @brief Initialize an empty set whose nodes come from `allocator` (a `const CLIP_Allocator *`, NULL for the default).
+ */
+#define Set_init_with_allocator(Type, allocator) init_set_with_allocator_##Type(allocator)
+
 /**
  * @def Set_insert(Type, set, val)
  * @brief Insert a value into the set.
@@ -659,6 +736,51 @@
  */
 #define Set_to_str_custom(Type, set, fn) set_to_str_##Type##_custom(set, fn)
 
+/**
+ * @def Set_write(Type, set, out)
+ * @brief Stream the set contents into the `CLIP_StrBuf` `out` using the registered
+ * print function. Produces the same text as `Set_to_str` in linear time, without
+ * building the whole string first.
+ *
+ * @return false if the writer failed.
+ * @note You must call `CLIP_REGISTER_SET_PRINT(Type, fn)` for this type first.
+ */
+#define Set_write(Type, set, out) set_write_##Type##_main(set, out)
+
+/**
+ * @def Set_write_custom(Type, set, out, fn)
+ * @brief Stream the set contents into `out` using a user-supplied
+ *        element-to-string function.
+ */
+#define Set_write_custom(Type, set, out, fn) set_write_##Type##_custom(set, out, fn)
+
+/**
+ * @def Set_fprint(Type, set, file)
+ * @brief Stream the set to a `FILE *` through a fixed-size buffer using the
+ * registered print function. (Does not print a trailing newline)
+ */
+#define Set_fprint(Type, set, file)     \
+  do                                    \
+  {                                     \
+    CLIP_StrBuf _out;                   \
+    clip_strbuf_init_file(&_out, file); \
+    Set_write(Type, set, &_out);        \
+    clip_strbuf_free(&_out);            \
+  } while (0)
+
+/**
+ * @def Set_fprint_custom(Type, set, file, fn)
+ * @brief Stream the set to a `FILE *` using the given element-to-string function.
+ */
+#define Set_fprint_custom(Type, set, file, fn) \
+  do                                           \
+  {                                            \
+    CLIP_StrBuf _out;                          \
+    clip_strbuf_init_file(&_out, file);        \
+    Set_write_custom(Type, set, &_out, fn);    \
+    clip_strbuf_free(&_out);                   \
+  } while (0)
+
 /**
  * @def Set_print(Type, set)
  * @brief Pretty-print a set directly to stdout using the registered
@@ -666,32 +788,14 @@
  *
  * @note You must call `CLIP_REGISTER_SET_PRINT(Type, fn)` for this type first.
  */
-#define Set_print(Type, set)                \
-  do                                        \
-  {                                         \
-    char *_tmp_str = Set_to_str(Type, set); \
-    if (_tmp_str)                           \
-    {                                       \
-      printf("%s", _tmp_str);               \
-      free(_tmp_str);                       \
-    }                                       \
-  } while (0)
+#define Set_print(Type, set) Set_fprint(Type, set, stdout)
 
 /**
  * @def Set_print_custom(Type, set, fn)
  * @brief Pretty-print a set directly to stdout using the given
  * element-to-string function. (Does not print the end-line character)
  */
-#define Set_print_custom(Type, set, fn)                \
-  do                                                   \
-  {                                                    \
-    char *_tmp_str = Set_to_str_custom(Type, set, fn); \
-    if (_tmp_str)                                      \
-    {                                                  \
-      printf("%s", _tmp_str);                          \
-      free(_tmp_str);                                  \
-    }                                                  \
-  } while (0)
+#define Set_print_custom(Type, set, fn) Set_fprint_custom(Type, set, stdout, fn)
 
 /**
  * @def Set_println(Type, set)
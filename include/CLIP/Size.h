@@ -0,0 +1,104 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Size type and overflow-safe growth policy shared by the CLIP containers.
+ *
+ * Sizes, capacities and indices of every container use `clip_size_t`. It is
+ * `int` by default. Defining `CLIP_64BIT_SIZES` before including any CLIP
+ * header switches it to `ptrdiff_t`, so a single container can hold more than
+ * 2^31 - 1 elements. It stays signed either way, so negative indices are still
+ * rejected by the bounds checks. The mode must be the same in every
+ * translation unit that shares container types.
+ *
+ * Growth goes through `clip_grow_capacity`. It never overflows: it clamps to the
+ * largest capacity whose byte size fits in `size_t`, and fails when even that
+ * is too small. Capacities grow by `CLIP_GROWTH_NUM / CLIP_GROWTH_DEN` (2x by
+ * default). Once a block reaches `CLIP_LARGE_GROWTH_THRESHOLD` bytes they grow
+ * by `CLIP_LARGE_GROWTH_NUM / CLIP_LARGE_GROWTH_DEN` instead (1.5x by default),
+ * which keeps the overshoot of very large containers in check. All of these
+ * can be overridden before including the headers.
+ */
+#ifndef CLIP_SIZE_H
+#define CLIP_SIZE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+
+#ifdef CLIP_64BIT_SIZES
+typedef ptrdiff_t clip_size_t;
+#define CLIP_SIZE_MAX PTRDIFF_MAX
+#else
+typedef int clip_size_t;
+#define CLIP_SIZE_MAX INT_MAX
+#endif
+
+/* Growth factor for small and medium blocks. */
+#ifndef CLIP_GROWTH_NUM
+#define CLIP_GROWTH_NUM 2
+#define CLIP_GROWTH_DEN 1
+#endif
+
+/* Block size in bytes from which the large growth factor applies. */
+#ifndef CLIP_LARGE_GROWTH_THRESHOLD
+#define CLIP_LARGE_GROWTH_THRESHOLD ((size_t)64 << 20)
+#endif
+
+/* Growth factor for blocks of at least `CLIP_LARGE_GROWTH_THRESHOLD` bytes. */
+#ifndef CLIP_LARGE_GROWTH_NUM
+#define CLIP_LARGE_GROWTH_NUM 3
+#define CLIP_LARGE_GROWTH_DEN 2
+#endif
+
+/**
+ * @brief Computes `a * b`, returning `false` (and leaving `*out` untouched) if it overflows `size_t`.
+ */
+static inline bool clip_size_mul(size_t a, size_t b, size_t *out)
+{
+  size_t r;
+  if (__builtin_mul_overflow(a, b, &r))
+    return false;
+  *out = r;
+  return true;
+}
+
+/**
+ * @brief Largest element count whose byte size (`count * elem_size`) fits in a `size_t`.
+ */
+static inline clip_size_t clip_max_capacity(size_t elem_size)
+{
+  size_t max = elem_size ? SIZE_MAX / elem_size : SIZE_MAX;
+  return max < (size_t)CLIP_SIZE_MAX ? (clip_size_t)max : CLIP_SIZE_MAX;
+}
+
+/**
+ * @brief Capacity to grow a block of `capacity` elements to so that `needed` elements fit.
+ *
+ * @param capacity Current capacity (0 for an empty block)
+ * @param needed Minimum number of elements the block must hold
+ * @param elem_size Size of one element, used for the overflow check and the large-growth threshold
+ * @return The new capacity (>= needed), or -1 if `needed` elements cannot be represented
+ */
+static inline clip_size_t clip_grow_capacity(clip_size_t capacity, clip_size_t needed, size_t elem_size)
+{
+  clip_size_t max = clip_max_capacity(elem_size);
+  if (needed < 0 || needed > max)
+    return -1;
+  clip_size_t new_capacity = capacity > 0 ? capacity : 1;
+  while (new_capacity < needed)
+  {
+    bool large = (size_t)new_capacity >= CLIP_LARGE_GROWTH_THRESHOLD / (elem_size ? elem_size : 1);
+    clip_size_t num = large ? CLIP_LARGE_GROWTH_NUM : CLIP_GROWTH_NUM;
+    clip_size_t den = large ? CLIP_LARGE_GROWTH_DEN : CLIP_GROWTH_DEN;
+    /* capacity * (num - den) / den, without forming the full product */
+    clip_size_t step = new_capacity / den > max / (num - den)
+                           ? max
+                           : new_capacity / den * (num - den) + new_capacity % den * (num - den) / den;
+    if (step < 1)
+      step = 1;
+    new_capacity = new_capacity > max - step ? max : new_capacity + step;
+  }
+  return new_capacity;
+}
+
+#endif /* CLIP_SIZE_H */
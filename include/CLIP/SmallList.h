@@ -0,0 +1,335 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief In this file we define a series of macros that generates a **type-safe**
+ * small-buffer-optimized list for any given element type in C.
+ *
+ * A `SmallList(Type)` stores up to N elements inside the struct itself and
+ * only moves them to the heap once the N + 1-th element is added, so short
+ * lists never touch the allocator. The struct holds no pointer to itself, so
+ * it can be returned and copied by value like a `List`.
+ *
+ * Example:
+ * CLIP_DEFINE_SMALL_LIST_TYPE(int, 8)
+ *
+ * SmallList(int) xs = SmallList_init(int);
+ * SmallList_append(int, &xs, 42); // No allocation until the 9th element
+ * SmallList_free(int, &xs);
+ *
+ * The following methods are generated automatically:
+ * - init
+ * - init_with_allocator
+ * - data
+ * - is_inline
+ * - ensure_capacity
+ * - append
+ * - pop
+ * - replace
+ * - insert
+ * - get
+ * - get_ptr
+ * - at
+ * - at_ptr
+ * - remove_at
+ * - clear
+ * - reserve
+ * - free
+ */
+#ifndef CLIP_SMALL_LIST_H
+#define CLIP_SMALL_LIST_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+
+/**
+ * @brief Define a type-safe list storing up to `N` elements inline.
+ *
+ * @param Type The element type (e.g., `int`, `float`, `struct Foo`).
+ * @param N Number of elements stored inside the struct before spilling to the heap (at least 1).
+ */
+#define CLIP_DEFINE_SMALL_LIST_TYPE(Type, N) \
+  CLIP_DEFINE_SMALL_LIST_TYPE_IMPL(Type, N, NULL)
+
+/**
+ * @brief Defines the SmallList type with a given free function
+ */
+#define CLIP_DEFINE_SMALL_LIST_TYPE_WITH_FREE(Type, N, FREE_FN) \
+  CLIP_DEFINE_SMALL_LIST_TYPE_IMPL(Type, N, FREE_FN)
+
+/**
+ * @brief Implementation of `CLIP_DEFINE_SMALL_LIST_TYPE`.
+ *
+ * @param Type The type
+ * @param N The inline capacity
+ * @param FREE_FN Destructor/Free function for the type (or NULL)
+ */
+#define CLIP_DEFINE_SMALL_LIST_TYPE_IMPL(Type, N, FREE_FN)                                 \
+  typedef struct                                                                           \
+  {                                                                                        \
+    clip_size_t size;                                                                      \
+    clip_size_t capacity; /* N while inline, the heap capacity once spilled */             \
+    const CLIP_Allocator *allocator; /* Heap block source, NULL for the default */         \
+    union                                                                                  \
+    {                                                                                      \
+      Type inline_data[N];                                                                 \
+      Type *heap;                                                                          \
+    } storage;                                                                             \
+  } SmallList_##Type;                                                                      \
+                                                                                           \
+  static inline SmallList_##Type init_small_list_with_allocator_##Type(                    \
+      const CLIP_Allocator *allocator)                                                     \
+  {                                                                                        \
+    SmallList_##Type list;                                                                 \
+    list.size = 0;                                                                         \
+    list.capacity = N;                                                                     \
+    list.allocator = allocator;                                                            \
+    return list;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline SmallList_##Type init_small_list_##Type(void)                              \
+  {                                                                                        \
+    return init_small_list_with_allocator_##Type(NULL);                                    \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_is_inline_##Type(const SmallList_##Type *list)             \
+  {                                                                                        \
+    return list->capacity <= N;                                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline Type *small_list_data_##Type(SmallList_##Type *list)                       \
+  {                                                                                        \
+    return list->capacity > N ? list->storage.heap : list->storage.inline_data;            \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_reserve_##Type(SmallList_##Type *list,                     \
+                                               clip_size_t capacity)                       \
+  {                                                                                        \
+    if (capacity <= list->capacity)                                                        \
+      return true;                                                                         \
+    if (capacity > clip_max_capacity(sizeof(Type)))                                        \
+      return false;                                                                        \
+    if (small_list_is_inline_##Type(list))                                                 \
+    {                                                                                      \
+      /* Spill: move the inline elements to a new heap block */                            \
+      Type *heap = clip_alloc(list->allocator, (size_t)capacity * sizeof(Type));           \
+      if (!heap)                                                                           \
+        return false;                                                                      \
+      memcpy(heap, list->storage.inline_data, list->size * sizeof(Type));                  \
+      list->storage.heap = heap;                                                           \
+    }                                                                                      \
+    else                                                                                   \
+    {                                                                                      \
+      Type *heap = clip_realloc(list->allocator, list->storage.heap,                       \
+                                (size_t)list->capacity * sizeof(Type),                     \
+                                (size_t)capacity * sizeof(Type));                          \
+      if (!heap)                                                                           \
+        return false;                                                                      \
+      list->storage.heap = heap;                                                           \
+    }                                                                                      \
+    list->capacity = capacity;                                                             \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_ensure_capacity_##Type(SmallList_##Type *list,             \
+                                                       clip_size_t needed)                 \
+  {                                                                                        \
+    if (needed > CLIP_SIZE_MAX - list->size)                                               \
+      return false;                                                                        \
+    if (list->size + needed > list->capacity)                                              \
+    {                                                                                      \
+      clip_size_t new_capacity =                                                           \
+          clip_grow_capacity(list->capacity, list->size + needed, sizeof(Type));           \
+      if (new_capacity < 0)                                                                \
+        return false;                                                                      \
+      return small_list_reserve_##Type(list, new_capacity);                                \
+    }                                                                                      \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_append_##Type(SmallList_##Type *list, Type value)          \
+  {                                                                                        \
+    if (!small_list_ensure_capacity_##Type(list, 1))                                       \
+      return false;                                                                        \
+    small_list_data_##Type(list)[list->size++] = value;                                    \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_pop_##Type(SmallList_##Type *list, Type *out)              \
+  {                                                                                        \
+    if (list->size == 0)                                                                   \
+      return false;                                                                        \
+    if (out)                                                                               \
+      *out = small_list_data_##Type(list)[list->size - 1];                                 \
+    list->size--;                                                                          \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_replace_##Type(SmallList_##Type *list, clip_size_t index,  \
+                                               Type value)                                 \
+  {                                                                                        \
+    if (index < 0 || index >= list->size)                                                  \
+      return false;                                                                        \
+    small_list_data_##Type(list)[index] = value;                                           \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_insert_##Type(SmallList_##Type *list, clip_size_t index,   \
+                                              Type value)                                  \
+  {                                                                                        \
+    if (index < 0 || index > list->size)                                                   \
+      return false;                                                                        \
+    if (!small_list_ensure_capacity_##Type(list, 1))                                       \
+      return false;                                                                        \
+    Type *data = small_list_data_##Type(list);                                             \
+    memmove(&data[index + 1], &data[index], (list->size - index) * sizeof(Type));          \
+    data[index] = value;                                                                   \
+    list->size++;                                                                          \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline Type small_list_get_##Type(SmallList_##Type *list, clip_size_t index)      \
+  {                                                                                        \
+    if (index < 0 || index >= list->size)                                                  \
+    {                                                                                      \
+      fprintf(stderr, "SmallList index out of bounds\n");                                  \
+      return (Type){0};                                                                    \
+    }                                                                                      \
+    return small_list_data_##Type(list)[index];                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline Type *small_list_get_ptr_##Type(SmallList_##Type *list, clip_size_t index) \
+  {                                                                                        \
+    if (index < 0 || index >= list->size)                                                  \
+    {                                                                                      \
+      fprintf(stderr, "SmallList index out of bounds\n");                                  \
+      return NULL;                                                                         \
+    }                                                                                      \
+    return &small_list_data_##Type(list)[index];                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline Type small_list_at_##Type(SmallList_##Type *list, clip_size_t index)       \
+  {                                                                                        \
+    return small_list_data_##Type(list)[index];                                            \
+  }                                                                                        \
+                                                                                           \
+  static inline Type *small_list_at_ptr_##Type(SmallList_##Type *list, clip_size_t index)  \
+  {                                                                                        \
+    return &small_list_data_##Type(list)[index];                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline bool small_list_remove_at_##Type(SmallList_##Type *list,                   \
+                                                 clip_size_t index)                        \
+  {                                                                                        \
+    if (index < 0 || index >= list->size)                                                  \
+      return false;                                                                        \
+    Type *data = small_list_data_##Type(list);                                             \
+    memmove(&data[index], &data[index + 1], (list->size - index - 1) * sizeof(Type));      \
+    list->size--;                                                                          \
+    return true;                                                                           \
+  }                                                                                        \
+                                                                                           \
+  static inline void small_list_clear_##Type(SmallList_##Type *list) { list->size = 0; }   \
+                                                                                           \
+  static inline void free_small_list_##Type(SmallList_##Type *list)                        \
+  {                                                                                        \
+    void (*Dtor_fn)(Type *) = FREE_FN;                                                     \
+    Type *data = small_list_data_##Type(list);                                             \
+    if (Dtor_fn)                                                                           \
+    {                                                                                      \
+      for (clip_size_t i = 0; i < list->size; i++)                                         \
+        (Dtor_fn)(&data[i]);                                                               \
+    }                                                                                      \
+    if (!small_list_is_inline_##Type(list))                                                \
+      clip_free(list->allocator, list->storage.heap,                                       \
+                (size_t)list->capacity * sizeof(Type));                                    \
+    list->size = 0;                                                                        \
+    list->capacity = N;                                                                    \
+  }
+
+/**
+ * @def SmallList(Type)
+ * @brief Alias to the generated `SmallList_<Type>` struct.
+ */
+#define SmallList(Type) SmallList_##Type
+
+/**
+ * @def SmallList_init(Type)
+ * @brief Initialize an empty small list. Never allocates.
+ */
+#define SmallList_init(Type) init_small_list_##Type()
+
+/**
+ * @def SmallList_init_with_allocator(Type, allocator)
+ * @brief Initialize an empty small list that spills to `allocator` (a `const CLIP_Allocator *`, NULL for the default).
+ */
+#define SmallList_init_with_allocator(Type, allocator) init_small_list_with_allocator_##Type(allocator)
+
+/**
+ * @def SmallList_data(Type, list)
+ * @brief Pointer to the first element (inline buffer or heap block).
+ */
+#define SmallList_data(Type, list) small_list_data_##Type(list)
+
+/**
+ * @def SmallList_is_inline(Type, list)
+ * @brief Returns `true` while the elements are still stored inside the struct.
+ */
+#define SmallList_is_inline(Type, list) small_list_is_inline_##Type(list)
+
+#define SmallList_append(Type, list, val) small_list_append_##Type(list, val)
+
+#define SmallList_pop(Type, list, val) small_list_pop_##Type(list, val)
+
+#define SmallList_replace(Type, list, i, val) small_list_replace_##Type(list, i, val)
+
+#define SmallList_insert(Type, list, i, val) small_list_insert_##Type(list, i, val)
+
+/**
+ * @def SmallList_get(Type, list, index)
+ * @brief Get the element at the given index, with bounds checking (see `List_get`).
+ */
+#define SmallList_get(Type, list, index) small_list_get_##Type(list, index)
+
+#define SmallList_get_ptr(Type, list, index) small_list_get_ptr_##Type(list, index)
+
+/**
+ * @def SmallList_at(Type, list, index)
+ * @brief Get the element at the given index without bounds checking (see `List_at`).
+ */
+#define SmallList_at(Type, list, index) small_list_at_##Type(list, index)
+
+#define SmallList_at_ptr(Type, list, index) small_list_at_ptr_##Type(list, index)
+
+#define SmallList_remove_at(Type, list, i) small_list_remove_at_##Type(list, i)
+
+#define SmallList_clear(Type, list) small_list_clear_##Type(list)
+
+/**
+ * @def SmallList_reserve(Type, list, cap)
+ * @brief Make room for `cap` elements (moves the elements to the heap if `cap` > N).
+ */
+#define SmallList_reserve(Type, list, cap) small_list_reserve_##Type(list, cap)
+
+/**
+ * @def SmallList_free(Type, list)
+ * @brief Free the heap block (if any) and reset the list to an empty inline list.
+ */
+#define SmallList_free(Type, list) free_small_list_##Type(list)
+
+#define SmallList_free_fn(Type) free_small_list_##Type
+
+/**
+ * @def SmallList_foreach(Type, var, list)
+ * @brief Iterates over the list, providing a pointer to the current element (see `List_foreach`).
+ */
+#define SmallList_foreach(Type, var, list)                   \
+  for (clip_size_t _i_##var = 0, _size_##var = (list)->size; \
+       _i_##var < _size_##var;                               \
+       _i_##var++)                                           \
+    for (Type *var = &small_list_data_##Type(list)[_i_##var]; var != NULL; var = NULL)
+
+#endif /* CLIP_SMALL_LIST_H */
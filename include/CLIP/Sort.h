@@ -0,0 +1,1176 @@
+/*
+ * \author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Type-specialized sorting kernels shared by the containers.
+ *
+ * `CLIP_DEFINE_SORT` generates a pattern-defeating quicksort (pdqsort) for a
+ * single element type. The comparison is a macro argument, so it is pasted
+ * directly into the generated code: passing a function name produces direct
+ * (inlinable) calls, passing a function-like macro such as `CLIP_SORT_ASC`
+ * expands the comparison in place, and passing the name of the `comparator`
+ * parameter keeps a runtime comparator (this is what `List_sort` does).
+ *
+ * The algorithm is introsort-like: median-of-3 (ninther above 128 elements)
+ * pivots, insertion sort below 24 elements, a separate partition for runs of
+ * elements equal to the pivot, pattern breaking on unbalanced partitions and a
+ * heapsort fallback that bounds the worst case to O(n log n). Already sorted
+ * (or nearly sorted) inputs are detected and finish in linear time.
+ *
+ * `CLIP_DEFINE_STABLE_SORT` generates a timsort with the same `CMP` convention:
+ * it finds the natural runs of the input (reversing strictly descending ones),
+ * extends short runs with binary insertion sort and merges them with galloping
+ * merges, so nearly sorted inputs or concatenations of sorted batches take
+ * close to linear time. Equal elements keep their original order.
+ *
+ * `CLIP_DEFINE_RADIX_SORT` generates a stable byte-wise LSD radix sort driven
+ * by a key extractor that maps each element to an order-preserving `uint64_t`.
+ * The `clip_radix_key_*` helpers provide those keys for the integer and
+ * floating-point types (signed values get their sign bit flipped, IEEE floats
+ * are bit-transformed so that the unsigned order matches the numeric one).
+ *
+ * Example:
+ * CLIP_DEFINE_SORT(ints_asc, int, CLIP_SORT_ASC)
+ * CLIP_DEFINE_RADIX_SORT(ints, int)
+ *
+ * int xs[] = {3, 1, 2};
+ * clip_sort_ints_asc(xs, 3, NULL);
+ * clip_radix_sort_ints(xs, 3, clip_radix_key_int, NULL);
+ */
+#ifndef CLIP_SORT_H
+#define CLIP_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <CLIP/Allocator.h>
+
+/* Partitions below this size are sorted with insertion sort. */
+#define CLIP_SORT_INSERTION_THRESHOLD 24
+
+/* Partitions above this size use the ninther as pivot. */
+#define CLIP_SORT_NINTHER_THRESHOLD 128
+
+/* Element moves allowed in a partial insertion sort before giving up. */
+#define CLIP_SORT_PARTIAL_INSERTION_LIMIT 8
+
+/**
+ * @brief Ascending comparison for arithmetic types, usable as the `CMP` argument.
+ */
+#define CLIP_SORT_ASC(a, b) ((*(a) > *(b)) - (*(a) < *(b)))
+
+/**
+ * @brief Descending comparison for arithmetic types, usable as the `CMP` argument.
+ */
+#define CLIP_SORT_DESC(a, b) ((*(a) < *(b)) - (*(a) > *(b)))
+
+/**
+ * @brief Generates `clip_sort_<Name>(Type *data, size_t n, int (*comparator)(const Type *, const Type *))`.
+ *
+ * @param Name Suffix of the generated functions
+ * @param Type The element type
+ * @param CMP Comparison invoked as `CMP(const Type *a, const Type *b)` returning <0, 0 or >0.
+ * It can be a function, a function-like macro or `comparator` (the runtime comparator parameter,
+ * which is otherwise ignored and may be NULL).
+ */
+#define CLIP_DEFINE_SORT(Name, Type, CMP)                                                                  \
+                                                                                                           \
+  static inline void clip_sort_swap_##Name(Type *a, Type *b)                                               \
+  {                                                                                                        \
+    Type tmp = *a;                                                                                         \
+    *a = *b;                                                                                               \
+    *b = tmp;                                                                                              \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_insertion_##Name(Type *begin, Type *end,                                    \
+                                                int (*comparator)(const Type *, const Type *))             \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    if (begin == end)                                                                                      \
+      return;                                                                                              \
+    for (Type *cur = begin + 1; cur != end; cur++)                                                         \
+    {                                                                                                      \
+      Type *sift = cur;                                                                                    \
+      if (CMP(sift, sift - 1) < 0)                                                                         \
+      {                                                                                                    \
+        Type tmp = *sift;                                                                                  \
+        do                                                                                                 \
+        {                                                                                                  \
+          *sift = *(sift - 1);                                                                             \
+          sift--;                                                                                          \
+        } while (sift != begin && CMP(&tmp, sift - 1) < 0);                                                \
+        *sift = tmp;                                                                                       \
+      }                                                                                                    \
+    }                                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  /* Insertion sort for a partition that has an element <= all of its elements right before `begin` */     \
+  static inline void clip_sort_unguarded_insertion_##Name(Type *begin, Type *end,                          \
+                                                          int (*comparator)(const Type *, const Type *))   \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    if (begin == end)                                                                                      \
+      return;                                                                                              \
+    for (Type *cur = begin + 1; cur != end; cur++)                                                         \
+    {                                                                                                      \
+      Type *sift = cur;                                                                                    \
+      if (CMP(sift, sift - 1) < 0)                                                                         \
+      {                                                                                                    \
+        Type tmp = *sift;                                                                                  \
+        do                                                                                                 \
+        {                                                                                                  \
+          *sift = *(sift - 1);                                                                             \
+          sift--;                                                                                          \
+        } while (CMP(&tmp, sift - 1) < 0);                                                                 \
+        *sift = tmp;                                                                                       \
+      }                                                                                                    \
+    }                                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  /* Insertion sort that gives up (returning false) once too many elements had to be moved */              \
+  static inline bool clip_sort_partial_insertion_##Name(Type *begin, Type *end,                            \
+                                                        int (*comparator)(const Type *, const Type *))     \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    if (begin == end)                                                                                      \
+      return true;                                                                                         \
+    size_t moved = 0;                                                                                      \
+    for (Type *cur = begin + 1; cur != end; cur++)                                                         \
+    {                                                                                                      \
+      if (moved > CLIP_SORT_PARTIAL_INSERTION_LIMIT)                                                       \
+        return false;                                                                                      \
+      Type *sift = cur;                                                                                    \
+      if (CMP(sift, sift - 1) < 0)                                                                         \
+      {                                                                                                    \
+        Type tmp = *sift;                                                                                  \
+        do                                                                                                 \
+        {                                                                                                  \
+          *sift = *(sift - 1);                                                                             \
+          sift--;                                                                                          \
+        } while (sift != begin && CMP(&tmp, sift - 1) < 0);                                                \
+        *sift = tmp;                                                                                       \
+        moved += (size_t)(cur - sift);                                                                     \
+      }                                                                                                    \
+    }                                                                                                      \
+    return true;                                                                                           \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_sift_down_##Name(Type *data, size_t root, size_t n,                         \
+                                                int (*comparator)(const Type *, const Type *))             \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    Type tmp = data[root];                                                                                 \
+    size_t child;                                                                                          \
+    while ((child = 2 * root + 1) < n)                                                                     \
+    {                                                                                                      \
+      if (child + 1 < n && CMP(&data[child], &data[child + 1]) < 0)                                        \
+        child++;                                                                                           \
+      if (CMP(&tmp, &data[child]) >= 0)                                                                    \
+        break;                                                                                             \
+      data[root] = data[child];                                                                            \
+      root = child;                                                                                        \
+    }                                                                                                      \
+    data[root] = tmp;                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_heap_##Name(Type *begin, Type *end,                                         \
+                                           int (*comparator)(const Type *, const Type *))                  \
+  {                                                                                                        \
+    size_t n = (size_t)(end - begin);                                                                      \
+    for (size_t i = n / 2; i-- > 0;)                                                                       \
+      clip_sort_sift_down_##Name(begin, i, n, comparator);                                                 \
+    for (size_t i = n; i-- > 1;)                                                                           \
+    {                                                                                                      \
+      clip_sort_swap_##Name(&begin[0], &begin[i]);                                                         \
+      clip_sort_sift_down_##Name(begin, 0, i, comparator);                                                 \
+    }                                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_sort2_##Name(Type *a, Type *b,                                              \
+                                            int (*comparator)(const Type *, const Type *))                 \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    if (CMP(b, a) < 0)                                                                                     \
+      clip_sort_swap_##Name(a, b);                                                                         \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_sort3_##Name(Type *a, Type *b, Type *c,                                     \
+                                            int (*comparator)(const Type *, const Type *))                 \
+  {                                                                                                        \
+    clip_sort_sort2_##Name(a, b, comparator);                                                              \
+    clip_sort_sort2_##Name(b, c, comparator);                                                              \
+    clip_sort_sort2_##Name(a, b, comparator);                                                              \
+  }                                                                                                        \
+                                                                                                           \
+  /* Partitions around *begin: [begin, pivot) < pivot <= (pivot, end). Returns the pivot position */       \
+  static inline Type *clip_sort_partition_right_##Name(Type *begin, Type *end, bool *already_partitioned,  \
+                                                       int (*comparator)(const Type *, const Type *))      \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    Type pivot = *begin;                                                                                   \
+    Type *first = begin;                                                                                   \
+    Type *last = end;                                                                                      \
+    /* The median-of-3 pivot selection guarantees an element >= pivot to the right */                      \
+    do                                                                                                     \
+    {                                                                                                      \
+      first++;                                                                                             \
+    } while (CMP(first, &pivot) < 0);                                                                      \
+    if (first - 1 == begin)                                                                                \
+    {                                                                                                      \
+      while (first < last)                                                                                 \
+      {                                                                                                    \
+        last--;                                                                                            \
+        if (CMP(last, &pivot) < 0)                                                                         \
+          break;                                                                                           \
+      }                                                                                                    \
+    }                                                                                                      \
+    else                                                                                                   \
+    {                                                                                                      \
+      do                                                                                                   \
+      {                                                                                                    \
+        last--;                                                                                            \
+      } while (CMP(last, &pivot) >= 0);                                                                    \
+    }                                                                                                      \
+    *already_partitioned = first >= last;                                                                  \
+    while (first < last)                                                                                   \
+    {                                                                                                      \
+      clip_sort_swap_##Name(first, last);                                                                  \
+      do                                                                                                   \
+      {                                                                                                    \
+        first++;                                                                                           \
+      } while (CMP(first, &pivot) < 0);                                                                    \
+      do                                                                                                   \
+      {                                                                                                    \
+        last--;                                                                                            \
+      } while (CMP(last, &pivot) >= 0);                                                                    \
+    }                                                                                                      \
+    Type *pivot_pos = first - 1;                                                                           \
+    *begin = *pivot_pos;                                                                                   \
+    *pivot_pos = pivot;                                                                                    \
+    return pivot_pos;                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  /* Partitions around *begin putting elements equal to the pivot on the left side */                      \
+  static inline Type *clip_sort_partition_left_##Name(Type *begin, Type *end,                              \
+                                                      int (*comparator)(const Type *, const Type *))       \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    Type pivot = *begin;                                                                                   \
+    Type *first = begin;                                                                                   \
+    Type *last = end;                                                                                      \
+    do                                                                                                     \
+    {                                                                                                      \
+      last--;                                                                                              \
+    } while (CMP(&pivot, last) < 0);                                                                       \
+    if (last + 1 == end)                                                                                   \
+    {                                                                                                      \
+      while (first < last)                                                                                 \
+      {                                                                                                    \
+        first++;                                                                                           \
+        if (CMP(&pivot, first) < 0)                                                                        \
+          break;                                                                                           \
+      }                                                                                                    \
+    }                                                                                                      \
+    else                                                                                                   \
+    {                                                                                                      \
+      do                                                                                                   \
+      {                                                                                                    \
+        first++;                                                                                           \
+      } while (CMP(&pivot, first) >= 0);                                                                   \
+    }                                                                                                      \
+    while (first < last)                                                                                   \
+    {                                                                                                      \
+      clip_sort_swap_##Name(first, last);                                                                  \
+      do                                                                                                   \
+      {                                                                                                    \
+        last--;                                                                                            \
+      } while (CMP(&pivot, last) < 0);                                                                     \
+      do                                                                                                   \
+      {                                                                                                    \
+        first++;                                                                                           \
+      } while (CMP(&pivot, first) >= 0);                                                                   \
+    }                                                                                                      \
+    *begin = *last;                                                                                        \
+    *last = pivot;                                                                                         \
+    return last;                                                                                           \
+  }                                                                                                        \
+                                                                                                           \
+  static inline void clip_sort_loop_##Name(Type *begin, Type *end, int bad_allowed, bool leftmost,         \
+                                           int (*comparator)(const Type *, const Type *))                  \
+  {                                                                                                        \
+    (void)comparator;                                                                                      \
+    for (;;)                                                                                               \
+    {                                                                                                      \
+      size_t size = (size_t)(end - begin);                                                                 \
+      if (size < CLIP_SORT_INSERTION_THRESHOLD)                                                            \
+      {                                                                                                    \
+        if (leftmost)                                                                                      \
+          clip_sort_insertion_##Name(begin, end, comparator);                                              \
+        else                                                                                               \
+          clip_sort_unguarded_insertion_##Name(begin, end, comparator);                                    \
+        return;                                                                                            \
+      }                                                                                                    \
+                                                                                                           \
+      size_t s2 = size / 2;                                                                                \
+      if (size > CLIP_SORT_NINTHER_THRESHOLD)                                                              \
+      {                                                                                                    \
+        clip_sort_sort3_##Name(begin, begin + s2, end - 1, comparator);                                    \
+        clip_sort_sort3_##Name(begin + 1, begin + (s2 - 1), end - 2, comparator);                          \
+        clip_sort_sort3_##Name(begin + 2, begin + (s2 + 1), end - 3, comparator);                          \
+        clip_sort_sort3_##Name(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comparator);                \
+        clip_sort_swap_##Name(begin, begin + s2);                                                          \
+      }                                                                                                    \
+      else                                                                                                 \
+        clip_sort_sort3_##Name(begin + s2, begin, end - 1, comparator);                                    \
+                                                                                                           \
+      /* The element before this partition is a previous pivot: if it equals ours, every element */        \
+      /* equal to the pivot can be put in place at once and skipped */                                     \
+      if (!leftmost && CMP(begin - 1, begin) >= 0)                                                         \
+      {                                                                                                    \
+        begin = clip_sort_partition_left_##Name(begin, end, comparator) + 1;                               \
+        continue;                                                                                          \
+      }                                                                                                    \
+                                                                                                           \
+      bool already_partitioned;                                                                            \
+      Type *pivot_pos = clip_sort_partition_right_##Name(begin, end, &already_partitioned, comparator);    \
+      size_t l_size = (size_t)(pivot_pos - begin);                                                         \
+      size_t r_size = (size_t)(end - (pivot_pos + 1));                                                     \
+                                                                                                           \
+      if (l_size < size / 8 || r_size < size / 8)                                                          \
+      {                                                                                                    \
+        /* Too many bad pivots: fall back to heapsort to keep O(n log n) */                                \
+        if (--bad_allowed == 0)                                                                            \
+        {                                                                                                  \
+          clip_sort_heap_##Name(begin, end, comparator);                                                   \
+          return;                                                                                          \
+        }                                                                                                  \
+        /* Break up patterns that may have caused the unbalanced partition */                              \
+        if (l_size >= CLIP_SORT_INSERTION_THRESHOLD)                                                       \
+        {                                                                                                  \
+          clip_sort_swap_##Name(begin, begin + l_size / 4);                                                \
+          clip_sort_swap_##Name(pivot_pos - 1, pivot_pos - l_size / 4);                                    \
+          if (l_size > CLIP_SORT_NINTHER_THRESHOLD)                                                        \
+          {                                                                                                \
+            clip_sort_swap_##Name(begin + 1, begin + (l_size / 4 + 1));                                    \
+            clip_sort_swap_##Name(begin + 2, begin + (l_size / 4 + 2));                                    \
+            clip_sort_swap_##Name(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));                            \
+            clip_sort_swap_##Name(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));                            \
+          }                                                                                                \
+        }                                                                                                  \
+        if (r_size >= CLIP_SORT_INSERTION_THRESHOLD)                                                       \
+        {                                                                                                  \
+          clip_sort_swap_##Name(pivot_pos + 1, pivot_pos + (1 + r_size / 4));                              \
+          clip_sort_swap_##Name(end - 1, end - r_size / 4);                                                \
+          if (r_size > CLIP_SORT_NINTHER_THRESHOLD)                                                        \
+          {                                                                                                \
+            clip_sort_swap_##Name(pivot_pos + 2, pivot_pos + (2 + r_size / 4));                            \
+            clip_sort_swap_##Name(pivot_pos + 3, pivot_pos + (3 + r_size / 4));                            \
+            clip_sort_swap_##Name(end - 2, end - (1 + r_size / 4));                                        \
+            clip_sort_swap_##Name(end - 3, end - (2 + r_size / 4));                                        \
+          }                                                                                                \
+        }                                                                                                  \
+      }                                                                                                    \
+      else if (already_partitioned &&                                                                      \
+               clip_sort_partial_insertion_##Name(begin, pivot_pos, comparator) &&                         \
+               clip_sort_partial_insertion_##Name(pivot_pos + 1, end, comparator))                         \
+      {                                                                                                    \
+        /* The input was (nearly) sorted already */                                                        \
+        return;                                                                                            \
+      }                                                                                                    \
+                                                                                                           \
+      /* Recurse into the smaller side and loop on the larger one to bound the stack depth */              \
+      if (l_size < r_size)                                                                                 \
+      {                                                                                                    \
+        clip_sort_loop_##Name(begin, pivot_pos, bad_allowed, leftmost, comparator);                        \
+        begin = pivot_pos + 1;                                                                             \
+        leftmost = false;                                                                                  \
+      }                                                                                                    \
+      else                                                                                                 \
+      {                                                                                                    \
+        clip_sort_loop_##Name(pivot_pos + 1, end, bad_allowed, false, comparator);                         \
+        end = pivot_pos;                                                                                   \
+      }                                                                                                    \
+    }                                                                                                      \
+  }                                                                                                        \
+                                                                                                           \
+  /**                                                                                                      \
+   * @brief Sorts `n` elements of `data` in place (not stable).                                            \
+   * @param comparator Runtime comparator, only used when `CMP` is `comparator`                            \
+   */                                                                                                      \
+  static inline void clip_sort_##Name(Type *data, size_t n, int (*comparator)(const Type *, const Type *)) \
+  {                                                                                                        \
+    if (n < 2)                                                                                             \
+      return;                                                                                              \
+    int bad_allowed = 0;                                                                                   \
+    for (size_t m = n; m > 1; m >>= 1)                                                                     \
+      bad_allowed++;                                                                                       \
+    clip_sort_loop_##Name(data, data + n, bad_allowed, true, comparator);                                  \
+  }
+
+/* Inputs shorter than this are sorted with a single binary insertion sort. */
+#define CLIP_TIMSORT_MIN_MERGE 32
+
+/* Initial number of consecutive wins from one run before a merge switches to galloping. */
+#define CLIP_TIMSORT_MIN_GALLOP 7
+
+/* Enough pending runs for any input size (run lengths grow at least like Fibonacci numbers). */
+#define CLIP_TIMSORT_MAX_RUNS 85
+
+/* Minimum run length for an input of `n` elements, so the number of runs is a power of two or slightly below */
+static inline ptrdiff_t clip_timsort_min_run(ptrdiff_t n)
+{
+  ptrdiff_t r = 0;
+  while (n >= CLIP_TIMSORT_MIN_MERGE)
+  {
+    r |= n & 1;
+    n >>= 1;
+  }
+  return n + r;
+}
+
+/**
+ * @brief Generates `clip_stable_sort_<Name>(Type *data, size_t n, int (*comparator)(const Type *, const Type *))`.
+ *
+ * Same parameters as `CLIP_DEFINE_SORT`. The sort allocates a temporary buffer of
+ * at most n / 2 elements (none for inputs that are a single run);
+ * `clip_stable_sort_with_allocator_<Name>` takes it from a given allocator.
+ */
+#define CLIP_DEFINE_STABLE_SORT(Name, Type, CMP)                                                                  \
+                                                                                                                  \
+  typedef struct                                                                                                  \
+  {                                                                                                               \
+    Type *a;                                                                                                      \
+    Type *tmp;                                                                                                    \
+    ptrdiff_t tmp_capacity;                                                                                       \
+    ptrdiff_t min_gallop;                                                                                         \
+    ptrdiff_t run_base[CLIP_TIMSORT_MAX_RUNS];                                                                    \
+    ptrdiff_t run_len[CLIP_TIMSORT_MAX_RUNS];                                                                     \
+    int stack_size;                                                                                               \
+    int (*comparator)(const Type *, const Type *);                                                                \
+    const CLIP_Allocator *allocator; /* Source of `tmp`, NULL for the default allocator */                        \
+  } ClipTimSort_##Name;                                                                                           \
+                                                                                                                  \
+  static inline Type *clip_timsort_tmp_##Name(ClipTimSort_##Name *ts, ptrdiff_t needed)                           \
+  {                                                                                                               \
+    if (ts->tmp_capacity < needed)                                                                                \
+    {                                                                                                             \
+      clip_free(ts->allocator, ts->tmp, (size_t)ts->tmp_capacity * sizeof(Type));                                 \
+      ts->tmp = (Type *)clip_alloc(ts->allocator, (size_t)needed * sizeof(Type));                                 \
+      if (!ts->tmp)                                                                                               \
+      {                                                                                                           \
+        fprintf(stderr, "Memory allocation failed!\n");                                                           \
+        exit(EXIT_FAILURE);                                                                                       \
+      }                                                                                                           \
+      ts->tmp_capacity = needed;                                                                                  \
+    }                                                                                                             \
+    return ts->tmp;                                                                                               \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Sorts a[lo, hi) knowing a[lo, start) is already sorted */                                                    \
+  static inline void clip_timsort_binary_insertion_##Name(Type *a, ptrdiff_t lo, ptrdiff_t hi, ptrdiff_t start,   \
+                                                          int (*comparator)(const Type *, const Type *))          \
+  {                                                                                                               \
+    (void)comparator;                                                                                             \
+    if (start == lo)                                                                                              \
+      start++;                                                                                                    \
+    for (; start < hi; start++)                                                                                   \
+    {                                                                                                             \
+      Type pivot = a[start];                                                                                      \
+      ptrdiff_t left = lo;                                                                                        \
+      ptrdiff_t right = start;                                                                                    \
+      while (left < right)                                                                                        \
+      {                                                                                                           \
+        ptrdiff_t mid = left + (right - left) / 2;                                                                \
+        if (CMP(&pivot, &a[mid]) < 0)                                                                             \
+          right = mid;                                                                                            \
+        else                                                                                                      \
+          left = mid + 1;                                                                                         \
+      }                                                                                                           \
+      memmove(&a[left + 1], &a[left], (size_t)(start - left) * sizeof(Type));                                     \
+      a[left] = pivot;                                                                                            \
+    }                                                                                                             \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Length of the run starting at `lo`; strictly descending runs are reversed (keeps stability) */               \
+  static inline ptrdiff_t clip_timsort_count_run_##Name(Type *a, ptrdiff_t lo, ptrdiff_t hi,                      \
+                                                        int (*comparator)(const Type *, const Type *))            \
+  {                                                                                                               \
+    (void)comparator;                                                                                             \
+    ptrdiff_t run_hi = lo + 1;                                                                                    \
+    if (run_hi == hi)                                                                                             \
+      return 1;                                                                                                   \
+    if (CMP(&a[run_hi], &a[lo]) < 0)                                                                              \
+    {                                                                                                             \
+      run_hi++;                                                                                                   \
+      while (run_hi < hi && CMP(&a[run_hi], &a[run_hi - 1]) < 0)                                                  \
+        run_hi++;                                                                                                 \
+      for (ptrdiff_t i = lo, j = run_hi - 1; i < j; i++, j--)                                                     \
+      {                                                                                                           \
+        Type t = a[i];                                                                                            \
+        a[i] = a[j];                                                                                              \
+        a[j] = t;                                                                                                 \
+      }                                                                                                           \
+    }                                                                                                             \
+    else                                                                                                          \
+    {                                                                                                             \
+      run_hi++;                                                                                                   \
+      while (run_hi < hi && CMP(&a[run_hi], &a[run_hi - 1]) >= 0)                                                 \
+        run_hi++;                                                                                                 \
+    }                                                                                                             \
+    return run_hi - lo;                                                                                           \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Leftmost position to insert `key` in the sorted a[0, len), searching from `hint` */                          \
+  static inline ptrdiff_t clip_timsort_gallop_left_##Name(const Type *key, const Type *a, ptrdiff_t len,          \
+                                                          ptrdiff_t hint,                                         \
+                                                          int (*comparator)(const Type *, const Type *))          \
+  {                                                                                                               \
+    (void)comparator;                                                                                             \
+    ptrdiff_t last_ofs = 0;                                                                                       \
+    ptrdiff_t ofs = 1;                                                                                            \
+    if (CMP(key, &a[hint]) > 0)                                                                                   \
+    {                                                                                                             \
+      /* Gallop right until a[hint + last_ofs] < key <= a[hint + ofs] */                                          \
+      ptrdiff_t max_ofs = len - hint;                                                                             \
+      while (ofs < max_ofs && CMP(key, &a[hint + ofs]) > 0)                                                       \
+      {                                                                                                           \
+        last_ofs = ofs;                                                                                           \
+        ofs = (ofs << 1) + 1;                                                                                     \
+      }                                                                                                           \
+      if (ofs > max_ofs)                                                                                          \
+        ofs = max_ofs;                                                                                            \
+      last_ofs += hint;                                                                                           \
+      ofs += hint;                                                                                                \
+    }                                                                                                             \
+    else                                                                                                          \
+    {                                                                                                             \
+      /* Gallop left until a[hint - ofs] < key <= a[hint - last_ofs] */                                           \
+      ptrdiff_t max_ofs = hint + 1;                                                                               \
+      while (ofs < max_ofs && CMP(key, &a[hint - ofs]) <= 0)                                                      \
+      {                                                                                                           \
+        last_ofs = ofs;                                                                                           \
+        ofs = (ofs << 1) + 1;                                                                                     \
+      }                                                                                                           \
+      if (ofs > max_ofs)                                                                                          \
+        ofs = max_ofs;                                                                                            \
+      ptrdiff_t t = last_ofs;                                                                                     \
+      last_ofs = hint - ofs;                                                                                      \
+      ofs = hint - t;                                                                                             \
+    }                                                                                                             \
+    /* a[last_ofs] < key <= a[ofs]: binary search in between */                                                   \
+    last_ofs++;                                                                                                   \
+    while (last_ofs < ofs)                                                                                        \
+    {                                                                                                             \
+      ptrdiff_t mid = last_ofs + (ofs - last_ofs) / 2;                                                            \
+      if (CMP(key, &a[mid]) > 0)                                                                                  \
+        last_ofs = mid + 1;                                                                                       \
+      else                                                                                                        \
+        ofs = mid;                                                                                                \
+    }                                                                                                             \
+    return ofs;                                                                                                   \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Rightmost position to insert `key` in the sorted a[0, len), searching from `hint` */                         \
+  static inline ptrdiff_t clip_timsort_gallop_right_##Name(const Type *key, const Type *a, ptrdiff_t len,         \
+                                                           ptrdiff_t hint,                                        \
+                                                           int (*comparator)(const Type *, const Type *))         \
+  {                                                                                                               \
+    (void)comparator;                                                                                             \
+    ptrdiff_t last_ofs = 0;                                                                                       \
+    ptrdiff_t ofs = 1;                                                                                            \
+    if (CMP(key, &a[hint]) < 0)                                                                                   \
+    {                                                                                                             \
+      /* Gallop left until a[hint - ofs] <= key < a[hint - last_ofs] */                                           \
+      ptrdiff_t max_ofs = hint + 1;                                                                               \
+      while (ofs < max_ofs && CMP(key, &a[hint - ofs]) < 0)                                                       \
+      {                                                                                                           \
+        last_ofs = ofs;                                                                                           \
+        ofs = (ofs << 1) + 1;                                                                                     \
+      }                                                                                                           \
+      if (ofs > max_ofs)                                                                                          \
+        ofs = max_ofs;                                                                                            \
+      ptrdiff_t t = last_ofs;                                                                                     \
+      last_ofs = hint - ofs;                                                                                      \
+      ofs = hint - t;                                                                                             \
+    }                                                                                                             \
+    else                                                                                                          \
+    {                                                                                                             \
+      /* Gallop right until a[hint + last_ofs] <= key < a[hint + ofs] */                                          \
+      ptrdiff_t max_ofs = len - hint;                                                                             \
+      while (ofs < max_ofs && CMP(key, &a[hint + ofs]) >= 0)                                                      \
+      {                                                                                                           \
+        last_ofs = ofs;                                                                                           \
+        ofs = (ofs << 1) + 1;                                                                                     \
+      }                                                                                                           \
+      if (ofs > max_ofs)                                                                                          \
+        ofs = max_ofs;                                                                                            \
+      last_ofs += hint;                                                                                           \
+      ofs += hint;                                                                                                \
+    }                                                                                                             \
+    /* a[last_ofs] <= key < a[ofs]: binary search in between */                                                   \
+    last_ofs++;                                                                                                   \
+    while (last_ofs < ofs)                                                                                        \
+    {                                                                                                             \
+      ptrdiff_t mid = last_ofs + (ofs - last_ofs) / 2;                                                            \
+      if (CMP(key, &a[mid]) < 0)                                                                                  \
+        ofs = mid;                                                                                                \
+      else                                                                                                        \
+        last_ofs = mid + 1;                                                                                       \
+    }                                                                                                             \
+    return ofs;                                                                                                   \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Merges two adjacent runs with len1 <= len2, copying the first one to the temporary buffer */                 \
+  static inline void clip_timsort_merge_lo_##Name(ClipTimSort_##Name *ts, ptrdiff_t base1, ptrdiff_t len1,        \
+                                                  ptrdiff_t base2, ptrdiff_t len2)                                \
+  {                                                                                                               \
+    int (*comparator)(const Type *, const Type *) = ts->comparator;                                               \
+    (void)comparator;                                                                                             \
+    Type *a = ts->a;                                                                                              \
+    Type *tmp = clip_timsort_tmp_##Name(ts, len1);                                                                \
+    memcpy(tmp, &a[base1], (size_t)len1 * sizeof(Type));                                                          \
+    ptrdiff_t cursor1 = 0;                                                                                        \
+    ptrdiff_t cursor2 = base2;                                                                                    \
+    ptrdiff_t dest = base1;                                                                                       \
+                                                                                                                  \
+    a[dest++] = a[cursor2++];                                                                                     \
+    if (--len2 == 0)                                                                                              \
+    {                                                                                                             \
+      memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(Type));                                               \
+      return;                                                                                                     \
+    }                                                                                                             \
+    if (len1 == 1)                                                                                                \
+    {                                                                                                             \
+      memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(Type));                                                \
+      a[dest + len2] = tmp[cursor1];                                                                              \
+      return;                                                                                                     \
+    }                                                                                                             \
+                                                                                                                  \
+    ptrdiff_t min_gallop = ts->min_gallop;                                                                        \
+    for (;;)                                                                                                      \
+    {                                                                                                             \
+      ptrdiff_t count1 = 0; /* Consecutive wins of the first run */                                               \
+      ptrdiff_t count2 = 0; /* Consecutive wins of the second run */                                              \
+      bool done = false;                                                                                          \
+                                                                                                                  \
+      /* One element at a time until a run starts winning consistently */                                         \
+      do                                                                                                          \
+      {                                                                                                           \
+        if (CMP(&a[cursor2], &tmp[cursor1]) < 0)                                                                  \
+        {                                                                                                         \
+          a[dest++] = a[cursor2++];                                                                               \
+          count2++;                                                                                               \
+          count1 = 0;                                                                                             \
+          if (--len2 == 0)                                                                                        \
+            done = true;                                                                                          \
+        }                                                                                                         \
+        else                                                                                                      \
+        {                                                                                                         \
+          a[dest++] = tmp[cursor1++];                                                                             \
+          count1++;                                                                                               \
+          count2 = 0;                                                                                             \
+          if (--len1 == 1)                                                                                        \
+            done = true;                                                                                          \
+        }                                                                                                         \
+      } while (!done && (count1 | count2) < min_gallop);                                                          \
+      if (done)                                                                                                   \
+        break;                                                                                                    \
+                                                                                                                  \
+      /* Galloping: copy whole stretches found by exponential search */                                           \
+      do                                                                                                          \
+      {                                                                                                           \
+        count1 = clip_timsort_gallop_right_##Name(&a[cursor2], &tmp[cursor1], len1, 0, comparator);               \
+        if (count1 != 0)                                                                                          \
+        {                                                                                                         \
+          memcpy(&a[dest], &tmp[cursor1], (size_t)count1 * sizeof(Type));                                         \
+          dest += count1;                                                                                         \
+          cursor1 += count1;                                                                                      \
+          len1 -= count1;                                                                                         \
+          if (len1 <= 1)                                                                                          \
+          {                                                                                                       \
+            done = true;                                                                                          \
+            break;                                                                                                \
+          }                                                                                                       \
+        }                                                                                                         \
+        a[dest++] = a[cursor2++];                                                                                 \
+        if (--len2 == 0)                                                                                          \
+        {                                                                                                         \
+          done = true;                                                                                            \
+          break;                                                                                                  \
+        }                                                                                                         \
+                                                                                                                  \
+        count2 = clip_timsort_gallop_left_##Name(&tmp[cursor1], &a[cursor2], len2, 0, comparator);                \
+        if (count2 != 0)                                                                                          \
+        {                                                                                                         \
+          memmove(&a[dest], &a[cursor2], (size_t)count2 * sizeof(Type));                                          \
+          dest += count2;                                                                                         \
+          cursor2 += count2;                                                                                      \
+          len2 -= count2;                                                                                         \
+          if (len2 == 0)                                                                                          \
+          {                                                                                                       \
+            done = true;                                                                                          \
+            break;                                                                                                \
+          }                                                                                                       \
+        }                                                                                                         \
+        a[dest++] = tmp[cursor1++];                                                                               \
+        if (--len1 == 1)                                                                                          \
+        {                                                                                                         \
+          done = true;                                                                                            \
+          break;                                                                                                  \
+        }                                                                                                         \
+        min_gallop--;                                                                                             \
+      } while (count1 >= CLIP_TIMSORT_MIN_GALLOP || count2 >= CLIP_TIMSORT_MIN_GALLOP);                           \
+      if (done)                                                                                                   \
+        break;                                                                                                    \
+      if (min_gallop < 0)                                                                                         \
+        min_gallop = 0;                                                                                           \
+      min_gallop += 2; /* Penalty for leaving gallop mode */                                                      \
+    }                                                                                                             \
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;                                                             \
+                                                                                                                  \
+    if (len1 == 1)                                                                                                \
+    {                                                                                                             \
+      memmove(&a[dest], &a[cursor2], (size_t)len2 * sizeof(Type));                                                \
+      a[dest + len2] = tmp[cursor1];                                                                              \
+    }                                                                                                             \
+    else if (len1 > 1)                                                                                            \
+    {                                                                                                             \
+      memcpy(&a[dest], &tmp[cursor1], (size_t)len1 * sizeof(Type));                                               \
+    }                                                                                                             \
+    /* len1 == 0 only happens with an inconsistent comparator: everything left is already in place */             \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Merges two adjacent runs with len1 > len2, copying the second one to the temporary buffer */                 \
+  static inline void clip_timsort_merge_hi_##Name(ClipTimSort_##Name *ts, ptrdiff_t base1, ptrdiff_t len1,        \
+                                                  ptrdiff_t base2, ptrdiff_t len2)                                \
+  {                                                                                                               \
+    int (*comparator)(const Type *, const Type *) = ts->comparator;                                               \
+    (void)comparator;                                                                                             \
+    Type *a = ts->a;                                                                                              \
+    Type *tmp = clip_timsort_tmp_##Name(ts, len2);                                                                \
+    memcpy(tmp, &a[base2], (size_t)len2 * sizeof(Type));                                                          \
+    ptrdiff_t cursor1 = base1 + len1 - 1;                                                                         \
+    ptrdiff_t cursor2 = len2 - 1;                                                                                 \
+    ptrdiff_t dest = base2 + len2 - 1;                                                                            \
+                                                                                                                  \
+    a[dest--] = a[cursor1--];                                                                                     \
+    if (--len1 == 0)                                                                                              \
+    {                                                                                                             \
+      memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(Type));                                            \
+      return;                                                                                                     \
+    }                                                                                                             \
+    if (len2 == 1)                                                                                                \
+    {                                                                                                             \
+      dest -= len1;                                                                                               \
+      cursor1 -= len1;                                                                                            \
+      memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(Type));                                        \
+      a[dest] = tmp[cursor2];                                                                                     \
+      return;                                                                                                     \
+    }                                                                                                             \
+                                                                                                                  \
+    ptrdiff_t min_gallop = ts->min_gallop;                                                                        \
+    for (;;)                                                                                                      \
+    {                                                                                                             \
+      ptrdiff_t count1 = 0; /* Consecutive wins of the first run */                                               \
+      ptrdiff_t count2 = 0; /* Consecutive wins of the second run */                                              \
+      bool done = false;                                                                                          \
+                                                                                                                  \
+      do                                                                                                          \
+      {                                                                                                           \
+        if (CMP(&tmp[cursor2], &a[cursor1]) < 0)                                                                  \
+        {                                                                                                         \
+          a[dest--] = a[cursor1--];                                                                               \
+          count1++;                                                                                               \
+          count2 = 0;                                                                                             \
+          if (--len1 == 0)                                                                                        \
+            done = true;                                                                                          \
+        }                                                                                                         \
+        else                                                                                                      \
+        {                                                                                                         \
+          a[dest--] = tmp[cursor2--];                                                                             \
+          count2++;                                                                                               \
+          count1 = 0;                                                                                             \
+          if (--len2 == 1)                                                                                        \
+            done = true;                                                                                          \
+        }                                                                                                         \
+      } while (!done && (count1 | count2) < min_gallop);                                                          \
+      if (done)                                                                                                   \
+        break;                                                                                                    \
+                                                                                                                  \
+      do                                                                                                          \
+      {                                                                                                           \
+        count1 = len1 - clip_timsort_gallop_right_##Name(&tmp[cursor2], &a[base1], len1, len1 - 1, comparator);   \
+        if (count1 != 0)                                                                                          \
+        {                                                                                                         \
+          dest -= count1;                                                                                         \
+          cursor1 -= count1;                                                                                      \
+          len1 -= count1;                                                                                         \
+          memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)count1 * sizeof(Type));                                  \
+          if (len1 == 0)                                                                                          \
+          {                                                                                                       \
+            done = true;                                                                                          \
+            break;                                                                                                \
+          }                                                                                                       \
+        }                                                                                                         \
+        a[dest--] = tmp[cursor2--];                                                                               \
+        if (--len2 == 1)                                                                                          \
+        {                                                                                                         \
+          done = true;                                                                                            \
+          break;                                                                                                  \
+        }                                                                                                         \
+                                                                                                                  \
+        count2 = len2 - clip_timsort_gallop_left_##Name(&a[cursor1], tmp, len2, len2 - 1, comparator);            \
+        if (count2 != 0)                                                                                          \
+        {                                                                                                         \
+          dest -= count2;                                                                                         \
+          cursor2 -= count2;                                                                                      \
+          len2 -= count2;                                                                                         \
+          memcpy(&a[dest + 1], &tmp[cursor2 + 1], (size_t)count2 * sizeof(Type));                                 \
+          if (len2 <= 1)                                                                                          \
+          {                                                                                                       \
+            done = true;                                                                                          \
+            break;                                                                                                \
+          }                                                                                                       \
+        }                                                                                                         \
+        a[dest--] = a[cursor1--];                                                                                 \
+        if (--len1 == 0)                                                                                          \
+        {                                                                                                         \
+          done = true;                                                                                            \
+          break;                                                                                                  \
+        }                                                                                                         \
+        min_gallop--;                                                                                             \
+      } while (count1 >= CLIP_TIMSORT_MIN_GALLOP || count2 >= CLIP_TIMSORT_MIN_GALLOP);                           \
+      if (done)                                                                                                   \
+        break;                                                                                                    \
+      if (min_gallop < 0)                                                                                         \
+        min_gallop = 0;                                                                                           \
+      min_gallop += 2;                                                                                            \
+    }                                                                                                             \
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;                                                             \
+                                                                                                                  \
+    if (len2 == 1)                                                                                                \
+    {                                                                                                             \
+      dest -= len1;                                                                                               \
+      cursor1 -= len1;                                                                                            \
+      memmove(&a[dest + 1], &a[cursor1 + 1], (size_t)len1 * sizeof(Type));                                        \
+      a[dest] = tmp[cursor2];                                                                                     \
+    }                                                                                                             \
+    else if (len2 > 1)                                                                                            \
+    {                                                                                                             \
+      memcpy(&a[dest - (len2 - 1)], tmp, (size_t)len2 * sizeof(Type));                                            \
+    }                                                                                                             \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Merges the pending runs i and i + 1 */                                                                       \
+  static inline void clip_timsort_merge_at_##Name(ClipTimSort_##Name *ts, int i)                                  \
+  {                                                                                                               \
+    int (*comparator)(const Type *, const Type *) = ts->comparator;                                               \
+    Type *a = ts->a;                                                                                              \
+    ptrdiff_t base1 = ts->run_base[i];                                                                            \
+    ptrdiff_t len1 = ts->run_len[i];                                                                              \
+    ptrdiff_t base2 = ts->run_base[i + 1];                                                                        \
+    ptrdiff_t len2 = ts->run_len[i + 1];                                                                          \
+                                                                                                                  \
+    ts->run_len[i] = len1 + len2;                                                                                 \
+    if (i == ts->stack_size - 3)                                                                                  \
+    {                                                                                                             \
+      ts->run_base[i + 1] = ts->run_base[i + 2];                                                                  \
+      ts->run_len[i + 1] = ts->run_len[i + 2];                                                                    \
+    }                                                                                                             \
+    ts->stack_size--;                                                                                             \
+                                                                                                                  \
+    /* Elements of the first run smaller than the second run's head are already in place */                       \
+    ptrdiff_t k = clip_timsort_gallop_right_##Name(&a[base2], &a[base1], len1, 0, comparator);                    \
+    base1 += k;                                                                                                   \
+    len1 -= k;                                                                                                    \
+    if (len1 == 0)                                                                                                \
+      return;                                                                                                     \
+    /* And so are the elements of the second run greater than the first run's tail */                             \
+    len2 = clip_timsort_gallop_left_##Name(&a[base1 + len1 - 1], &a[base2], len2, len2 - 1, comparator);          \
+    if (len2 == 0)                                                                                                \
+      return;                                                                                                     \
+                                                                                                                  \
+    if (len1 <= len2)                                                                                             \
+      clip_timsort_merge_lo_##Name(ts, base1, len1, base2, len2);                                                 \
+    else                                                                                                          \
+      clip_timsort_merge_hi_##Name(ts, base1, len1, base2, len2);                                                 \
+  }                                                                                                               \
+                                                                                                                  \
+  /* Restores the run length invariants: len[i - 2] > len[i - 1] + len[i] and len[i - 1] > len[i] */              \
+  static inline void clip_timsort_merge_collapse_##Name(ClipTimSort_##Name *ts)                                   \
+  {                                                                                                               \
+    ptrdiff_t *len = ts->run_len;                                                                                 \
+    while (ts->stack_size > 1)                                                                                    \
+    {                                                                                                             \
+      int i = ts->stack_size - 2;                                                                                 \
+      if ((i > 0 && len[i - 1] <= len[i] + len[i + 1]) || (i > 1 && len[i - 2] <= len[i] + len[i - 1]))           \
+      {                                                                                                           \
+        if (len[i - 1] < len[i + 1])                                                                              \
+          i--;                                                                                                    \
+      }                                                                                                           \
+      else if (len[i] > len[i + 1])                                                                               \
+      {                                                                                                           \
+        break;                                                                                                    \
+      }                                                                                                           \
+      clip_timsort_merge_at_##Name(ts, i);                                                                        \
+    }                                                                                                             \
+  }                                                                                                               \
+                                                                                                                  \
+  /**                                                                                                             \
+   * @brief Sorts `n` elements of `data` in place, keeping equal elements in their original order.                \
+   * @param comparator Runtime comparator, only used when `CMP` is `comparator`                                   \
+   * @param allocator Source of the merge buffer, NULL for the default allocator                                  \
+   */                                                                                                             \
+  static inline void clip_stable_sort_with_allocator_##Name(Type *data, size_t n,                                 \
+                                                            int (*comparator)(const Type *, const Type *),        \
+                                                            const CLIP_Allocator *allocator)                      \
+  {                                                                                                               \
+    ptrdiff_t lo = 0;                                                                                             \
+    ptrdiff_t hi = (ptrdiff_t)n;                                                                                  \
+    ptrdiff_t remaining = hi;                                                                                     \
+    if (remaining < 2)                                                                                            \
+      return;                                                                                                     \
+    if (remaining < CLIP_TIMSORT_MIN_MERGE)                                                                       \
+    {                                                                                                             \
+      ptrdiff_t run = clip_timsort_count_run_##Name(data, lo, hi, comparator);                                    \
+      clip_timsort_binary_insertion_##Name(data, lo, hi, lo + run, comparator);                                   \
+      return;                                                                                                     \
+    }                                                                                                             \
+                                                                                                                  \
+    ClipTimSort_##Name ts;                                                                                        \
+    ts.a = data;                                                                                                  \
+    ts.tmp = NULL;                                                                                                \
+    ts.tmp_capacity = 0;                                                                                          \
+    ts.min_gallop = CLIP_TIMSORT_MIN_GALLOP;                                                                      \
+    ts.stack_size = 0;                                                                                            \
+    ts.comparator = comparator;                                                                                   \
+    ts.allocator = allocator;                                                                                     \
+                                                                                                                  \
+    ptrdiff_t min_run = clip_timsort_min_run(remaining);                                                          \
+    do                                                                                                            \
+    {                                                                                                             \
+      ptrdiff_t run = clip_timsort_count_run_##Name(data, lo, hi, comparator);                                    \
+      if (run < min_run)                                                                                          \
+      {                                                                                                           \
+        /* Extend short runs to min_run elements */                                                               \
+        ptrdiff_t force = remaining <= min_run ? remaining : min_run;                                             \
+        clip_timsort_binary_insertion_##Name(data, lo, lo + force, lo + run, comparator);                         \
+        run = force;                                                                                              \
+      }                                                                                                           \
+      ts.run_base[ts.stack_size] = lo;                                                                            \
+      ts.run_len[ts.stack_size] = run;                                                                            \
+      ts.stack_size++;                                                                                            \
+      clip_timsort_merge_collapse_##Name(&ts);                                                                    \
+      lo += run;                                                                                                  \
+      remaining -= run;                                                                                           \
+    } while (remaining != 0);                                                                                     \
+                                                                                                                  \
+    while (ts.stack_size > 1)                                                                                     \
+    {                                                                                                             \
+      int i = ts.stack_size - 2;                                                                                  \
+      if (i > 0 && ts.run_len[i - 1] < ts.run_len[i + 1])                                                         \
+        i--;                                                                                                      \
+      clip_timsort_merge_at_##Name(&ts, i);                                                                       \
+    }                                                                                                             \
+    clip_free(ts.allocator, ts.tmp, (size_t)ts.tmp_capacity * sizeof(Type));                                      \
+  }                                                                                                               \
+                                                                                                                  \
+  static inline void clip_stable_sort_##Name(Type *data, size_t n, int (*comparator)(const Type *, const Type *)) \
+  {                                                                                                               \
+    clip_stable_sort_with_allocator_##Name(data, n, comparator, NULL);                                            \
+  }
+
+/* Inputs smaller than this are insertion sorted by key instead of radix sorted. */
+#define CLIP_RADIX_SORT_THRESHOLD 64
+
+/**
+ * @brief Order-preserving key transforms: the unsigned order of the result
+ * matches the natural order of the value. Use them to write key extractors.
+ */
+static inline uint64_t clip_radix_key_from_u64(uint64_t v)
+{
+  return v;
+}
+
+static inline uint64_t clip_radix_key_from_i64(int64_t v)
+{
+  return (uint64_t)v ^ 0x8000000000000000ULL;
+}
+
+static inline uint64_t clip_radix_key_from_u32(uint32_t v)
+{
+  return v;
+}
+
+/* 32-bit values keep their upper key bytes at zero, so those passes are skipped */
+static inline uint64_t clip_radix_key_from_i32(int32_t v)
+{
+  return (uint32_t)v ^ 0x80000000u;
+}
+
+/* Negative floats have every bit flipped, positive ones only the sign bit (NaNs sort to the ends) */
+static inline uint64_t clip_radix_key_from_f64(double v)
+{
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return bits ^ ((bits >> 63) ? 0xFFFFFFFFFFFFFFFFULL : 0x8000000000000000ULL);
+}
+
+static inline uint64_t clip_radix_key_from_f32(float v)
+{
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return bits ^ ((bits >> 31) ? 0xFFFFFFFFu : 0x80000000u);
+}
+
+/**
+ * @brief Ready-made key extractors for lists of the basic numeric types.
+ */
+static inline uint64_t clip_radix_key_int(const int *v)
+{
+  return sizeof(int) == 4 ? clip_radix_key_from_i32((int32_t)*v) : clip_radix_key_from_i64(*v);
+}
+
+static inline uint64_t clip_radix_key_unsigned(const unsigned *v)
+{
+  return *v;
+}
+
+static inline uint64_t clip_radix_key_int64(const int64_t *v)
+{
+  return clip_radix_key_from_i64(*v);
+}
+
+static inline uint64_t clip_radix_key_uint64(const uint64_t *v)
+{
+  return *v;
+}
+
+static inline uint64_t clip_radix_key_float(const float *v)
+{
+  return clip_radix_key_from_f32(*v);
+}
+
+static inline uint64_t clip_radix_key_double(const double *v)
+{
+  return clip_radix_key_from_f64(*v);
+}
+
+/**
+ * @brief Scratch memory for the radix sort. Keep one around and pass it to
+ * every call to avoid allocating a new buffer per sort.
+ */
+typedef struct
+{
+  void *data;
+  size_t capacity;                 /* In bytes */
+  const CLIP_Allocator *allocator; /* NULL for the default allocator */
+} CLIP_RadixScratch;
+
+#define CLIP_RADIX_SCRATCH_INIT {NULL, 0, NULL}
+
+static inline void *clip_radix_scratch_reserve(CLIP_RadixScratch *scratch, size_t bytes)
+{
+  if (scratch->capacity < bytes)
+  {
+    clip_free(scratch->allocator, scratch->data, scratch->capacity);
+    scratch->data = clip_alloc(scratch->allocator, bytes);
+    if (!scratch->data)
+    {
+      fprintf(stderr, "Memory allocation failed!\n");
+      exit(EXIT_FAILURE);
+    }
+    scratch->capacity = bytes;
+  }
+  return scratch->data;
+}
+
+static inline void clip_radix_scratch_free(CLIP_RadixScratch *scratch)
+{
+  clip_free(scratch->allocator, scratch->data, scratch->capacity);
+  scratch->data = NULL;
+  scratch->capacity = 0;
+}
+
+/**
+ * @brief Generates `clip_radix_sort_<Name>(Type *data, size_t n, uint64_t (*key)(const Type *), CLIP_RadixScratch *scratch)`.
+ *
+ * The sort is stable and makes one pass per key byte; bytes that are the same
+ * for every element (e.g. the upper half of 32-bit keys) are skipped. `scratch`
+ * may be NULL, in which case a temporary buffer is allocated for the call
+ * (from `allocator` with `clip_radix_sort_with_allocator_<Name>`).
+ *
+ * @param Name Suffix of the generated function
+ * @param Type The element type
+ */
+#define CLIP_DEFINE_RADIX_SORT(Name, Type)                                                       \
+                                                                                                 \
+  static inline void clip_radix_sort_with_allocator_##Name(Type *data, size_t n,                 \
+                                                           uint64_t (*key)(const Type *),        \
+                                                           CLIP_RadixScratch *scratch,           \
+                                                           const CLIP_Allocator *allocator)      \
+  {                                                                                              \
+    if (n < 2)                                                                                   \
+      return;                                                                                    \
+    if (n < CLIP_RADIX_SORT_THRESHOLD)                                                           \
+    {                                                                                            \
+      for (size_t i = 1; i < n; i++)                                                             \
+      {                                                                                          \
+        Type tmp = data[i];                                                                      \
+        uint64_t k = key(&tmp);                                                                  \
+        size_t j = i;                                                                            \
+        for (; j > 0 && key(&data[j - 1]) > k; j--)                                              \
+          data[j] = data[j - 1];                                                                 \
+        data[j] = tmp;                                                                           \
+      }                                                                                          \
+      return;                                                                                    \
+    }                                                                                            \
+                                                                                                 \
+    /* All eight byte histograms are built in a single pass over the keys */                     \
+    size_t counts[8][256];                                                                       \
+    memset(counts, 0, sizeof(counts));                                                           \
+    for (size_t i = 0; i < n; i++)                                                               \
+    {                                                                                            \
+      uint64_t k = key(&data[i]);                                                                \
+      for (int b = 0; b < 8; b++)                                                                \
+        counts[b][(k >> (8 * b)) & 0xFF]++;                                                      \
+    }                                                                                            \
+                                                                                                 \
+    CLIP_RadixScratch local = {NULL, 0, allocator};                                              \
+    CLIP_RadixScratch *buf = scratch ? scratch : &local;                                         \
+    Type *src = data;                                                                            \
+    Type *dst = (Type *)clip_radix_scratch_reserve(buf, n * sizeof(Type));                       \
+    uint64_t first_key = key(&data[0]);                                                          \
+    for (int b = 0; b < 8; b++)                                                                  \
+    {                                                                                            \
+      int shift = 8 * b;                                                                         \
+      if (counts[b][(first_key >> shift) & 0xFF] == n)                                           \
+        continue;                                                                                \
+      size_t offsets[256];                                                                       \
+      size_t sum = 0;                                                                            \
+      for (int d = 0; d < 256; d++)                                                              \
+      {                                                                                          \
+        offsets[d] = sum;                                                                        \
+        sum += counts[b][d];                                                                     \
+      }                                                                                          \
+      for (size_t i = 0; i < n; i++)                                                             \
+        dst[offsets[(key(&src[i]) >> shift) & 0xFF]++] = src[i];                                 \
+      Type *swap = src;                                                                          \
+      src = dst;                                                                                 \
+      dst = swap;                                                                                \
+    }                                                                                            \
+    if (src != data)                                                                             \
+      memcpy(data, src, n * sizeof(Type));                                                       \
+    if (!scratch)                                                                                \
+      clip_radix_scratch_free(&local);                                                           \
+  }                                                                                              \
+                                                                                                 \
+  static inline void clip_radix_sort_##Name(Type *data, size_t n, uint64_t (*key)(const Type *), \
+                                            CLIP_RadixScratch *scratch)                          \
+  {                                                                                              \
+    clip_radix_sort_with_allocator_##Name(data, n, key, scratch, NULL);                          \
+  }
+
+#endif /* CLIP_SORT_H */
@@ -15,6 +15,7 @@
  *
  * The following methods are generated automatically:
  * - init
+ * - init_with_allocator
  * - init_from_array
  * - ensure_capacity
  * - push
@@ -27,6 +28,8 @@
  * - clear
  * - reserve
  * - shrink_to_fit
+ * - write (streams into a `CLIP_StrBuf`, requires registration via CLIP_REGISTER_STACK_PRINT)
+ * - write_custom (takes a user-supplied function)
  * - to_str (requires registration via CLIP_REGISTER_STACK_PRINT)
  * - to_str_custom (takes a user-supplied function)
  * - reverse
@@ -41,6 +44,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <CLIP/Allocator.h>
+#include <CLIP/Size.h>
+#include <CLIP/StrBuf.h>
+
 #define CLIP_DEFINE_STACK_TYPE(...) \
     CLIP_DEFINE_STACK_TYPE_IMPL(__VA_ARGS__, NULL, 256)
 
@@ -102,14 +109,23 @@
     typedef struct                                                              \
     {                                                                           \
         Type *data;                                                             \
-        int size;                                                               \
-        int capacity;                                                           \
+        clip_size_t size;                                                       \
+        clip_size_t capacity;                                                   \
+        const CLIP_Allocator *allocator; /* NULL for the default allocator */   \
     } Stack_##Type;                                                             \
                                                                                 \
-    static inline Stack_##Type init_stack_##Type(int capacity)                  \
+    static inline Stack_##Type init_stack_with_allocator_##Type(                \
+        clip_size_t capacity, const CLIP_Allocator *allocator)                  \
     {                                                                           \
         Stack_##Type stack;                                                     \
-        stack.data = malloc(capacity * sizeof(Type));                           \
+        size_t bytes;                                                           \
+        if (capacity < 0 ||                                                     \
+            !clip_size_mul((size_t)capacity, sizeof(Type), &bytes))             \
+        {                                                                       \
+            fprintf(stderr, "Invalid stack capacity!\n");                       \
+            exit(EXIT_FAILURE);                                                 \
+        }                                                                       \
+        stack.data = clip_alloc(allocator, bytes);                              \
         if (!stack.data)                                                        \
         {                                                                       \
             fprintf(stderr, "Memory allocation failed!\n");                     \
@@ -117,34 +133,53 @@
         }                                                                       \
         stack.size = 0;                                                         \
         stack.capacity = capacity;                                              \
+        stack.allocator = allocator;                                            \
         return stack;                                                           \
     }                                                                           \
                                                                                 \
+    static inline Stack_##Type init_stack_##Type(clip_size_t capacity)          \
+    {                                                                           \
+        return init_stack_with_allocator_##Type(capacity, NULL);                \
+    }                                                                           \
+                                                                                \
     static inline Stack_##Type init_stack_from_array_##Type(const Type *arr,    \
-                                                            int n)              \
+                                                            clip_size_t n)      \
     {                                                                           \
         Stack_##Type stack;                                                     \
-        stack.data = malloc(n * sizeof(Type));                                  \
+        size_t bytes;                                                           \
+        if (n < 0 || !clip_size_mul((size_t)n, sizeof(Type), &bytes))           \
+        {                                                                       \
+            fprintf(stderr, "Invalid stack capacity!\n");                       \
+            exit(EXIT_FAILURE);                                                 \
+        }                                                                       \
+        stack.data = clip_alloc(NULL, bytes);                                   \
         if (!stack.data && n > 0)                                               \
         {                                                                       \
             fprintf(stderr, "Memory allocation failed!\n");                     \
             exit(EXIT_FAILURE);                                                 \
         }                                                                       \
-        memcpy(stack.data, arr, n * sizeof(Type));                              \
+        memcpy(stack.data, arr, bytes);                                         \
         stack.size = n;                                                         \
         stack.capacity = n;                                                     \
+        stack.allocator = NULL;                                                 \
         return stack;                                                           \
     }                                                                           \
                                                                                 \
     static inline bool stack_ensure_capacity_##Type(Stack_##Type *stack,        \
-                                                    int needed)                 \
+                                                    clip_size_t needed)         \
     {                                                                           \
+        if (needed > CLIP_SIZE_MAX - stack->size)                               \
+            return false;                                                       \
         if (stack->size + needed > stack->capacity)                             \
         {                                                                       \
-            int new_capacity = stack->capacity ? stack->capacity * 2 : 1;       \
-            while (new_capacity < stack->size + needed)                         \
-                new_capacity *= 2;                                              \
-            Type *new_data = realloc(stack->data, new_capacity * sizeof(Type)); \
+            clip_size_t new_capacity = clip_grow_capacity(                      \
+                stack->capacity, stack->size + needed, sizeof(Type));           \
+            if (new_capacity < 0)                                               \
+                return false;                                                   \
+            Type *new_data = clip_realloc(                                      \
+                stack->allocator, stack->data,                                  \
+                (size_t)stack->capacity * sizeof(Type),                         \
+                (size_t)new_capacity * sizeof(Type));                           \
             if (!new_data)                                                      \
                 return false;                                                   \
             stack->data = new_data;                                             \
@@ -192,12 +227,12 @@
         return stack->size == 0;                                                \
     }                                                                           \
                                                                                 \
-    static inline int stack_size_##Type(Stack_##Type *stack)                    \
+    static inline clip_size_t stack_size_##Type(Stack_##Type *stack)            \
     {                                                                           \
         return stack->size;                                                     \
     }                                                                           \
                                                                                 \
-    static inline int stack_capacity_##Type(Stack_##Type *stack)                \
+    static inline clip_size_t stack_capacity_##Type(Stack_##Type *stack)        \
     {                                                                           \
         return stack->capacity;                                                 \
     }                                                                           \
@@ -207,11 +242,16 @@
         stack->size = 0;                                                        \
     }                                                                           \
                                                                                 \
-    static inline bool stack_reserve_##Type(Stack_##Type *stack, int capacity)  \
+    static inline bool stack_reserve_##Type(Stack_##Type *stack,                \
+                                            clip_size_t capacity)               \
     {                                                                           \
         if (capacity <= stack->capacity)                                        \
             return true;                                                        \
-        Type *new_data = realloc(stack->data, capacity * sizeof(Type));         \
+        if (capacity > clip_max_capacity(sizeof(Type)))                         \
+            return false;                                                       \
+        Type *new_data = clip_realloc(stack->allocator, stack->data,            \
+                                      (size_t)stack->capacity * sizeof(Type),   \
+                                      (size_t)capacity * sizeof(Type));         \
         if (!new_data)                                                          \
             return false;                                                       \
         stack->data = new_data;                                                 \
@@ -223,7 +263,9 @@
     {                                                                           \
         if (stack->size == stack->capacity)                                     \
             return true;                                                        \
-        Type *new_data = realloc(stack->data, stack->size * sizeof(Type));      \
+        Type *new_data = clip_realloc(stack->allocator, stack->data,            \
+                                      (size_t)stack->capacity * sizeof(Type),   \
+                                      (size_t)stack->size * sizeof(Type));      \
         if (!new_data && stack->size > 0)                                       \
             return false;                                                       \
         stack->data = new_data;                                                 \
@@ -231,33 +273,42 @@
         return true;                                                            \
     }                                                                           \
                                                                                 \
+    static inline bool stack_write_##Type##_custom(                             \
+        Stack_##Type *stack, CLIP_StrBuf *out,                                  \
+        void (*elem_to_str)(Type, char *, size_t))                              \
+    {                                                                           \
+        if (!stack || !clip_strbuf_puts(out, "[top: "))                         \
+            return false;                                                       \
+        for (clip_size_t i = stack->size - 1; i >= 0; i--)                      \
+        {                                                                       \
+            char *elem = clip_strbuf_reserve(out, BUF_SIZE);                    \
+            if (!elem)                                                          \
+                return false;                                                   \
+            elem[0] = '\0';                                                     \
+            elem_to_str(stack->data[i], elem, BUF_SIZE);                        \
+            clip_strbuf_commit_str(out, BUF_SIZE);                              \
+            if (i > 0 && !clip_strbuf_append(out, ", ", 2))                     \
+                return false;                                                   \
+        }                                                                       \
+        return clip_strbuf_puts(out, " :bottom]");                              \
+    }                                                                           \
+                                                                                \
     static inline char *stack_to_str_##Type##_custom(                           \
         Stack_##Type *stack, void (*elem_to_str)(Type, char *, size_t))         \
     {                                                                           \
         if (!stack)                                                             \
             return NULL;                                                        \
-        size_t bufsize = stack->size * BUF_SIZE + 16;                           \
-        char *buffer = malloc(bufsize);                                         \
-        if (!buffer)                                                            \
-            return NULL;                                                        \
-        strcpy(buffer, "[top: ");                                               \
-        char elem[BUF_SIZE];                                                    \
-        for (int i = stack->size - 1; i >= 0; i--)                              \
-        {                                                                       \
-            elem_to_str(stack->data[i], elem, sizeof(elem));                    \
-            strcat(buffer, elem);                                               \
-            if (i > 0)                                                          \
-                strcat(buffer, ", ");                                           \
-        }                                                                       \
-        strcat(buffer, " :bottom]");                                            \
-        return buffer;                                                          \
+        CLIP_StrBuf out;                                                        \
+        clip_strbuf_init(&out);                                                 \
+        stack_write_##Type##_custom(stack, &out, elem_to_str);                  \
+        return clip_strbuf_detach(&out);                                        \
     }                                                                           \
                                                                                 \
     static inline void stack_reverse_##Type(Stack_##Type *stack)                \
     {                                                                           \
         if (stack->size < 2)                                                    \
             return;                                                             \
-        for (int i = 0; i < stack->size / 2; i++)                               \
+        for (clip_size_t i = 0; i < stack->size / 2; i++)                       \
         {                                                                       \
             Type temp = stack->data[i];                                         \
             stack->data[i] = stack->data[stack->size - 1 - i];                  \
@@ -268,7 +319,8 @@
     static inline Stack_##Type stack_copy_##Type(const Stack_##Type *src)       \
     {                                                                           \
         Stack_##Type copy;                                                      \
-        copy.data = malloc(src->capacity * sizeof(Type));                       \
+        copy.data = clip_alloc(src->allocator,                                  \
+                               (size_t)src->capacity * sizeof(Type));           \
         if (!copy.data && src->capacity > 0)                                    \
         {                                                                       \
             fprintf(stderr, "Memory allocation failed!\n");                     \
@@ -277,6 +329,7 @@
         memcpy(copy.data, src->data, src->size * sizeof(Type));                 \
         copy.size = src->size;                                                  \
         copy.capacity = src->capacity;                                          \
+        copy.allocator = src->allocator;                                        \
         return copy;                                                            \
     }                                                                           \
                                                                                 \
@@ -285,13 +338,14 @@
         void (*free_fn)(Type *) = FREE_FN;                                      \
         if (free_fn)                                                            \
         {                                                                       \
-            for (int i = 0; i < stack->size; i++)                               \
+            for (clip_size_t i = 0; i < stack->size; i++)                       \
             {                                                                   \
                                                                                 \
                 (free_fn)(&stack->data[i]);                                     \
             }                                                                   \
         }                                                                       \
-        free(stack->data);                                                      \
+        clip_free(stack->allocator, stack->data,                                \
+                  (size_t)stack->capacity * sizeof(Type));                      \
         stack->data = NULL;                                                     \
         stack->size = 0;                                                        \
         stack->capacity = 0;                                                    \
@@ -300,8 +354,8 @@
 /**
  * @brief Registers the default print function for a specific stack type.
  *
- * This macro **defines** the `stack_to_str_<Type>_main` function, which is used
- * by convenience macros like `Stack_to_str` and `Stack_print`.
+ * This macro **defines** the `stack_write_<Type>_main` and `stack_to_str_<Type>_main` functions,
+ * which are used by convenience macros like `Stack_write`, `Stack_to_str` and `Stack_print`.
  *
  * @param Type The element type for which to register the print function.
  * @param print_fn The function with signature: `void func(Type, char*, size_t)`.
@@ -324,15 +378,25 @@
  * Stack_print(int, &stack);  // Uses registered function!
  * ```
  */
-#define CLIP_REGISTER_STACK_PRINT(Type, print_fn)                                  \
-    static inline char *stack_to_str_##Type##_main(Stack_##Type *stack)            \
-    {                                                                              \
-        if (!print_fn)                                                             \
-        {                                                                          \
-            fprintf(stderr, "No print function registered for type " #Type "!\n"); \
-            return NULL;                                                           \
-        }                                                                          \
-        return stack_to_str_##Type##_custom(stack, print_fn);                      \
+#define CLIP_REGISTER_STACK_PRINT(Type, print_fn)                                       \
+    static inline bool stack_write_##Type##_main(Stack_##Type *stack, CLIP_StrBuf *out) \
+    {                                                                                   \
+        if (!print_fn)                                                                  \
+        {                                                                               \
+            fprintf(stderr, "No print function registered for type " #Type "!\n");      \
+            return false;                                                               \
+        }                                                                               \
+        return stack_write_##Type##_custom(stack, out, print_fn);                       \
+    }                                                                                   \
+                                                                                        \
+    static inline char *stack_to_str_##Type##_main(Stack_##Type *stack)                 \
+    {                                                                                   \
+        if (!print_fn)                                                                  \
+        {                                                                               \
+            fprintf(stderr, "No print function registered for type " #Type "!\n");      \
+            return NULL;                                                                \
+        }                                                                               \
+        return stack_to_str_##Type##_custom(stack, print_fn);                           \
     }
 
 /**
@@ -352,6 +416,12 @@
  */
 #define Stack_init(Type, cap) init_stack_##Type(cap)
 
+/**
+ * @def Stack_init_with_allocator(Type, cap, allocator)
+ * @brief Initialize a stack whose storage comes from `allocator` (a `const CLIP_Allocator *`, NULL for the default).
+ */
+#define Stack_init_with_allocator(Type, cap, allocator) init_stack_with_allocator_##Type(cap, allocator)
+
 /**
  * @def Stack_init_from_array(Type, arr, n)
  * @brief Initialize a stack with elements copied from an existing C array.
@@ -397,7 +467,7 @@
  * ```
  */
 #define Stack_init_from_static_array(Type, arr) \
-    init_stack_from_array_##Type((arr), (int)(sizeof(arr) / sizeof((arr)[0])))
+    init_stack_from_array_##Type((arr), (clip_size_t)(sizeof(arr) / sizeof((arr)[0])))
 
 /**
  * @def Stack_push(Type, stack, val)
@@ -480,6 +550,51 @@
  */
 #define Stack_to_str_custom(Type, stack, fn) stack_to_str_##Type##_custom(stack, fn)
 
+/**
+ * @def Stack_write(Type, stack, out)
+ * @brief Stream the stack contents into the `CLIP_StrBuf` `out` using the registered
+ * print function. Produces the same text as `Stack_to_str` in linear time, without
+ * building the whole string first.
+ *
+ * @return false if the writer failed.
+ * @note You must call `CLIP_REGISTER_STACK_PRINT(Type, fn)` for this type first.
+ */
+#define Stack_write(Type, stack, out) stack_write_##Type##_main(stack, out)
+
+/**
+ * @def Stack_write_custom(Type, stack, out, fn)
+ * @brief Stream the stack contents into `out` using a user-supplied
+ *        element-to-string function.
+ */
+#define Stack_write_custom(Type, stack, out, fn) stack_write_##Type##_custom(stack, out, fn)
+
+/**
+ * @def Stack_fprint(Type, stack, file)
+ * @brief Stream the stack to a `FILE *` through a fixed-size buffer using the
+ * registered print function. (Does not print a trailing newline)
+ */
+#define Stack_fprint(Type, stack, file)     \
+    do                                      \
+    {                                       \
+        CLIP_StrBuf _out;                   \
+        clip_strbuf_init_file(&_out, file); \
+        Stack_write(Type, stack, &_out);    \
+        clip_strbuf_free(&_out);            \
+    } while (0)
+
+/**
+ * @def Stack_fprint_custom(Type, stack, file, fn)
+ * @brief Stream the stack to a `FILE *` using the given element-to-string function.
+ */
+#define Stack_fprint_custom(Type, stack, file, fn)  \
+    do                                              \
+    {                                               \
+        CLIP_StrBuf _out;                           \
+        clip_strbuf_init_file(&_out, file);         \
+        Stack_write_custom(Type, stack, &_out, fn); \
+        clip_strbuf_free(&_out);                    \
+    } while (0)
+
 /**
  * @def Stack_reverse(Type, stack)
  * @brief Reverses the given stack (top becomes bottom, bottom becomes top).
@@ -511,16 +626,7 @@
  * Stack_print(int, &my_stack);
  * ```
  */
-#define Stack_print(Type, stack)                    \
-    do                                              \
-    {                                               \
-        char *_tmp_str = Stack_to_str(Type, stack); \
-        if (_tmp_str)                               \
-        {                                           \
-            printf("%s", _tmp_str);                 \
-            free(_tmp_str);                         \
-        }                                           \
-    } while (0)
+#define Stack_print(Type, stack) Stack_fprint(Type, stack, stdout)
 
 /**
  * @def Stack_print_custom(Type, stack, fn)
@@ -532,16 +638,7 @@
  * Stack_print_custom(Student, &student_stack, Student_to_str);
  * ```
  */
-#define Stack_print_custom(Type, stack, fn)                    \
-    do                                                         \
-    {                                                          \
-        char *_tmp_str = Stack_to_str_custom(Type, stack, fn); \
-        if (_tmp_str)                                          \
-        {                                                      \
-            printf("%s", _tmp_str);                            \
-            free(_tmp_str);                                    \
-        }                                                      \
-    } while (0)
+#define Stack_print_custom(Type, stack, fn) Stack_fprint_custom(Type, stack, stdout, fn)
 
 /**
  * @def Stack_println(Type, stack)
@@ -0,0 +1,325 @@
+/*
+ * @author Eduardo I. Lopez H. - eduardo98m@gmail.com
+ * @brief Growable string builder and buffered writer shared by the `*_to_str` and `*_write` functions.
+ *
+ * A `CLIP_StrBuf` works in one of two modes:
+ * - In memory (`clip_strbuf_init`): the buffer grows geometrically and keeps
+ *   track of its length, so appending is amortized O(1) regardless of how long
+ *   the string already is. `clip_strbuf_detach` hands the result over as a
+ *   regular NUL-terminated string.
+ * - Streaming (`clip_strbuf_init_file`, `clip_strbuf_init_fd`,
+ *   `clip_strbuf_init_sink`): output goes through a fixed-size buffer of
+ *   `CLIP_STRBUF_STREAM_SIZE` bytes that is flushed to the sink whenever it
+ *   fills up, so memory stays bounded no matter how much is written.
+ *
+ * Once a sink reports an error (or an allocation fails) the buffer is marked as
+ * failed: later writes are dropped and return `false`.
+ *
+ * Example:
+ * CLIP_StrBuf sb;
+ * clip_strbuf_init_file(&sb, stdout);
+ * List_write(int, &xs, &sb);
+ * clip_strbuf_puts(&sb, "\n");
+ * clip_strbuf_free(&sb); // flushes
+ */
+#ifndef CLIP_STRBUF_H
+#define CLIP_STRBUF_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <CLIP/Allocator.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+/* Size of the buffer used by streaming writers. */
+#ifndef CLIP_STRBUF_STREAM_SIZE
+#define CLIP_STRBUF_STREAM_SIZE 4096
+#endif
+
+/* Initial capacity of an in-memory buffer. */
+#define CLIP_STRBUF_MIN_CAPACITY 64
+
+/* Receives `len` bytes of output; returns false on error. */
+typedef bool (*CLIP_StrBufSink)(void *ctx, const char *data, size_t len);
+
+typedef struct CLIP_StrBuf
+{
+  char *data;           /* Pending output (the whole string in memory mode) */
+  size_t len;           /* Bytes currently held in `data` */
+  size_t capacity;      /* Allocated size of `data` */
+  CLIP_StrBufSink sink; /* NULL in memory mode */
+  void *sink_ctx;       /* Passed back to `sink` */
+  bool failed;          /* Set after the first sink or allocation error */
+} CLIP_StrBuf;
+
+/**
+ * @brief Initialize an empty in-memory string builder. Nothing is allocated until the first write.
+ */
+static inline void clip_strbuf_init(CLIP_StrBuf *sb)
+{
+  sb->data = NULL;
+  sb->len = 0;
+  sb->capacity = 0;
+  sb->sink = NULL;
+  sb->sink_ctx = NULL;
+  sb->failed = false;
+}
+
+/**
+ * @brief Initialize a streaming writer that forwards its output to `sink`.
+ */
+static inline void clip_strbuf_init_sink(CLIP_StrBuf *sb, CLIP_StrBufSink sink, void *ctx)
+{
+  clip_strbuf_init(sb);
+  sb->sink = sink;
+  sb->sink_ctx = ctx;
+  sb->data = (char *)CLIP_MALLOC(CLIP_STRBUF_STREAM_SIZE);
+  if (!sb->data)
+  {
+    sb->failed = true;
+    return;
+  }
+  sb->capacity = CLIP_STRBUF_STREAM_SIZE;
+}
+
+static inline bool clip_strbuf_file_sink(void *ctx, const char *data, size_t len)
+{
+  return fwrite(data, 1, len, (FILE *)ctx) == len;
+}
+
+/**
+ * @brief Initialize a streaming writer on a stdio stream.
+ */
+static inline void clip_strbuf_init_file(CLIP_StrBuf *sb, FILE *file)
+{
+  clip_strbuf_init_sink(sb, clip_strbuf_file_sink, file);
+}
+
+#ifndef _WIN32
+static inline bool clip_strbuf_fd_sink(void *ctx, const char *data, size_t len)
+{
+  int fd = (int)(intptr_t)ctx;
+  while (len > 0)
+  {
+    ssize_t n = write(fd, data, len);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    len -= (size_t)n;
+  }
+  return true;
+}
+
+/**
+ * @brief Initialize a streaming writer on a raw file descriptor (no stdio buffering involved).
+ */
+static inline void clip_strbuf_init_fd(CLIP_StrBuf *sb, int fd)
+{
+  clip_strbuf_init_sink(sb, clip_strbuf_fd_sink, (void *)(intptr_t)fd);
+}
+#endif
+
+/**
+ * @brief Hand all pending output to the sink. A no-op in memory mode.
+ */
+static inline bool clip_strbuf_flush(CLIP_StrBuf *sb)
+{
+  if (sb->failed)
+    return false;
+  if (!sb->sink || sb->len == 0)
+    return true;
+  if (!sb->sink(sb->sink_ctx, sb->data, sb->len))
+    sb->failed = true;
+  sb->len = 0;
+  return !sb->failed;
+}
+
+/**
+ * @brief Make room for `n` more bytes and return where they go.
+ *
+ * Write at most `n` bytes there, then call `clip_strbuf_commit` with the number
+ * actually used. In memory mode one extra byte is kept for the terminator, so
+ * `n` bytes of a NUL-terminated string (as produced by `snprintf`) fit.
+ *
+ * @return The write position, or NULL if the buffer has failed.
+ */
+static inline char *clip_strbuf_reserve(CLIP_StrBuf *sb, size_t n)
+{
+  if (sb->failed)
+    return NULL;
+  if (sb->sink && sb->capacity - sb->len < n && !clip_strbuf_flush(sb))
+    return NULL;
+  size_t needed = sb->len + n + (sb->sink ? 0 : 1);
+  if (needed < n)
+  {
+    sb->failed = true;
+    return NULL;
+  }
+  if (needed > sb->capacity)
+  {
+    /* A streaming buffer only grows when a single reservation does not fit in it */
+    size_t capacity = sb->sink || sb->capacity == 0 ? CLIP_STRBUF_MIN_CAPACITY : sb->capacity;
+    while (capacity < needed)
+      capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+    char *data = (char *)CLIP_REALLOC(sb->data, capacity);
+    if (!data)
+    {
+      sb->failed = true;
+      return NULL;
+    }
+    sb->data = data;
+    sb->capacity = capacity;
+  }
+  return sb->data + sb->len;
+}
+
+/**
+ * @brief Account for `n` bytes written at the position returned by `clip_strbuf_reserve`.
+ */
+static inline void clip_strbuf_commit(CLIP_StrBuf *sb, size_t n)
+{
+  sb->len += n;
+  if (!sb->sink)
+    sb->data[sb->len] = '\0';
+}
+
+/**
+ * @brief Commit the NUL-terminated string (at most `max` bytes) written at the reserved position.
+ *
+ * Lets `void fn(T, char *, size_t)` style formatters write straight into the buffer.
+ */
+static inline void clip_strbuf_commit_str(CLIP_StrBuf *sb, size_t max)
+{
+  const char *start = sb->data + sb->len;
+  const char *end = (const char *)memchr(start, '\0', max);
+  clip_strbuf_commit(sb, end ? (size_t)(end - start) : max);
+}
+
+/**
+ * @brief Append `len` bytes. Writes larger than a streaming buffer go straight to the sink.
+ */
+static inline bool clip_strbuf_append(CLIP_StrBuf *sb, const char *str, size_t len)
+{
+  if (sb->sink && len > sb->capacity)
+  {
+    if (!clip_strbuf_flush(sb))
+      return false;
+    if (!sb->sink(sb->sink_ctx, str, len))
+      sb->failed = true;
+    return !sb->failed;
+  }
+  char *dst = clip_strbuf_reserve(sb, len);
+  if (!dst)
+    return false;
+  memcpy(dst, str, len);
+  clip_strbuf_commit(sb, len);
+  return true;
+}
+
+/**
+ * @brief Append a NUL-terminated string.
+ */
+static inline bool clip_strbuf_puts(CLIP_StrBuf *sb, const char *str)
+{
+  return clip_strbuf_append(sb, str, strlen(str));
+}
+
+/**
+ * @brief Append a single character.
+ */
+static inline bool clip_strbuf_putc(CLIP_StrBuf *sb, char c)
+{
+  char *dst = clip_strbuf_reserve(sb, 1);
+  if (!dst)
+    return false;
+  *dst = c;
+  clip_strbuf_commit(sb, 1);
+  return true;
+}
+
+/**
+ * @brief Append `printf`-style formatted output.
+ */
+static inline bool clip_strbuf_printf(CLIP_StrBuf *sb, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  va_list measure;
+  va_copy(measure, args);
+  int n = vsnprintf(NULL, 0, fmt, measure);
+  va_end(measure);
+  /* The formatter needs room for its terminator even when the sink does not */
+  char *dst = n < 0 ? NULL : clip_strbuf_reserve(sb, (size_t)n + 1);
+  if (dst)
+  {
+    vsnprintf(dst, (size_t)n + 1, fmt, args);
+    clip_strbuf_commit(sb, (size_t)n);
+  }
+  else
+    sb->failed = true;
+  va_end(args);
+  return dst != NULL;
+}
+
+/**
+ * @brief Current contents of an in-memory builder (always NUL-terminated, "" when empty).
+ */
+static inline const char *clip_strbuf_cstr(const CLIP_StrBuf *sb)
+{
+  return sb->data && !sb->sink ? sb->data : "";
+}
+
+/**
+ * @brief Take ownership of the string built in memory and reset the builder.
+ *
+ * @return A NUL-terminated string to be released with `free` (`CLIP_FREE`),
+ * or NULL if any write failed.
+ */
+static inline char *clip_strbuf_detach(CLIP_StrBuf *sb)
+{
+  char *str = NULL;
+  if (!sb->failed && !sb->sink)
+  {
+    if (!sb->data)
+    {
+      str = (char *)CLIP_MALLOC(1);
+      if (str)
+        str[0] = '\0';
+    }
+    else
+    {
+      str = sb->data;
+      sb->data = NULL;
+    }
+  }
+  CLIP_FREE(sb->data);
+  clip_strbuf_init(sb);
+  return str;
+}
+
+/**
+ * @brief Flush a streaming writer and release the buffer.
+ *
+ * @return false if any write since initialization failed.
+ */
+static inline bool clip_strbuf_free(CLIP_StrBuf *sb)
+{
+  bool ok = clip_strbuf_flush(sb);
+  CLIP_FREE(sb->data);
+  clip_strbuf_init(sb);
+  return ok;
+}
+
+#endif /* CLIP_STRBUF_H */
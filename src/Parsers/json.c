@@ -1,219 +1,3417 @@
 // src/Parsers/Json.c
 #include <CLIP/Parsers/json.h>
+#include <CLIP/ParSort.h>
+#include <CLIP/HashMap.h>
+#include <CLIP/Stack.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <locale.h>
+#include <math.h>
+
+#include "json_pow5.h"
+
+// The scanners use AVX2 when it is enabled at compile time (e.g. -mavx2), SSE2 otherwise
+// on x86, and plain byte loops elsewhere or when CLIP_JSON_NO_SIMD is defined.
+#if !defined(CLIP_JSON_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define CLIP_JSON_AVX2 1
+#elif !defined(CLIP_JSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define CLIP_JSON_SSE2 1
+#endif
+
+// Block loads are aligned, so they never cross into an unmapped page, but they may read
+// a few bytes past the terminating NUL. Keep AddressSanitizer from flagging that.
+#if defined(__GNUC__) || defined(__clang__)
+#define CLIP_JSON_NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define CLIP_JSON_NO_ASAN
+#endif
 
 // --- Utility ---
+static inline bool is_ws(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+#if defined(CLIP_JSON_AVX2)
+#define CLIP_JSON_BLOCK 32
+#define CLIP_JSON_BLOCK_BITS 0xFFFFFFFFu
+typedef __m256i json_block;
+#define json_load(p) _mm256_load_si256((const __m256i *)(p))
+#define json_eq(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+#define json_or(a, b) _mm256_or_si256(a, b)
+#define json_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define json_loadu(p) _mm256_loadu_si256((const __m256i *)(p))
+#define json_set1(c) _mm256_set1_epi8(c)
+#define json_blank(v) _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8(0x20))
+#define json_ctrl(v) _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F))
+#elif defined(CLIP_JSON_SSE2)
+#define CLIP_JSON_BLOCK 16
+#define CLIP_JSON_BLOCK_BITS 0xFFFFu
+typedef __m128i json_block;
+#define json_load(p) _mm_load_si128((const __m128i *)(p))
+#define json_eq(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+#define json_or(a, b) _mm_or_si128(a, b)
+#define json_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#define json_loadu(p) _mm_loadu_si128((const __m128i *)(p))
+#define json_set1(c) _mm_set1_epi8(c)
+#define json_blank(v) _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x20)), _mm_set1_epi8(0x20))
+#define json_ctrl(v) _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F))
+#endif
+
+#ifdef CLIP_JSON_BLOCK
+// Bit i is set when byte i of the block is not JSON whitespace
+static inline uint32_t non_ws_bits(json_block v)
+{
+    return CLIP_JSON_BLOCK_BITS & ~json_mask(json_or(json_or(json_eq(v, ' '), json_eq(v, '\n')),
+                             json_or(json_eq(v, '\r'), json_eq(v, '\t'))));
+}
+
+// Bit i is set when byte i of the block ends a run of plain string bytes
+static inline uint32_t string_stop_bits(json_block v)
+{
+    return json_mask(json_or(json_or(json_eq(v, '"'), json_eq(v, '\\')), json_eq(v, '\0')));
+}
+
+// Bit i is set when byte i of the block is a quote, a bracket or a brace ('[' and ']' fold
+// onto '{' and '}' once bit 5 is set), or the terminator
+static inline uint32_t skip_stop_bits(json_block v)
+{
+    json_block folded = json_or(v, json_set1(0x20));
+    return json_mask(json_or(json_or(json_eq(v, '"'), json_eq(v, '\0')),
+                             json_or(json_eq(folded, '{'), json_eq(folded, '}'))));
+}
+
+// Each scan starts on the aligned block holding `p` and drops the bits of the bytes before it
+CLIP_JSON_NO_ASAN static string find_non_ws(string p)
+{
+    size_t skip = (uintptr_t)p % CLIP_JSON_BLOCK;
+    string block = p - skip;
+    uint32_t bits = non_ws_bits(json_load(block)) >> skip << skip;
+    while (!bits)
+    {
+        block += CLIP_JSON_BLOCK;
+        bits = non_ws_bits(json_load(block));
+    }
+    return block + __builtin_ctz(bits);
+}
+
+CLIP_JSON_NO_ASAN static string find_string_stop(string p)
+{
+    size_t skip = (uintptr_t)p % CLIP_JSON_BLOCK;
+    string block = p - skip;
+    uint32_t bits = string_stop_bits(json_load(block)) >> skip << skip;
+    while (!bits)
+    {
+        block += CLIP_JSON_BLOCK;
+        bits = string_stop_bits(json_load(block));
+    }
+    return block + __builtin_ctz(bits);
+}
+
+// Stops at bytes that `skip_stop_bits` flags; a few others (control bytes) may stop it too
+CLIP_JSON_NO_ASAN static string find_skip_stop(string p)
+{
+    size_t skip = (uintptr_t)p % CLIP_JSON_BLOCK;
+    string block = p - skip;
+    uint32_t bits = skip_stop_bits(json_load(block)) >> skip << skip;
+    while (!bits)
+    {
+        block += CLIP_JSON_BLOCK;
+        bits = skip_stop_bits(json_load(block));
+    }
+    return block + __builtin_ctz(bits);
+}
+
+// Bounded variants for inputs that are not NUL-terminated: they return `end` when nothing is
+// found before it (`p` < `end`) and never load a block that starts at or past `end`
+CLIP_JSON_NO_ASAN static string find_non_ws_n(string p, string end)
+{
+    size_t skip = (uintptr_t)p % CLIP_JSON_BLOCK;
+    string block = p - skip;
+    uint32_t bits = non_ws_bits(json_load(block)) >> skip << skip;
+    while (!bits)
+    {
+        block += CLIP_JSON_BLOCK;
+        if (block >= end)
+            return end;
+        bits = non_ws_bits(json_load(block));
+    }
+    string found = block + __builtin_ctz(bits);
+    return found < end ? found : end;
+}
+
+CLIP_JSON_NO_ASAN static string find_string_stop_n(string p, string end)
+{
+    size_t skip = (uintptr_t)p % CLIP_JSON_BLOCK;
+    string block = p - skip;
+    uint32_t bits = string_stop_bits(json_load(block)) >> skip << skip;
+    while (!bits)
+    {
+        block += CLIP_JSON_BLOCK;
+        if (block >= end)
+            return end;
+        bits = string_stop_bits(json_load(block));
+    }
+    string found = block + __builtin_ctz(bits);
+    return found < end ? found : end;
+}
+#else
+static string find_non_ws(string p)
+{
+    while (is_ws(*p))
+        p++;
+    return p;
+}
+
+static string find_string_stop(string p)
+{
+    while (*p && *p != '"' && *p != '\\')
+        p++;
+    return p;
+}
+
+static string find_skip_stop(string p)
+{
+    while (*p && *p != '"' && *p != '{' && *p != '}' && *p != '[' && *p != ']')
+        p++;
+    return p;
+}
+
+static string find_non_ws_n(string p, string end)
+{
+    while (p < end && is_ws(*p))
+        p++;
+    return p;
+}
+
+static string find_string_stop_n(string p, string end)
+{
+    while (p < end && *p && *p != '"' && *p != '\\')
+        p++;
+    return p;
+}
+#endif
+
 static void skip_ws(string *s)
 {
-    while (isspace((unsigned char)**s))
+    // Most gaps between tokens are empty or a single space: only scan longer runs
+    if (!is_ws(**s))
+        return;
+    if (!is_ws((*s)[1]))
+    {
         (*s)++;
+        return;
+    }
+    *s = find_non_ws(*s + 2);
 }
 
+// --- Parser internals ---
+// Parse state threaded through the descent
+typedef struct JsonParseCtx
+{
+    const CLIP_Allocator *allocator; // Source of every node, string and container
+    bool insitu;                     // Strings are decoded in place and point into the input
+    bool packed;                     // Arrays of one kind of number, or of booleans, are packed
+} JsonParseCtx;
+
+static JsonValue *parse_value(string *s, JsonParseCtx *ctx);
+static bool parse_into(string *s, JsonParseCtx *ctx, JsonValue *v);
+static void parse_scalar(string *s, JsonParseCtx *ctx, JsonValue *v);
+static JsonValue *parse_object(string *s, JsonParseCtx *ctx, JsonValue *v);
+static JsonValue *parse_list(string *s, JsonParseCtx *ctx, JsonValue *v);
+static void parse_string(string *s, JsonParseCtx *ctx, JsonValue *v);
+static char *parse_string_raw(string *s, JsonParseCtx *ctx, size_t *out_len);
+static void parse_number(string *s, JsonParseCtx *ctx, JsonValue *v);
+static void parse_literal(string *s, string literal, JsonType type, int bool_val, JsonParseCtx *ctx, JsonValue *v);
+
 // --- Constructors ---
-static JsonValue *new_value(JsonType t)
+static void value_init(JsonValue *v, JsonType t, JsonParseCtx *ctx)
 {
-    JsonValue *v = malloc(sizeof(JsonValue));
     v->type = t;
+    v->insitu = ctx->insitu;
+}
+
+// A value of its own, the root of a document
+static JsonValue *new_value(JsonType t, JsonParseCtx *ctx)
+{
+    JsonValue *v = clip_alloc(ctx->allocator, sizeof(JsonValue));
+    if (!v)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    value_init(v, t, ctx);
+    v->embedded = false;
     return v;
 }
 
+// Top-level literals: shared, never written to, and never freed
+static JsonValue json_null = {.type = JSON_NULL, .embedded = true};
+static JsonValue json_true = {.type = JSON_BOOL, .embedded = true, .boolean = true};
+static JsonValue json_false = {.type = JSON_BOOL, .embedded = true, .boolean = false};
+
 // --- Parse entrypoint ---
+static JsonEngine json_engine = JSON_ENGINE_RECURSIVE;
+
+void Json_set_engine(JsonEngine engine)
+{
+    json_engine = engine;
+}
+
+JsonEngine Json_get_engine(void)
+{
+    return json_engine;
+}
+
+static JsonValue *parse_structural(const char *input, size_t len, const CLIP_Allocator *allocator);
+
 JsonValue *Json_parse(const string input)
 {
+    return Json_parse_with_allocator(input, NULL);
+}
+
+// Every node, string and container of the document comes from `allocator`
+JsonValue *Json_parse_with_allocator(const string input, const CLIP_Allocator *allocator)
+{
+    if (json_engine == JSON_ENGINE_STRUCTURAL)
+    {
+        // Input the structural engine rejects goes to the recursive parser, which keeps
+        // reading what it can of it, as always
+        JsonValue *v = parse_structural(input, strlen(input), allocator);
+        if (v)
+            return v;
+    }
+    JsonParseCtx ctx = {allocator, false, false};
+    string s = input;
+    skip_ws(&s);
+    return parse_value(&s, &ctx);
+}
+
+JsonValue *Json_parse_packed(const string input, const CLIP_Allocator *allocator)
+{
+    JsonParseCtx ctx = {allocator, false, true};
+    string s = input;
+    skip_ws(&s);
+    return parse_value(&s, &ctx);
+}
+
+// Strings and keys are decoded in place and point into `input`, which must outlive the document
+JsonValue *Json_parse_insitu(char *input, const CLIP_Allocator *allocator)
+{
+    JsonParseCtx ctx = {allocator, true, false};
     string s = input;
     skip_ws(&s);
-    return parse_value(&s);
+    return parse_value(&s, &ctx);
+}
+
+// The document lives in `arena`: no per-node frees, released by `Json_arena_free`
+JsonValue *Json_parse_arena(const string input, CLIP_Arena *arena)
+{
+    return Json_parse_with_allocator(input, &arena->allocator);
 }
 
 // --- Parse value ---
-static JsonValue *parse_value(string *s)
+// The root of a document: the only value allocated on its own. NULL if it nests too deeply.
+static JsonValue *parse_value(string *s, JsonParseCtx *ctx)
 {
     skip_ws(s);
-    if (**s == '{')
-        return parse_object(s);
-    if (**s == '[')
-        return parse_list(s);
-    if (**s == '"')
-        return parse_string(s);
     if (strncmp(*s, "true", 4) == 0)
-        return parse_literal(s, "true", JSON_BOOL, 1);
+    {
+        *s += 4;
+        return &json_true;
+    }
     if (strncmp(*s, "false", 5) == 0)
-        return parse_literal(s, "false", JSON_BOOL, 0);
+    {
+        *s += 5;
+        return &json_false;
+    }
     if (strncmp(*s, "null", 4) == 0)
-        return parse_literal(s, "null", JSON_NULL, 0);
-    return parse_number(s);
+    {
+        *s += 4;
+        return &json_null;
+    }
+    JsonValue *v = new_value(JSON_NULL, ctx);
+    if (!parse_into(s, ctx, v))
+    {
+        Json_free_with_allocator(v, ctx->allocator);
+        return NULL;
+    }
+    return v;
 }
 
-// --- Object ---
-static JsonValue *parse_object(string *s)
-{
-    (*s)++; // skip '{'
-    JsonValue *obj = new_value(JSON_OBJECT);
-    obj->object = Map_init(string, JsonValue_ptr);
+CLIP_DEFINE_STACK_TYPE(JsonValue_ptr)
 
+static JsonValue *parse_next(string *s, JsonParseCtx *ctx, JsonValue *parent);
+
+// Fills `v`, which its container provides. The objects and arrays being filled are kept on
+// an explicit stack, each one the last value of the one below it, so their slots stay put
+// until they are closed. Returns false, with what was read still freeable, once they nest
+// deeper than CLIP_JSON_MAX_DEPTH.
+static bool parse_into(string *s, JsonParseCtx *ctx, JsonValue *v)
+{
     skip_ws(s);
-    if (**s == '}')
+    if (**s != '{' && **s != '[')
     {
-        (*s)++;
-        return obj;
+        parse_scalar(s, ctx, v);
+        return true;
     }
-
-    while (**s)
+    Stack(JsonValue_ptr) open = Stack_init(JsonValue_ptr, 16);
+    bool ok = true;
+    while (v)
     {
         skip_ws(s);
-        JsonValue *key = parse_string(s);
-        skip_ws(s);
-        if (**s != ':')
+        JsonValue *child = NULL;
+        if (**s == '{' || **s == '[')
         {
-            fprintf(stderr, "Expected ':'\n");
-            exit(1);
+            if (open.size == CLIP_JSON_MAX_DEPTH)
+            {
+                v->type = JSON_NULL;
+                ok = false;
+                break;
+            }
+            child = **s == '{' ? parse_object(s, ctx, v) : parse_list(s, ctx, v);
+            if (child)
+                Stack_push(JsonValue_ptr, &open, v);
         }
-        (*s)++;
-        JsonValue *val = parse_value(s);
-        Map_insert(string, JsonValue_ptr, &obj->object, key->str, val);
-        free(key); // free temporary key JsonValue (string memory is now owned by Map)
+        else
+            parse_scalar(s, ctx, v);
 
-        skip_ws(s);
-        if (**s == '}')
-        {
-            (*s)++;
-            break;
-        }
-        if (**s == ',')
+        // The next value to fill: the first one of a container just opened, or the one after
+        // the value just read, closing the containers that end there
+        v = child;
+        while (!v && open.size > 0)
         {
-            (*s)++;
-            continue;
+            v = parse_next(s, ctx, open.data[open.size - 1]);
+            if (!v)
+                open.size--;
         }
-        fprintf(stderr, "Expected ',' or '}'\n");
+    }
+    Stack_free(JsonValue_ptr, &open);
+    return ok;
+}
+
+static void parse_scalar(string *s, JsonParseCtx *ctx, JsonValue *v)
+{
+    if (**s == '"')
+        parse_string(s, ctx, v);
+    else if (strncmp(*s, "true", 4) == 0)
+        parse_literal(s, "true", JSON_BOOL, 1, ctx, v);
+    else if (strncmp(*s, "false", 5) == 0)
+        parse_literal(s, "false", JSON_BOOL, 0, ctx, v);
+    else if (strncmp(*s, "null", 4) == 0)
+        parse_literal(s, "null", JSON_NULL, 0, ctx, v);
+    else
+        parse_number(s, ctx, v);
+}
+
+// --- Object ---
+// Members are appended as they are parsed, with no duplicate check. Once an object reaches
+// CLIP_JSON_OBJECT_INDEX_MIN members it also gets a hash index, kept at most 3/4 full.
+static JsonObject object_init(const CLIP_Allocator *allocator)
+{
+    JsonObject o;
+    o.members.data = NULL; // Empty objects allocate nothing
+    o.members.size = 0;
+    o.members.capacity = 0;
+    o.members.allocator = allocator;
+    o.index = NULL;
+    return o;
+}
+
+// Index slot holding `key`, whose hash is `hash`, or the empty slot where it belongs
+static size_t object_slot_hashed(const JsonObject *o, const char *key, size_t len, uint64_t hash)
+{
+    const uint32_t *slots = o->index + 1;
+    size_t mask = o->index[0] - 1;
+    size_t i = (size_t)hash & mask;
+    while (slots[i])
+    {
+        const JsonMember *m = &o->members.data[slots[i] - 1];
+        if (m->key_len == len && memcmp(m->key, key, len) == 0)
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static size_t object_slot(const JsonObject *o, const char *key, size_t len)
+{
+    return object_slot_hashed(o, key, len, clip_hash_bytes(key, len));
+}
+
+static void object_reindex(JsonObject *o, size_t cap)
+{
+    const CLIP_Allocator *allocator = o->members.allocator;
+    if (o->index)
+        clip_free(allocator, o->index, (o->index[0] + 1) * sizeof(uint32_t));
+    o->index = clip_alloc(allocator, (cap + 1) * sizeof(uint32_t));
+    if (!o->index)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(o->index + 1, 0, cap * sizeof(uint32_t));
+    o->index[0] = (uint32_t)cap;
+    // In input order, so a repeated key ends up pointing at its last occurrence
+    for (clip_size_t i = 0; i < o->members.size; i++)
+    {
+        const JsonMember *m = &o->members.data[i];
+        o->index[1 + object_slot(o, m->key, m->key_len)] = (uint32_t)i + 1;
+    }
+}
+
+// Member values live in the member array, so when it moves, each `value` follows its slot
+static void object_grow(JsonObject *o)
+{
+    clip_size_t cap = clip_grow_capacity(o->members.capacity, o->members.size + 1, sizeof(JsonMember));
+    JsonMember *data = cap < 0 ? NULL
+                               : clip_realloc(o->members.allocator, o->members.data,
+                                              (size_t)o->members.capacity * sizeof(JsonMember),
+                                              (size_t)cap * sizeof(JsonMember));
+    if (!data)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    if (data != o->members.data)
+        for (clip_size_t i = 0; i < o->members.size; i++)
+            data[i].value = &data[i].slot;
+    o->members.data = data;
+    o->members.capacity = cap;
+}
+
+// Appends a member and returns the slot its value goes in. Takes ownership of `key`.
+static JsonValue *object_add(JsonObject *o, char *key, size_t key_len)
+{
+    if (o->members.size == o->members.capacity)
+        object_grow(o);
+    JsonMember *m = &o->members.data[o->members.size++];
+    m->key = key;
+    m->key_len = key_len;
+    m->value = &m->slot;
+    m->slot.embedded = true;
+    size_t n = (size_t)o->members.size;
+    if (n < CLIP_JSON_OBJECT_INDEX_MIN)
+        return m->value;
+    size_t index_cap = o->index ? o->index[0] : 0;
+    if (n * 4 > index_cap * 3)
+    {
+        size_t cap = index_cap ? index_cap * 2 : CLIP_JSON_OBJECT_INDEX_MIN * 2;
+        while (n * 4 > cap * 3)
+            cap *= 2;
+        object_reindex(o, cap);
+    }
+    else
+        o->index[1 + object_slot(o, key, key_len)] = (uint32_t)n;
+    return m->value;
+}
+
+static const JsonMember *object_find(const JsonObject *o, const char *key, size_t len)
+{
+    if (o->index)
+    {
+        uint32_t at = o->index[1 + object_slot(o, key, len)];
+        return at ? &o->members.data[at - 1] : NULL;
+    }
+    // Backwards, so the last occurrence of a repeated key wins
+    for (clip_size_t i = o->members.size; i-- > 0;)
+    {
+        const JsonMember *m = &o->members.data[i];
+        if (m->key_len == len && memcmp(m->key, key, len) == 0)
+            return m;
+    }
+    return NULL;
+}
+
+JsonValue *Json_object_get(const JsonValue *obj, const char *key)
+{
+    if (!obj || obj->type != JSON_OBJECT)
+        return NULL;
+    const JsonMember *m = object_find(&obj->object, key, strlen(key));
+    return m ? m->value : NULL;
+}
+
+// Reads a member's key and its ':', and returns the slot for its value
+static JsonValue *parse_member(string *s, JsonParseCtx *ctx, JsonObject *o)
+{
+    skip_ws(s);
+    size_t key_len;
+    char *key = parse_string_raw(s, ctx, &key_len);
+    skip_ws(s);
+    if (**s != ':')
+    {
+        fprintf(stderr, "Expected ':'\n");
         exit(1);
     }
-    return obj;
+    (*s)++;
+    return object_add(o, key, key_len);
 }
 
-// --- Array ---
-static JsonValue *parse_list(string *s)
+// Opens the object at `*s` into `obj` and returns the slot of its first value, or NULL if it
+// has no members
+static JsonValue *parse_object(string *s, JsonParseCtx *ctx, JsonValue *obj)
 {
-    (*s)++; // skip '['
-    JsonValue *arr = new_value(JSON_LIST);
-    arr->list = List_init(JsonValue_ptr, 4);
+    (*s)++; // skip '{'
+    value_init(obj, JSON_OBJECT, ctx);
+    obj->object = object_init(ctx->allocator);
 
     skip_ws(s);
-    if (**s == ']')
+    if (**s == '}')
     {
         (*s)++;
-        return arr;
+        return NULL;
+    }
+    if (!**s)
+        return NULL;
+    return parse_member(s, ctx, &obj->object);
+}
+
+// --- Array ---
+static string scan_number(string start, string end, JsonNumber *out);
+
+static void list_init(JsonValue *arr, const CLIP_Allocator *allocator)
+{
+    arr->list.data = NULL; // Empty arrays allocate nothing
+    arr->list.size = 0;
+    arr->list.capacity = 0;
+    arr->list.allocator = allocator;
+    arr->slots = NULL;
+}
+
+// Appends an element to a JSON_LIST and returns its slot. The elements live in `slots`, which
+// grows along with `list`, and list.data is pointed at them again whenever they move.
+static JsonValue *list_add(JsonValue *arr)
+{
+    List(JsonValue_ptr) *l = &arr->list;
+    if (l->size == l->capacity)
+    {
+        clip_size_t cap = clip_grow_capacity(l->capacity, l->size + 1, sizeof(JsonValue));
+        JsonValue **data = cap < 0 ? NULL
+                                   : clip_realloc(l->allocator, l->data, (size_t)l->capacity * sizeof(JsonValue *),
+                                                  (size_t)cap * sizeof(JsonValue *));
+        JsonValue *slots = data ? clip_realloc(l->allocator, arr->slots, (size_t)l->capacity * sizeof(JsonValue),
+                                               (size_t)cap * sizeof(JsonValue))
+                                : NULL;
+        if (!slots)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        for (clip_size_t i = 0; i < l->size; i++)
+            data[i] = &slots[i];
+        l->data = data;
+        l->capacity = cap;
+        arr->slots = slots;
+    }
+    JsonValue *slot = &arr->slots[l->size];
+    l->data[l->size++] = slot;
+    slot->embedded = true;
+    return slot;
+}
+
+static size_t packed_elem_size(JsonPackedKind kind)
+{
+    return kind == JSON_PACKED_BOOL ? sizeof(bool) : kind == JSON_PACKED_INT ? sizeof(int64_t) : sizeof(double);
+}
+
+static void packed_append(JsonNumberArray *a, const CLIP_Allocator *allocator, const JsonNumber *n, bool b)
+{
+    if (a->size == a->capacity)
+    {
+        size_t elem = packed_elem_size(a->kind);
+        size_t cap = a->capacity ? a->capacity * 2 : 8;
+        void *data = clip_realloc(allocator, a->ints, a->capacity * elem, cap * elem);
+        if (!data)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        a->ints = data;
+        a->capacity = cap;
     }
+    if (a->kind == JSON_PACKED_BOOL)
+        a->bools[a->size++] = b;
+    else if (a->kind == JSON_PACKED_INT)
+        a->ints[a->size++] = n->integer;
+    else
+        a->doubles[a->size++] = n->number;
+}
 
-    while (**s)
+// Reads the elements of the array at `*s` (past '[' and any whitespace) into a packed buffer
+// while they are all of the kind of the first one. Returns true with `arr` complete as a
+// JSON_NUMBER_ARRAY. Otherwise `arr` is left a JSON_LIST of the elements read so far, `*s` at
+// the first element that did not fit, and parse_list carries on from there.
+static bool parse_packed(string *s, JsonParseCtx *ctx, JsonValue *arr)
+{
+    JsonNumberArray a = {JSON_PACKED_BOOL, 0, 0, {NULL}};
+    bool first = true;
+    string start;
+    for (;;)
     {
-        JsonValue *val = parse_value(s);
-        List_append(JsonValue_ptr, &arr->list, val);
+        skip_ws(s);
+        start = *s;
+        JsonNumber n;
+        bool b = false;
+        if (strncmp(*s, "true", 4) == 0 || strncmp(*s, "false", 5) == 0)
+        {
+            b = **s == 't';
+            if (!first && a.kind != JSON_PACKED_BOOL)
+                break;
+            *s += b ? 4 : 5;
+        }
+        else if (**s == '-' || isdigit((unsigned char)**s))
+        {
+            string after = scan_number(*s, NULL, &n);
+            JsonPackedKind kind = n.number_kind == JSON_NUMBER_INT ? JSON_PACKED_INT : JSON_PACKED_DOUBLE;
+            if (n.number_kind == JSON_NUMBER_UINT || (!first && a.kind != kind))
+                break;
+            a.kind = kind;
+            *s = after;
+        }
+        else
+            break;
+        first = false;
+        packed_append(&a, ctx->allocator, &n, b);
+
         skip_ws(s);
         if (**s == ']')
         {
             (*s)++;
-            break;
+            arr->type = JSON_NUMBER_ARRAY;
+            arr->numbers = a;
+            return true;
         }
-        if (**s == ',')
+        if (**s != ',')
         {
-            (*s)++;
-            continue;
+            fprintf(stderr, "Expected ',' or ']'\n");
+            exit(1);
+        }
+        (*s)++;
+    }
+
+    // Mixed kinds: the elements read so far become list elements
+    for (size_t i = 0; i < a.size; i++)
+    {
+        JsonValue *v = list_add(arr);
+        if (a.kind == JSON_PACKED_BOOL)
+        {
+            value_init(v, JSON_BOOL, ctx);
+            v->boolean = a.bools[i];
+        }
+        else
+        {
+            value_init(v, JSON_NUMBER, ctx);
+            bool integer = a.kind == JSON_PACKED_INT;
+            v->number = integer ? (double)a.ints[i] : a.doubles[i];
+            v->number_kind = integer ? JSON_NUMBER_INT : JSON_NUMBER_DOUBLE;
+            v->integer = integer ? a.ints[i] : 0;
         }
-        fprintf(stderr, "Expected ',' or ']'\n");
-        exit(1);
     }
-    return arr;
+    clip_free(ctx->allocator, a.ints, a.capacity * packed_elem_size(a.kind));
+    *s = start;
+    return false;
 }
 
-// --- String ---
-static JsonValue *parse_string(string *s)
+// Opens the array at `*s` into `arr` and returns the slot of its first element, or NULL if it
+// is empty or was read whole as a packed array
+static JsonValue *parse_list(string *s, JsonParseCtx *ctx, JsonValue *arr)
 {
-    (*s)++; // skip opening "
-    string start = *s;
-    while (**s && **s != '"')
+    (*s)++; // skip '['
+    value_init(arr, JSON_LIST, ctx);
+    list_init(arr, ctx->allocator);
+
+    skip_ws(s);
+    if (**s == ']')
     {
-        if (**s == '\\')
-            (*s)++; // skip escaped char
         (*s)++;
+        return NULL;
     }
-    size_t len = *s - start;
-    char *buf = malloc(len + 1);
-    strncpy(buf, start, len);
-    buf[len] = '\0';
-    if (**s == '"')
-        (*s)++;
-
-    JsonValue *strv = new_value(JSON_STRING);
-    strv->str = buf;
-    return strv;
+    if (!**s || (ctx->packed && parse_packed(s, ctx, arr)))
+        return NULL;
+    return list_add(arr);
 }
 
-// --- Number ---
-static JsonValue *parse_number(string *s)
+// After a value in the open container `parent`: the slot of the next one, or NULL once
+// `parent` is closed
+static JsonValue *parse_next(string *s, JsonParseCtx *ctx, JsonValue *parent)
 {
-    string start = *s;
-    while (isdigit((unsigned char)**s) || **s == '.' || **s == '-' || **s == '+' || **s == 'e' || **s == 'E')
+    bool object = parent->type == JSON_OBJECT;
+    skip_ws(s);
+    if (**s == (object ? '}' : ']'))
     {
         (*s)++;
+        return NULL;
     }
-
-    size_t len = *s - start;
-    char buf[128]; // enough for most numbers, avoids heap alloc
-    if (len >= sizeof(buf))
+    if (**s != ',')
     {
-        // fallback if number too long
-        char *heapbuf = strndup(start, len);
-        JsonValue *num = new_value(JSON_NUMBER);
-        num->number = strtod(heapbuf, NULL);
-        free(heapbuf);
-        return num;
+        fprintf(stderr, object ? "Expected ',' or '}'\n" : "Expected ',' or ']'\n");
+        exit(1);
     }
+    (*s)++;
+    if (!**s)
+        return NULL; // Truncated input closes what is open
+    return object ? parse_member(s, ctx, &parent->object) : list_add(parent);
+}
 
-    memcpy(buf, start, len);
-    buf[len] = '\0';
-
-    JsonValue *num = new_value(JSON_NUMBER);
-    num->number = strtod(buf, NULL);
-    return num;
+// --- String ---
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
 }
 
-// --- Literal ---
-static JsonValue *parse_literal(string *s, string literal, JsonType type, int bool_val)
+// Reads the 4 hex digits after "\u", or returns -1
+static long read_hex4(string p, string end)
 {
-    size_t len = strlen(literal);
-    *s += len;
-    JsonValue *v = new_value(type);
-    if (type == JSON_BOOL)
-        v->boolean = bool_val;
-    return v;
+    if (end - p < 4)
+        return -1;
+    long cp = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        int h = hex_value(p[i]);
+        if (h < 0)
+            return -1;
+        cp = cp << 4 | h;
+    }
+    return cp;
 }
 
-// --- Free helpers ---
-static void free_object_entry(string *k, JsonValue_ptr *v, void *ud)
+static size_t put_utf8(char *dst, unsigned long cp)
 {
-    (void)ud;
-    free((char *)*k); // free the strdup’d key
-    Json_free(*v);    // free the value recursively
+    if (cp < 0x80)
+    {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        dst[0] = (char)(0xC0 | cp >> 6);
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        dst[0] = (char)(0xE0 | cp >> 12);
+        dst[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | cp >> 18);
+    dst[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    dst[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
 }
 
-void Json_free(JsonValue* v) {
-    if (!v) return;
+// Decodes the escapes of the `len` raw bytes at `src` into `dst` and returns the decoded length.
+// The output is never longer than the input, so `dst == src` decodes in place.
+static size_t unescape(char *dst, string src, size_t len)
+{
+    string end = src + len;
+    char *out = dst;
+    while (src < end)
+    {
+        if (*src != '\\' || src + 1 == end)
+        {
+            *out++ = *src++;
+            continue;
+        }
+        char c = src[1];
+        src += 2;
+        switch (c)
+        {
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u':
+        {
+            long cp = read_hex4(src, end);
+            if (cp < 0)
+            {
+                *out++ = 'u'; // Malformed escape: keep it as text
+                break;
+            }
+            src += 4;
+            // A high surrogate followed by "\uDC00".."\uDFFF" encodes one code point
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - src >= 6 && src[0] == '\\' && src[1] == 'u')
+            {
+                long lo = read_hex4(src + 2, end);
+                if (lo >= 0xDC00 && lo <= 0xDFFF)
+                {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    src += 6;
+                }
+            }
+            out += put_utf8(out, (unsigned long)cp);
+            break;
+        }
+        default: // '"', '\\', '/' and anything unknown stand for themselves
+            *out++ = c;
+            break;
+        }
+    }
+    return (size_t)(out - dst);
+}
+
+// Finds the closing quote of the string whose contents start at `p` (or the terminator
+// if it is missing), and whether the string has escapes
+static string string_end(string p, bool *escaped)
+{
+    *escaped = false;
+    p = find_string_stop(p);
+    while (*p == '\\')
+    {
+        *escaped = true;
+        if (p[1])
+            p++; // skip escaped char
+        p = find_string_stop(p + 1);
+    }
+    return p;
+}
+
+// Reads the string at `*s` (opening quote included), decoding its escapes.
+// The copy comes from the context's allocator, or, in situ, is the input itself.
+static char *parse_string_raw(string *s, JsonParseCtx *ctx, size_t *out_len)
+{
+    (*s)++; // skip opening "
+    string start = *s;
+    bool escaped;
+    *s = string_end(*s, &escaped);
+    size_t raw_len = *s - start;
+    if (**s == '"')
+        (*s)++; // before the quote is overwritten by an in situ terminator
+
+    char *buf = (char *)start;
+    if (!ctx->insitu)
+    {
+        buf = clip_alloc(ctx->allocator, raw_len + 1);
+        if (!buf)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    size_t len = raw_len;
+    if (escaped)
+        len = unescape(buf, start, raw_len);
+    else if (!ctx->insitu)
+        memcpy(buf, start, raw_len);
+    if (!ctx->insitu && len < raw_len)
+        buf = clip_realloc(ctx->allocator, buf, raw_len + 1, len + 1); // keep the block size equal to strlen + 1
+    buf[len] = '\0';
+    if (out_len)
+        *out_len = len;
+    return buf;
+}
+
+static void parse_string(string *s, JsonParseCtx *ctx, JsonValue *v)
+{
+    value_init(v, JSON_STRING, ctx);
+    v->str = parse_string_raw(s, ctx, &v->str_len);
+}
+
+// --- Number ---
+// The lexeme is scanned once: its digits accumulate into a 64-bit significand `w` while
+// the decimal exponent `q` is tracked separately. Integers without a fraction or exponent
+// that fit in 64 bits are kept exactly. Any other number becomes the correctly rounded
+// double nearest to w * 10^q, through exact double arithmetic when both w and q are small
+// (Clinger's fast path), then through Eisel-Lemire, and through strtod only in the rare
+// cases where neither can prove the rounding.
+
+static const double json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline void mul_64x64(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a * b;
+    *hi = (uint64_t)(p >> 64);
+    *lo = (uint64_t)p;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    *lo = (mid << 32) | (uint32_t)ll;
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+static inline int leading_zeros_64(uint64_t x) // x != 0
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    for (; !(x >> 63); x <<= 1)
+        n++;
+    return n;
+#endif
+}
+
+// w * 10^q for w != 0, following Lemire, "Number Parsing at a Gigabyte per Second"
+// (2021). The truncated 128-bit product of w with 5^q is almost always enough to fix the
+// 54 leading bits of the result; when it is not, or when the value lands exactly halfway
+// between two doubles or outside the normal range, this returns false instead of
+// guessing. json_pow5.h holds the powers of five, generated as in the paper.
+static bool eisel_lemire(uint64_t w, int64_t q, bool negative, double *out)
+{
+    if (q < CLIP_JSON_POW5_MIN || q > CLIP_JSON_POW5_MAX)
+        return false;
+    // 1024 + 63 + floor(log2(5^q)) + q, via a fixed point approximation of log2(5)
+    int64_t exponent = (((152170 + 65536) * q) >> 16) + 1024 + 63;
+    int lz = leading_zeros_64(w);
+    w <<= lz;
+
+    const uint64_t *pow5 = json_pow5_128[q - CLIP_JSON_POW5_MIN];
+    uint64_t upper, lower;
+    mul_64x64(w, pow5[0], &upper, &lower);
+    if ((upper & 0x1FF) == 0x1FF && lower + w < lower)
+    {
+        // The low half of 5^q could still carry into the bits we keep
+        uint64_t high2, low2;
+        mul_64x64(w, pow5[1], &high2, &low2);
+        uint64_t middle = lower + high2;
+        if (middle < lower)
+            upper++;
+        if (middle + 1 == 0 && (upper & 0x1FF) == 0x1FF && low2 + w < low2)
+            return false;
+        lower = middle;
+    }
+
+    uint64_t upper_bit = upper >> 63;
+    uint64_t mantissa = upper >> (upper_bit + 9);
+    lz += (int)(1 ^ upper_bit);
+    if (lower == 0 && (upper & 0x1FF) == 0 && (mantissa & 3) == 1)
+        return false; // Possibly a tie, which has to round to even
+    mantissa = (mantissa + 1) >> 1;
+    if (mantissa >= (1ULL << 53))
+    {
+        mantissa = 1ULL << 52; // Rounding carried into the next binade
+        lz--;
+    }
+    mantissa &= ~(1ULL << 52);
+    int64_t biased = exponent - lz;
+    if (biased < 1 || biased > 2046)
+        return false; // Subnormal or infinite
+    uint64_t bits = mantissa | (uint64_t)biased << 52 | (uint64_t)negative << 63;
+    memcpy(out, &bits, sizeof(bits));
+    return true;
+}
+
+// The character at `p`, or NUL at `end`
+static inline char peek(string p, string end)
+{
+    return p == end ? '\0' : *p;
+}
+
+static inline bool is_number_char(char c)
+{
+    return isdigit((unsigned char)c) || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+// Slow path: strtod on a copy of the lexeme, with '.' swapped for the decimal point of the
+// current locale so a program that called setlocale still reads "1.5" as 1.5.
+static double strtod_lexeme(string start, size_t len)
+{
+    char buf[128];
+    char *copy = len < sizeof(buf) ? buf : malloc(len + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, start, len);
+    copy[len] = '\0';
+    const char *point = localeconv()->decimal_point;
+    if (point[0] != '.' && point[0] != '\0' && point[1] == '\0')
+    {
+        char *dot = memchr(copy, '.', len);
+        if (dot)
+            *dot = point[0];
+    }
+    double d = strtod(copy, NULL);
+    if (copy != buf)
+        free(copy);
+    return d;
+}
+
+// Reads the number starting at `start`, stopping at `end` (NULL when the input is
+// NUL-terminated), and returns the position after it.
+static string scan_number(string start, string end, JsonNumber *out)
+{
+    string p = start;
+    bool negative = peek(p, end) == '-';
+    p += negative;
+
+    uint64_t w = 0;       // Leading digits, as many as fit in 64 bits
+    int64_t q = 0;        // Decimal exponent applying to w
+    bool dropped = false; // Nonzero digits did not fit in w
+    bool integer = true;
+    string digits = p;
+    for (; isdigit((unsigned char)peek(p, end)); p++)
+    {
+        unsigned d = (unsigned)(*p - '0');
+        if (w < UINT64_MAX / 10 || (w == UINT64_MAX / 10 && d <= UINT64_MAX % 10))
+            w = w * 10 + d;
+        else
+        {
+            dropped |= d != 0;
+            q++;
+        }
+    }
+    bool valid = p > digits;
+    if (peek(p, end) == '.')
+    {
+        integer = false;
+        digits = ++p;
+        for (; isdigit((unsigned char)peek(p, end)); p++)
+        {
+            unsigned d = (unsigned)(*p - '0');
+            if (w < UINT64_MAX / 10 || (w == UINT64_MAX / 10 && d <= UINT64_MAX % 10))
+            {
+                w = w * 10 + d;
+                q--;
+            }
+            else
+                dropped |= d != 0;
+        }
+        valid = valid && p > digits;
+    }
+    if (peek(p, end) == 'e' || peek(p, end) == 'E')
+    {
+        integer = false;
+        p++;
+        bool negative_exp = peek(p, end) == '-';
+        if (peek(p, end) == '-' || peek(p, end) == '+')
+            p++;
+        int64_t e = 0;
+        for (digits = p; isdigit((unsigned char)peek(p, end)); p++)
+            if (e < 1000000) // Far beyond any double; saturating keeps q from overflowing
+                e = e * 10 + (*p - '0');
+        valid = valid && p > digits;
+        q += negative_exp ? -e : e;
+    }
+
+    // "-0" stays a double so its sign survives
+    bool exact_integer = integer && q == 0 && !dropped && (!negative || (w != 0 && w <= (uint64_t)INT64_MAX + 1));
+
+    out->number_kind = JSON_NUMBER_DOUBLE;
+    out->uinteger = 0;
+    if (!valid || is_number_char(peek(p, end)))
+    {
+        // Not JSON number syntax ("+1", "1.2.3"): keep the old lenient reading of the whole run
+        for (p = start; is_number_char(peek(p, end)); p++)
+            ;
+        out->number = strtod_lexeme(start, (size_t)(p - start));
+    }
+    else if (exact_integer)
+    {
+        if (negative)
+        {
+            out->integer = w == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)w;
+            out->number = (double)out->integer;
+            out->number_kind = JSON_NUMBER_INT;
+        }
+        else if (w <= INT64_MAX)
+        {
+            out->integer = (int64_t)w;
+            out->number = (double)out->integer;
+            out->number_kind = JSON_NUMBER_INT;
+        }
+        else
+        {
+            out->uinteger = w;
+            out->number = (double)w;
+            out->number_kind = JSON_NUMBER_UINT;
+        }
+    }
+    else if (w == 0 && !dropped)
+        out->number = negative ? -0.0 : 0.0;
+    else if (!dropped && w <= (1ULL << 53) && q >= -22 && q <= 22)
+    {
+        double d = (double)w; // Both operands are exact, so one IEEE operation rounds correctly
+        d = q < 0 ? d / json_pow10[-q] : d * json_pow10[q];
+        out->number = negative ? -d : d;
+    }
+    else
+    {
+        // With digits dropped the value lies between w and w + 1 (times 10^q); if both
+        // round to the same double, so does the value itself
+        double lo, hi;
+        if (!eisel_lemire(w, q, negative, &lo) ||
+            (dropped && (w == UINT64_MAX || !eisel_lemire(w + 1, q, negative, &hi) || hi != lo)))
+            lo = strtod_lexeme(start, (size_t)(p - start));
+        out->number = lo;
+    }
+    return p;
+}
+
+static void parse_number(string *s, JsonParseCtx *ctx, JsonValue *v)
+{
+    JsonNumber n;
+    *s = scan_number(*s, NULL, &n);
+    value_init(v, JSON_NUMBER, ctx);
+    v->number = n.number;
+    v->number_kind = n.number_kind;
+    v->uinteger = n.uinteger; // Also carries `integer`
+}
+
+bool Json_get_int64(const JsonValue *v, int64_t *out)
+{
+    if (!v || v->type != JSON_NUMBER)
+        return false;
+    if (v->number_kind == JSON_NUMBER_INT)
+        *out = v->integer;
+    else if (v->number_kind == JSON_NUMBER_UINT)
+        return false;
+    else if (v->number >= -0x1p63 && v->number < 0x1p63 && v->number == (double)(int64_t)v->number)
+        *out = (int64_t)v->number; // "1e3" and "2.0" are whole numbers too
+    else
+        return false;
+    return true;
+}
+
+bool Json_get_uint64(const JsonValue *v, uint64_t *out)
+{
+    if (!v || v->type != JSON_NUMBER)
+        return false;
+    if (v->number_kind == JSON_NUMBER_UINT)
+        *out = v->uinteger;
+    else if (v->number_kind == JSON_NUMBER_INT)
+    {
+        if (v->integer < 0)
+            return false;
+        *out = (uint64_t)v->integer;
+    }
+    else if (v->number >= 0 && v->number < 0x1p64 && v->number == (double)(uint64_t)v->number)
+        *out = (uint64_t)v->number;
+    else
+        return false;
+    return true;
+}
+
+size_t Json_array_size(const JsonValue *v)
+{
+    if (v && v->type == JSON_LIST)
+        return (size_t)v->list.size;
+    if (v && v->type == JSON_NUMBER_ARRAY)
+        return v->numbers.size;
+    return 0;
+}
+
+bool Json_array_number(const JsonValue *v, size_t i, JsonNumber *out)
+{
+    if (i >= Json_array_size(v))
+        return false;
+    if (v->type == JSON_LIST)
+    {
+        const JsonValue *e = v->list.data[i];
+        if (e->type != JSON_NUMBER)
+            return false;
+        out->number = e->number;
+        out->number_kind = e->number_kind;
+        out->uinteger = e->uinteger;
+        return true;
+    }
+    if (v->numbers.kind == JSON_PACKED_INT)
+    {
+        out->number = (double)v->numbers.ints[i];
+        out->number_kind = JSON_NUMBER_INT;
+        out->integer = v->numbers.ints[i];
+    }
+    else if (v->numbers.kind == JSON_PACKED_DOUBLE)
+    {
+        out->number = v->numbers.doubles[i];
+        out->number_kind = JSON_NUMBER_DOUBLE;
+        out->uinteger = 0;
+    }
+    else
+        return false;
+    return true;
+}
+
+bool Json_array_bool(const JsonValue *v, size_t i, bool *out)
+{
+    if (i >= Json_array_size(v))
+        return false;
+    if (v->type == JSON_LIST)
+    {
+        if (v->list.data[i]->type != JSON_BOOL)
+            return false;
+        *out = v->list.data[i]->boolean;
+    }
+    else if (v->numbers.kind == JSON_PACKED_BOOL)
+        *out = v->numbers.bools[i];
+    else
+        return false;
+    return true;
+}
+
+// --- Literal ---
+static void parse_literal(string *s, string literal, JsonType type, int bool_val, JsonParseCtx *ctx, JsonValue *v)
+{
+    *s += strlen(literal);
+    value_init(v, type, ctx);
+    if (type == JSON_BOOL)
+        v->boolean = bool_val;
+}
+
+// --- Free helpers ---
+void Json_free(JsonValue *v)
+{
+    Json_free_with_allocator(v, NULL);
+}
+
+// Releases what `v` owns besides its children, which must be gone already, and `v` itself
+static void free_node(JsonValue *v, const CLIP_Allocator *allocator)
+{
     switch (v->type) {
         case JSON_STRING:
-            free((char*)v->str);
+            if (!v->insitu)
+                clip_free(allocator, (char *)v->str, v->str_len + 1);
             break;
         case JSON_OBJECT:
-            //Map_foreach(string, JsonValue_ptr, &v->object, free_object_entry, NULL);
-            Map_free(string, JsonValue_ptr, &v->object);
+            if (!v->insitu) // In situ keys point into the input
+                for (clip_size_t i = 0; i < v->object.members.size; i++)
+                    clip_free(allocator, (char *)v->object.members.data[i].key, v->object.members.data[i].key_len + 1);
+            clip_free(allocator, v->object.members.data, (size_t)v->object.members.capacity * sizeof(JsonMember));
+            if (v->object.index)
+                clip_free(allocator, v->object.index, (v->object.index[0] + 1) * sizeof(uint32_t));
             break;
         case JSON_LIST:
-            List_free(JsonValue_ptr, &v->list);
+            clip_free(allocator, v->list.data, (size_t)v->list.capacity * sizeof(JsonValue *));
+            clip_free(allocator, v->slots, (size_t)v->list.capacity * sizeof(JsonValue));
+            break;
+        case JSON_NUMBER_ARRAY:
+            clip_free(allocator, v->numbers.ints, v->numbers.capacity * packed_elem_size(v->numbers.kind));
             break;
         default:
             break;
     }
-    free(v);
+    if (!v->embedded) // Values inside a container go with its storage
+        clip_free(allocator, v, sizeof(JsonValue));
+}
+
+// Child `i` of an object or array, or NULL past the last one (and for any other value)
+static JsonValue *node_child(const JsonValue *v, clip_size_t i)
+{
+    if (v->type == JSON_OBJECT)
+        return i < v->object.members.size ? v->object.members.data[i].value : NULL;
+    if (v->type == JSON_LIST)
+        return i < v->list.size ? v->list.data[i] : NULL;
+    return NULL;
+}
+
+// A container being freed, and the next of its children to free
+typedef struct
+{
+    JsonValue *v;
+    clip_size_t next;
+} JsonFreeFrame;
+
+CLIP_DEFINE_STACK_TYPE(JsonFreeFrame)
+
+// Children are freed before the storage of their container holding them, depth first, with
+// the containers on the way down kept on an explicit stack
+void Json_free_with_allocator(JsonValue *v, const CLIP_Allocator *allocator)
+{
+    if (!v) return;
+    if (!node_child(v, 0))
+    {
+        free_node(v, allocator);
+        return;
+    }
+    Stack(JsonFreeFrame) open = Stack_init(JsonFreeFrame, 16);
+    Stack_push(JsonFreeFrame, &open, ((JsonFreeFrame){v, 0}));
+    while (open.size > 0)
+    {
+        JsonFreeFrame *top = &open.data[open.size - 1];
+        JsonValue *child = node_child(top->v, top->next++);
+        if (!child)
+        {
+            free_node(top->v, allocator);
+            open.size--;
+        }
+        else if (node_child(child, 0))
+            Stack_push(JsonFreeFrame, &open, ((JsonFreeFrame){child, 0}));
+        else
+            free_node(child, allocator);
+    }
+    Stack_free(JsonFreeFrame, &open);
+}
+
+// Drops every document parsed into `arena` at once; its blocks are kept for the next parse
+void Json_arena_free(CLIP_Arena *arena)
+{
+    clip_arena_reset(arena);
+}
+
+// --- Key paths ---
+// A path chains steps: a key, then ".key" or "[n]" for an array position, as in "a.b[3].c".
+// The empty path is the document itself.
+typedef struct
+{
+    string key; // NULL for an array position
+    size_t key_len;
+    size_t index;
+} JsonPathStep;
+
+// Reads the step at `*p`, which is not the end of the path. Returns false if it is malformed.
+static bool path_step(string *p, bool first, JsonPathStep *step)
+{
+    string c = *p;
+    if (*c == '[')
+    {
+        c++;
+        if (*c < '0' || *c > '9')
+            return false;
+        size_t n = 0;
+        while (*c >= '0' && *c <= '9')
+        {
+            if (n > (SIZE_MAX - 9) / 10)
+                return false;
+            n = n * 10 + (size_t)(*c++ - '0');
+        }
+        if (*c != ']')
+            return false;
+        step->key = NULL;
+        step->key_len = 0;
+        step->index = n;
+        *p = c + 1;
+        return true;
+    }
+    if (!first)
+    {
+        if (*c != '.')
+            return false;
+        c++;
+    }
+    step->key = c;
+    while (*c && *c != '.' && *c != '[')
+        c++;
+    step->key_len = (size_t)(c - step->key);
+    step->index = 0;
+    *p = c;
+    return true;
+}
+
+// --- Compiled paths ---
+typedef struct
+{
+    JsonPathStep step;
+    uint64_t hash; // Of the key, for objects with an index
+    size_t slot;   // Index slot where the key was found last time
+} JsonPathEntry;
+
+struct JsonPath
+{
+    size_t count;
+    JsonPathEntry entries[]; // Followed by a copy of the path text, which the keys point into
+};
+
+JsonPath *Json_path_compile(const char *path)
+{
+    size_t len = strlen(path);
+    size_t count = 0;
+    JsonPathStep step;
+    for (string p = path; *p; count++)
+        if (!path_step(&p, count == 0, &step))
+            return NULL;
+
+    JsonPath *compiled = malloc(sizeof(JsonPath) + count * sizeof(JsonPathEntry) + len + 1);
+    if (!compiled)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    char *text = (char *)(compiled->entries + count);
+    memcpy(text, path, len + 1);
+    compiled->count = count;
+    string p = text;
+    for (size_t i = 0; i < count; i++)
+    {
+        JsonPathEntry *e = &compiled->entries[i];
+        path_step(&p, i == 0, &e->step);
+        e->hash = e->step.key ? clip_hash_bytes(e->step.key, e->step.key_len) : 0;
+        e->slot = 0;
+    }
+    return compiled;
+}
+
+void Json_path_free(JsonPath *path)
+{
+    free(path);
+}
+
+// Resolves one key step the way `Json_object_get` does. Large objects are probed with the
+// stored hash, starting from the slot that held the key in the previous document: objects of
+// the same shape are indexed alike, so it usually still does.
+static JsonValue *path_member(const JsonObject *o, JsonPathEntry *e)
+{
+    const JsonPathStep *step = &e->step;
+    if (!o->index)
+    {
+        const JsonMember *m = object_find(o, step->key, step->key_len);
+        return m ? m->value : NULL;
+    }
+    const uint32_t *slots = o->index + 1;
+    if (e->slot < o->index[0] && slots[e->slot])
+    {
+        const JsonMember *m = &o->members.data[slots[e->slot] - 1];
+        if (m->key_len == step->key_len && memcmp(m->key, step->key, step->key_len) == 0)
+            return m->value;
+    }
+    e->slot = object_slot_hashed(o, step->key, step->key_len, e->hash);
+    uint32_t at = slots[e->slot];
+    return at ? o->members.data[at - 1].value : NULL;
+}
+
+JsonValue *Json_path_eval(JsonPath *path, const JsonValue *root)
+{
+    const JsonValue *v = root;
+    for (size_t i = 0; i < path->count && v; i++)
+    {
+        JsonPathEntry *e = &path->entries[i];
+        if (e->step.key)
+            v = v->type == JSON_OBJECT ? path_member(&v->object, e) : NULL;
+        else
+            v = v->type == JSON_LIST && e->step.index < (size_t)v->list.size ? v->list.data[e->step.index] : NULL;
+    }
+    return (JsonValue *)v;
+}
+
+// --- Selective parsing ---
+// Only the values on a requested path are looked at: objects and arrays are walked member by
+// member while some path still goes through them, the values at the end of a path are parsed,
+// and everything else is skipped without being decoded.
+typedef struct
+{
+    JsonParseCtx ctx;
+    JsonPathStep *steps; // The steps of every path, one path after the other
+    size_t *first;       // Where the steps of each path start
+    size_t *count;       // How many steps each path has
+    size_t *work;        // For each depth, the paths that go through the current value
+    size_t n;
+    size_t remaining;    // Paths not found yet
+    JsonValue_ptr *out;
+    char *scratch;       // Decoding buffer for keys with escapes
+    size_t scratch_cap;
+} JsonSelect;
+
+// Moves past the value at `*s` by counting quotes and brackets: nothing is decoded, allocated
+// or copied, and brackets are not checked to pair up
+static void skip_value(string *s)
+{
+    skip_ws(s);
+    string p = *s;
+    bool escaped;
+    if (*p == '"')
+    {
+        p = string_end(p + 1, &escaped);
+        if (*p)
+            p++;
+    }
+    else if (*p == '{' || *p == '[')
+    {
+        size_t depth = 0;
+        for (;;)
+        {
+            p = find_skip_stop(p);
+            char c = *p;
+            if (c == '\0')
+                break;
+            if (c == '"')
+            {
+                p = string_end(p + 1, &escaped);
+                if (*p)
+                    p++;
+                continue;
+            }
+            p++;
+            if (c == '{' || c == '[')
+                depth++;
+            else if ((c == '}' || c == ']') && --depth == 0)
+                break;
+        }
+    }
+    else
+    {
+        while (*p && !is_ws(*p) && *p != ',' && *p != '}' && *p != ']')
+            p++;
+    }
+    *s = p;
+}
+
+// Reads the key at `*s`. It points into the input unless it has escapes.
+static void select_key(JsonSelect *sel, string *s, string *key, size_t *key_len)
+{
+    string start = *s + 1;
+    bool escaped;
+    string q = string_end(start, &escaped);
+    *s = *q ? q + 1 : q;
+    size_t raw_len = (size_t)(q - start);
+    if (!escaped)
+    {
+        *key = start;
+        *key_len = raw_len;
+        return;
+    }
+    if (raw_len > sel->scratch_cap)
+    {
+        size_t cap = sel->scratch_cap * 2 > raw_len ? sel->scratch_cap * 2 : raw_len;
+        char *scratch = realloc(sel->scratch, cap);
+        if (!scratch)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        sel->scratch = scratch;
+        sel->scratch_cap = cap;
+    }
+    *key = sel->scratch;
+    *key_len = unescape(sel->scratch, start, raw_len);
+}
+
+static void select_value(JsonSelect *sel, string *s, size_t depth, const size_t *active, size_t nactive);
+
+// Gathers into the work list of `depth + 1` the paths in `active` whose step at `depth` is
+// `key` (or, with a NULL key, array position `index`). A key repeated in an object replaces
+// what its earlier occurrence held, as in the DOM, so what was found through that one is
+// dropped and looked for again.
+static size_t select_next(JsonSelect *sel, size_t depth, const size_t *active, size_t nactive,
+                          string key, size_t key_len, size_t index)
+{
+    size_t *next = sel->work + (depth + 1) * sel->n;
+    size_t m = 0;
+    for (size_t k = 0; k < nactive; k++)
+    {
+        size_t i = active[k];
+        if (sel->count[i] <= depth)
+            continue;
+        const JsonPathStep *step = &sel->steps[sel->first[i] + depth];
+        if (key ? step->key && step->key_len == key_len && memcmp(step->key, key, key_len) == 0
+                : !step->key && step->index == index)
+        {
+            if (sel->out[i])
+            {
+                Json_free(sel->out[i]);
+                sel->out[i] = NULL;
+                sel->remaining++;
+            }
+            next[m++] = i;
+        }
+    }
+    return m;
+}
+
+static void select_object(JsonSelect *sel, string *s, size_t depth, const size_t *active, size_t nactive)
+{
+    (*s)++; // skip '{'
+    const size_t *next = sel->work + (depth + 1) * sel->n;
+    for (;;)
+    {
+        skip_ws(s);
+        if (**s != '"')
+            break;
+        string key;
+        size_t key_len;
+        select_key(sel, s, &key, &key_len);
+        skip_ws(s);
+        if (**s != ':')
+            return;
+        (*s)++;
+        // Read to the end even with every path found: a later duplicate of a key wins
+        size_t m = select_next(sel, depth, active, nactive, key, key_len, 0);
+        if (m)
+            select_value(sel, s, depth + 1, next, m);
+        else
+            skip_value(s);
+        skip_ws(s);
+        if (**s != ',')
+            break;
+        (*s)++;
+    }
+    if (**s == '}')
+        (*s)++;
+}
+
+static void select_list(JsonSelect *sel, string *s, size_t depth, const size_t *active, size_t nactive)
+{
+    (*s)++; // skip '['
+    const size_t *next = sel->work + (depth + 1) * sel->n;
+    skip_ws(s);
+    if (**s == ']')
+    {
+        (*s)++;
+        return;
+    }
+    for (size_t pos = 0; **s; pos++)
+    {
+        size_t m = sel->remaining ? select_next(sel, depth, active, nactive, NULL, 0, pos) : 0;
+        if (m)
+            select_value(sel, s, depth + 1, next, m);
+        else
+            skip_value(s);
+        skip_ws(s);
+        if (**s != ',')
+            break;
+        (*s)++;
+    }
+    if (**s == ']')
+        (*s)++;
+}
+
+// `active` holds the paths that lead to the value at `*s`, `depth` steps into each
+static void select_value(JsonSelect *sel, string *s, size_t depth, const size_t *active, size_t nactive)
+{
+    skip_ws(s);
+    string start = *s, end = NULL;
+    bool deeper = false;
+    for (size_t k = 0; k < nactive; k++)
+    {
+        size_t i = active[k];
+        if (sel->count[i] > depth)
+        {
+            deeper = true;
+            continue;
+        }
+        // A path ends here; the same value is parsed again for each path naming it
+        *s = start;
+        sel->out[i] = parse_value(s, &sel->ctx);
+        end = *s;
+        if (sel->out[i]) // NULL if it nests too deeply
+            sel->remaining--;
+    }
+    if (!deeper)
+    {
+        *s = end;
+        return;
+    }
+    *s = start;
+    if (**s == '{')
+        select_object(sel, s, depth, active, nactive);
+    else if (**s == '[')
+        select_list(sel, s, depth, active, nactive);
+    else
+        skip_value(s);
+}
+
+size_t Json_parse_select(const string input, const string *paths, size_t n, JsonValue_ptr *out)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = NULL;
+        total += strlen(paths[i]) + 1; // A path has at most one step per character, plus one
+    }
+    if (n == 0)
+        return 0;
+
+    JsonSelect sel = {{NULL, false, false}, NULL, NULL, NULL, NULL, n, 0, out, NULL, 0};
+    sel.steps = malloc(total * sizeof(JsonPathStep));
+    sel.first = malloc(2 * n * sizeof(size_t));
+    if (!sel.steps || !sel.first)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    sel.count = sel.first + n;
+
+    size_t used = 0, max_steps = 0, valid = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        string p = paths[i];
+        size_t start = used;
+        bool ok = true;
+        while (*p && ok)
+        {
+            ok = path_step(&p, used == start, &sel.steps[used]);
+            used++;
+        }
+        sel.first[i] = start;
+        sel.count[i] = ok ? used - start : SIZE_MAX;
+        if (ok && used - start > max_steps)
+            max_steps = used - start;
+    }
+
+    sel.work = malloc((max_steps + 1) * n * sizeof(size_t));
+    if (!sel.work)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (sel.count[i] != SIZE_MAX) // Malformed paths match nothing
+            sel.work[valid++] = i;
+    sel.remaining = valid;
+    if (valid)
+    {
+        string s = input;
+        select_value(&sel, &s, 0, sel.work, valid);
+    }
+
+    free(sel.steps);
+    free(sel.first);
+    free(sel.work);
+    free(sel.scratch);
+    return valid - sel.remaining;
+}
+
+// --- Structural index ---
+// Stage one of the structural engine. Each 64 bytes of input become bit masks (whitespace,
+// operators, quotes, backslashes); escapes and strings are resolved with carries from block to
+// block, and what remains are the positions of the tokens: every operator ({}[]:,) outside
+// strings, both quotes of every string, and the first byte of every number or literal. The positions
+// are produced a batch of CLIP_JSON_INDEX_BATCH bytes at a time, as stage two asks for them,
+// so the index needs no allocation and stays in cache.
+#define CLIP_JSON_INDEX_BATCH 4096
+
+typedef struct
+{
+    string p, end;      // Input not indexed yet
+    string base;        // Start of the current batch; `pos` holds offsets from it
+    uint32_t count;     // Positions in the current batch
+    uint32_t next;      // Next position to hand out
+    uint64_t escaped;   // 1 when the next block starts with an escaped byte
+    uint64_t in_string; // All ones when the next block starts inside a string
+    uint64_t scalar;    // 1 when the last byte indexed belongs to a number or literal
+    uint32_t pos[CLIP_JSON_INDEX_BATCH + 3]; // Room for the positions written past the last one
+} JsonIndex;
+
+typedef struct
+{
+    uint64_t ws; // Whitespace, and control bytes too: stage two rejects them between tokens
+    uint64_t op, quote, backslash;
+} JsonBlockBits;
+
+static inline int trailing_zeros_64(uint64_t x) // x != 0
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    for (; !(x & 1); x >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+static inline uint32_t popcount_64(uint64_t x)
+{
+#if defined(__POPCNT__)
+    return (uint32_t)__builtin_popcountll(x);
+#else
+    // Without the instruction the builtin is a library call
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (uint32_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Bit i of `x` becomes the parity of bits 0..i
+static inline uint64_t prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static inline JsonBlockBits classify_block(const char *p)
+{
+    JsonBlockBits b = {0, 0, 0, 0};
+#ifdef CLIP_JSON_BLOCK
+    for (int i = 0; i < 64; i += CLIP_JSON_BLOCK)
+    {
+        json_block v = json_loadu(p + i);
+        json_block folded = json_or(v, json_set1(0x20)); // '[' and ']' become '{' and '}'
+        b.ws |= (uint64_t)json_mask(json_blank(v)) << i;
+        b.op |= (uint64_t)json_mask(json_or(json_or(json_eq(folded, '{'), json_eq(folded, '}')),
+                                            json_or(json_eq(v, ':'), json_eq(v, ',')))) << i;
+        b.quote |= (uint64_t)json_mask(json_eq(v, '"')) << i;
+        b.backslash |= (uint64_t)json_mask(json_eq(v, '\\')) << i;
+    }
+#else
+    for (int i = 0; i < 64; i++)
+    {
+        char c = p[i];
+        uint64_t bit = (uint64_t)1 << i;
+        if ((unsigned char)c <= ' ')
+            b.ws |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+            b.op |= bit;
+        else if (c == '"')
+            b.quote |= bit;
+        else if (c == '\\')
+            b.backslash |= bit;
+    }
+#endif
+    return b;
+}
+
+// Token starts among the 64 bytes at `p`, carrying the state over to the next block
+static inline uint64_t structural_bits(JsonIndex *ix, const char *p)
+{
+    const uint64_t even = 0x5555555555555555ULL;
+    JsonBlockBits b = classify_block(p);
+
+    // A run of backslashes escapes the byte after it when its length is odd. Adding the first
+    // bit of a run carries past its end: a run starting on an even bit with an odd length ends
+    // on an odd bit, and the other way around.
+    uint64_t backslash = b.backslash & ~ix->escaped;
+    uint64_t starts = backslash & ~(backslash << 1);
+    uint64_t from_even = backslash + (starts & even);
+    uint64_t from_odd = backslash + (starts & ~even);
+    uint64_t escaped = (((from_even & ~even) | (from_odd & even)) & ~backslash) | ix->escaped;
+    ix->escaped = from_odd < backslash; // A run from an odd bit through bit 63 has odd length
+
+    // Between an opening quote (included) and its closing quote (excluded)
+    uint64_t quote = b.quote & ~escaped;
+    uint64_t in_string = prefix_xor(quote) ^ ix->in_string;
+    ix->in_string = 0 - (in_string >> 63);
+
+    // A number or literal starts at a byte that is no whitespace or operator and does not
+    // follow another such byte (a quote starts a string instead)
+    uint64_t scalar = ~(b.ws | b.op);
+    uint64_t plain = scalar & ~b.quote;
+    uint64_t scalar_starts = scalar & ~((plain << 1) | ix->scalar);
+    ix->scalar = plain >> 63;
+
+    // Nothing inside a string counts; both of its quotes do
+    return ((b.op | scalar_starts) & ~(in_string ^ quote)) | quote;
+}
+
+static void index_init(JsonIndex *ix, const char *input, size_t len)
+{
+    ix->p = ix->base = input;
+    ix->end = input + len;
+    ix->count = ix->next = 0;
+    ix->escaped = ix->in_string = ix->scalar = 0;
+}
+
+static void index_fill(JsonIndex *ix)
+{
+    string stop = (size_t)(ix->end - ix->p) > CLIP_JSON_INDEX_BATCH ? ix->p + CLIP_JSON_INDEX_BATCH : ix->end;
+    uint32_t count = 0;
+    ix->base = ix->p;
+    for (string block = ix->p; block < stop; block += 64)
+    {
+        uint64_t bits;
+        if (stop - block >= 64)
+            bits = structural_bits(ix, block);
+        else
+        {
+            char tail[64]; // The last block of the input, padded with whitespace
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, (size_t)(stop - block));
+            bits = structural_bits(ix, tail);
+        }
+        // Four positions at a time, which keeps the loop predictable; the extra ones written
+        // past the last are overwritten by the next block
+        uint32_t offset = (uint32_t)(block - ix->base);
+        uint32_t *out = ix->pos + count;
+        count += popcount_64(bits);
+        const uint64_t top = (uint64_t)1 << 63; // Keeps the count of trailing zeros defined
+        while (bits)
+        {
+            out[0] = offset + (uint32_t)trailing_zeros_64(bits | top);
+            bits &= bits - 1;
+            out[1] = offset + (uint32_t)trailing_zeros_64(bits | top);
+            bits &= bits - 1;
+            out[2] = offset + (uint32_t)trailing_zeros_64(bits | top);
+            bits &= bits - 1;
+            out[3] = offset + (uint32_t)trailing_zeros_64(bits | top);
+            bits &= bits - 1;
+            out += 4;
+        }
+    }
+    ix->p = stop;
+    ix->count = count;
+    ix->next = 0;
+}
+
+// Position of the next token, or NULL past the last one
+static inline string index_next(JsonIndex *ix)
+{
+    while (ix->next == ix->count)
+    {
+        if (ix->p == ix->end)
+            return NULL;
+        index_fill(ix);
+    }
+    return ix->base + ix->pos[ix->next++];
+}
+
+// --- SAX ---
+// The walk is a resumable state machine, so the same code serves a whole buffer
+// (Json_sax_parse) and input arriving in chunks (Json_parser_feed).
+typedef enum
+{
+    SAX_VALUE,       // A value is expected
+    SAX_FIRST_VALUE, // Right after '[': a value or ']'
+    SAX_KEY,         // After ',' in an object
+    SAX_FIRST_KEY,   // Right after '{': a key or '}'
+    SAX_COLON,       // After a key
+    SAX_AFTER_VALUE, // ',' or the end of the innermost container
+    SAX_DONE         // The top-level value is complete: only whitespace may follow
+} SaxState;
+
+typedef struct JsonSax
+{
+    string p, end;
+    const JsonSaxHandler *h;
+    void *ud;
+    char *scratch; // Decoding buffer for strings with escapes, sized by the longest one
+    size_t scratch_cap;
+    SaxState state;
+    int depth;
+    bool partial; // Stopped at a token that may continue past `end`; `p` is its first byte
+    JsonIndex *index; // Where the structural engine finds the tokens; NULL to scan for them
+    bool in_object[CLIP_JSON_MAX_DEPTH];
+} JsonSax;
+
+static void sax_init(JsonSax *sx, const JsonSaxHandler *handler, void *ud)
+{
+    sx->p = sx->end = NULL;
+    sx->h = handler;
+    sx->ud = ud;
+    sx->scratch = NULL;
+    sx->scratch_cap = 0;
+    sx->state = SAX_VALUE;
+    sx->depth = 0;
+    sx->partial = false;
+    sx->index = NULL;
+}
+
+static void sax_skip_ws(JsonSax *sx)
+{
+    if (sx->p < sx->end && is_ws(*sx->p))
+        sx->p = find_non_ws_n(sx->p, sx->end);
+}
+
+// Reads the string at `sx->p` (opening quote included). Without escapes the result points into the input.
+// Returns false if the string does not end before `sx->end`.
+static bool sax_string(JsonSax *sx, string *out, size_t *out_len)
+{
+    string start = sx->p + 1;
+    string q = start;
+    bool escaped = false;
+    if (sx->index)
+    {
+        // The closing quote is the next position of the structural index
+        q = index_next(sx->index);
+        if (!q || q < start || *q != '"')
+            return false;
+        escaped = memchr(start, '\\', (size_t)(q - start)) != NULL;
+    }
+    else
+    {
+        for (;;)
+        {
+            q = q < sx->end ? find_string_stop_n(q, sx->end) : sx->end;
+            if (q == sx->end)
+                return false;
+            if (*q == '"')
+                break;
+            if (*q == '\\')
+            {
+                escaped = true;
+                q++;
+            }
+            q++;
+        }
+    }
+    size_t raw_len = (size_t)(q - start);
+    sx->p = q + 1;
+    if (!escaped)
+    {
+        *out = start;
+        *out_len = raw_len;
+        return true;
+    }
+    if (raw_len > sx->scratch_cap)
+    {
+        size_t cap = sx->scratch_cap * 2 > raw_len ? sx->scratch_cap * 2 : raw_len;
+        char *scratch = realloc(sx->scratch, cap);
+        if (!scratch)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        sx->scratch = scratch;
+        sx->scratch_cap = cap;
+    }
+    *out = sx->scratch;
+    *out_len = unescape(sx->scratch, start, raw_len);
+    return true;
+}
+
+// Consumes `literal` at `sx->p`. A prefix of it cut off by `end` is partial when more input may follow.
+static JsonSaxStatus sax_literal(JsonSax *sx, string literal, size_t len, bool more)
+{
+    size_t avail = (size_t)(sx->end - sx->p);
+    if (avail < len)
+    {
+        sx->partial = more && memcmp(sx->p, literal, avail) == 0;
+        return sx->partial ? JSON_SAX_OK : JSON_SAX_SYNTAX_ERROR;
+    }
+    if (memcmp(sx->p, literal, len) != 0)
+        return JSON_SAX_SYNTAX_ERROR;
+    sx->p += len;
+    return JSON_SAX_OK;
+}
+
+// Reads one scalar value at `sx->p` and reports it
+static JsonSaxStatus sax_scalar(JsonSax *sx, bool more)
+{
+    const JsonSaxHandler *h = sx->h;
+    char c = *sx->p;
+    bool ok = true;
+    JsonSaxStatus status;
+    if (c == '"')
+    {
+        string str;
+        size_t len;
+        if (!sax_string(sx, &str, &len))
+        {
+            sx->partial = more;
+            return more ? JSON_SAX_OK : JSON_SAX_SYNTAX_ERROR;
+        }
+        ok = !h->on_string || h->on_string(sx->ud, str, len);
+    }
+    else if (c == 't' || c == 'f')
+    {
+        bool value = c == 't';
+        if ((status = sax_literal(sx, value ? "true" : "false", value ? 4 : 5, more)) != JSON_SAX_OK || sx->partial)
+            return status;
+        ok = !h->on_bool || h->on_bool(sx->ud, value);
+    }
+    else if (c == 'n')
+    {
+        if ((status = sax_literal(sx, "null", 4, more)) != JSON_SAX_OK || sx->partial)
+            return status;
+        ok = !h->on_null || h->on_null(sx->ud);
+    }
+    else if (c == '-' || isdigit((unsigned char)c))
+    {
+        JsonNumber n;
+        string after = scan_number(sx->p, sx->end, &n);
+        if (after == sx->end && more)
+        {
+            sx->partial = true; // More digits may follow
+            return JSON_SAX_OK;
+        }
+        sx->p = after;
+        ok = !h->on_number || h->on_number(sx->ud, &n);
+    }
+    else
+        return JSON_SAX_SYNTAX_ERROR;
+    return ok ? JSON_SAX_OK : JSON_SAX_STOPPED;
+}
+
+static JsonSaxStatus sax_open(JsonSax *sx, bool object)
+{
+    if (sx->depth == CLIP_JSON_MAX_DEPTH)
+        return JSON_SAX_TOO_DEEP;
+    bool (*start)(void *) = object ? sx->h->on_start_object : sx->h->on_start_array;
+    if (start && !start(sx->ud))
+        return JSON_SAX_STOPPED;
+    sx->p++;
+    sx->in_object[sx->depth++] = object;
+    sx->state = object ? SAX_FIRST_KEY : SAX_FIRST_VALUE;
+    return JSON_SAX_OK;
+}
+
+static JsonSaxStatus sax_close(JsonSax *sx)
+{
+    sx->p++;
+    bool (*finish)(void *) = sx->in_object[--sx->depth] ? sx->h->on_end_object : sx->h->on_end_array;
+    if (finish && !finish(sx->ud))
+        return JSON_SAX_STOPPED;
+    sx->state = sx->depth ? SAX_AFTER_VALUE : SAX_DONE;
+    return JSON_SAX_OK;
+}
+
+// Moves `sx->p` to the next token of the structural index. Only whitespace may lie between
+// the end of the previous token and that position, which also catches whatever the index
+// could not tell from bytes alone (e.g. the "x" in "1x").
+static bool sax_next_indexed(JsonSax *sx)
+{
+    string t = index_next(sx->index);
+    if (!t)
+        t = sx->end;
+    if (t < sx->p)
+        return false;
+    for (; sx->p < t; sx->p++) // Gaps are short, mostly none or a single space
+        if (!is_ws(*sx->p))
+            return false;
+    return true;
+}
+
+// Consumes tokens up to `sx->end`. With `more`, a token running into `end` is left for the
+// next call (`sx->partial`); without, `end` terminates it. Whether the document is complete
+// is up to the caller to check (`sx->state == SAX_DONE`).
+static JsonSaxStatus sax_run(JsonSax *sx, bool more)
+{
+    JsonSaxStatus status = JSON_SAX_OK;
+    while (status == JSON_SAX_OK)
+    {
+        if (!sx->index)
+            sax_skip_ws(sx);
+        else if (!sax_next_indexed(sx))
+            return JSON_SAX_SYNTAX_ERROR;
+        if (sx->p == sx->end)
+            return JSON_SAX_OK;
+        char c = *sx->p;
+        switch (sx->state)
+        {
+        case SAX_DONE:
+            return JSON_SAX_SYNTAX_ERROR;
+        case SAX_COLON:
+            if (c != ':')
+                return JSON_SAX_SYNTAX_ERROR;
+            sx->p++;
+            sx->state = SAX_VALUE;
+            break;
+        case SAX_AFTER_VALUE:
+            if (c == ',')
+            {
+                sx->p++;
+                sx->state = sx->in_object[sx->depth - 1] ? SAX_KEY : SAX_VALUE;
+            }
+            else if (c == (sx->in_object[sx->depth - 1] ? '}' : ']'))
+                status = sax_close(sx);
+            else
+                return JSON_SAX_SYNTAX_ERROR;
+            break;
+        case SAX_FIRST_KEY:
+        case SAX_KEY:
+        {
+            if (c == '}' && sx->state == SAX_FIRST_KEY)
+            {
+                status = sax_close(sx);
+                break;
+            }
+            string key;
+            size_t len;
+            if (c != '"')
+                return JSON_SAX_SYNTAX_ERROR;
+            if (!sax_string(sx, &key, &len))
+            {
+                sx->partial = more;
+                return more ? JSON_SAX_OK : JSON_SAX_SYNTAX_ERROR;
+            }
+            if (sx->h->on_key && !sx->h->on_key(sx->ud, key, len))
+                return JSON_SAX_STOPPED;
+            sx->state = SAX_COLON;
+            break;
+        }
+        case SAX_FIRST_VALUE:
+        case SAX_VALUE:
+            if (c == ']' && sx->state == SAX_FIRST_VALUE)
+                status = sax_close(sx);
+            else if (c == '{' || c == '[')
+                status = sax_open(sx, c == '{');
+            else
+            {
+                status = sax_scalar(sx, more);
+                if (status != JSON_SAX_OK || sx->partial)
+                    return status;
+                sx->state = sx->depth ? SAX_AFTER_VALUE : SAX_DONE;
+            }
+            break;
+        }
+    }
+    return status;
+}
+
+static JsonSaxStatus sax_parse(const char *input, size_t len, const JsonSaxHandler *handler, void *ud,
+                               JsonEngine engine)
+{
+    JsonSax sx;
+    JsonIndex index;
+    sax_init(&sx, handler, ud);
+    sx.p = input;
+    sx.end = input + len;
+    if (engine == JSON_ENGINE_STRUCTURAL)
+    {
+        index_init(&index, input, len);
+        sx.index = &index;
+    }
+    JsonSaxStatus status = sax_run(&sx, false);
+    if (status == JSON_SAX_OK && sx.state != SAX_DONE)
+        status = JSON_SAX_SYNTAX_ERROR; // Truncated
+    free(sx.scratch);
+    return status;
+}
+
+// Both engines report the same events and the same status for any input
+JsonSaxStatus Json_sax_parse(const char *input, size_t len, const JsonSaxHandler *handler, void *ud)
+{
+    return sax_parse(input, len, handler, ud, json_engine);
+}
+
+// --- Incremental parser ---
+// Chunks are parsed where they are. Only a token cut by a chunk boundary (a string, number
+// or literal) is copied, into `pending`, and completed from the start of the next chunk.
+struct JsonParser
+{
+    JsonSax sax;
+    JsonDomBuilder dom; // Receives the events unless a handler was given
+    bool build_dom;
+    char *pending;
+    size_t pending_len, pending_cap;
+    bool pending_escape; // The pending string ends inside an escape sequence
+    JsonSaxStatus status; // First error, kept for every later call
+};
+
+static JsonParser *parser_new(void)
+{
+    JsonParser *p = malloc(sizeof(JsonParser));
+    if (!p)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    p->pending = NULL;
+    p->pending_len = p->pending_cap = 0;
+    p->pending_escape = false;
+    p->status = JSON_SAX_OK;
+    return p;
+}
+
+JsonParser *Json_parser_new(const CLIP_Allocator *allocator)
+{
+    JsonParser *p = parser_new();
+    p->build_dom = true;
+    Json_dom_builder_init(&p->dom, allocator);
+    sax_init(&p->sax, &Json_dom_handler, &p->dom);
+    return p;
+}
+
+JsonParser *Json_parser_new_sax(const JsonSaxHandler *handler, void *ud)
+{
+    JsonParser *p = parser_new();
+    p->build_dom = false;
+    sax_init(&p->sax, handler, ud);
+    return p;
+}
+
+static void pending_append(JsonParser *p, const char *data, size_t len)
+{
+    if (p->pending_len + len > p->pending_cap)
+    {
+        size_t cap = p->pending_cap ? p->pending_cap : 64;
+        while (cap < p->pending_len + len)
+            cap *= 2;
+        char *pending = realloc(p->pending, cap);
+        if (!pending)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        p->pending = pending;
+        p->pending_cap = cap;
+    }
+    memcpy(p->pending + p->pending_len, data, len);
+    p->pending_len += len;
+}
+
+// How many bytes of `chunk` belong to the pending token, or `len + 1` if all of them do and
+// it may go on. Tracks escapes so an escaped quote split from its backslash is not an end.
+static size_t pending_token_end(JsonParser *p, const char *chunk, size_t len)
+{
+    size_t i = 0;
+    if (p->pending[0] != '"')
+    {
+        while (i < len && (is_number_char(chunk[i]) || isalpha((unsigned char)chunk[i])))
+            i++;
+        return i < len ? i : len + 1;
+    }
+    if (p->pending_escape)
+        i = 1;
+    while (i < len && chunk[i] != '"')
+        i += chunk[i] == '\\' ? 2 : 1;
+    if (i < len)
+        return i + 1;
+    p->pending_escape = i > len;
+    return len + 1;
+}
+
+// Runs the state machine over `len` bytes; a cut-off token at the end moves to `pending`
+static JsonSaxStatus parser_run(JsonParser *p, const char *data, size_t len, bool more)
+{
+    JsonSax *sx = &p->sax;
+    sx->p = data;
+    sx->end = data + len;
+    JsonSaxStatus status = sax_run(sx, more);
+    if (status == JSON_SAX_OK && sx->partial)
+    {
+        sx->partial = false;
+        size_t i = 1, rest = (size_t)(sx->end - sx->p);
+        if (*sx->p == '"')
+            while (i < rest)
+                i += sx->p[i] == '\\' ? 2 : 1;
+        p->pending_escape = i > rest;
+        pending_append(p, sx->p, rest);
+    }
+    return status;
+}
+
+JsonSaxStatus Json_parser_feed(JsonParser *p, const char *chunk, size_t len)
+{
+    if (p->status != JSON_SAX_OK)
+        return p->status;
+    if (p->pending_len)
+    {
+        size_t used = pending_token_end(p, chunk, len);
+        if (used > len)
+        {
+            pending_append(p, chunk, len);
+            return JSON_SAX_OK;
+        }
+        pending_append(p, chunk, used);
+        chunk += used;
+        len -= used;
+        // The token is complete now, so its end is a real boundary
+        size_t pending_len = p->pending_len;
+        p->pending_len = 0;
+        p->status = parser_run(p, p->pending, pending_len, false);
+        if (p->status != JSON_SAX_OK)
+            return p->status;
+    }
+    p->status = parser_run(p, chunk, len, true);
+    return p->status;
+}
+
+JsonValue *Json_parser_finish(JsonParser *p, JsonSaxStatus *status)
+{
+    JsonSaxStatus result = p->status;
+    if (result == JSON_SAX_OK && p->pending_len)
+        result = parser_run(p, p->pending, p->pending_len, false);
+    if (result == JSON_SAX_OK && p->sax.state != SAX_DONE)
+        result = JSON_SAX_SYNTAX_ERROR; // Truncated
+    JsonValue *root = NULL;
+    if (p->build_dom)
+    {
+        root = Json_dom_builder_finish(&p->dom);
+        if (root && result != JSON_SAX_OK)
+        {
+            Json_free_with_allocator(root, p->dom.allocator);
+            root = NULL;
+        }
+    }
+    free(p->sax.scratch);
+    free(p->pending);
+    free(p);
+    if (status)
+        *status = result;
+    return root;
+}
+
+// --- DOM builder (SAX consumer) ---
+static char *dom_copy_string(JsonDomBuilder *b, const char *str, size_t len)
+{
+    char *copy = clip_alloc(b->allocator, len + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Memory allocation failed!\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// The slot for the next value, of type `type`: in the innermost open container, or a new root.
+// NULL for a second top-level value.
+static JsonValue *dom_slot(JsonDomBuilder *b, JsonType type)
+{
+    JsonParseCtx ctx = {b->allocator, false, false}; // The builder copies every string
+    JsonValue *v;
+    if (b->open.size == 0)
+    {
+        if (b->root)
+            return NULL;
+        b->root = new_value(type, &ctx);
+        return b->root;
+    }
+    JsonValue *parent = b->open.data[b->open.size - 1];
+    if (parent->type == JSON_LIST)
+        v = list_add(parent);
+    else
+    {
+        v = object_add(&parent->object, b->key, b->key_len);
+        b->key = NULL;
+    }
+    value_init(v, type, &ctx);
+    return v;
+}
+
+// Top-level literals are the shared singletons, like the recursive parser returns
+static bool dom_literal(JsonDomBuilder *b, JsonValue *literal)
+{
+    if (b->open.size == 0 && !b->root)
+    {
+        b->root = literal;
+        return true;
+    }
+    JsonValue *v = dom_slot(b, literal->type);
+    if (!v)
+        return false;
+    v->boolean = literal->boolean;
+    return true;
+}
+
+static bool dom_on_null(void *ud)
+{
+    return dom_literal(ud, &json_null);
+}
+
+static bool dom_on_bool(void *ud, bool value)
+{
+    return dom_literal(ud, value ? &json_true : &json_false);
+}
+
+static bool dom_on_number(void *ud, const JsonNumber *number)
+{
+    JsonDomBuilder *b = ud;
+    JsonValue *v = dom_slot(b, JSON_NUMBER);
+    if (!v)
+        return false;
+    v->number = number->number;
+    v->number_kind = number->number_kind;
+    v->uinteger = number->uinteger;
+    return true;
+}
+
+static bool dom_on_string(void *ud, const char *str, size_t len)
+{
+    JsonDomBuilder *b = ud;
+    JsonValue *v = dom_slot(b, JSON_STRING);
+    if (!v)
+        return false;
+    v->str = dom_copy_string(b, str, len);
+    v->str_len = len;
+    return true;
+}
+
+static bool dom_on_key(void *ud, const char *key, size_t len)
+{
+    JsonDomBuilder *b = ud;
+    b->key = dom_copy_string(b, key, len);
+    b->key_len = len;
+    return true;
+}
+
+// An open container is always the last value of its parent, so its slot does not move
+// until it is closed
+static bool dom_on_start_object(void *ud)
+{
+    JsonDomBuilder *b = ud;
+    JsonValue *v = dom_slot(b, JSON_OBJECT);
+    if (!v)
+        return false;
+    v->object = object_init(b->allocator);
+    List_append(JsonValue_ptr, &b->open, v);
+    return true;
+}
+
+static bool dom_on_start_array(void *ud)
+{
+    JsonDomBuilder *b = ud;
+    JsonValue *v = dom_slot(b, JSON_LIST);
+    if (!v)
+        return false;
+    list_init(v, b->allocator);
+    List_append(JsonValue_ptr, &b->open, v);
+    return true;
+}
+
+static bool dom_on_end(void *ud)
+{
+    JsonDomBuilder *b = ud;
+    b->open.size--;
+    return true;
+}
+
+const JsonSaxHandler Json_dom_handler = {
+    dom_on_null, dom_on_bool, dom_on_number, dom_on_string, dom_on_key,
+    dom_on_start_object, dom_on_end, dom_on_start_array, dom_on_end};
+
+void Json_dom_builder_init(JsonDomBuilder *b, const CLIP_Allocator *allocator)
+{
+    b->allocator = allocator;
+    b->open = List_init(JsonValue_ptr, 16);
+    b->key = NULL;
+    b->root = NULL;
+}
+
+JsonValue *Json_dom_builder_finish(JsonDomBuilder *b)
+{
+    JsonValue *root = b->root;
+    if (b->open.size != 0 || b->key)
+    {
+        // Every open container hangs off the root, so this releases the partial tree
+        if (b->key)
+            clip_free(b->allocator, b->key, b->key_len + 1);
+        if (root)
+            Json_free_with_allocator(root, b->allocator);
+        root = NULL;
+    }
+    b->open.size = 0; // The list only borrows the containers
+    List_free(JsonValue_ptr, &b->open);
+    b->key = NULL;
+    b->root = NULL;
+    return root;
+}
+
+// --- Structural engine ---
+// Stage two is the SAX state machine taking its tokens from the structural index
+// (JsonSax.index) instead of scanning for them. Its events build either the JsonValue DOM,
+// through the DOM builder, or a tape.
+static JsonValue *parse_structural(const char *input, size_t len, const CLIP_Allocator *allocator)
+{
+    JsonDomBuilder b;
+    Json_dom_builder_init(&b, allocator);
+    JsonSaxStatus status = sax_parse(input, len, &Json_dom_handler, &b, JSON_ENGINE_STRUCTURAL);
+    JsonValue *root = Json_dom_builder_finish(&b);
+    if (status != JSON_SAX_OK && root)
+    {
+        Json_free_with_allocator(root, allocator); // Complete, but followed by something else
+        root = NULL;
+    }
+    return root;
+}
+
+typedef struct
+{
+    JsonTape *tape;
+    int depth;
+    size_t open[CLIP_JSON_MAX_DEPTH]; // Start words of the containers being filled
+} JsonTapeBuilder;
+
+#define tape_word(type, payload) ((uint64_t)(type) << 56 | (uint64_t)(payload))
+
+static void tape_push(JsonTape *t, uint64_t word)
+{
+    if (t->size == t->capacity)
+    {
+        size_t capacity = t->capacity ? t->capacity * 2 : 256;
+        uint64_t *words = realloc(t->words, capacity * sizeof(uint64_t));
+        if (!words)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        t->words = words;
+        t->capacity = capacity;
+    }
+    t->words[t->size++] = word;
+}
+
+static bool tape_on_null(void *ud)
+{
+    tape_push(((JsonTapeBuilder *)ud)->tape, tape_word(JSON_TAPE_NULL, 0));
+    return true;
+}
+
+static bool tape_on_bool(void *ud, bool value)
+{
+    tape_push(((JsonTapeBuilder *)ud)->tape, tape_word(value ? JSON_TAPE_TRUE : JSON_TAPE_FALSE, 0));
+    return true;
+}
+
+static bool tape_on_number(void *ud, const JsonNumber *number)
+{
+    JsonTape *t = ((JsonTapeBuilder *)ud)->tape;
+    uint64_t bits = number->uinteger;
+    JsonTapeType type = number->number_kind == JSON_NUMBER_INT ? JSON_TAPE_INT : JSON_TAPE_UINT;
+    if (number->number_kind == JSON_NUMBER_DOUBLE)
+    {
+        memcpy(&bits, &number->number, sizeof(bits));
+        type = JSON_TAPE_DOUBLE;
+    }
+    tape_push(t, tape_word(type, 0));
+    tape_push(t, bits);
+    return true;
+}
+
+// Strings are stored as their length (a uint64_t), the bytes and a NUL
+static bool tape_on_string(void *ud, const char *str, size_t len)
+{
+    JsonTape *t = ((JsonTapeBuilder *)ud)->tape;
+    size_t needed = t->strings_len + sizeof(uint64_t) + len + 1;
+    if (needed > t->strings_cap)
+    {
+        size_t cap = t->strings_cap ? t->strings_cap : 4096;
+        while (cap < needed)
+            cap *= 2;
+        char *strings = realloc(t->strings, cap);
+        if (!strings)
+        {
+            fprintf(stderr, "Memory allocation failed!\n");
+            exit(EXIT_FAILURE);
+        }
+        t->strings = strings;
+        t->strings_cap = cap;
+    }
+    tape_push(t, tape_word(JSON_TAPE_STRING, t->strings_len));
+    uint64_t n = len;
+    memcpy(t->strings + t->strings_len, &n, sizeof(n));
+    memcpy(t->strings + t->strings_len + sizeof(n), str, len);
+    t->strings[t->strings_len + sizeof(n) + len] = '\0';
+    t->strings_len = needed;
+    return true;
+}
+
+static bool tape_open(JsonTapeBuilder *b, JsonTapeType type)
+{
+    b->open[b->depth++] = b->tape->size;
+    tape_push(b->tape, tape_word(type, 0)); // Completed by tape_close
+    return true;
+}
+
+static bool tape_close(JsonTapeBuilder *b, JsonTapeType type)
+{
+    size_t start = b->open[--b->depth];
+    tape_push(b->tape, tape_word(type, start));
+    b->tape->words[start] |= b->tape->size;
+    return true;
+}
+
+static bool tape_on_start_object(void *ud)
+{
+    return tape_open(ud, JSON_TAPE_START_OBJECT);
+}
+
+static bool tape_on_end_object(void *ud)
+{
+    return tape_close(ud, JSON_TAPE_END_OBJECT);
+}
+
+static bool tape_on_start_array(void *ud)
+{
+    return tape_open(ud, JSON_TAPE_START_ARRAY);
+}
+
+static bool tape_on_end_array(void *ud)
+{
+    return tape_close(ud, JSON_TAPE_END_ARRAY);
+}
+
+static const JsonSaxHandler tape_handler = {
+    tape_on_null, tape_on_bool, tape_on_number, tape_on_string, tape_on_string,
+    tape_on_start_object, tape_on_end_object, tape_on_start_array, tape_on_end_array};
+
+JsonSaxStatus Json_tape_parse(const char *input, size_t len, JsonTape *tape)
+{
+    JsonTapeBuilder b;
+    b.tape = tape;
+    b.depth = 0;
+    tape->size = 0;
+    tape->strings_len = 0;
+    JsonSaxStatus status = sax_parse(input, len, &tape_handler, &b, JSON_ENGINE_STRUCTURAL);
+    if (status != JSON_SAX_OK)
+        tape->size = tape->strings_len = 0;
+    return status;
+}
+
+void Json_tape_free(JsonTape *tape)
+{
+    free(tape->words);
+    free(tape->strings);
+    memset(tape, 0, sizeof(*tape));
+}
+
+size_t Json_tape_next(const JsonTape *tape, size_t i)
+{
+    switch (Json_tape_type(tape, i))
+    {
+    case JSON_TAPE_START_OBJECT:
+    case JSON_TAPE_START_ARRAY:
+        return (size_t)(tape->words[i] & JSON_TAPE_PAYLOAD_MASK);
+    case JSON_TAPE_INT:
+    case JSON_TAPE_UINT:
+    case JSON_TAPE_DOUBLE:
+        return i + 2;
+    default:
+        return i + 1;
+    }
+}
+
+const char *Json_tape_string(const JsonTape *tape, size_t i, size_t *len)
+{
+    const char *at = tape->strings + (tape->words[i] & JSON_TAPE_PAYLOAD_MASK);
+    uint64_t n;
+    memcpy(&n, at, sizeof(n));
+    if (len)
+        *len = (size_t)n;
+    return at + sizeof(n);
+}
+
+void Json_tape_number(const JsonTape *tape, size_t i, JsonNumber *out)
+{
+    uint64_t bits = tape->words[i + 1];
+    switch (Json_tape_type(tape, i))
+    {
+    case JSON_TAPE_INT:
+        out->number_kind = JSON_NUMBER_INT;
+        out->uinteger = bits;
+        out->number = (double)out->integer;
+        break;
+    case JSON_TAPE_UINT:
+        out->number_kind = JSON_NUMBER_UINT;
+        out->uinteger = bits;
+        out->number = (double)out->uinteger;
+        break;
+    default:
+        out->number_kind = JSON_NUMBER_DOUBLE;
+        memcpy(&out->number, &bits, sizeof(bits));
+        out->uinteger = 0;
+        break;
+    }
+}
+
+// --- JSON Lines ---
+// Workers claim batches of about CLIP_JSON_LINES_BATCH bytes, always cut after a newline, and
+// parse each line through the SAX parser into their own arena. Unordered, every record is
+// delivered as soon as it is parsed. Ordered, a worker keeps its batch's records until the
+// batches before it have been delivered, so at most one batch per thread is held at a time.
+typedef struct
+{
+    size_t offset;
+    JsonValue_ptr value;
+} JsonLine;
+
+CLIP_DEFINE_LIST_TYPE(JsonLine)
+
+typedef struct
+{
+    const char *buf;
+    size_t len;
+    bool ordered;
+    JsonLineCallback callback;
+    void *ud;
+    pthread_mutex_t lock;
+    pthread_cond_t turn_changed;
+    size_t next_start; // First byte not yet claimed by a worker
+    size_t next_batch; // Index of the next batch to claim
+    size_t turn;       // Index of the next batch to deliver (ordered)
+    size_t failed;     // Lines that were not valid JSON
+} JsonLinesJob;
+
+typedef struct
+{
+    JsonLinesJob *job;
+} JsonLinesTask;
+
+static bool is_blank(const char *p, const char *end)
+{
+    while (p < end && is_ws(*p))
+        p++;
+    return p == end;
+}
+
+// The builder is reused from line to line: what it allocates lives in the worker's arena,
+// so a failed line needs no cleanup
+static JsonValue *parse_line(const char *p, size_t len, JsonDomBuilder *b)
+{
+    b->root = NULL;
+    b->key = NULL;
+    b->open.size = 0;
+    JsonSaxStatus status = Json_sax_parse(p, len, &Json_dom_handler, b);
+    return status == JSON_SAX_OK ? b->root : NULL;
+}
+
+static void *lines_worker(void *arg)
+{
+    JsonLinesJob *job = ((JsonLinesTask *)arg)->job;
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 1 << 16);
+    JsonDomBuilder builder;
+    Json_dom_builder_init(&builder, &arena.allocator);
+    List(JsonLine) held = List_init(JsonLine, 64);
+    size_t failed = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&job->lock);
+        size_t start = job->next_start, batch = job->next_batch++;
+        size_t end = start;
+        if (start < job->len)
+        {
+            end = start + CLIP_JSON_LINES_BATCH < job->len ? start + CLIP_JSON_LINES_BATCH : job->len;
+            const char *nl = memchr(job->buf + end, '\n', job->len - end);
+            end = nl ? (size_t)(nl - job->buf) + 1 : job->len;
+        }
+        job->next_start = end;
+        pthread_mutex_unlock(&job->lock);
+        if (start == end)
+            break;
+
+        for (size_t line = start; line < end;)
+        {
+            const char *nl = memchr(job->buf + line, '\n', end - line);
+            size_t line_end = nl ? (size_t)(nl - job->buf) : end;
+            const char *text = job->buf + line;
+            if (!is_blank(text, job->buf + line_end))
+            {
+                JsonValue *v = parse_line(text, line_end - line, &builder);
+                failed += v == NULL;
+                if (job->ordered)
+                    List_append(JsonLine, &held, ((JsonLine){line, v}));
+                else
+                {
+                    job->callback(job->ud, line, v);
+                    clip_arena_reset(&arena);
+                }
+            }
+            line = line_end + 1;
+        }
+
+        if (job->ordered)
+        {
+            pthread_mutex_lock(&job->lock);
+            while (job->turn != batch)
+                pthread_cond_wait(&job->turn_changed, &job->lock);
+            pthread_mutex_unlock(&job->lock);
+            for (clip_size_t i = 0; i < held.size; i++)
+                job->callback(job->ud, held.data[i].offset, held.data[i].value);
+            held.size = 0;
+            clip_arena_reset(&arena);
+            pthread_mutex_lock(&job->lock);
+            job->turn++;
+            pthread_cond_broadcast(&job->turn_changed);
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+    List_free(JsonLine, &held);
+    builder.root = NULL;
+    builder.key = NULL;
+    builder.open.size = 0;
+    Json_dom_builder_finish(&builder);
+    clip_arena_destroy(&arena);
+    pthread_mutex_lock(&job->lock);
+    job->failed += failed;
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+size_t Json_parse_lines(const char *buf, size_t len, int nthreads, bool ordered, JsonLineCallback callback, void *ud)
+{
+    JsonLinesJob job;
+    job.buf = buf;
+    job.len = len;
+    job.ordered = ordered;
+    job.callback = callback;
+    job.ud = ud;
+    job.next_start = job.next_batch = job.turn = job.failed = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.turn_changed, NULL);
+
+    if (nthreads <= 0)
+        nthreads = clip_par_sort_default_threads();
+    if (nthreads > CLIP_PAR_SORT_MAX_THREADS)
+        nthreads = CLIP_PAR_SORT_MAX_THREADS;
+    size_t batches = len / CLIP_JSON_LINES_BATCH + 1;
+    if ((size_t)nthreads > batches)
+        nthreads = (int)batches; // No point in threads without a batch to take
+
+    JsonLinesTask tasks[CLIP_PAR_SORT_MAX_THREADS];
+    for (int i = 0; i < nthreads; i++)
+        tasks[i].job = &job;
+    clip_par_sort_run(lines_worker, tasks, sizeof(JsonLinesTask), nthreads);
+
+    pthread_cond_destroy(&job.turn_changed);
+    pthread_mutex_destroy(&job.lock);
+    return job.failed;
+}
+
+// --- Stringify ---
+// Doubles are printed with Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", 2010), as in RapidJSON: the digits always read back as the
+// same double, and are the shortest such digits for all but a tiny fraction of values.
+typedef struct
+{
+    uint64_t f;
+    int e;
+} DiyFp; // f * 2^e
+
+// 10^k for k = -348, -340, ..., 340, normalized to 64 bits and rounded
+static const uint64_t json_cached_pow10_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+static const int16_t json_cached_pow10_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066,
+};
+
+static const uint64_t json_pow10_u64[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL};
+
+static DiyFp diyfp_mul(DiyFp a, DiyFp b)
+{
+    uint64_t hi, lo;
+    mul_64x64(a.f, b.f, &hi, &lo);
+    DiyFp r = {hi + (lo >> 63), a.e + b.e + 64}; // Rounded
+    return r;
+}
+
+static DiyFp diyfp_normalize(DiyFp x)
+{
+    int lz = leading_zeros_64(x.f);
+    x.f <<= lz;
+    x.e -= lz;
+    return x;
+}
+
+// The value of a positive double and the neighbours halfway to the adjacent doubles
+static void diyfp_boundaries(double d, DiyFp *v, DiyFp *minus, DiyFp *plus)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    int biased = (int)(bits >> 52 & 0x7FF);
+    uint64_t significand = bits & ((1ULL << 52) - 1);
+    if (biased)
+    {
+        v->f = significand | 1ULL << 52;
+        v->e = biased - 1075;
+    }
+    else
+    {
+        v->f = significand;
+        v->e = -1074;
+    }
+    DiyFp pl = {(v->f << 1) + 1, v->e - 1};
+    pl = diyfp_normalize(pl);
+    // The gap below a power of two is half as wide
+    DiyFp mi = v->f == 1ULL << 52 ? (DiyFp){(v->f << 2) - 1, v->e - 2} : (DiyFp){(v->f << 1) - 1, v->e - 1};
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *plus = pl;
+    *minus = mi;
+    *v = diyfp_normalize(*v);
+}
+
+static void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int count_digits_32(uint32_t n)
+{
+    int digits = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Writes the digits of the shortest decimal in (minus, plus) that is closest to w
+static void grisu_digits(DiyFp w, DiyFp plus, uint64_t delta, char *buf, int *len, int *k)
+{
+    DiyFp one = {1ULL << -plus.e, plus.e};
+    uint64_t wp_w = plus.f - w.f;
+    uint32_t p1 = (uint32_t)(plus.f >> -one.e);
+    uint64_t p2 = plus.f & (one.f - 1);
+    int kappa = count_digits_32(p1);
+    *len = 0;
+    while (kappa > 0)
+    {
+        uint32_t pow = (uint32_t)json_pow10_u64[kappa - 1];
+        uint32_t d = p1 / pow;
+        p1 %= pow;
+        if (d || *len)
+            buf[(*len)++] = (char)('0' + d);
+        kappa--;
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta)
+        {
+            *k += kappa;
+            grisu_round(buf, *len, delta, rest, json_pow10_u64[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || *len)
+            buf[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta)
+        {
+            *k += kappa;
+            int index = -kappa;
+            grisu_round(buf, *len, delta, p2, one.f, wp_w * (index < 20 ? json_pow10_u64[index] : 0));
+            return;
+        }
+    }
+}
+
+// Digits of a positive finite double: value = buf[0..len) * 10^k
+static int grisu2(double d, char *buf, int *k)
+{
+    DiyFp v, minus, plus;
+    diyfp_boundaries(d, &v, &minus, &plus);
+    // Pick the cached power that brings plus.e into [-60, -32]
+    double dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    if (dk - ik > 0.0)
+        ik++;
+    unsigned index = (unsigned)((ik >> 3) + 1);
+    *k = -(-348 + (int)(index << 3));
+    DiyFp c = {json_cached_pow10_f[index], json_cached_pow10_e[index]};
+
+    DiyFp w = diyfp_mul(v, c);
+    DiyFp wp = diyfp_mul(plus, c);
+    DiyFp wm = diyfp_mul(minus, c);
+    wm.f++;
+    wp.f--;
+    int len;
+    grisu_digits(w, wp, wp.f - wm.f, buf, &len, k);
+    return len;
+}
+
+static const char json_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes `n` in decimal at `out` and returns the number of characters (at most 20)
+static int format_u64(char *out, uint64_t n)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    while (n >= 100)
+    {
+        unsigned pair = (unsigned)(n % 100) * 2;
+        n /= 100;
+        *--p = json_digit_pairs[pair + 1];
+        *--p = json_digit_pairs[pair];
+    }
+    if (n >= 10)
+    {
+        *--p = json_digit_pairs[n * 2 + 1];
+        *--p = json_digit_pairs[n * 2];
+    }
+    else
+        *--p = (char)('0' + n);
+    int len = (int)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, (size_t)len);
+    return len;
+}
+
+// Writes a double as JSON (at most 26 characters). Values that are whole keep a ".0" so they
+// read back as doubles; NaN and infinities, which JSON cannot express, become null.
+static int format_double(char *out, double d)
+{
+    if (d != d || d - d != 0)
+    {
+        memcpy(out, "null", 4);
+        return 4;
+    }
+    char *p = out;
+    if (signbit(d))
+    {
+        *p++ = '-';
+        d = -d;
+    }
+    if (d == 0)
+    {
+        memcpy(p, "0.0", 3);
+        return (int)(p - out) + 3;
+    }
+    char digits[20];
+    int k;
+    int len = grisu2(d, digits, &k);
+    int point = len + k; // Position of the decimal point relative to the digits
+    if (point >= len && point <= 21)
+    {
+        memcpy(p, digits, (size_t)len); // 1234e2 -> 123400.0
+        memset(p + len, '0', (size_t)(point - len));
+        p += point;
+        memcpy(p, ".0", 2);
+        p += 2;
+    }
+    else if (point > 0 && point <= 21)
+    {
+        memcpy(p, digits, (size_t)point); // 1234e-2 -> 12.34
+        p[point] = '.';
+        memcpy(p + point + 1, digits + point, (size_t)(len - point));
+        p += len + 1;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        memcpy(p, "0.", 2); // 1234e-7 -> 0.0001234
+        memset(p + 2, '0', (size_t)-point);
+        memcpy(p + 2 - point, digits, (size_t)len);
+        p += 2 - point + len;
+    }
+    else
+    {
+        *p++ = digits[0]; // 1234e30 -> 1.234e33
+        if (len > 1)
+        {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)(len - 1));
+            p += len - 1;
+        }
+        int exp = point - 1;
+        *p++ = 'e';
+        *p++ = exp < 0 ? '-' : '+';
+        p += format_u64(p, (uint64_t)(exp < 0 ? -exp : exp));
+    }
+    return (int)(p - out);
+}
+
+// First byte in [p, end) that must be escaped in a JSON string: '"', '\\' or a control character
+static string find_escape(string p, string end)
+{
+#ifdef CLIP_JSON_BLOCK
+    for (; end - p >= CLIP_JSON_BLOCK; p += CLIP_JSON_BLOCK)
+    {
+        json_block v = json_loadu(p);
+        uint32_t bits = json_mask(json_or(json_or(json_eq(v, '"'), json_eq(v, '\\')), json_ctrl(v)));
+        if (bits)
+            return p + __builtin_ctz(bits);
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20)
+        p++;
+    return p;
+}
+
+static bool write_string(CLIP_StrBuf *out, string str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    string end = str + len;
+    clip_strbuf_putc(out, '"');
+    while (str < end)
+    {
+        string stop = find_escape(str, end);
+        clip_strbuf_append(out, str, (size_t)(stop - str));
+        if (stop == end)
+            break;
+        char esc[6] = {'\\', 0};
+        size_t n = 2;
+        switch (*stop)
+        {
+        case '"': esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        default:
+            memcpy(esc + 1, "u00", 3);
+            esc[4] = hex[(unsigned char)*stop >> 4];
+            esc[5] = hex[*stop & 0xF];
+            n = 6;
+            break;
+        }
+        clip_strbuf_append(out, esc, n);
+        str = stop + 1;
+    }
+    return clip_strbuf_putc(out, '"');
+}
+
+// `bits` holds the exact integer of an INT or UINT, as in JsonValue
+static bool write_number(CLIP_StrBuf *out, JsonNumberKind kind, double number, uint64_t bits)
+{
+    char *dst = clip_strbuf_reserve(out, 32);
+    if (!dst)
+        return false;
+    int len;
+    if (kind == JSON_NUMBER_INT)
+    {
+        uint64_t magnitude = bits;
+        len = 0;
+        if ((int64_t)bits < 0)
+        {
+            dst[len++] = '-';
+            magnitude = 0 - magnitude;
+        }
+        len += format_u64(dst + len, magnitude);
+    }
+    else if (kind == JSON_NUMBER_UINT)
+        len = format_u64(dst, bits);
+    else
+        len = format_double(dst, number);
+    clip_strbuf_commit(out, (size_t)len);
+    return true;
+}
+
+typedef struct
+{
+    CLIP_StrBuf *out;
+    int flags;
+    int depth;
+} JsonWriter;
+
+static void write_newline(JsonWriter *w)
+{
+    if (!(w->flags & JSON_STRINGIFY_PRETTY))
+        return;
+    char *dst = clip_strbuf_reserve(w->out, 1 + (size_t)w->depth * 2);
+    if (!dst)
+        return;
+    dst[0] = '\n';
+    memset(dst + 1, ' ', (size_t)w->depth * 2);
+    clip_strbuf_commit(w->out, 1 + (size_t)w->depth * 2);
+}
+
+static void write_value(JsonWriter *w, const JsonValue *v)
+{
+    switch (v->type)
+    {
+    case JSON_NULL:
+        clip_strbuf_append(w->out, "null", 4);
+        break;
+    case JSON_BOOL:
+        if (v->boolean)
+            clip_strbuf_append(w->out, "true", 4);
+        else
+            clip_strbuf_append(w->out, "false", 5);
+        break;
+    case JSON_NUMBER:
+        write_number(w->out, v->number_kind, v->number, v->uinteger);
+        break;
+    case JSON_STRING:
+        write_string(w->out, v->str, v->str_len);
+        break;
+    case JSON_OBJECT:
+        clip_strbuf_putc(w->out, '{');
+        if (v->object.members.size)
+        {
+            w->depth++;
+            for (clip_size_t i = 0; i < v->object.members.size; i++)
+            {
+                const JsonMember *m = &v->object.members.data[i];
+                if (i)
+                    clip_strbuf_putc(w->out, ',');
+                write_newline(w);
+                write_string(w->out, m->key, m->key_len);
+                clip_strbuf_append(w->out, ": ", w->flags & JSON_STRINGIFY_PRETTY ? 2 : 1);
+                write_value(w, m->value);
+            }
+            w->depth--;
+            write_newline(w);
+        }
+        clip_strbuf_putc(w->out, '}');
+        break;
+    case JSON_LIST:
+        clip_strbuf_putc(w->out, '[');
+        if (v->list.size)
+        {
+            w->depth++;
+            for (clip_size_t i = 0; i < v->list.size; i++)
+            {
+                if (i)
+                    clip_strbuf_putc(w->out, ',');
+                write_newline(w);
+                write_value(w, v->list.data[i]);
+            }
+            w->depth--;
+            write_newline(w);
+        }
+        clip_strbuf_putc(w->out, ']');
+        break;
+    case JSON_NUMBER_ARRAY:
+        clip_strbuf_putc(w->out, '[');
+        if (v->numbers.size)
+        {
+            w->depth++;
+            for (size_t i = 0; i < v->numbers.size; i++)
+            {
+                if (i)
+                    clip_strbuf_putc(w->out, ',');
+                write_newline(w);
+                if (v->numbers.kind == JSON_PACKED_INT)
+                    write_number(w->out, JSON_NUMBER_INT, 0, (uint64_t)v->numbers.ints[i]);
+                else if (v->numbers.kind == JSON_PACKED_DOUBLE)
+                    write_number(w->out, JSON_NUMBER_DOUBLE, v->numbers.doubles[i], 0);
+                else if (v->numbers.bools[i])
+                    clip_strbuf_append(w->out, "true", 4);
+                else
+                    clip_strbuf_append(w->out, "false", 5);
+            }
+            w->depth--;
+            write_newline(w);
+        }
+        clip_strbuf_putc(w->out, ']');
+        break;
+    }
+}
+
+bool Json_stringify(const JsonValue *v, CLIP_StrBuf *out, int flags)
+{
+    JsonWriter w = {out, flags, 0};
+    write_value(&w, v);
+    return !out->failed;
+}
+
+char *Json_to_str(const JsonValue *v, int flags)
+{
+    CLIP_StrBuf out;
+    clip_strbuf_init(&out);
+    Json_stringify(v, &out, flags);
+    return clip_strbuf_detach(&out);
 }
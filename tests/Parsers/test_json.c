@@ -4,6 +4,7 @@
 #include <string.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 
 // ========== BASIC TYPE TESTS ==========
 
@@ -94,7 +95,7 @@ TEST(json_parse_empty_object) {
     JsonValue *v = Json_parse("{}");
     ASSERT_NOT_NULL(v);
     ASSERT_TRUE(v->type == JSON_OBJECT);
-    ASSERT_TRUE(Map_size(string, JsonValue_ptr, &v->object) == 0);
+    ASSERT_TRUE(v->object.members.size == 0);
     Json_free(v);
 }
 
@@ -102,14 +103,14 @@ TEST(json_parse_simple_object) {
     JsonValue *v = Json_parse("{\"a\": 1, \"b\": true}");
     ASSERT_NOT_NULL(v);
     ASSERT_TRUE(v->type == JSON_OBJECT);
-    ASSERT_TRUE(Map_size(string, JsonValue_ptr, &v->object) == 2);
+    ASSERT_TRUE(v->object.members.size == 2);
 
-    JsonValue *va = *Map_get(string, JsonValue_ptr, &v->object, "a");
+    JsonValue *va = Json_object_get(v, "a");
     ASSERT_NOT_NULL(va);
     ASSERT_TRUE(va->type == JSON_NUMBER);
     ASSERT_TRUE(fabs(va->number - 1.0) < 1e-9);
 
-    JsonValue *vb = *Map_get(string, JsonValue_ptr, &v->object, "b");
+    JsonValue *vb = Json_object_get(v, "b");
     ASSERT_NOT_NULL(vb);
     ASSERT_TRUE(vb->boolean == 1);
 
@@ -121,11 +122,11 @@ TEST(json_parse_nested_object) {
     ASSERT_NOT_NULL(v);
     ASSERT_TRUE(v->type == JSON_OBJECT);
 
-    JsonValue *inner_obj = *Map_get(string, JsonValue_ptr, &v->object, "outer");
+    JsonValue *inner_obj = Json_object_get(v, "outer");
     ASSERT_NOT_NULL(inner_obj);
     ASSERT_TRUE(inner_obj->type == JSON_OBJECT);
 
-    JsonValue *inner_list = *Map_get(string, JsonValue_ptr, &inner_obj->object, "inner");
+    JsonValue *inner_list = Json_object_get(inner_obj, "inner");
     ASSERT_NOT_NULL(inner_list);
     ASSERT_TRUE(inner_list->type == JSON_LIST);
     ASSERT_TRUE(inner_list->list.size == 2);
@@ -135,6 +136,70 @@ TEST(json_parse_nested_object) {
     Json_free(v);
 }
 
+TEST(json_object_keeps_input_order) {
+    JsonValue *v = Json_parse("{\"z\": 1, \"a\": 2, \"m\": 3}");
+    ASSERT_TRUE(v->object.members.size == 3);
+    ASSERT_STR_EQ(v->object.members.data[0].key, "z");
+    ASSERT_STR_EQ(v->object.members.data[1].key, "a");
+    ASSERT_STR_EQ(v->object.members.data[2].key, "m");
+    ASSERT_TRUE(v->object.members.data[2].value->integer == 3);
+    ASSERT_NULL(v->object.index);
+    ASSERT_NULL(Json_object_get(v, "q"));
+    ASSERT_NULL(Json_object_get(Json_object_get(v, "a"), "a")); // Not an object
+    Json_free(v);
+}
+
+TEST(json_object_repeated_key_last_wins) {
+    JsonValue *v = Json_parse("{\"k\": 1, \"other\": 2, \"k\": 3, \"a\\u0000b\": 4, \"a\": 5}");
+    ASSERT_TRUE(v->object.members.size == 5);
+    ASSERT_TRUE(Json_object_get(v, "k")->integer == 3);
+    ASSERT_TRUE(Json_object_get(v, "a")->integer == 5); // Not the key with an embedded NUL
+    ASSERT_TRUE(v->object.members.data[3].key_len == 3);
+    Json_free(v);
+}
+
+// Builds {"k0": 0, "k1": 1, ...} with every key of the first half repeated at the end
+static char *large_object(int n) {
+    char *doc = malloc((size_t)n * 48 + 16);
+    size_t pos = sprintf(doc, "{");
+    for (int i = 0; i < n; i++)
+        pos += sprintf(doc + pos, "%s\"k%d\": %d", i ? ", " : "", i, i);
+    for (int i = 0; i < n / 2; i++)
+        pos += sprintf(doc + pos, ", \"k%d\": %d", i, -i);
+    sprintf(doc + pos, "}");
+    return doc;
+}
+
+TEST(json_large_object_is_indexed) {
+    char *doc = large_object(1000);
+    JsonParser *p = Json_parser_new(NULL);
+    Json_parser_feed(p, doc, strlen(doc));
+    JsonValue *sax = Json_parser_finish(p, NULL);
+    JsonValue *v = Json_parse(doc);
+    JsonValue *both[] = {v, sax};
+    for (int d = 0; d < 2; d++)
+    {
+        JsonValue *o = both[d];
+        ASSERT_NOT_NULL(o);
+        ASSERT_TRUE(o->object.members.size == 1500);
+        ASSERT_NOT_NULL(o->object.index);
+        ASSERT_TRUE((size_t)o->object.index[0] * 3 >= (size_t)o->object.members.size * 4); // At most 3/4 full
+        char key[16];
+        for (int i = 0; i < 1000; i++)
+        {
+            snprintf(key, sizeof(key), "k%d", i);
+            JsonValue *x = Json_object_get(o, key);
+            ASSERT_NOT_NULL(x);
+            ASSERT_TRUE(x->integer == (i < 500 ? -i : i));
+        }
+        ASSERT_NULL(Json_object_get(o, "k1000"));
+        ASSERT_NULL(Json_object_get(o, ""));
+    }
+    Json_free(v);
+    Json_free(sax);
+    free(doc);
+}
+
 // ========== MIXED COMPLEX TESTS ==========
 
 TEST(json_parse_complex) {
@@ -145,17 +210,17 @@ TEST(json_parse_complex) {
     ASSERT_NOT_NULL(v);
     ASSERT_TRUE(v->type == JSON_OBJECT);
 
-    JsonValue *name = *Map_get(string, JsonValue_ptr, &v->object, "name");
+    JsonValue *name = Json_object_get(v, "name");
     ASSERT_NOT_NULL(name);
     ASSERT_TRUE(name->type == JSON_STRING);
     ASSERT_TRUE(strcmp(name->str, "Eduardo") == 0);
 
-    JsonValue *age = *Map_get(string, JsonValue_ptr, &v->object, "age");
+    JsonValue *age = Json_object_get(v, "age");
     ASSERT_NOT_NULL(age);
     ASSERT_TRUE(age->type == JSON_NUMBER);
     ASSERT_TRUE(fabs(age->number - 27.0) < 1e-9);
 
-    JsonValue *skills = *Map_get(string, JsonValue_ptr, &v->object, "skills");
+    JsonValue *skills = Json_object_get(v, "skills");
     ASSERT_NOT_NULL(skills);
     ASSERT_TRUE(skills->type == JSON_LIST);
     ASSERT_TRUE(skills->list.size == 3);
@@ -164,12 +229,12 @@ TEST(json_parse_complex) {
     ASSERT_TRUE(strcmp(skills->list.data[1]->str, "C++") == 0);
     ASSERT_TRUE(strcmp(skills->list.data[2]->str, "Python") == 0);
 
-    JsonValue *active = *Map_get(string, JsonValue_ptr, &v->object, "active");
+    JsonValue *active = Json_object_get(v, "active");
     ASSERT_NOT_NULL(active);
     ASSERT_TRUE(active->type == JSON_BOOL);
     ASSERT_TRUE(active->boolean == 1);
 
-    JsonValue *addr = *Map_get(string, JsonValue_ptr, &v->object, "address");
+    JsonValue *addr = Json_object_get(v, "address");
     ASSERT_NOT_NULL(addr);
     ASSERT_TRUE(addr->type == JSON_NULL);
 
@@ -177,6 +242,984 @@ TEST(json_parse_complex) {
 }
 
 
+// ========== ALLOCATOR TESTS ==========
+
+typedef struct {
+    long live_bytes;
+    int live_blocks;
+} JsonTracker;
+
+static void *tracking_alloc(void *ctx, size_t size) {
+    JsonTracker *t = ctx;
+    t->live_bytes += (long)size;
+    t->live_blocks++;
+    return malloc(size);
+}
+
+static void *tracking_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    JsonTracker *t = ctx;
+    if (!ptr)
+        return tracking_alloc(ctx, new_size);
+    t->live_bytes += (long)new_size - (long)old_size;
+    return realloc(ptr, new_size);
+}
+
+static void tracking_free(void *ctx, void *ptr, size_t size) {
+    JsonTracker *t = ctx;
+    t->live_bytes -= (long)size;
+    t->live_blocks--;
+    free(ptr);
+}
+
+static const char *allocator_doc =
+    "{\"name\": \"Alice\", \"tags\": [\"a\", \"b\", {\"deep\": [1, 2, 3]}], \"ok\": true, \"n\": null}";
+
+TEST(json_parse_with_allocator_releases_everything) {
+    JsonTracker t = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &t};
+    JsonValue *v = Json_parse_with_allocator(allocator_doc, &a);
+    ASSERT_NOT_NULL(v);
+    ASSERT_TRUE(v->type == JSON_OBJECT);
+    ASSERT_TRUE(v->object.members.allocator == &a);
+    JsonValue *tags = Json_object_get(v, "tags");
+    ASSERT_TRUE(tags->list.size == 3);
+    ASSERT_TRUE(t.live_blocks > 0);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+}
+
+TEST(json_object_allocations_are_released) {
+    JsonTracker t = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &t};
+    JsonValue *v = Json_parse_with_allocator("{}", &a);
+    ASSERT_TRUE(t.live_blocks == 1); // Just the value, no member storage
+    Json_free_with_allocator(v, &a);
+
+    char *doc = large_object(200);
+    v = Json_parse_with_allocator(doc, &a);
+    ASSERT_NOT_NULL(v->object.index);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+    free(doc);
+}
+
+TEST(json_scalars_are_stored_inline) {
+    JsonTracker t = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &t};
+    JsonValue *v = Json_parse_with_allocator("[1, 2.5, true, null, 4]", &a);
+    ASSERT_TRUE(t.live_blocks == 3); // The value, the element pointers and the elements
+    ASSERT_TRUE(v->list.data[4]->integer == 4);
+    ASSERT_TRUE(v->list.data[2]->boolean);
+    Json_free_with_allocator(v, &a);
+
+    v = Json_parse_with_allocator("{\"a\": 1, \"b\": [2], \"c\": {\"d\": 3}}", &a);
+    ASSERT_TRUE(t.live_blocks == 1 + 1 + 3 + 2 + 1 + 1); // Value, members, keys, list, object
+    ASSERT_TRUE(Json_object_get(Json_object_get(v, "c"), "d")->integer == 3);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(t.live_bytes == 0 && t.live_blocks == 0);
+
+    // Top-level literals are shared and allocate nothing
+    JsonValue *x = Json_parse_with_allocator(" true ", &a);
+    ASSERT_TRUE(x == Json_parse("true"));
+    ASSERT_TRUE(x->type == JSON_BOOL && x->boolean);
+    ASSERT_TRUE(Json_parse("null")->type == JSON_NULL);
+    ASSERT_TRUE(t.live_blocks == 0);
+    Json_free_with_allocator(x, &a);
+    ASSERT_TRUE(x->boolean);
+}
+
+TEST(json_deep_nesting_is_bounded) {
+    JsonTracker t = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &t};
+    // [{"k": [{"k": ... 1 ...}]}], CLIP_JSON_MAX_DEPTH levels
+    size_t depth = CLIP_JSON_MAX_DEPTH, n = 1;
+    char *doc = malloc(depth * 6 + 3);
+    doc[0] = '['; // Only used for the deeper document
+    for (size_t i = 0; i < depth; i++)
+    {
+        if (i % 2 == 0)
+            doc[n++] = '[';
+        else
+        {
+            memcpy(doc + n, "{\"k\":", 5);
+            n += 5;
+        }
+    }
+    doc[n++] = '1';
+    for (size_t i = depth; i-- > 0;)
+        doc[n++] = i % 2 == 0 ? ']' : '}';
+    doc[n] = '\0';
+
+    JsonValue *v = Json_parse_with_allocator(doc + 1, &a);
+    ASSERT_NOT_NULL(v);
+    size_t levels = 0;
+    for (JsonValue *x = v; x->type != JSON_NUMBER; levels++)
+        x = x->type == JSON_LIST ? x->list.data[0] : x->object.members.data[0].value;
+    ASSERT_TRUE(levels == depth);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(t.live_blocks == 0);
+
+    // One level more is rejected, and what was read of it released
+    doc[n++] = ']';
+    doc[n] = '\0';
+    ASSERT_NULL(Json_parse_with_allocator(doc, &a));
+    ASSERT_TRUE(t.live_bytes == 0 && t.live_blocks == 0);
+    Json_set_engine(JSON_ENGINE_STRUCTURAL);
+    ASSERT_NULL(Json_parse(doc));
+    Json_set_engine(JSON_ENGINE_RECURSIVE);
+    const char *whole = "";
+    JsonValue *out;
+    ASSERT_TRUE(Json_parse_select(doc, &whole, 1, &out) == 0);
+    ASSERT_NULL(out);
+    free(doc);
+}
+
+TEST(json_parse_on_arena) {
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 0);
+    JsonValue *v = Json_parse_with_allocator(allocator_doc, &arena.allocator);
+    ASSERT_NOT_NULL(v);
+    JsonValue *name = Json_object_get(v, "name");
+    ASSERT_TRUE(strcmp(name->str, "Alice") == 0);
+    clip_arena_destroy(&arena); // No Json_free needed: the whole document goes at once
+}
+
+TEST(json_parse_arena_reuses_blocks_after_free) {
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 256);
+    JsonValue *v = Json_parse_arena(allocator_doc, &arena);
+    ASSERT_NOT_NULL(v);
+    ASSERT_TRUE(v->object.members.allocator == &arena.allocator);
+    JsonValue *tags = Json_object_get(v, "tags");
+    ASSERT_TRUE(tags->list.size == 3);
+    CLIP_ArenaBlock *blocks = arena.blocks;
+    ASSERT_NOT_NULL(blocks);
+
+    Json_arena_free(&arena);
+    v = Json_parse_arena(allocator_doc, &arena);
+    ASSERT_TRUE(arena.blocks == blocks); // Same blocks, nothing new was requested
+    JsonValue *ok = Json_object_get(v, "ok");
+    ASSERT_TRUE(ok->type == JSON_BOOL && ok->boolean);
+    Json_arena_free(&arena);
+    clip_arena_destroy(&arena);
+}
+
+
+// ========== NUMBERS ==========
+
+TEST(json_parse_integers_exactly) {
+    JsonValue *v = Json_parse("[0, -7, 9007199254740993, 9223372036854775807, -9223372036854775808, "
+                              "18446744073709551615, 18446744073709551616, 1.0, -0]");
+    JsonValue **n = v->list.data;
+    ASSERT_TRUE(n[0]->number_kind == JSON_NUMBER_INT && n[0]->integer == 0);
+    ASSERT_TRUE(n[1]->number_kind == JSON_NUMBER_INT && n[1]->integer == -7 && n[1]->number == -7.0);
+    ASSERT_TRUE(n[2]->number_kind == JSON_NUMBER_INT && n[2]->integer == 9007199254740993LL);
+    ASSERT_TRUE(n[3]->number_kind == JSON_NUMBER_INT && n[3]->integer == INT64_MAX);
+    ASSERT_TRUE(n[4]->number_kind == JSON_NUMBER_INT && n[4]->integer == INT64_MIN);
+    ASSERT_TRUE(n[5]->number_kind == JSON_NUMBER_UINT && n[5]->uinteger == UINT64_MAX);
+    ASSERT_TRUE(n[6]->number_kind == JSON_NUMBER_DOUBLE && n[6]->number == 18446744073709551616.0);
+    ASSERT_TRUE(n[7]->number_kind == JSON_NUMBER_DOUBLE && n[7]->number == 1.0);
+    ASSERT_TRUE(n[8]->number_kind == JSON_NUMBER_DOUBLE && n[8]->number == 0.0 && signbit(n[8]->number));
+    Json_free(v);
+}
+
+// Every result must be the correctly rounded double, as the compiler reads the same literal
+TEST(json_parse_floats_round_correctly) {
+    static const struct { const char *text; double value; } cases[] = {
+        {"123.45", 123.45}, {"-0.1", -0.1}, {"1e23", 1e23}, {"5e-324", 5e-324},
+        {"2.2250738585072011e-308", 2.2250738585072011e-308}, {"1.7976931348623157e308", 1.7976931348623157e308},
+        {"7.3177701707893310e+15", 7.3177701707893310e+15}, {"9007199254740993.0", 9007199254740993.0},
+        {"0.30000000000000000000000000000001", 0.30000000000000000000000000000001},
+        {"3.141592653589793238462643383279", 3.141592653589793238462643383279}, {"1E-2", 1E-2}, {"1e+2", 1e+2},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        JsonValue *v = Json_parse(cases[i].text);
+        ASSERT_TRUE(v->number_kind == JSON_NUMBER_DOUBLE);
+        ASSERT_TRUE(v->number == cases[i].value);
+        Json_free(v);
+    }
+    JsonValue *v = Json_parse("[1e400, -1e400, 1e-400]");
+    ASSERT_TRUE(isinf(v->list.data[0]->number) && v->list.data[1]->number < 0);
+    ASSERT_TRUE(v->list.data[2]->number == 0.0);
+    Json_free(v);
+}
+
+TEST(json_get_integer_values) {
+    JsonValue *v = Json_parse("[42, -1, 18446744073709551615, 1e3, 2.5, \"7\"]");
+    JsonValue **n = v->list.data;
+    int64_t i;
+    uint64_t u;
+    ASSERT_TRUE(Json_get_int64(n[0], &i) && i == 42);
+    ASSERT_TRUE(Json_get_uint64(n[0], &u) && u == 42);
+    ASSERT_TRUE(Json_get_int64(n[1], &i) && i == -1);
+    ASSERT_FALSE(Json_get_uint64(n[1], &u));
+    ASSERT_FALSE(Json_get_int64(n[2], &i));
+    ASSERT_TRUE(Json_get_uint64(n[2], &u) && u == UINT64_MAX);
+    ASSERT_TRUE(Json_get_int64(n[3], &i) && i == 1000);
+    ASSERT_FALSE(Json_get_int64(n[4], &i));
+    ASSERT_FALSE(Json_get_int64(n[5], &i));
+    Json_free(v);
+}
+
+
+// ========== ESCAPES AND IN SITU ==========
+
+TEST(json_parse_decodes_escapes) {
+    JsonValue *v = Json_parse("[\"a\\\"b\\\\c\\/d\", \"tab\\there\\n\", \"\\u00e9\\u20ac\", \"\\ud83d\\ude00\"]");
+    ASSERT_STR_EQ(v->list.data[0]->str, "a\"b\\c/d");
+    ASSERT_TRUE(v->list.data[0]->str_len == 7);
+    ASSERT_STR_EQ(v->list.data[1]->str, "tab\there\n");
+    ASSERT_STR_EQ(v->list.data[2]->str, "\xc3\xa9\xe2\x82\xac");
+    ASSERT_STR_EQ(v->list.data[3]->str, "\xf0\x9f\x98\x80");
+    Json_free(v);
+}
+
+TEST(json_parse_insitu_points_into_input) {
+    char input[] = "{\"name\": \"Alice\", \"quote\": \"say \\\"hi\\\"\", \"nul\": \"a\\u0000b\"}";
+    char *end = input + sizeof(input);
+    JsonValue *v = Json_parse_insitu(input, NULL);
+    ASSERT_NOT_NULL(v);
+    ASSERT_TRUE(v->insitu);
+    JsonValue *name = Json_object_get(v, "name");
+    ASSERT_TRUE(name->str > input && name->str < end);
+    ASSERT_STR_EQ(name->str, "Alice");
+    ASSERT_TRUE(name->str_len == 5);
+    JsonValue *quote = Json_object_get(v, "quote");
+    ASSERT_STR_EQ(quote->str, "say \"hi\"");
+    JsonValue *nul = Json_object_get(v, "nul");
+    ASSERT_TRUE(nul->str_len == 3 && memcmp(nul->str, "a\0b", 3) == 0);
+    Json_free(v); // Leaves the borrowed strings and keys alone
+}
+
+TEST(json_parse_insitu_allocates_no_strings) {
+    JsonTracker copied = {0}, insitu = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &copied};
+    CLIP_Allocator b = {tracking_alloc, tracking_realloc, tracking_free, &insitu};
+    char buffer[256];
+    strcpy(buffer, allocator_doc);
+    JsonValue *v1 = Json_parse_with_allocator(allocator_doc, &a);
+    JsonValue *v2 = Json_parse_insitu(buffer, &b);
+    // name, tags, ok, n, deep (keys) + Alice, a, b (values): 8 strings fewer
+    ASSERT_TRUE(copied.live_blocks - insitu.live_blocks == 8);
+    JsonValue *tags = Json_object_get(v2, "tags");
+    ASSERT_STR_EQ(tags->list.data[1]->str, "b");
+    Json_free_with_allocator(v1, &a);
+    Json_free_with_allocator(v2, &b);
+    ASSERT_TRUE(copied.live_bytes == 0 && copied.live_blocks == 0);
+    ASSERT_TRUE(insitu.live_bytes == 0 && insitu.live_blocks == 0);
+}
+
+// ========== SCANNERS ==========
+
+// Whitespace runs and strings of every length around the scanners' block size (16/32 bytes)
+TEST(json_scanners_handle_every_length_and_alignment) {
+    char doc[512], expected[160];
+    for (int pad = 0; pad < 70; pad++) {
+        for (int len = 0; len < 100; len += 7) {
+            int pos = 0;
+            for (int i = 0; i < pad; i++)
+                doc[pos++] = " \t\n\r"[i % 4];
+            doc[pos++] = '[';
+            doc[pos++] = '"';
+            int e = 0;
+            for (int i = 0; i < len; i++) {
+                if (i % 23 == 22) { // an escape every so often
+                    doc[pos++] = '\\';
+                    doc[pos++] = 'n';
+                    expected[e++] = '\n';
+                } else {
+                    doc[pos++] = 'a' + i % 26;
+                    expected[e++] = 'a' + i % 26;
+                }
+            }
+            expected[e] = '\0';
+            doc[pos++] = '"';
+            for (int i = 0; i < pad; i++)
+                doc[pos++] = ' ';
+            doc[pos++] = ']';
+            doc[pos] = '\0';
+
+            JsonValue *v = Json_parse(doc);
+            ASSERT_TRUE(v->type == JSON_LIST && v->list.size == 1);
+            ASSERT_STR_EQ(v->list.data[0]->str, expected);
+            Json_free(v);
+        }
+    }
+}
+
+TEST(json_scanner_stops_at_unterminated_string) {
+    JsonValue *v = Json_parse("\"abcdefghijklmnopqrstuvwxyz0123456789\\");
+    ASSERT_TRUE(v->type == JSON_STRING);
+    ASSERT_TRUE(v->str_len == 37);
+    Json_free(v);
+}
+
+// ========== SAX ==========
+
+// Records every event as a compact trace, e.g. "[ 1 s:a ]"
+typedef struct {
+    char text[512];
+    size_t len;
+    int stop_after; // Stop the parse after this many events (0 = never)
+    int events;
+} SaxTrace;
+
+static bool trace(SaxTrace *t, const char *piece, size_t n) {
+    if (t->len)
+        t->text[t->len++] = ' ';
+    memcpy(t->text + t->len, piece, n);
+    t->len += n;
+    t->text[t->len] = '\0';
+    return !t->stop_after || ++t->events < t->stop_after;
+}
+
+static bool trace_null(void *ud) { return trace(ud, "null", 4); }
+static bool trace_bool(void *ud, bool b) { return trace(ud, b ? "true" : "false", b ? 4 : 5); }
+static bool trace_start_object(void *ud) { return trace(ud, "{", 1); }
+static bool trace_end_object(void *ud) { return trace(ud, "}", 1); }
+static bool trace_start_array(void *ud) { return trace(ud, "[", 1); }
+static bool trace_end_array(void *ud) { return trace(ud, "]", 1); }
+
+static bool trace_number(void *ud, const JsonNumber *n) {
+    char buf[32];
+    int len = n->number_kind == JSON_NUMBER_INT ? snprintf(buf, sizeof(buf), "i%lld", (long long)n->integer)
+                                                : snprintf(buf, sizeof(buf), "d%g", n->number);
+    return trace(ud, buf, (size_t)len);
+}
+
+static bool trace_string(void *ud, const char *str, size_t len) {
+    char buf[64] = "s:";
+    memcpy(buf + 2, str, len);
+    return trace(ud, buf, len + 2);
+}
+
+static bool trace_key(void *ud, const char *key, size_t len) {
+    char buf[64] = "k:";
+    memcpy(buf + 2, key, len);
+    return trace(ud, buf, len + 2);
+}
+
+static const JsonSaxHandler trace_handler = {
+    trace_null, trace_bool, trace_number, trace_string, trace_key,
+    trace_start_object, trace_end_object, trace_start_array, trace_end_array};
+
+static JsonSaxStatus sax_trace(const char *doc, SaxTrace *t) {
+    memset(t, 0, sizeof(*t));
+    return Json_sax_parse(doc, strlen(doc), &trace_handler, t);
+}
+
+TEST(json_sax_reports_events_in_order) {
+    SaxTrace t;
+    ASSERT_TRUE(sax_trace(" {\"a\": [1, -2.5, \"x\\ty\"], \"b\": {}, \"c\": [], \"d\": [true, false, null]} ", &t) == JSON_SAX_OK);
+    ASSERT_STR_EQ(t.text, "{ k:a [ i1 d-2.5 s:x\ty ] k:b { } k:c [ ] k:d [ true false null ] }");
+    ASSERT_TRUE(sax_trace("42", &t) == JSON_SAX_OK);
+    ASSERT_STR_EQ(t.text, "i42");
+}
+
+TEST(json_sax_respects_length) {
+    // The input does not need a terminator, and nothing past `len` is read
+    const char doc[] = "[\"abc\", 12]garbage";
+    SaxTrace t = {0};
+    ASSERT_TRUE(Json_sax_parse(doc, 11, &trace_handler, &t) == JSON_SAX_OK);
+    ASSERT_STR_EQ(t.text, "[ s:abc i12 ]");
+    memset(&t, 0, sizeof(t));
+    ASSERT_TRUE(Json_sax_parse("123456", 3, &trace_handler, &t) == JSON_SAX_OK);
+    ASSERT_STR_EQ(t.text, "i123");
+}
+
+TEST(json_sax_reports_errors) {
+    SaxTrace t;
+    const char *bad[] = {"", "[1, 2", "{\"a\" 1}", "{\"a\": 1,}", "[1 2]", "\"open", "tru", "[1]]", "{1: 2}", "+1"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        ASSERT_TRUE(sax_trace(bad[i], &t) == JSON_SAX_SYNTAX_ERROR);
+
+    char deep[CLIP_JSON_MAX_DEPTH + 2];
+    memset(deep, '[', sizeof(deep) - 1);
+    deep[sizeof(deep) - 1] = '\0';
+    ASSERT_TRUE(Json_sax_parse(deep, sizeof(deep) - 1, &(JsonSaxHandler){0}, NULL) == JSON_SAX_TOO_DEEP);
+}
+
+TEST(json_sax_stops_when_asked) {
+    SaxTrace t = {0};
+    t.stop_after = 3;
+    const char *doc = "[1, 2, 3, 4]";
+    ASSERT_TRUE(Json_sax_parse(doc, strlen(doc), &trace_handler, &t) == JSON_SAX_STOPPED);
+    ASSERT_STR_EQ(t.text, "[ i1 i2");
+}
+
+// Aggregating one field needs no tree at all
+static bool sum_number(void *ud, const JsonNumber *n) {
+    *(double *)ud += n->number;
+    return true;
+}
+
+TEST(json_sax_aggregates_large_documents) {
+    size_t cap = 40 * 20000, len = 0;
+    char *doc = malloc(cap);
+    len += snprintf(doc + len, cap - len, "[");
+    for (int i = 0; i < 20000; i++)
+        len += snprintf(doc + len, cap - len, "%s{\"id\": \"r\\u0031\", \"v\": %d}", i ? "," : "", i);
+    len += snprintf(doc + len, cap - len, "]");
+    double sum = 0;
+    JsonSaxHandler h = {0};
+    h.on_number = sum_number;
+    ASSERT_TRUE(Json_sax_parse(doc, len, &h, &sum) == JSON_SAX_OK);
+    ASSERT_TRUE(sum == 20000.0 * 19999.0 / 2);
+    free(doc);
+}
+
+TEST(json_dom_builder_matches_json_parse) {
+    const char *doc = "{\"name\": \"Al\\u00e9\", \"n\": [1, 2.5, 18446744073709551615], \"ok\": true, \"nil\": null, \"o\": {\"x\": []}}";
+    JsonTracker tracker = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &tracker};
+    JsonDomBuilder b;
+    Json_dom_builder_init(&b, &a);
+    ASSERT_TRUE(Json_sax_parse(doc, strlen(doc), &Json_dom_handler, &b) == JSON_SAX_OK);
+    JsonValue *v = Json_dom_builder_finish(&b);
+    JsonValue *expected = Json_parse(doc);
+    ASSERT_TRUE(v->type == JSON_OBJECT && v->object.members.size == expected->object.members.size);
+    ASSERT_STR_EQ(Json_object_get(v, "name")->str, "Al\xc3\xa9");
+    JsonValue *n = Json_object_get(v, "n");
+    ASSERT_TRUE(n->list.size == 3 && n->list.data[1]->number == 2.5);
+    ASSERT_TRUE(n->list.data[2]->number_kind == JSON_NUMBER_UINT && n->list.data[2]->uinteger == UINT64_MAX);
+    ASSERT_TRUE(Json_object_get(v, "ok")->boolean);
+    ASSERT_TRUE(Json_object_get(v, "nil")->type == JSON_NULL);
+    JsonValue *o = Json_object_get(v, "o");
+    ASSERT_TRUE(Json_object_get(o, "x")->type == JSON_LIST);
+    Json_free(expected);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(tracker.live_bytes == 0 && tracker.live_blocks == 0);
+
+    // A truncated document leaves nothing behind
+    Json_dom_builder_init(&b, &a);
+    ASSERT_TRUE(Json_sax_parse(doc, 40, &Json_dom_handler, &b) == JSON_SAX_SYNTAX_ERROR);
+    ASSERT_NULL(Json_dom_builder_finish(&b));
+    ASSERT_TRUE(tracker.live_bytes == 0 && tracker.live_blocks == 0);
+}
+
+// ========== INCREMENTAL ==========
+
+static const char *chunked_doc =
+    "{\"id\": 12345678901234, \"name\": \"sp\\\"lit\\u00e9\", \"vals\": [1.5e3, -0.25, true, false, null], \"o\": {}}";
+
+// Every way of cutting the document in two, and one byte at a time, gives the events of a single pass
+TEST(json_parser_matches_sax_at_every_split) {
+    SaxTrace whole, fed;
+    ASSERT_TRUE(sax_trace(chunked_doc, &whole) == JSON_SAX_OK);
+    size_t len = strlen(chunked_doc);
+    for (size_t cut = 0; cut <= len; cut++) {
+        memset(&fed, 0, sizeof(fed));
+        JsonParser *p = Json_parser_new_sax(&trace_handler, &fed);
+        ASSERT_TRUE(Json_parser_feed(p, chunked_doc, cut) == JSON_SAX_OK);
+        ASSERT_TRUE(Json_parser_feed(p, chunked_doc + cut, len - cut) == JSON_SAX_OK);
+        JsonSaxStatus status;
+        ASSERT_NULL(Json_parser_finish(p, &status));
+        ASSERT_TRUE(status == JSON_SAX_OK);
+        ASSERT_STR_EQ(fed.text, whole.text);
+    }
+
+    memset(&fed, 0, sizeof(fed));
+    JsonParser *p = Json_parser_new_sax(&trace_handler, &fed);
+    for (size_t i = 0; i < len; i++) {
+        char byte = chunked_doc[i]; // Each chunk is gone once fed
+        ASSERT_TRUE(Json_parser_feed(p, &byte, 1) == JSON_SAX_OK);
+    }
+    JsonSaxStatus status;
+    Json_parser_finish(p, &status);
+    ASSERT_TRUE(status == JSON_SAX_OK);
+    ASSERT_STR_EQ(fed.text, whole.text);
+}
+
+TEST(json_parser_builds_document_from_chunks) {
+    JsonTracker tracker = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &tracker};
+    JsonParser *p = Json_parser_new(&a);
+    size_t len = strlen(chunked_doc);
+    for (size_t i = 0; i < len; i += 7)
+        ASSERT_TRUE(Json_parser_feed(p, chunked_doc + i, len - i < 7 ? len - i : 7) == JSON_SAX_OK);
+    JsonValue *v = Json_parser_finish(p, NULL);
+    ASSERT_NOT_NULL(v);
+    JsonValue *id = Json_object_get(v, "id");
+    ASSERT_TRUE(id->number_kind == JSON_NUMBER_INT && id->integer == 12345678901234LL);
+    ASSERT_STR_EQ(Json_object_get(v, "name")->str, "sp\"lit\xc3\xa9");
+    JsonValue *vals = Json_object_get(v, "vals");
+    ASSERT_TRUE(vals->list.size == 5 && vals->list.data[0]->number == 1500.0);
+    Json_free_with_allocator(v, &a);
+    ASSERT_TRUE(tracker.live_bytes == 0 && tracker.live_blocks == 0);
+}
+
+TEST(json_parser_reports_errors) {
+    JsonSaxStatus status;
+    JsonParser *p = Json_parser_new(NULL);
+    ASSERT_TRUE(Json_parser_feed(p, "[1, 2", 5) == JSON_SAX_OK);
+    ASSERT_NULL(Json_parser_finish(p, &status)); // Truncated
+    ASSERT_TRUE(status == JSON_SAX_SYNTAX_ERROR);
+
+    p = Json_parser_new(NULL);
+    ASSERT_TRUE(Json_parser_feed(p, "[tr", 3) == JSON_SAX_OK);
+    ASSERT_TRUE(Json_parser_feed(p, "ux]", 3) == JSON_SAX_SYNTAX_ERROR);
+    ASSERT_TRUE(Json_parser_feed(p, "]", 1) == JSON_SAX_SYNTAX_ERROR); // Sticky
+    ASSERT_NULL(Json_parser_finish(p, &status));
+    ASSERT_TRUE(status == JSON_SAX_SYNTAX_ERROR);
+
+    p = Json_parser_new(NULL);
+    ASSERT_TRUE(Json_parser_feed(p, "  ", 2) == JSON_SAX_OK);
+    ASSERT_NULL(Json_parser_finish(p, &status)); // Nothing but whitespace
+    ASSERT_TRUE(status == JSON_SAX_SYNTAX_ERROR);
+
+    p = Json_parser_new(NULL);
+    ASSERT_TRUE(Json_parser_feed(p, "12", 2) == JSON_SAX_OK);
+    ASSERT_TRUE(Json_parser_feed(p, "34", 2) == JSON_SAX_OK);
+    JsonValue *v = Json_parser_finish(p, &status); // A number ended by the end of input
+    ASSERT_TRUE(status == JSON_SAX_OK && v->integer == 1234);
+    Json_free(v);
+}
+
+// ========== JSON LINES ==========
+
+// Several batches' worth of records, with a blank and a malformed line in the middle
+static char *make_lines(int n, size_t *len) {
+    size_t cap = (size_t)n * 64 + 64;
+    char *buf = malloc(cap);
+    size_t pos = 0;
+    for (int i = 0; i < n; i++) {
+        pos += snprintf(buf + pos, cap - pos, "{\"id\": %d, \"tag\": \"t\\u0041\"}\n", i);
+        if (i == n / 2)
+            pos += snprintf(buf + pos, cap - pos, "   \r\n{\"broken\": \n");
+    }
+    *len = pos;
+    return buf;
+}
+
+typedef struct {
+    long records;
+    long id_sum;
+    size_t last_offset;
+    bool in_order;
+    const char *buf;
+} LinesSeen;
+
+static void collect_line(void *ud, size_t offset, JsonValue *v) {
+    LinesSeen *seen = ud;
+    if (seen->records && offset <= seen->last_offset)
+        seen->in_order = false;
+    seen->last_offset = offset;
+    seen->records++;
+    if (!v) {
+        ASSERT_TRUE(strncmp(seen->buf + offset, "{\"broken\"", 9) == 0);
+        return;
+    }
+    JsonValue *tag = Json_object_get(v, "tag");
+    ASSERT_STR_EQ(tag->str, "tA");
+    seen->id_sum += Json_object_get(v, "id")->integer;
+}
+
+TEST(json_parse_lines_in_order) {
+    size_t len;
+    int n = 40000;
+    char *buf = make_lines(n, &len);
+    ASSERT_TRUE(len > 3 * CLIP_JSON_LINES_BATCH);
+    for (int threads = 1; threads <= 4; threads += 3) {
+        LinesSeen seen = {0, 0, 0, true, buf};
+        ASSERT_TRUE(Json_parse_lines(buf, len, threads, true, collect_line, &seen) == 1);
+        ASSERT_TRUE(seen.in_order);
+        ASSERT_TRUE(seen.records == n + 1);
+        ASSERT_TRUE(seen.id_sum == (long)n * (n - 1) / 2);
+    }
+    free(buf);
+}
+
+static void count_line(void *ud, size_t offset, JsonValue *v) {
+    (void)offset;
+    atomic_fetch_add((atomic_long *)ud, v ? Json_object_get(v, "id")->integer : 0);
+}
+
+TEST(json_parse_lines_unordered) {
+    size_t len;
+    int n = 40000;
+    char *buf = make_lines(n, &len);
+    atomic_long sum = 0;
+    ASSERT_TRUE(Json_parse_lines(buf, len, 4, false, count_line, &sum) == 1);
+    ASSERT_TRUE(atomic_load(&sum) == (long)n * (n - 1) / 2);
+
+    // A last line without its newline still counts
+    sum = 0;
+    ASSERT_TRUE(Json_parse_lines("{\"id\": 1}\n{\"id\": 2}", 19, 0, false, count_line, &sum) == 0);
+    ASSERT_TRUE(atomic_load(&sum) == 3);
+    free(buf);
+}
+
+// ========== STRINGIFY ==========
+
+TEST(json_stringify_compact_round_trips) {
+    const char *doc = "{\"a\":[1,-2,18446744073709551615,-9223372036854775808],\"b\":{\"c\":null,\"d\":true,\"e\":false},"
+                      "\"f\":[],\"g\":{},\"h\":\"text\"}";
+    JsonValue *v = Json_parse(doc);
+    char *s = Json_to_str(v, JSON_STRINGIFY_COMPACT);
+    ASSERT_STR_EQ(s, doc);
+    free(s);
+    Json_free(v);
+}
+
+TEST(json_stringify_pretty) {
+    JsonValue *v = Json_parse("{\"a\": [1, {\"b\": []}], \"c\": {}}");
+    char *s = Json_to_str(v, JSON_STRINGIFY_PRETTY);
+    ASSERT_STR_EQ(s, "{\n  \"a\": [\n    1,\n    {\n      \"b\": []\n    }\n  ],\n  \"c\": {}\n}");
+    free(s);
+    Json_free(v);
+}
+
+TEST(json_stringify_escapes_strings) {
+    JsonValue *v = Json_parse("[\"q\\\"b\\\\s/\\b\\f\\n\\r\\t\\u0001\\u001f\\u0000\\u00e9\\ud83d\\ude00\"]");
+    char *s = Json_to_str(v, 0);
+    ASSERT_STR_EQ(s, "[\"q\\\"b\\\\s/\\b\\f\\n\\r\\t\\u0001\\u001f\\u0000\xc3\xa9\xf0\x9f\x98\x80\"]");
+    free(s);
+    Json_free(v);
+
+    // Escapes at every position around the SIMD block size
+    char text[80], doc[96];
+    for (int at = 0; at < 70; at++) {
+        memset(text, 'x', sizeof(text));
+        text[at] = '"';
+        text[75] = '\0';
+        JsonValue str = {0};
+        str.type = JSON_STRING;
+        str.str = text;
+        str.str_len = strlen(text);
+        s = Json_to_str(&str, 0);
+        snprintf(doc, sizeof(doc), "\"%.*s\\\"%s\"", at, text, text + at + 1);
+        ASSERT_STR_EQ(s, doc);
+        free(s);
+    }
+}
+
+TEST(json_stringify_numbers_read_back_exactly) {
+    JsonValue *v = Json_parse("[0.1, 2.5e-8, 1e21, 100.0, -0.0, 5e-324, 1.7976931348623157e308, 123456.789, 3]");
+    char *s = Json_to_str(v, 0);
+    ASSERT_STR_EQ(s, "[0.1,2.5e-8,1e+21,100.0,-0.0,5e-324,1.7976931348623157e+308,123456.789,3]");
+    JsonValue *back = Json_parse(s);
+    for (clip_size_t i = 0; i < v->list.size; i++) {
+        ASSERT_TRUE(memcmp(&back->list.data[i]->number, &v->list.data[i]->number, sizeof(double)) == 0);
+        ASSERT_TRUE(back->list.data[i]->number_kind == v->list.data[i]->number_kind);
+    }
+    free(s);
+    Json_free(back);
+
+    v->list.data[0]->number = NAN;
+    v->list.data[1]->number = INFINITY;
+    s = Json_to_str(v, 0);
+    ASSERT_TRUE(strncmp(s, "[null,null,", 11) == 0);
+    free(s);
+    Json_free(v);
+}
+
+// ========== STRUCTURAL ENGINE ==========
+
+static JsonSaxStatus sax_trace_with(JsonEngine engine, const char *doc, SaxTrace *t) {
+    Json_set_engine(engine);
+    JsonSaxStatus status = sax_trace(doc, t);
+    Json_set_engine(JSON_ENGINE_RECURSIVE);
+    return status;
+}
+
+TEST(json_structural_engine_matches_sax) {
+    const char *docs[] = {
+        " {\"a\": [1, -2.5, \"x\\ty\"], \"b\": {}, \"c\": [], \"d\": [true, false, null]} ", "42", " \"s\" ",
+        "", "[1, 2", "{\"a\" 1}", "{\"a\": 1,}", "[1 2]", "\"open", "tru", "[1]]", "{1: 2}", "+1",
+        "[1x]", "[\"a\"b]", "[12\"a\"]", "[\\\"a\"]", "{\"a\": 1} x", "[\x01 1]", "[1,\x01]", "[nul]", "[\"\\\\\"]",
+        "[\"a\\\"\", \"b\"]", "{\"k\":\"v\",\"k\":[{}]}", "[\"\xc3\xa9\", \"\\u00e9\"]"};
+    for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        SaxTrace a, b;
+        ASSERT_TRUE(sax_trace_with(JSON_ENGINE_RECURSIVE, docs[i], &a) == sax_trace_with(JSON_ENGINE_STRUCTURAL, docs[i], &b));
+        ASSERT_STR_EQ(a.text, b.text);
+    }
+
+    // Runs of backslashes ending at every position around the 64-byte blocks: an odd run
+    // escapes the quote after it and leaves the string open
+    char doc[200];
+    for (int pad = 0; pad < 70; pad++) {
+        for (int run = 1; run < 70; run++) {
+            size_t len = 0;
+            doc[len++] = '[';
+            doc[len++] = '"';
+            memset(doc + len, 'x', (size_t)pad);
+            len += (size_t)pad;
+            memset(doc + len, '\\', (size_t)run);
+            len += (size_t)run;
+            memcpy(doc + len, "\", 1]", 5);
+            len += 5;
+            Json_set_engine(JSON_ENGINE_STRUCTURAL);
+            JsonSaxStatus status = Json_sax_parse(doc, len, &(JsonSaxHandler){0}, NULL);
+            Json_set_engine(JSON_ENGINE_RECURSIVE);
+            ASSERT_TRUE(status == (run % 2 ? JSON_SAX_SYNTAX_ERROR : JSON_SAX_OK));
+        }
+    }
+}
+
+TEST(json_structural_parse_matches_recursive) {
+    const char *docs[] = {allocator_doc, "[1, 2.5, -0.0, 18446744073709551615, \"a\\u0000b\", {\"x\": {\"y\": []}}]",
+                          "  7  ", "[1, 2] trailing text the recursive parser ignores"};
+    for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        JsonValue *expected = Json_parse(docs[i]);
+        Json_set_engine(JSON_ENGINE_STRUCTURAL);
+        ASSERT_TRUE(Json_get_engine() == JSON_ENGINE_STRUCTURAL);
+        JsonValue *v = Json_parse(docs[i]);
+        Json_set_engine(JSON_ENGINE_RECURSIVE);
+        char *a = Json_to_str(expected, 0), *b = Json_to_str(v, 0);
+        ASSERT_STR_EQ(a, b);
+        free(a);
+        free(b);
+        Json_free(expected);
+        Json_free(v);
+    }
+}
+
+TEST(json_tape_walks_document) {
+    const char *doc = "{\"a\": [1, -2, 18446744073709551615, 2.5], \"b\\u0000c\": \"x\\ny\", \"t\": true, "
+                      "\"f\": false, \"n\": null, \"o\": {}}";
+    JsonTape tape = {0};
+    for (int round = 0; round < 2; round++) { // The second parse reuses the buffers
+        ASSERT_TRUE(Json_tape_parse(doc, strlen(doc), &tape) == JSON_SAX_OK);
+        ASSERT_TRUE(Json_tape_type(&tape, 0) == JSON_TAPE_START_OBJECT);
+        ASSERT_TRUE(Json_tape_next(&tape, 0) == tape.size);
+        ASSERT_TRUE(Json_tape_type(&tape, tape.size - 1) == JSON_TAPE_END_OBJECT);
+
+        size_t len, i = 1;
+        ASSERT_STR_EQ(Json_tape_string(&tape, i, &len), "a");
+        i++;
+        ASSERT_TRUE(Json_tape_type(&tape, i) == JSON_TAPE_START_ARRAY);
+        size_t after = Json_tape_next(&tape, i);
+        ASSERT_TRUE(Json_tape_type(&tape, after - 1) == JSON_TAPE_END_ARRAY);
+        JsonNumber n;
+        const JsonTapeType kinds[] = {JSON_TAPE_INT, JSON_TAPE_INT, JSON_TAPE_UINT, JSON_TAPE_DOUBLE};
+        i++;
+        for (int k = 0; k < 4; k++, i = Json_tape_next(&tape, i))
+            ASSERT_TRUE(Json_tape_type(&tape, i) == kinds[k]);
+        Json_tape_number(&tape, after - 7, &n);
+        ASSERT_TRUE(n.number_kind == JSON_NUMBER_INT && n.integer == -2);
+        Json_tape_number(&tape, after - 5, &n);
+        ASSERT_TRUE(n.number_kind == JSON_NUMBER_UINT && n.uinteger == UINT64_MAX);
+        Json_tape_number(&tape, after - 3, &n);
+        ASSERT_TRUE(n.number_kind == JSON_NUMBER_DOUBLE && n.number == 2.5);
+
+        i = after; // Past the END_ARRAY
+        const char *key = Json_tape_string(&tape, i, &len);
+        ASSERT_TRUE(len == 3 && memcmp(key, "b\0c", 4) == 0);
+        ASSERT_STR_EQ(Json_tape_string(&tape, i + 1, &len), "x\ny");
+        ASSERT_TRUE(Json_tape_type(&tape, i + 3) == JSON_TAPE_TRUE);
+        ASSERT_TRUE(Json_tape_type(&tape, i + 5) == JSON_TAPE_FALSE);
+        ASSERT_TRUE(Json_tape_type(&tape, i + 7) == JSON_TAPE_NULL);
+        ASSERT_TRUE(Json_tape_type(&tape, i + 9) == JSON_TAPE_START_OBJECT);
+        ASSERT_TRUE(Json_tape_next(&tape, i + 9) == i + 11);
+    }
+    ASSERT_TRUE(Json_tape_parse("[1, 2", 5, &tape) == JSON_SAX_SYNTAX_ERROR);
+    ASSERT_TRUE(tape.size == 0);
+    Json_tape_free(&tape);
+}
+
+// ========== SELECTIVE PARSING AND PATHS ==========
+
+TEST(json_select_parses_requested_paths) {
+    const char *doc = "{\"id\": 7, \"skip\": {\"s\": \"}]\\\"[{\", \"deep\": [[[{\"x\": [1, {}]}]]]}, "
+                      "\"user\": {\"name\": \"ann\", \"tags\": [\"a\", {\"t\": \"b\"}, 3]}, \"n\": 1.5, "
+                      "\"k\\u0065y\": true, \"list\": [10, [20, 21], 30]}";
+    const char *paths[] = {"id", "user.name", "user.tags[1].t", "list[1][0]", "key", "user", "missing",
+                           "user.tags[9]", "id.x", "list[", "n", ""};
+    JsonValue *out[12];
+    ASSERT_TRUE(Json_parse_select(doc, paths, 12, out) == 8);
+    ASSERT_TRUE(out[0]->type == JSON_NUMBER && out[0]->integer == 7);
+    ASSERT_STR_EQ(out[1]->str, "ann");
+    ASSERT_STR_EQ(out[2]->str, "b");
+    ASSERT_TRUE(out[3]->type == JSON_NUMBER && out[3]->integer == 20);
+    ASSERT_TRUE(out[4]->type == JSON_BOOL && out[4]->boolean); // Found through its decoded key
+    char *user = Json_to_str(out[5], 0);
+    ASSERT_STR_EQ(user, "{\"name\":\"ann\",\"tags\":[\"a\",{\"t\":\"b\"},3]}");
+    free(user);
+    ASSERT_NULL(out[6]);
+    ASSERT_NULL(out[7]);
+    ASSERT_NULL(out[8]);
+    ASSERT_NULL(out[9]);
+    ASSERT_TRUE(out[10]->number == 1.5);
+    JsonValue *whole = Json_parse(doc);
+    char *a = Json_to_str(out[11], 0), *b = Json_to_str(whole, 0);
+    ASSERT_STR_EQ(a, b);
+    free(a);
+    free(b);
+    Json_free(whole);
+    for (int i = 0; i < 12; i++)
+        Json_free(out[i]);
+}
+
+TEST(json_select_skips_to_later_members) {
+    // Strings, escapes and brackets in skipped values must not throw off the skipping
+    char doc[4096];
+    int len = sprintf(doc, "{");
+    for (int i = 0; i < 40; i++)
+        len += sprintf(doc + len, "\"f%d\": [\"\\\\\", \"]\\\"}\", {\"a\": [[], {}]}, -1e5, null], ", i);
+    sprintf(doc + len, "\"last\": {\"v\": [0, 1, 2]}, \"dup\": 1, \"dup\": 2}");
+    const char *paths[] = {"last.v[2]", "dup", "dup", "f39[1]"};
+    JsonValue *out[4];
+    ASSERT_TRUE(Json_parse_select(doc, paths, 4, out) == 4);
+    ASSERT_TRUE(out[0]->integer == 2);
+    ASSERT_TRUE(out[1]->integer == 2 && out[2]->integer == 2); // Last occurrence, parsed for each
+    ASSERT_STR_EQ(out[3]->str, "]\"}");
+    for (int i = 0; i < 4; i++)
+        Json_free(out[i]);
+    ASSERT_TRUE(Json_parse_select(doc, paths, 0, out) == 0);
+}
+
+TEST(json_select_repeated_keys_match_the_dom) {
+    const char *docs[] = {"{\"a\": {\"b\": 1, \"c\": 0}, \"a\": {\"c\": 2}, \"a\": {\"b\": 3, \"b\": 4}}",
+                          "{\"a\": {\"b\": 1}, \"a\": 5, \"c\": [1, 2]}",
+                          "[{\"a\": 1, \"a\": [7, 8]}, {\"a\": 2}]"};
+    const char *paths[] = {"a.b", "a.c", "a", "[0].a[1]", "c[1]"};
+    size_t npaths = sizeof(paths) / sizeof(paths[0]);
+    for (size_t d = 0; d < sizeof(docs) / sizeof(docs[0]); d++)
+    {
+        JsonValue *whole = Json_parse(docs[d]);
+        JsonValue *out[5];
+        size_t expected = 0;
+        Json_parse_select(docs[d], paths, npaths, out);
+        for (size_t i = 0; i < npaths; i++)
+        {
+            JsonPath *path = Json_path_compile(paths[i]);
+            JsonValue *v = Json_path_eval(path, whole);
+            expected += v != NULL;
+            char *a = v ? Json_to_str(v, 0) : NULL, *b = out[i] ? Json_to_str(out[i], 0) : NULL;
+            ASSERT_TRUE((a == NULL) == (b == NULL));
+            if (a)
+                ASSERT_STR_EQ(a, b);
+            free(a);
+            free(b);
+            Json_path_free(path);
+            Json_free(out[i]);
+        }
+        ASSERT_TRUE(Json_parse_select(docs[d], paths, npaths, out) == expected);
+        for (size_t i = 0; i < npaths; i++)
+            Json_free(out[i]);
+        Json_free(whole);
+    }
+}
+
+TEST(json_path_eval_follows_steps) {
+    JsonValue *doc = Json_parse("{\"a\": {\"b\": [0, 1, 2, {\"c\": \"hit\"}]}, \"x\": 1, \"x\": 2, \"\": {\"e\": null}}");
+    JsonPath *path = Json_path_compile("a.b[3].c");
+    ASSERT_NOT_NULL(path);
+    for (int i = 0; i < 2; i++)
+        ASSERT_STR_EQ(Json_path_eval(path, doc)->str, "hit");
+    Json_path_free(path);
+
+    const char *misses[] = {"a.b[4]", "a.b.c", "a[0]", "nope", "x.y"};
+    for (size_t i = 0; i < sizeof(misses) / sizeof(misses[0]); i++) {
+        path = Json_path_compile(misses[i]);
+        ASSERT_NULL(Json_path_eval(path, doc));
+        Json_path_free(path);
+    }
+    path = Json_path_compile("x"); // Repeated key: the last one wins, as with Json_object_get
+    ASSERT_TRUE(Json_path_eval(path, doc)->integer == 2);
+    Json_path_free(path);
+    path = Json_path_compile(".e");
+    ASSERT_TRUE(Json_path_eval(path, doc)->type == JSON_NULL);
+    Json_path_free(path);
+    path = Json_path_compile("");
+    ASSERT_TRUE(Json_path_eval(path, doc) == doc);
+    Json_path_free(path);
+
+    ASSERT_NULL(Json_path_compile("a["));
+    ASSERT_NULL(Json_path_compile("a[x]"));
+    ASSERT_NULL(Json_path_compile("a[1]b"));
+    Json_free(doc);
+}
+
+TEST(json_path_eval_across_documents) {
+    // Large objects are indexed, and the remembered slot goes stale as the key order changes
+    JsonPath *path = Json_path_compile("rec.k7");
+    for (int round = 0; round < 6; round++) {
+        char text[2048];
+        int len = sprintf(text, "{\"rec\": {");
+        int members = 10 + round * 8;
+        for (int i = 0; i < members; i++)
+            len += sprintf(text + len, "%s\"k%d\": %d", i ? ", " : "", (i * 11 + round) % members, i);
+        sprintf(text + len, "}}");
+        JsonValue *doc = Json_parse(text);
+        JsonValue *rec = Json_object_get(doc, "rec");
+        for (int i = 0; i < 2; i++)
+            ASSERT_TRUE(Json_path_eval(path, doc) == Json_object_get(rec, "k7"));
+        ASSERT_NOT_NULL(Json_object_get(rec, "k7"));
+        Json_free(doc);
+    }
+    Json_path_free(path);
+}
+
+// ========== PACKED ARRAYS ==========
+
+TEST(json_parse_packed_arrays) {
+    JsonValue *v = Json_parse_packed("{\"i\": [1, -2, 9223372036854775807], \"d\": [1.5, -2e3, 0.1], "
+                                     "\"b\": [true, false], \"e\": [], \"m\": [1, 2.5], \"s\": [1, \"x\"], "
+                                     "\"bn\": [true, 1], \"u\": [18446744073709551615], \"g\": [[1, 2], [3.5]]}", NULL);
+    JsonValue *i = Json_object_get(v, "i"), *d = Json_object_get(v, "d"), *b = Json_object_get(v, "b");
+    ASSERT_TRUE(i->type == JSON_NUMBER_ARRAY && i->numbers.kind == JSON_PACKED_INT && i->numbers.size == 3);
+    ASSERT_TRUE(i->numbers.ints[1] == -2 && i->numbers.ints[2] == INT64_MAX);
+    ASSERT_TRUE(d->type == JSON_NUMBER_ARRAY && d->numbers.kind == JSON_PACKED_DOUBLE);
+    ASSERT_TRUE(d->numbers.doubles[1] == -2000.0 && d->numbers.doubles[2] == 0.1);
+    ASSERT_TRUE(b->type == JSON_NUMBER_ARRAY && b->numbers.kind == JSON_PACKED_BOOL);
+    ASSERT_TRUE(b->numbers.bools[0] && !b->numbers.bools[1]);
+
+    // Empty, mixed and out of int64 range arrays stay lists, with every element exact
+    const char *lists[] = {"e", "m", "s", "bn", "u"};
+    for (int k = 0; k < 5; k++)
+        ASSERT_TRUE(Json_object_get(v, lists[k])->type == JSON_LIST);
+    JsonValue *m = Json_object_get(v, "m");
+    ASSERT_TRUE(m->list.data[0]->number_kind == JSON_NUMBER_INT && m->list.data[0]->integer == 1);
+    ASSERT_TRUE(m->list.data[1]->number_kind == JSON_NUMBER_DOUBLE && m->list.data[1]->number == 2.5);
+    ASSERT_TRUE(Json_object_get(v, "bn")->list.data[0]->boolean);
+    JsonValue *g = Json_object_get(v, "g");
+    ASSERT_TRUE(g->type == JSON_LIST && g->list.data[0]->type == JSON_NUMBER_ARRAY);
+
+    // Both representations read the same through the accessors
+    JsonNumber n;
+    bool flag;
+    ASSERT_TRUE(Json_array_size(i) == 3 && Json_array_size(m) == 2 && Json_array_size(v) == 0);
+    ASSERT_TRUE(Json_array_number(i, 2, &n) && n.number_kind == JSON_NUMBER_INT && n.integer == INT64_MAX);
+    ASSERT_TRUE(Json_array_number(d, 0, &n) && n.number_kind == JSON_NUMBER_DOUBLE && n.number == 1.5);
+    ASSERT_TRUE(Json_array_number(m, 1, &n) && n.number == 2.5);
+    ASSERT_FALSE(Json_array_number(i, 3, &n));
+    ASSERT_FALSE(Json_array_number(b, 0, &n));
+    ASSERT_TRUE(Json_array_bool(b, 1, &flag) && !flag);
+    ASSERT_TRUE(Json_array_bool(Json_object_get(v, "bn"), 0, &flag) && flag);
+    ASSERT_FALSE(Json_array_bool(i, 0, &flag));
+    Json_free(v);
+}
+
+TEST(json_packed_arrays_stringify_like_lists) {
+    const char *doc = "[[1, -2, 3], [0.5, 1e300, -0.0], [true, false, true], [], [1, 2.0], "
+                      "{\"k\": [[7], [8.25]]}, [9223372036854775807, -9223372036854775808]]";
+    JsonValue *lists = Json_parse(doc);
+    JsonValue *packed = Json_parse_packed(doc, NULL);
+    for (int flags = JSON_STRINGIFY_COMPACT; flags <= JSON_STRINGIFY_PRETTY; flags++) {
+        char *a = Json_to_str(lists, flags), *b = Json_to_str(packed, flags);
+        ASSERT_STR_EQ(a, b);
+        free(a);
+        free(b);
+    }
+    Json_free(lists);
+    Json_free(packed);
+
+    JsonTracker t = {0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, &t};
+    char big[4096];
+    int len = sprintf(big, "[");
+    for (int k = 0; k < 500; k++)
+        len += sprintf(big + len, "%s%d", k ? "," : "", k);
+    sprintf(big + len, "]");
+    packed = Json_parse_packed(big, &a);
+    ASSERT_TRUE(packed->numbers.size == 500 && packed->numbers.ints[499] == 499);
+    ASSERT_TRUE(t.live_blocks == 2); // The value and its buffer
+    Json_free_with_allocator(packed, &a);
+    ASSERT_TRUE(t.live_bytes == 0 && t.live_blocks == 0);
+}
 
 // ========== TEST SUITE DEFINITION ==========
 
@@ -194,6 +1237,59 @@ TEST_SUITE(
     RUN_TEST(json_parse_empty_object),
     RUN_TEST(json_parse_simple_object),
     RUN_TEST(json_parse_nested_object),
+    RUN_TEST(json_object_keeps_input_order),
+    RUN_TEST(json_object_repeated_key_last_wins),
+    RUN_TEST(json_large_object_is_indexed),
+
+    RUN_TEST(json_parse_complex),
+
+    RUN_TEST(json_parse_with_allocator_releases_everything),
+    RUN_TEST(json_object_allocations_are_released),
+    RUN_TEST(json_scalars_are_stored_inline),
+    RUN_TEST(json_deep_nesting_is_bounded),
+    RUN_TEST(json_parse_on_arena),
+    RUN_TEST(json_parse_arena_reuses_blocks_after_free),
+
+    RUN_TEST(json_parse_integers_exactly),
+    RUN_TEST(json_parse_floats_round_correctly),
+    RUN_TEST(json_get_integer_values),
+
+    RUN_TEST(json_parse_decodes_escapes),
+    RUN_TEST(json_parse_insitu_points_into_input),
+    RUN_TEST(json_parse_insitu_allocates_no_strings),
+
+    RUN_TEST(json_scanners_handle_every_length_and_alignment),
+    RUN_TEST(json_scanner_stops_at_unterminated_string),
+
+    RUN_TEST(json_sax_reports_events_in_order),
+    RUN_TEST(json_sax_respects_length),
+    RUN_TEST(json_sax_reports_errors),
+    RUN_TEST(json_sax_stops_when_asked),
+    RUN_TEST(json_sax_aggregates_large_documents),
+    RUN_TEST(json_dom_builder_matches_json_parse),
+
+    RUN_TEST(json_parser_matches_sax_at_every_split),
+    RUN_TEST(json_parser_builds_document_from_chunks),
+    RUN_TEST(json_parser_reports_errors),
+
+    RUN_TEST(json_parse_lines_in_order),
+    RUN_TEST(json_parse_lines_unordered),
+
+    RUN_TEST(json_stringify_compact_round_trips),
+    RUN_TEST(json_stringify_pretty),
+    RUN_TEST(json_stringify_escapes_strings),
+    RUN_TEST(json_stringify_numbers_read_back_exactly),
+
+    RUN_TEST(json_structural_engine_matches_sax),
+    RUN_TEST(json_structural_parse_matches_recursive),
+    RUN_TEST(json_tape_walks_document),
+
+    RUN_TEST(json_select_parses_requested_paths),
+    RUN_TEST(json_select_skips_to_later_members),
+    RUN_TEST(json_select_repeated_keys_match_the_dom),
+    RUN_TEST(json_path_eval_follows_steps),
+    RUN_TEST(json_path_eval_across_documents),
 
-    RUN_TEST(json_parse_complex)
+    RUN_TEST(json_parse_packed_arrays),
+    RUN_TEST(json_packed_arrays_stringify_like_lists)
 )
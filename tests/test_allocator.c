@@ -0,0 +1,319 @@
+#include "CLIP/Test.h"
+#include "CLIP/Allocator.h"
+#include "CLIP/List.h"
+#include "CLIP/Stack.h"
+#include "CLIP/Queue.h"
+#include "CLIP/Map.h"
+#include "CLIP/Set.h"
+#include "CLIP/HashMap.h"
+#include "CLIP/SmallList.h"
+
+// Allocator that forwards to libc and keeps track of what is still alive.
+// The sizes reported on realloc/free must match what was requested, or the counters drift.
+typedef struct
+{
+    long live_bytes;
+    int live_blocks;
+    int allocs;
+    int frees;
+} Tracker;
+
+static void *tracking_alloc(void *ctx, size_t size)
+{
+    Tracker *t = ctx;
+    t->live_bytes += (long)size;
+    t->live_blocks++;
+    t->allocs++;
+    return malloc(size);
+}
+
+static void *tracking_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+    Tracker *t = ctx;
+    if (!ptr)
+        return tracking_alloc(ctx, new_size);
+    t->live_bytes += (long)new_size - (long)old_size;
+    return realloc(ptr, new_size);
+}
+
+static void tracking_free(void *ctx, void *ptr, size_t size)
+{
+    Tracker *t = ctx;
+    t->live_bytes -= (long)size;
+    t->live_blocks--;
+    t->frees++;
+    free(ptr);
+}
+
+static CLIP_Allocator tracking_allocator(Tracker *t)
+{
+    *t = (Tracker){0};
+    CLIP_Allocator a = {tracking_alloc, tracking_realloc, tracking_free, t};
+    return a;
+}
+
+int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+CLIP_DEFINE_LIST_TYPE(int)
+CLIP_DEFINE_STACK_TYPE(int)
+CLIP_DEFINE_QUEUE_TYPE(int)
+CLIP_DEFINE_MAP_TYPE(int, int, cmp_int);
+CLIP_DEFINE_SET_TYPE(int, cmp_int)
+CLIP_DEFINE_HASHMAP_TYPE(int, int, clip_hash_int, clip_eq_int);
+CLIP_DEFINE_SMALL_LIST_TYPE(int, 4)
+
+typedef int pooled_int;
+CLIP_DEFINE_MAP_TYPE_POOLED(pooled_int, int, cmp_int, NULL, NULL);
+
+// --- Arena ---
+TEST(arena_allocations_are_aligned_and_distinct)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 256);
+    char *a = clip_arena_alloc(&arena, 3);
+    char *b = clip_arena_alloc(&arena, 17);
+    ASSERT_TRUE((uintptr_t)a % CLIP_ARENA_ALIGNMENT == 0);
+    ASSERT_TRUE((uintptr_t)b % CLIP_ARENA_ALIGNMENT == 0);
+    ASSERT_TRUE(b >= a + 3);
+    memset(a, 'x', 3);
+    memset(b, 'y', 17);
+    ASSERT_TRUE(a[2] == 'x');
+    clip_arena_destroy(&arena);
+}
+
+TEST(arena_large_request_gets_own_block)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 64);
+    char *big = clip_arena_alloc(&arena, 1000);
+    memset(big, 1, 1000);
+    char *small = clip_arena_alloc(&arena, 8);
+    ASSERT_NOT_NULL(small);
+    ASSERT_TRUE(arena.blocks != NULL && arena.blocks->next != NULL);
+    clip_arena_destroy(&arena);
+    ASSERT_NULL(arena.blocks);
+}
+
+TEST(arena_realloc_grows_last_allocation_in_place)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 1024);
+    const CLIP_Allocator *a = &arena.allocator;
+    int *xs = clip_alloc(a, 4 * sizeof(int));
+    for (int i = 0; i < 4; i++)
+        xs[i] = i;
+    int *grown = clip_realloc(a, xs, 4 * sizeof(int), 64 * sizeof(int));
+    ASSERT_TRUE(grown == xs);
+
+    // Not the most recent block any more: contents are copied
+    clip_alloc(a, 16);
+    int *moved = clip_realloc(a, grown, 64 * sizeof(int), 128 * sizeof(int));
+    ASSERT_TRUE(moved != grown);
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(moved[i] == i);
+    clip_arena_destroy(&arena);
+}
+
+TEST(arena_free_pops_last_allocation)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 1024);
+    void *a = clip_alloc(&arena.allocator, 32);
+    clip_free(&arena.allocator, a, 32);
+    void *b = clip_alloc(&arena.allocator, 32);
+    ASSERT_TRUE(a == b);
+    clip_arena_destroy(&arena);
+}
+
+TEST(arena_reset_reuses_blocks)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 128);
+    void *first = clip_arena_alloc(&arena, 100);
+    clip_arena_alloc(&arena, 100);
+    CLIP_ArenaBlock *blocks = arena.blocks;
+    clip_arena_reset(&arena);
+    void *again = clip_arena_alloc(&arena, 100);
+    ASSERT_TRUE(again == first);
+    ASSERT_TRUE(arena.blocks == blocks);
+    clip_arena_destroy(&arena);
+}
+
+// --- Containers on a tracking allocator ---
+TEST(list_uses_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    List(int) xs = List_init_with_allocator(int, 2, &a);
+    for (int i = 0; i < 100; i++)
+        List_append(int, &xs, i);
+    List_shrink_to_fit(int, &xs);
+    ASSERT_TRUE(List_get(int, &xs, 99) == 99);
+    ASSERT_TRUE(t.live_bytes == (long)(xs.capacity * sizeof(int)));
+    List_free(int, &xs);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+    ASSERT_TRUE(t.allocs == 1);
+}
+
+TEST(list_sort_buffers_use_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    List(int) xs = List_init_with_allocator(int, 1000, &a);
+    for (int i = 0; i < 1000; i++)
+        List_append(int, &xs, (i * 7919) % 1000);
+    List_stable_sort(int, &xs, cmp_int);
+    ASSERT_TRUE(t.allocs > 1); // The merge buffer, besides the list
+    ASSERT_TRUE(t.live_blocks == 1);
+    int allocs = t.allocs;
+    for (int i = 0; i < 1000; i++)
+        xs.data[i] = 999 - i;
+    List_radix_sort(int, &xs, clip_radix_key_int);
+    ASSERT_TRUE(t.allocs == allocs + 1);
+    ASSERT_TRUE(t.live_blocks == 1);
+    ASSERT_TRUE(List_get(int, &xs, 0) == 0 && List_get(int, &xs, 999) == 999);
+    List_free(int, &xs);
+    ASSERT_TRUE(t.live_bytes == 0);
+}
+
+TEST(default_allocator_is_null)
+{
+    List(int) xs = List_init(int, 4);
+    ASSERT_NULL(xs.allocator);
+    List_free(int, &xs);
+    Map(int, int) m = Map_init(int, int);
+    ASSERT_NULL(m.allocator);
+}
+
+TEST(stack_and_copy_use_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    Stack(int) s = Stack_init_with_allocator(int, 1, &a);
+    for (int i = 0; i < 50; i++)
+        Stack_push(int, &s, i);
+    Stack(int) copy = Stack_copy(int, &s);
+    ASSERT_TRUE(copy.allocator == &a);
+    ASSERT_TRUE(t.live_blocks == 2);
+    Stack_free(int, &s);
+    Stack_free(int, &copy);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+}
+
+TEST(queue_uses_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    Queue(int) q = Queue_init_with_allocator(int, 8, &a);
+    Queue_enqueue(int, &q, 1);
+    ASSERT_TRUE(t.live_bytes == (long)(9 * sizeof(int)));
+    Queue_free(int, &q);
+    ASSERT_TRUE(t.live_bytes == 0);
+}
+
+TEST(map_and_set_nodes_use_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    Map(int, int) m = Map_init_with_allocator(int, int, &a);
+    Set(int) s = Set_init_with_allocator(int, &a);
+    for (int i = 0; i < 64; i++)
+    {
+        Map_insert(int, int, &m, i, i * i);
+        Set_insert(int, &s, i);
+    }
+    ASSERT_TRUE(t.live_blocks == 128);
+    Map_remove(int, int, &m, 10);
+    Set_remove(int, &s, 10);
+    ASSERT_TRUE(t.live_blocks == 126);
+    Map_free(int, int, &m);
+    Set_free(int, &s);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+}
+
+TEST(pooled_map_chunks_use_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    Map(pooled_int, int) m = Map_init_with_allocator(pooled_int, int, &a);
+    for (int i = 0; i < 1000; i++)
+        Map_insert(pooled_int, int, &m, i, i);
+    ASSERT_TRUE(m.pool->allocator == &a);
+    ASSERT_TRUE(t.live_blocks > 1 && t.live_blocks < 20); // pool object + a few chunks
+    Map_free(pooled_int, int, &m);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+}
+
+TEST(hashmap_uses_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    HashMap(int, int) m = HashMap_init_with_allocator(int, int, &a);
+    for (int i = 0; i < 1000; i++)
+        HashMap_insert(int, int, &m, i, i);
+    ASSERT_TRUE(t.live_blocks == 2);
+    ASSERT_TRUE(*HashMap_get(int, int, &m, 500) == 500);
+    HashMap_free(int, int, &m);
+    ASSERT_TRUE(t.live_bytes == 0);
+    ASSERT_TRUE(t.live_blocks == 0);
+}
+
+TEST(small_list_spills_to_allocator)
+{
+    Tracker t;
+    CLIP_Allocator a = tracking_allocator(&t);
+    SmallList(int) xs = SmallList_init_with_allocator(int, &a);
+    for (int i = 0; i < 4; i++)
+        SmallList_append(int, &xs, i);
+    ASSERT_TRUE(t.allocs == 0);
+    for (int i = 4; i < 40; i++)
+        SmallList_append(int, &xs, i);
+    ASSERT_TRUE(t.allocs == 1);
+    ASSERT_TRUE(SmallList_get(int, &xs, 39) == 39);
+    SmallList_free(int, &xs);
+    ASSERT_TRUE(t.live_bytes == 0);
+}
+
+TEST(request_scoped_containers_on_arena)
+{
+    CLIP_Arena arena;
+    clip_arena_init(&arena, 0);
+    for (int round = 0; round < 3; round++)
+    {
+        List(int) xs = List_init_with_allocator(int, 1, &arena.allocator);
+        Map(int, int) m = Map_init_with_allocator(int, int, &arena.allocator);
+        for (int i = 0; i < 500; i++)
+        {
+            List_append(int, &xs, i);
+            Map_insert(int, int, &m, i, -i);
+        }
+        ASSERT_TRUE(List_get(int, &xs, 499) == 499);
+        ASSERT_TRUE(*Map_get(int, int, &m, 250) == -250);
+        clip_arena_reset(&arena); // Drops both containers at once
+    }
+    clip_arena_destroy(&arena);
+}
+
+TEST_SUITE(
+    RUN_TEST(arena_allocations_are_aligned_and_distinct),
+    RUN_TEST(arena_large_request_gets_own_block),
+    RUN_TEST(arena_realloc_grows_last_allocation_in_place),
+    RUN_TEST(arena_free_pops_last_allocation),
+    RUN_TEST(arena_reset_reuses_blocks),
+    RUN_TEST(list_uses_allocator),
+    RUN_TEST(list_sort_buffers_use_allocator),
+    RUN_TEST(default_allocator_is_null),
+    RUN_TEST(stack_and_copy_use_allocator),
+    RUN_TEST(queue_uses_allocator),
+    RUN_TEST(map_and_set_nodes_use_allocator),
+    RUN_TEST(pooled_map_chunks_use_allocator),
+    RUN_TEST(hashmap_uses_allocator),
+    RUN_TEST(small_list_spills_to_allocator),
+    RUN_TEST(request_scoped_containers_on_arena))
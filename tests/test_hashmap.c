@@ -0,0 +1,223 @@
+#include "CLIP/Test.h"
+#include "CLIP/HashMap.h"
+#include <string.h>
+#include <stdlib.h>
+
+typedef const char *string;
+
+// key/val -> string
+void str_to_str(string s, char *buf, size_t n)
+{
+  snprintf(buf, n, "\"%s\"", s);
+}
+void int_to_str(int v, char *buf, size_t n)
+{
+  snprintf(buf, n, "%d", v);
+}
+
+// Deliberately poor hash: every key lands in the same probe sequence
+uint64_t collide_hash(const int *key)
+{
+  (void)key;
+  return 42;
+}
+
+// define maps
+CLIP_DEFINE_HASHMAP_TYPE(string, int, clip_hash_cstr, clip_eq_cstr);
+CLIP_REGISTER_HASHMAP_PRINT(string, int, str_to_str, int_to_str);
+
+CLIP_DEFINE_HASHMAP_TYPE(int, int, clip_hash_int, clip_eq_int);
+
+typedef int colliding_int;
+CLIP_DEFINE_HASHMAP_TYPE(colliding_int, int, collide_hash, clip_eq_int);
+
+// ========== BASIC FUNCTIONALITY TESTS ==========
+
+TEST(hashmap_init_empty)
+{
+  HashMap(string, int) m = HashMap_init(string, int);
+  ASSERT_TRUE(HashMap_size(string, int, &m) == 0);
+  ASSERT_TRUE(HashMap_empty(string, int, &m));
+  ASSERT_NULL(HashMap_get(string, int, &m, "missing"));
+  ASSERT_FALSE(HashMap_remove(string, int, &m, "missing"));
+  HashMap_free(string, int, &m);
+}
+
+TEST(hashmap_insert_and_get)
+{
+  HashMap(string, int) m = HashMap_init(string, int);
+  ASSERT_TRUE(HashMap_insert(string, int, &m, "Hello", 4));
+  ASSERT_TRUE(*HashMap_get(string, int, &m, "Hello") == 4);
+  ASSERT_TRUE(HashMap_contains(string, int, &m, "Hello"));
+  ASSERT_FALSE(HashMap_contains(string, int, &m, "World"));
+  HashMap_free(string, int, &m);
+}
+
+TEST(hashmap_overwrite)
+{
+  HashMap(string, int) m = HashMap_init(string, int);
+  ASSERT_TRUE(HashMap_insert(string, int, &m, "A", 1));
+  ASSERT_FALSE(HashMap_insert(string, int, &m, "A", 2));
+  ASSERT_TRUE(*HashMap_get(string, int, &m, "A") == 2);
+  ASSERT_TRUE(HashMap_size(string, int, &m) == 1); // size should not increase
+  HashMap_free(string, int, &m);
+}
+
+TEST(hashmap_remove)
+{
+  HashMap(string, int) m = HashMap_init(string, int);
+  HashMap_insert(string, int, &m, "A", 1);
+  HashMap_insert(string, int, &m, "B", 2);
+  HashMap_insert(string, int, &m, "C", 3);
+
+  ASSERT_TRUE(HashMap_remove(string, int, &m, "B"));
+  ASSERT_FALSE(HashMap_remove(string, int, &m, "B"));
+  ASSERT_TRUE(HashMap_size(string, int, &m) == 2);
+  ASSERT_TRUE(HashMap_contains(string, int, &m, "A"));
+  ASSERT_FALSE(HashMap_contains(string, int, &m, "B"));
+  ASSERT_TRUE(HashMap_contains(string, int, &m, "C"));
+
+  HashMap_free(string, int, &m);
+}
+
+TEST(hashmap_clear_and_reuse)
+{
+  HashMap(int, int) m = HashMap_init(int, int);
+  for (int i = 0; i < 100; i++)
+    HashMap_insert(int, int, &m, i, i);
+  int capacity = m.capacity;
+
+  HashMap_clear(int, int, &m);
+  ASSERT_TRUE(HashMap_empty(int, int, &m));
+  ASSERT_FALSE(HashMap_contains(int, int, &m, 5));
+
+  for (int i = 0; i < 100; i++)
+    HashMap_insert(int, int, &m, i, -i);
+  ASSERT_TRUE(m.capacity == capacity); // refill reuses the table
+  ASSERT_TRUE(*HashMap_get(int, int, &m, 99) == -99);
+
+  HashMap_free(int, int, &m);
+}
+
+// ========== STRESS AND EDGE CASE TESTS ==========
+
+TEST(hashmap_large)
+{
+  HashMap(int, int) m = HashMap_init(int, int);
+  for (int i = 0; i < 100000; i++)
+    ASSERT_TRUE(HashMap_insert(int, int, &m, i * 7, i));
+  ASSERT_TRUE(HashMap_size(int, int, &m) == 100000);
+  for (int i = 0; i < 100000; i++)
+  {
+    int *v = HashMap_get(int, int, &m, i * 7);
+    ASSERT_NOT_NULL(v);
+    ASSERT_TRUE(*v == i);
+  }
+  ASSERT_NULL(HashMap_get(int, int, &m, 3));
+  HashMap_free(int, int, &m);
+}
+
+TEST(hashmap_stress_insert_remove)
+{
+  HashMap(int, int) m = HashMap_init(int, int);
+  // Churn through many keys while keeping the live set small: exercises tombstones
+  for (int round = 0; round < 50; round++)
+  {
+    for (int i = 0; i < 1000; i++)
+      HashMap_insert(int, int, &m, round * 1000 + i, i);
+    for (int i = 0; i < 1000; i++)
+      if (i % 10 != 0)
+        ASSERT_TRUE(HashMap_remove(int, int, &m, round * 1000 + i));
+  }
+  ASSERT_TRUE(HashMap_size(int, int, &m) == 50 * 100);
+  ASSERT_TRUE(m.capacity <= 16384); // tombstones are recycled, not accumulated
+  for (int round = 0; round < 50; round++)
+  {
+    ASSERT_TRUE(HashMap_contains(int, int, &m, round * 1000));
+    ASSERT_FALSE(HashMap_contains(int, int, &m, round * 1000 + 1));
+  }
+  HashMap_free(int, int, &m);
+}
+
+TEST(hashmap_full_collisions)
+{
+  HashMap(colliding_int, int) m = HashMap_init(colliding_int, int);
+  for (int i = 0; i < 200; i++)
+    HashMap_insert(colliding_int, int, &m, i, i * 2);
+  for (int i = 0; i < 200; i += 2)
+    ASSERT_TRUE(HashMap_remove(colliding_int, int, &m, i));
+  for (int i = 0; i < 200; i++)
+  {
+    int *v = HashMap_get(colliding_int, int, &m, i);
+    if (i % 2)
+      ASSERT_TRUE(v && *v == i * 2);
+    else
+      ASSERT_NULL(v);
+  }
+  HashMap_free(colliding_int, int, &m);
+}
+
+TEST(hashmap_reserve)
+{
+  HashMap(int, int) m = HashMap_init(int, int);
+  ASSERT_TRUE(HashMap_reserve(int, int, &m, 1000));
+  int capacity = m.capacity;
+  for (int i = 0; i < 1000; i++)
+    HashMap_insert(int, int, &m, i, i);
+  ASSERT_TRUE(m.capacity == capacity); // no rehash after reserve
+  HashMap_free(int, int, &m);
+}
+
+// ========== ITERATION AND STRING TESTS ==========
+
+static void sum_entries(int *key, int *val, void *userdata)
+{
+  *(long *)userdata += *key + *val;
+}
+
+TEST(hashmap_foreach)
+{
+  HashMap(int, int) m = HashMap_init(int, int);
+  long expected = 0;
+  for (int i = 0; i < 500; i++)
+  {
+    HashMap_insert(int, int, &m, i, 2 * i);
+    expected += 3 * i;
+  }
+  long sum = 0;
+  HashMap_foreach(int, int, &m, sum_entries, &sum);
+  ASSERT_TRUE(sum == expected);
+  HashMap_free(int, int, &m);
+}
+
+TEST(hashmap_to_str)
+{
+  HashMap(string, int) m = HashMap_init(string, int);
+  char *empty = HashMap_to_str(string, int, &m);
+  ASSERT_STR_EQ(empty, "{}");
+  free(empty);
+
+  HashMap_insert(string, int, &m, "key", 7);
+  char *s = HashMap_to_str(string, int, &m);
+  ASSERT_STR_EQ(s, "{{\"key\" : 7}}");
+  free(s);
+  HashMap_free(string, int, &m);
+}
+
+TEST_SUITE(
+    // Basic operations
+    RUN_TEST(hashmap_init_empty),
+    RUN_TEST(hashmap_insert_and_get),
+    RUN_TEST(hashmap_overwrite),
+    RUN_TEST(hashmap_remove),
+    RUN_TEST(hashmap_clear_and_reuse),
+
+    // Stress tests
+    RUN_TEST(hashmap_large),
+    RUN_TEST(hashmap_stress_insert_remove),
+    RUN_TEST(hashmap_full_collisions),
+    RUN_TEST(hashmap_reserve),
+
+    // Iteration and string representation
+    RUN_TEST(hashmap_foreach),
+    RUN_TEST(hashmap_to_str))
@@ -5,6 +5,31 @@ CLIP_DEFINE_LIST_TYPE(int)
 
 CLIP_DEFINE_LIST_TYPE_WITH_FREE(List(int), List_free_fn(int))
 
+CLIP_DEFINE_LIST_SORT(int, asc, CLIP_SORT_ASC)
+CLIP_DEFINE_LIST_SORT(int, desc, CLIP_SORT_DESC)
+
+typedef struct
+{
+    int key;
+    int id;
+} Record;
+
+int compare_records(const Record *a, const Record *b)
+{
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+CLIP_DEFINE_LIST_TYPE(Record)
+CLIP_DEFINE_LIST_SORT(Record, by_key, compare_records)
+
+uint64_t record_radix_key(const Record *r)
+{
+    return clip_radix_key_from_i32(r->key);
+}
+
+CLIP_DEFINE_LIST_TYPE(double)
+CLIP_DEFINE_LIST_TYPE(uint64_t)
+
 
 // --- Test Cases ---
 TEST(init)
@@ -141,6 +166,254 @@ TEST(reverse_and_sort)
     List_free(int, &xs);
 }
 
+// Deterministic pseudo-random numbers for the sort tests
+static unsigned int sort_seed = 12345u;
+static int next_random(void)
+{
+    sort_seed = sort_seed * 1103515245u + 12345u;
+    return (int)((sort_seed >> 8) & 0xffff);
+}
+
+static bool is_sorted_int(List(int) *xs)
+{
+    for (int i = 1; i < xs->size; i++)
+        if (xs->data[i - 1] > xs->data[i])
+            return false;
+    return true;
+}
+
+TEST(sort_large_patterns)
+{
+    const int n = 20000;
+    List(int) xs = List_init(int, n);
+
+    // Random
+    for (int i = 0; i < n; i++)
+        List_append(int, &xs, next_random());
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+
+    // Already sorted and reversed
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+    List_reverse(int, &xs);
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+
+    // Few distinct values
+    for (int i = 0; i < n; i++)
+        xs.data[i] = next_random() % 4;
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+
+    // Organ pipe (ascending then descending) and sawtooth
+    for (int i = 0; i < n; i++)
+        xs.data[i] = i < n / 2 ? i : n - i;
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+    for (int i = 0; i < n; i++)
+        xs.data[i] = i % 97;
+    ASSERT_TRUE(List_sort(int, &xs, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&xs));
+
+    List_free(int, &xs);
+}
+
+TEST(sort_by_inline_comparison)
+{
+    List(int) xs = List_init(int, 1000);
+    long sum = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        int v = next_random() - 0x8000;
+        List_append(int, &xs, v);
+        sum += v;
+    }
+
+    ASSERT_TRUE(List_sort_by(int, desc, &xs));
+    for (int i = 1; i < xs.size; i++)
+        ASSERT_TRUE(xs.data[i - 1] >= xs.data[i]);
+
+    ASSERT_TRUE(List_sort_by(int, asc, &xs));
+    ASSERT_TRUE(is_sorted_int(&xs));
+
+    // Sorting is a permutation: nothing lost or duplicated
+    for (int i = 0; i < xs.size; i++)
+        sum -= xs.data[i];
+    ASSERT_TRUE(sum == 0);
+
+    List_free(int, &xs);
+}
+
+TEST(sort_structs)
+{
+    List(Record) rs = List_init(Record, 500);
+    for (int i = 0; i < 500; i++)
+        List_append(Record, &rs, ((Record){.key = next_random() % 50, .id = i}));
+
+    ASSERT_TRUE(List_sort_by(Record, by_key, &rs));
+    for (int i = 1; i < rs.size; i++)
+        ASSERT_TRUE(rs.data[i - 1].key <= rs.data[i].key);
+
+    for (int i = 0; i < rs.size; i++)
+        rs.data[i].key = -rs.data[i].key;
+    ASSERT_TRUE(List_sort(Record, &rs, compare_records));
+    for (int i = 1; i < rs.size; i++)
+        ASSERT_TRUE(rs.data[i - 1].key <= rs.data[i].key);
+
+    List_free(Record, &rs);
+}
+
+TEST(stable_sort_keeps_order_of_equal_elements)
+{
+    List(Record) rs = List_init(Record, 3000);
+    for (int i = 0; i < 3000; i++)
+        List_append(Record, &rs, ((Record){.key = next_random() % 20, .id = i}));
+
+    ASSERT_TRUE(List_stable_sort(Record, &rs, compare_records));
+    for (int i = 1; i < rs.size; i++)
+    {
+        ASSERT_TRUE(rs.data[i - 1].key <= rs.data[i].key);
+        if (rs.data[i - 1].key == rs.data[i].key)
+            ASSERT_TRUE(rs.data[i - 1].id < rs.data[i].id);
+    }
+
+    // Multi-key sort: by id descending within each key, chained through stability
+    for (int i = 0; i < rs.size; i++)
+        rs.data[i].id = next_random() % 1000;
+    List_sort_by(Record, by_key, &rs);
+    for (int i = 0; i < rs.size; i++)
+        rs.data[i].id = -rs.data[i].id;
+    ASSERT_TRUE(List_stable_sort(Record, &rs, compare_records));
+    for (int i = 0; i < rs.size; i++)
+    {
+        Record tmp = rs.data[i];
+        rs.data[i].key = tmp.id;
+        rs.data[i].id = tmp.key;
+    }
+    ASSERT_TRUE(List_stable_sort_by(Record, by_key, &rs)); // now ordered by (-id, key)
+    for (int i = 1; i < rs.size; i++)
+    {
+        ASSERT_TRUE(rs.data[i - 1].key <= rs.data[i].key);
+        if (rs.data[i - 1].key == rs.data[i].key)
+            ASSERT_TRUE(rs.data[i - 1].id <= rs.data[i].id);
+    }
+
+    List_free(Record, &rs);
+}
+
+TEST(stable_sort_runs)
+{
+    // Two sorted batches merged with List_merge, then a few out-of-place elements
+    List(int) a = List_init(int, 10000);
+    List(int) b = List_init(int, 10000);
+    for (int i = 0; i < 10000; i++)
+    {
+        List_append(int, &a, 2 * i);
+        List_append(int, &b, 3 * i + 1);
+    }
+    ASSERT_TRUE(List_merge(int, &a, &b));
+    for (int i = 0; i < 20; i++)
+        a.data[next_random() % a.size] = next_random();
+
+    ASSERT_TRUE(List_stable_sort(int, &a, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&a));
+
+    // Strictly descending input is a single reversed run
+    for (int i = 0; i < a.size; i++)
+        a.data[i] = a.size - i;
+    ASSERT_TRUE(List_stable_sort(int, &a, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&a));
+    ASSERT_TRUE(a.data[0] == 1);
+
+    // Random data and small inputs
+    for (int i = 0; i < a.size; i++)
+        a.data[i] = next_random();
+    ASSERT_TRUE(List_stable_sort(int, &a, compare_ints_ascending));
+    ASSERT_TRUE(is_sorted_int(&a));
+    ASSERT_TRUE(List_stable_sort(int, &b, NULL) == false);
+    b.size = 5;
+    ASSERT_TRUE(List_stable_sort_by(int, desc, &b));
+    ASSERT_TRUE(b.data[0] == 13 && b.data[4] == 1);
+
+    List_free(int, &a);
+    List_free(int, &b);
+}
+
+TEST(radix_sort_ints)
+{
+    List(int) xs = List_init(int, 5000);
+    for (int i = 0; i < 5000; i++)
+        List_append(int, &xs, (next_random() - 0x8000) * 30000 + i);
+    List_append(int, &xs, 2147483647);
+    List_append(int, &xs, -2147483647 - 1);
+
+    ASSERT_TRUE(List_radix_sort(int, &xs, clip_radix_key_int));
+    ASSERT_TRUE(is_sorted_int(&xs));
+    ASSERT_TRUE(xs.data[0] == -2147483647 - 1);
+    ASSERT_TRUE(xs.data[xs.size - 1] == 2147483647);
+
+    // Small inputs take the insertion path
+    int small[] = {5, -1, 3, 0, -7};
+    List(int) ys = List_init_from_array(int, small, 5);
+    ASSERT_TRUE(List_radix_sort(int, &ys, clip_radix_key_int));
+    ASSERT_TRUE(is_sorted_int(&ys));
+
+    List_free(int, &xs);
+    List_free(int, &ys);
+}
+
+TEST(radix_sort_doubles_and_uint64)
+{
+    List(double) ds = List_init(double, 1000);
+    for (int i = 0; i < 1000; i++)
+        List_append(double, &ds, (next_random() - 0x8000) / 7.0);
+    List_append(double, &ds, -0.0);
+    List_append(double, &ds, 1e300);
+    List_append(double, &ds, -1e300);
+
+    ASSERT_TRUE(List_radix_sort(double, &ds, clip_radix_key_double));
+    for (int i = 1; i < ds.size; i++)
+        ASSERT_TRUE(ds.data[i - 1] <= ds.data[i]);
+    ASSERT_TRUE(ds.data[0] == -1e300);
+    ASSERT_TRUE(ds.data[ds.size - 1] == 1e300);
+
+    List(uint64_t) us = List_init(uint64_t, 1000);
+    for (int i = 0; i < 1000; i++)
+        List_append(uint64_t, &us, ((uint64_t)next_random() << 48) | (uint64_t)next_random());
+    ASSERT_TRUE(List_radix_sort(uint64_t, &us, clip_radix_key_uint64));
+    for (int i = 1; i < us.size; i++)
+        ASSERT_TRUE(us.data[i - 1] <= us.data[i]);
+
+    List_free(double, &ds);
+    List_free(uint64_t, &us);
+}
+
+TEST(radix_sort_structs_stable)
+{
+    CLIP_RadixScratch scratch = CLIP_RADIX_SCRATCH_INIT;
+    List(Record) rs = List_init(Record, 2000);
+    for (int round = 0; round < 3; round++)
+    {
+        List_clear(Record, &rs);
+        for (int i = 0; i < 2000; i++)
+            List_append(Record, &rs, ((Record){.key = next_random() % 100 - 50, .id = i}));
+
+        ASSERT_TRUE(List_radix_sort_scratch(Record, &rs, record_radix_key, &scratch));
+        for (int i = 1; i < rs.size; i++)
+        {
+            ASSERT_TRUE(rs.data[i - 1].key <= rs.data[i].key);
+            // Equal keys keep their insertion order
+            if (rs.data[i - 1].key == rs.data[i].key)
+                ASSERT_TRUE(rs.data[i - 1].id < rs.data[i].id);
+        }
+    }
+    ASSERT_TRUE(scratch.capacity >= 2000 * sizeof(Record));
+
+    clip_radix_scratch_free(&scratch);
+    List_free(Record, &rs);
+}
+
 TEST(pop)
 {
     List(int) xs = List_init(int, 2);
@@ -238,6 +511,14 @@ TEST_SUITE(
     RUN_TEST(insert_and_remove),
     RUN_TEST(clear_and_reserve),
     RUN_TEST(reverse_and_sort),
+    RUN_TEST(sort_large_patterns),
+    RUN_TEST(sort_by_inline_comparison),
+    RUN_TEST(sort_structs),
+    RUN_TEST(stable_sort_keeps_order_of_equal_elements),
+    RUN_TEST(stable_sort_runs),
+    RUN_TEST(radix_sort_ints),
+    RUN_TEST(radix_sort_doubles_and_uint64),
+    RUN_TEST(radix_sort_structs_stable),
     RUN_TEST(pop),
     RUN_TEST(merge),
     RUN_TEST(foreach_macro),
@@ -37,6 +37,9 @@ CLIP_REGISTER_MAP_PRINT(int, string, int_to_str, str_to_str);
 CLIP_DEFINE_MAP_TYPE(int, int, cmp_int);
 CLIP_REGISTER_MAP_PRINT(int, int, int_to_str, int_to_str);
 
+typedef int pooled_int;
+CLIP_DEFINE_MAP_TYPE_POOLED(pooled_int, int, cmp_int, NULL, NULL);
+
 // ========== BASIC FUNCTIONALITY TESTS ==========
 
 TEST(map_init_empty)
@@ -584,6 +587,7 @@ TEST(map_foreach_empty)
 
   CollectCtx ctx;
   ctx.count = 0;
+  ctx.capacity = 10;
   ctx.keys = malloc(10 * sizeof(char *));
   ctx.values = malloc(10 * sizeof(int));
 
@@ -603,6 +607,7 @@ TEST(map_foreach_single)
 
   CollectCtx ctx;
   ctx.count = 0;
+  ctx.capacity = 10;
   ctx.keys = malloc(10 * sizeof(char *));
   ctx.values = malloc(10 * sizeof(int));
 
@@ -688,6 +693,50 @@ TEST(map_foreach_large)
   Map_free(string, int, &m);
 }
 
+// ========== POOLED NODE TESTS ==========
+
+TEST(map_pooled_insert_get_remove)
+{
+  Map(pooled_int, int) m = Map_init(pooled_int, int);
+  for (int i = 0; i < 5000; i++)
+    ASSERT_TRUE(Map_insert(pooled_int, int, &m, i, i * 3));
+  for (int i = 0; i < 5000; i += 2)
+    ASSERT_TRUE(Map_remove(pooled_int, int, &m, i));
+  ASSERT_TRUE(Map_size(pooled_int, int, &m) == 2500);
+  for (int i = 0; i < 5000; i++)
+  {
+    int *v = Map_get(pooled_int, int, &m, i);
+    if (i % 2)
+      ASSERT_TRUE(v && *v == i * 3);
+    else
+      ASSERT_NULL(v);
+  }
+  Map_free(pooled_int, int, &m);
+  ASSERT_NULL(m.pool);
+}
+
+TEST(map_pooled_clear_reuses_chunks)
+{
+  Map(pooled_int, int) m = Map_init(pooled_int, int);
+  for (int i = 0; i < 3000; i++)
+    Map_insert(pooled_int, int, &m, i, i);
+  CLIP_NodePool *pool = m.pool;
+  CLIP_PoolChunk *chunks = pool->chunks;
+  size_t next_chunk_nodes = pool->next_chunk_nodes;
+
+  Map_clear(pooled_int, int, &m);
+  ASSERT_TRUE(Map_size(pooled_int, int, &m) == 0);
+  for (int i = 0; i < 3000; i++)
+    Map_insert(pooled_int, int, &m, -i, i);
+
+  // Refilling to the same size must not allocate any new chunk
+  ASSERT_TRUE(m.pool == pool);
+  ASSERT_TRUE(pool->chunks == chunks);
+  ASSERT_TRUE(pool->next_chunk_nodes == next_chunk_nodes);
+  ASSERT_TRUE(*Map_get(pooled_int, int, &m, -2999) == 2999);
+  Map_free(pooled_int, int, &m);
+}
+
 // ========== TEST SUITE DEFINITION ==========
 
 TEST_SUITE(
@@ -742,4 +791,8 @@ TEST_SUITE(
     RUN_TEST(map_foreach_empty),
     RUN_TEST(map_foreach_single),
     RUN_TEST(map_foreach_multiple_sorted_order),
-    RUN_TEST(map_foreach_large))
\ No newline at end of file
+    RUN_TEST(map_foreach_large),
+
+    // Pooled nodes
+    RUN_TEST(map_pooled_insert_get_remove),
+    RUN_TEST(map_pooled_clear_reuses_chunks))
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "CLIP/Test.h"
+#include "CLIP/ParSort.h"
+
+int compare_ints(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+typedef struct
+{
+    double value;
+    int key;
+} Sample;
+
+int compare_samples(const Sample *a, const Sample *b)
+{
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+CLIP_DEFINE_LIST_TYPE(int)
+CLIP_DEFINE_LIST_PAR_SORT(int)
+
+CLIP_DEFINE_LIST_TYPE(Sample)
+CLIP_DEFINE_LIST_PAR_SORT(Sample)
+
+// Deterministic pseudo-random numbers
+static unsigned int seed = 2024u;
+static int next_random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (int)(seed >> 1);
+}
+
+static List(int) random_list(int n, int modulo)
+{
+    List(int) xs = List_init(int, n);
+    for (int i = 0; i < n; i++)
+        List_append(int, &xs, next_random() % modulo - modulo / 2);
+    return xs;
+}
+
+static bool is_sorted(List(int) *xs)
+{
+    for (int i = 1; i < xs->size; i++)
+        if (xs->data[i - 1] > xs->data[i])
+            return false;
+    return true;
+}
+
+static long checksum(List(int) *xs)
+{
+    long sum = 0;
+    for (int i = 0; i < xs->size; i++)
+        sum += (long)xs->data[i] * 31 + (xs->data[i] & 7);
+    return sum;
+}
+
+// --- Test Cases ---
+TEST(below_threshold_uses_serial_path)
+{
+    List(int) xs = random_list(1000, 1000);
+    ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, 4));
+    ASSERT_TRUE(is_sorted(&xs));
+    List_free(int, &xs);
+}
+
+TEST(thread_counts)
+{
+    // Odd thread counts leave an unpaired run in some merge rounds
+    int counts[] = {1, 2, 3, 4, 5, 7, 8, 16};
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        List(int) xs = random_list(300000, 1 << 30);
+        long before = checksum(&xs);
+        ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, counts[c]));
+        ASSERT_TRUE(is_sorted(&xs));
+        ASSERT_TRUE(checksum(&xs) == before);
+        List_free(int, &xs);
+    }
+}
+
+TEST(default_thread_count)
+{
+    List(int) xs = random_list(200000, 1 << 20);
+    ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, 0));
+    ASSERT_TRUE(is_sorted(&xs));
+    List_free(int, &xs);
+}
+
+TEST(many_duplicates_and_sorted_input)
+{
+    List(int) xs = random_list(250000, 3);
+    long before = checksum(&xs);
+    ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, 6));
+    ASSERT_TRUE(is_sorted(&xs));
+    ASSERT_TRUE(checksum(&xs) == before);
+
+    // Sorting again (already sorted) and in reverse order
+    ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, 6));
+    ASSERT_TRUE(is_sorted(&xs));
+    List_reverse(int, &xs);
+    ASSERT_TRUE(List_par_sort(int, &xs, compare_ints, 6));
+    ASSERT_TRUE(is_sorted(&xs));
+    List_free(int, &xs);
+}
+
+TEST(structs)
+{
+    List(Sample) xs = List_init(Sample, 100000);
+    for (int i = 0; i < 100000; i++)
+        List_append(Sample, &xs, ((Sample){.value = i * 0.5, .key = next_random() % 5000}));
+
+    ASSERT_TRUE(List_par_sort(Sample, &xs, compare_samples, 4));
+    for (int i = 1; i < xs.size; i++)
+        ASSERT_TRUE(xs.data[i - 1].key <= xs.data[i].key);
+    List_free(Sample, &xs);
+}
+
+TEST(null_arguments)
+{
+    List(int) xs = random_list(10, 10);
+    ASSERT_FALSE(List_par_sort(int, &xs, NULL, 2));
+    ASSERT_FALSE(List_par_sort(int, NULL, compare_ints, 2));
+    List_free(int, &xs);
+}
+
+TEST_SUITE(
+    RUN_TEST(below_threshold_uses_serial_path),
+    RUN_TEST(thread_counts),
+    RUN_TEST(default_thread_count),
+    RUN_TEST(many_duplicates_and_sorted_input),
+    RUN_TEST(structs),
+    RUN_TEST(null_arguments))
@@ -44,6 +44,12 @@ AllocatedInt new_allocated_int(int val)
 }
 CLIP_DEFINE_SET_TYPE_WITH_FREE(AllocatedInt, compare_allocated_int, free_allocated_int)
 
+typedef int pooled_int;
+CLIP_DEFINE_SET_TYPE_POOLED(pooled_int, compare_ints, NULL)
+
+typedef AllocatedInt PooledAllocatedInt;
+CLIP_DEFINE_SET_TYPE_POOLED(PooledAllocatedInt, compare_allocated_int, free_allocated_int)
+
 // --- Test Cases ---
 TEST(init)
 {
@@ -662,6 +668,48 @@ TEST(join_with_destructor)
     ASSERT_TRUE(destructor_call_count == 4); 
 }
 
+TEST(pooled_clear_and_refill)
+{
+    Set(pooled_int) xs = Set_init(pooled_int);
+    for (int i = 0; i < 2000; i++)
+        ASSERT_TRUE(Set_insert(pooled_int, &xs, i));
+    for (int i = 0; i < 2000; i += 3)
+        ASSERT_TRUE(Set_remove(pooled_int, &xs, i));
+    ASSERT_FALSE(Set_contains(pooled_int, &xs, 3));
+    ASSERT_TRUE(Set_contains(pooled_int, &xs, 4));
+
+    CLIP_PoolChunk *chunks = xs.pool->chunks;
+    Set_clear(pooled_int, &xs);
+    ASSERT_TRUE(Set_size(pooled_int, &xs) == 0);
+    for (int i = 0; i < 2000; i++)
+        Set_insert(pooled_int, &xs, -i);
+    ASSERT_TRUE(xs.pool->chunks == chunks); // chunks are reused, not reallocated
+    ASSERT_TRUE(Set_contains(pooled_int, &xs, -1999));
+
+    Set_free(pooled_int, &xs);
+    ASSERT_NULL(xs.pool);
+}
+
+TEST(pooled_with_destructor)
+{
+    destructor_call_count = 0;
+    Set(PooledAllocatedInt) xs = Set_init(PooledAllocatedInt);
+    for (int i = 0; i < 100; i++)
+        Set_insert(PooledAllocatedInt, &xs, new_allocated_int(i));
+
+    AllocatedInt key = new_allocated_int(50);
+    ASSERT_TRUE(Set_contains(PooledAllocatedInt, &xs, key));
+    free(key.value);
+
+    Set_clear(PooledAllocatedInt, &xs);
+    ASSERT_TRUE(destructor_call_count == 100);
+
+    for (int i = 0; i < 10; i++)
+        Set_insert(PooledAllocatedInt, &xs, new_allocated_int(i));
+    Set_free(PooledAllocatedInt, &xs);
+    ASSERT_TRUE(destructor_call_count == 110);
+}
+
 TEST_SUITE(
     RUN_TEST(init),
     RUN_TEST(insert_and_contains),
@@ -687,4 +735,6 @@ TEST_SUITE(
     RUN_TEST(join_large_sets),
     RUN_TEST(join_and_then_insert),
     RUN_TEST(join_null_source),
-    RUN_TEST(join_with_destructor))
\ No newline at end of file
+    RUN_TEST(join_with_destructor),
+    RUN_TEST(pooled_clear_and_refill),
+    RUN_TEST(pooled_with_destructor))
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "CLIP/Test.h"
+#include "CLIP/Size.h"
+#include "CLIP/List.h"
+#include "CLIP/SmallList.h"
+
+CLIP_DEFINE_LIST_TYPE(int)
+CLIP_DEFINE_SMALL_LIST_TYPE(int, 2)
+
+TEST(size_type_matches_mode)
+{
+#ifdef CLIP_64BIT_SIZES
+    ASSERT_TRUE(sizeof(clip_size_t) == sizeof(ptrdiff_t));
+    ASSERT_TRUE(CLIP_SIZE_MAX > INT_MAX);
+#else
+    ASSERT_TRUE(sizeof(clip_size_t) == sizeof(int));
+#endif
+    List(int) xs = List_init(int, 1);
+    ASSERT_TRUE(sizeof(xs.size) == sizeof(clip_size_t));
+    List_free(int, &xs);
+}
+
+TEST(checked_multiplication)
+{
+    size_t out = 7;
+    ASSERT_TRUE(clip_size_mul(1000, 8, &out));
+    ASSERT_TRUE(out == 8000);
+    ASSERT_FALSE(clip_size_mul(SIZE_MAX / 2 + 1, 2, &out));
+    ASSERT_TRUE(out == 8000);
+}
+
+TEST(max_capacity_bounds_byte_size)
+{
+    ASSERT_TRUE(clip_max_capacity(SIZE_MAX / 4) == 4);
+    ASSERT_TRUE(clip_max_capacity(1) == CLIP_SIZE_MAX);
+}
+
+TEST(grow_doubles_small_blocks)
+{
+    ASSERT_TRUE(clip_grow_capacity(0, 1, sizeof(int)) == 1);
+    ASSERT_TRUE(clip_grow_capacity(4, 5, sizeof(int)) == 8);
+    ASSERT_TRUE(clip_grow_capacity(4, 17, sizeof(int)) == 32);
+}
+
+TEST(grow_uses_large_factor_past_threshold)
+{
+    size_t elem = 1 << 20; // 64 elements reach the 64 MiB threshold
+    ASSERT_TRUE(clip_grow_capacity(32, 33, elem) == 64);
+    ASSERT_TRUE(clip_grow_capacity(64, 65, elem) == 96);
+    ASSERT_TRUE(clip_grow_capacity(96, 97, elem) == 144);
+}
+
+TEST(grow_clamps_and_reports_overflow)
+{
+    size_t elem = SIZE_MAX / 4; // At most 4 elements fit in a size_t byte count
+    ASSERT_TRUE(clip_grow_capacity(3, 4, elem) == 4);
+    ASSERT_TRUE(clip_grow_capacity(4, 5, elem) == -1);
+    ASSERT_TRUE(clip_grow_capacity(CLIP_SIZE_MAX - 1, CLIP_SIZE_MAX, 1) == CLIP_SIZE_MAX);
+}
+
+TEST(list_growth_rejects_size_overflow)
+{
+    List(int) xs = List_init(int, 1);
+    clip_size_t real_size = xs.size;
+    xs.size = CLIP_SIZE_MAX; // Pretend the list is full, without allocating it
+    ASSERT_FALSE(List_append(int, &xs, 1));
+    xs.size = real_size;
+    ASSERT_TRUE(List_append(int, &xs, 1));
+    List_free(int, &xs);
+}
+
+TEST(small_list_growth_rejects_size_overflow)
+{
+    SmallList(int) xs = SmallList_init(int);
+    xs.size = CLIP_SIZE_MAX;
+    ASSERT_FALSE(SmallList_append(int, &xs, 1));
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+    xs.size = 0;
+    SmallList_free(int, &xs);
+}
+
+TEST_SUITE(
+    RUN_TEST(size_type_matches_mode),
+    RUN_TEST(checked_multiplication),
+    RUN_TEST(max_capacity_bounds_byte_size),
+    RUN_TEST(grow_doubles_small_blocks),
+    RUN_TEST(grow_uses_large_factor_past_threshold),
+    RUN_TEST(grow_clamps_and_reports_overflow),
+    RUN_TEST(list_growth_rejects_size_overflow),
+    RUN_TEST(small_list_growth_rejects_size_overflow))
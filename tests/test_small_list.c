@@ -0,0 +1,167 @@
+#include "CLIP/Test.h"
+#include "CLIP/SmallList.h"
+
+CLIP_DEFINE_SMALL_LIST_TYPE(int, 4)
+
+// Global counter to track how many times the destructor is called
+static int destructor_call_count = 0;
+typedef char *owned_str;
+void free_owned_str(owned_str *s)
+{
+    free(*s);
+    destructor_call_count++;
+}
+CLIP_DEFINE_SMALL_LIST_TYPE_WITH_FREE(owned_str, 2, free_owned_str)
+
+// --- Test Cases ---
+TEST(init_is_inline)
+{
+    SmallList(int) xs = SmallList_init(int);
+    ASSERT_TRUE(xs.size == 0);
+    ASSERT_TRUE(xs.capacity == 4);
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+    SmallList_free(int, &xs);
+}
+
+TEST(append_stays_inline_up_to_n)
+{
+    SmallList(int) xs = SmallList_init(int);
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(SmallList_append(int, &xs, i * 10));
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+    ASSERT_TRUE(SmallList_data(int, &xs) == xs.storage.inline_data);
+    ASSERT_TRUE(SmallList_get(int, &xs, 3) == 30);
+    SmallList_free(int, &xs);
+}
+
+TEST(spill_to_heap)
+{
+    SmallList(int) xs = SmallList_init(int);
+    for (int i = 0; i < 100; i++)
+        ASSERT_TRUE(SmallList_append(int, &xs, i));
+    ASSERT_FALSE(SmallList_is_inline(int, &xs));
+    ASSERT_TRUE(xs.size == 100);
+    ASSERT_TRUE(xs.capacity >= 100);
+    for (int i = 0; i < 100; i++)
+        ASSERT_TRUE(SmallList_get(int, &xs, i) == i);
+
+    SmallList_free(int, &xs);
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+    ASSERT_TRUE(xs.size == 0);
+}
+
+TEST(pop_replace_get_bounds)
+{
+    SmallList(int) xs = SmallList_init(int);
+    int out = -1;
+    ASSERT_FALSE(SmallList_pop(int, &xs, &out));
+    SmallList_append(int, &xs, 1);
+    SmallList_append(int, &xs, 2);
+
+    ASSERT_TRUE(SmallList_replace(int, &xs, 0, 7));
+    ASSERT_FALSE(SmallList_replace(int, &xs, 2, 9));
+    ASSERT_TRUE(SmallList_at(int, &xs, 0) == 7);
+    ASSERT_NULL(SmallList_get_ptr(int, &xs, 5));
+    ASSERT_NOT_NULL(SmallList_get_ptr(int, &xs, 1));
+
+    ASSERT_TRUE(SmallList_pop(int, &xs, &out));
+    ASSERT_TRUE(out == 2);
+    ASSERT_TRUE(xs.size == 1);
+    SmallList_free(int, &xs);
+}
+
+TEST(insert_and_remove_across_spill)
+{
+    SmallList(int) xs = SmallList_init(int);
+    SmallList_append(int, &xs, 1);
+    SmallList_append(int, &xs, 3);
+    ASSERT_TRUE(SmallList_insert(int, &xs, 1, 2));
+    ASSERT_TRUE(SmallList_insert(int, &xs, 0, 0));
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+
+    // The fifth element spills, order must be preserved
+    ASSERT_TRUE(SmallList_insert(int, &xs, 2, 99));
+    ASSERT_FALSE(SmallList_is_inline(int, &xs));
+    ASSERT_FALSE(SmallList_insert(int, &xs, 10, 5));
+    int expected[] = {0, 1, 99, 2, 3};
+    for (int i = 0; i < 5; i++)
+        ASSERT_TRUE(SmallList_get(int, &xs, i) == expected[i]);
+
+    ASSERT_TRUE(SmallList_remove_at(int, &xs, 2));
+    ASSERT_FALSE(SmallList_remove_at(int, &xs, 4));
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(SmallList_get(int, &xs, i) == i);
+    SmallList_free(int, &xs);
+}
+
+TEST(reserve_and_clear)
+{
+    SmallList(int) xs = SmallList_init(int);
+    ASSERT_TRUE(SmallList_reserve(int, &xs, 3));
+    ASSERT_TRUE(SmallList_is_inline(int, &xs));
+    SmallList_append(int, &xs, 5);
+    ASSERT_TRUE(SmallList_reserve(int, &xs, 64));
+    ASSERT_FALSE(SmallList_is_inline(int, &xs));
+    ASSERT_TRUE(xs.capacity == 64);
+    ASSERT_TRUE(SmallList_get(int, &xs, 0) == 5);
+
+    SmallList_clear(int, &xs);
+    ASSERT_TRUE(xs.size == 0);
+    ASSERT_TRUE(xs.capacity == 64); // keeps the heap block for reuse
+    SmallList_free(int, &xs);
+}
+
+TEST(foreach_and_copy_by_value)
+{
+    SmallList(int) xs = SmallList_init(int);
+    for (int i = 1; i <= 3; i++)
+        SmallList_append(int, &xs, i);
+
+    // Inline lists are plain values: a copy is independent
+    SmallList(int) copy = xs;
+    SmallList_replace(int, &copy, 0, 100);
+    ASSERT_TRUE(SmallList_get(int, &xs, 0) == 1);
+
+    int sum = 0;
+    SmallList_foreach(int, item, &xs)
+    {
+        sum += *item;
+        *item *= 2;
+    }
+    ASSERT_TRUE(sum == 6);
+    ASSERT_TRUE(SmallList_get(int, &xs, 2) == 6);
+    SmallList_free(int, &xs);
+}
+
+static char *dup_str(const char *s)
+{
+    char *p = malloc(strlen(s) + 1);
+    strcpy(p, s);
+    return p;
+}
+
+TEST(free_calls_destructor_inline_and_spilled)
+{
+    destructor_call_count = 0;
+    SmallList(owned_str) xs = SmallList_init(owned_str);
+    SmallList_append(owned_str, &xs, dup_str("a"));
+    SmallList_append(owned_str, &xs, dup_str("b"));
+    SmallList_free(owned_str, &xs);
+    ASSERT_TRUE(destructor_call_count == 2);
+
+    for (int i = 0; i < 5; i++)
+        SmallList_append(owned_str, &xs, dup_str("spilled"));
+    ASSERT_STR_EQ(SmallList_get(owned_str, &xs, 4), "spilled");
+    SmallList_free(owned_str, &xs);
+    ASSERT_TRUE(destructor_call_count == 7);
+}
+
+TEST_SUITE(
+    RUN_TEST(init_is_inline),
+    RUN_TEST(append_stays_inline_up_to_n),
+    RUN_TEST(spill_to_heap),
+    RUN_TEST(pop_replace_get_bounds),
+    RUN_TEST(insert_and_remove_across_spill),
+    RUN_TEST(reserve_and_clear),
+    RUN_TEST(foreach_and_copy_by_value),
+    RUN_TEST(free_calls_destructor_inline_and_spilled))
@@ -0,0 +1,263 @@
+#define _POSIX_C_SOURCE 200809L // fileno
+#include "CLIP/Test.h"
+#include "CLIP/StrBuf.h"
+#include "CLIP/List.h"
+#include "CLIP/Stack.h"
+#include "CLIP/Queue.h"
+#include "CLIP/Map.h"
+#include "CLIP/Set.h"
+#include "CLIP/HashMap.h"
+
+void int_to_str(int v, char *buf, size_t n)
+{
+    snprintf(buf, n, "%d", v);
+}
+
+int cmp_int(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+CLIP_DEFINE_LIST_TYPE(int)
+CLIP_REGISTER_LIST_PRINT(int, int_to_str)
+CLIP_DEFINE_STACK_TYPE(int)
+CLIP_REGISTER_STACK_PRINT(int, int_to_str)
+CLIP_DEFINE_QUEUE_TYPE(int)
+CLIP_REGISTER_QUEUE_PRINT(int, int_to_str)
+CLIP_DEFINE_MAP_TYPE(int, int, cmp_int);
+CLIP_REGISTER_MAP_PRINT(int, int, int_to_str, int_to_str);
+CLIP_DEFINE_SET_TYPE(int, cmp_int)
+CLIP_REGISTER_SET_PRINT(int, int_to_str)
+CLIP_DEFINE_HASHMAP_TYPE(int, int, clip_hash_int, clip_eq_int);
+CLIP_REGISTER_HASHMAP_PRINT(int, int, int_to_str, int_to_str);
+
+// Sink that appends everything into an in-memory builder and records the largest chunk it saw.
+typedef struct
+{
+    CLIP_StrBuf collected;
+    size_t calls;
+    size_t largest;
+    bool fail;
+} Capture;
+
+static bool capture_sink(void *ctx, const char *data, size_t len)
+{
+    Capture *c = ctx;
+    if (c->fail)
+        return false;
+    c->calls++;
+    if (len > c->largest)
+        c->largest = len;
+    return clip_strbuf_append(&c->collected, data, len);
+}
+
+// --- Builder ---
+TEST(builder_appends_and_detaches)
+{
+    CLIP_StrBuf sb;
+    clip_strbuf_init(&sb);
+    ASSERT_STR_EQ(clip_strbuf_cstr(&sb), "");
+    ASSERT_TRUE(clip_strbuf_puts(&sb, "abc"));
+    ASSERT_TRUE(clip_strbuf_putc(&sb, '-'));
+    ASSERT_TRUE(clip_strbuf_printf(&sb, "%d/%s", 42, "x"));
+    ASSERT_TRUE(clip_strbuf_append(&sb, "yz!", 2));
+    ASSERT_TRUE(sb.len == 10);
+    ASSERT_STR_EQ(clip_strbuf_cstr(&sb), "abc-42/xyz");
+    char *s = clip_strbuf_detach(&sb);
+    ASSERT_STR_EQ(s, "abc-42/xyz");
+    ASSERT_NULL(sb.data);
+    free(s);
+}
+
+TEST(builder_detach_empty_is_empty_string)
+{
+    CLIP_StrBuf sb;
+    clip_strbuf_init(&sb);
+    char *s = clip_strbuf_detach(&sb);
+    ASSERT_NOT_NULL(s);
+    ASSERT_STR_EQ(s, "");
+    free(s);
+}
+
+TEST(builder_grows_geometrically)
+{
+    CLIP_StrBuf sb;
+    clip_strbuf_init(&sb);
+    int reallocations = 0;
+    size_t capacity = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        clip_strbuf_putc(&sb, 'a' + i % 26);
+        if (sb.capacity != capacity)
+        {
+            capacity = sb.capacity;
+            reallocations++;
+        }
+    }
+    ASSERT_TRUE(sb.len == 100000);
+    ASSERT_TRUE(reallocations < 20);
+    ASSERT_TRUE(sb.data[25] == 'z' && sb.data[26] == 'a');
+    clip_strbuf_free(&sb);
+}
+
+// --- Streaming ---
+TEST(stream_memory_stays_bounded)
+{
+    Capture c = {0};
+    clip_strbuf_init(&c.collected);
+    List(int) xs = List_init(int, 1);
+    for (int i = 0; i < 50000; i++)
+        List_append(int, &xs, i);
+
+    CLIP_StrBuf out;
+    clip_strbuf_init_sink(&out, capture_sink, &c);
+    ASSERT_TRUE(List_write(int, &xs, &out));
+    ASSERT_TRUE(out.capacity == CLIP_STRBUF_STREAM_SIZE);
+    ASSERT_TRUE(clip_strbuf_free(&out));
+    ASSERT_TRUE(c.calls > 10);
+    ASSERT_TRUE(c.largest <= CLIP_STRBUF_STREAM_SIZE);
+
+    char *expected = List_to_str(int, &xs);
+    ASSERT_STR_EQ(clip_strbuf_cstr(&c.collected), expected);
+    free(expected);
+    clip_strbuf_free(&c.collected);
+    List_free(int, &xs);
+}
+
+TEST(stream_large_append_bypasses_buffer)
+{
+    Capture c = {0};
+    clip_strbuf_init(&c.collected);
+    char big[CLIP_STRBUF_STREAM_SIZE * 2 + 1];
+    memset(big, 'q', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    CLIP_StrBuf out;
+    clip_strbuf_init_sink(&out, capture_sink, &c);
+    clip_strbuf_puts(&out, "<");
+    clip_strbuf_puts(&out, big);
+    clip_strbuf_puts(&out, ">");
+    ASSERT_TRUE(out.capacity == CLIP_STRBUF_STREAM_SIZE);
+    ASSERT_TRUE(clip_strbuf_free(&out));
+    ASSERT_TRUE(c.collected.len == sizeof(big) + 1);
+    ASSERT_TRUE(c.collected.data[0] == '<' && c.collected.data[sizeof(big)] == '>');
+    clip_strbuf_free(&c.collected);
+}
+
+TEST(stream_failure_is_sticky)
+{
+    Capture c = {0};
+    clip_strbuf_init(&c.collected);
+    c.fail = true;
+    CLIP_StrBuf out;
+    clip_strbuf_init_sink(&out, capture_sink, &c);
+    char chunk[1024];
+    memset(chunk, 'x', sizeof(chunk));
+    bool ok = true;
+    for (int i = 0; i < 8 && ok; i++)
+        ok = clip_strbuf_append(&out, chunk, sizeof(chunk));
+    ASSERT_FALSE(ok);
+    ASSERT_TRUE(out.failed);
+    ASSERT_FALSE(clip_strbuf_putc(&out, 'y'));
+    ASSERT_FALSE(clip_strbuf_free(&out));
+    clip_strbuf_free(&c.collected);
+}
+
+TEST(stream_to_file_and_fd)
+{
+    List(int) xs = List_init(int, 4);
+    for (int i = 0; i < 5; i++)
+        List_append(int, &xs, i * 10);
+
+    FILE *f = tmpfile();
+    ASSERT_NOT_NULL(f);
+    List_fprint(int, &xs, f);
+    fflush(f);
+
+    CLIP_StrBuf out;
+    clip_strbuf_init_fd(&out, fileno(f));
+    clip_strbuf_puts(&out, " | ");
+    List_write(int, &xs, &out);
+    ASSERT_TRUE(clip_strbuf_free(&out));
+
+    char read_back[128] = {0};
+    rewind(f);
+    size_t n = fread(read_back, 1, sizeof(read_back) - 1, f);
+    fclose(f);
+    ASSERT_TRUE(n > 0);
+    ASSERT_STR_EQ(read_back, "[0, 10, 20, 30, 40] | [0, 10, 20, 30, 40]");
+    List_free(int, &xs);
+}
+
+// --- Containers write the same text as to_str ---
+TEST(container_writes_match_to_str)
+{
+    Stack(int) st = Stack_init(int, 2);
+    Queue(int) q = Queue_init(int, 8);
+    Map(int, int) m = Map_init(int, int);
+    Set(int) s = Set_init(int);
+    HashMap(int, int) hm = HashMap_init(int, int);
+    for (int i = 0; i < 4; i++)
+    {
+        Stack_push(int, &st, i);
+        Queue_enqueue(int, &q, i);
+        Map_insert(int, int, &m, i, -i);
+        Set_insert(int, &s, i);
+        HashMap_insert(int, int, &hm, i, i * i);
+    }
+
+    CLIP_StrBuf out;
+    clip_strbuf_init(&out);
+    ASSERT_TRUE(Stack_write(int, &st, &out));
+    ASSERT_TRUE(clip_strbuf_putc(&out, ' '));
+    ASSERT_TRUE(Queue_write(int, &q, &out));
+    ASSERT_TRUE(clip_strbuf_putc(&out, ' '));
+    ASSERT_TRUE(Map_write(int, int, &m, &out));
+    ASSERT_TRUE(clip_strbuf_putc(&out, ' '));
+    ASSERT_TRUE(Set_write(int, &s, &out));
+    ASSERT_STR_EQ(clip_strbuf_cstr(&out),
+                  "[top: 3, 2, 1, 0 :bottom] [0, 1, 2, 3] {{0 : 0}, {1 : -1}, {2 : -2}, {3 : -3}} {0, 1, 2, 3}");
+    clip_strbuf_free(&out);
+
+    clip_strbuf_init(&out);
+    ASSERT_TRUE(HashMap_write(int, int, &hm, &out));
+    char *expected = HashMap_to_str(int, int, &hm);
+    ASSERT_STR_EQ(clip_strbuf_cstr(&out), expected);
+    ASSERT_TRUE(strstr(expected, "{3 : 9}") != NULL);
+    free(expected);
+    clip_strbuf_free(&out);
+
+    Stack_free(int, &st);
+    Queue_free(int, &q);
+    Map_free(int, int, &m);
+    Set_free(int, &s);
+    HashMap_free(int, int, &hm);
+}
+
+TEST(empty_containers_write_brackets)
+{
+    List(int) xs = List_init(int, 1);
+    Queue(int) q = Queue_init(int, 1);
+    Set(int) s = Set_init(int);
+    CLIP_StrBuf out;
+    clip_strbuf_init(&out);
+    List_write(int, &xs, &out);
+    Queue_write(int, &q, &out);
+    Set_write(int, &s, &out);
+    ASSERT_STR_EQ(clip_strbuf_cstr(&out), "[][]{}");
+    clip_strbuf_free(&out);
+    List_free(int, &xs);
+    Queue_free(int, &q);
+    Set_free(int, &s);
+}
+
+TEST_SUITE(
+    RUN_TEST(builder_appends_and_detaches),
+    RUN_TEST(builder_detach_empty_is_empty_string),
+    RUN_TEST(builder_grows_geometrically),
+    RUN_TEST(stream_memory_stays_bounded),
+    RUN_TEST(stream_large_append_bypasses_buffer),
+    RUN_TEST(stream_failure_is_sticky),
+    RUN_TEST(stream_to_file_and_fd),
+    RUN_TEST(container_writes_match_to_str),
+    RUN_TEST(empty_containers_write_brackets))